@@ -89,6 +89,11 @@ bool FeedProvider::readImage(image::Image<unsigned char> &imageGray,
   return(_feeder->readImage(imageGray, camIntrinsics, mediaPath, hasIntrinsics));
 }
   
+void FeedProvider::setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache)
+{
+  _feeder->setDecodedImageCache(imageCache);
+}
+
 std::size_t FeedProvider::nbFrames() const
 {
   if(_isLiveFeed)
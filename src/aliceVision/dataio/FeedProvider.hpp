@@ -52,6 +52,13 @@ public:
         std::string &mediaPath,
         bool &hasIntrinsics);
 
+  /**
+   * @brief Set the decoded image cache used to read the images of the feed.
+   * It is only used by the image feeds.
+   * @param[in] imageCache The decoded image cache (nullptr to disable)
+   */
+  void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache);
+
   /**
    * @brief It returns the number of frames contained of the video. It return infinity
    * if the feed is a live stream.
@@ -10,7 +10,14 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/image/pixelTypes.hpp>
 
+#include <memory>
+
 namespace aliceVision{
+
+namespace image {
+class DecodedImageCache;
+} // namespace image
+
 namespace dataio{
 
 class IFeed
@@ -52,6 +59,13 @@ public:
                     std::string &mediaPath,
                     bool &hasIntrinsics) = 0;  
 
+  /**
+   * @brief Set the decoded image cache used to read the images of the feed.
+   * The feeds which do not read image files ignore it.
+   * @param[in] imageCache The decoded image cache (nullptr to disable)
+   */
+  virtual void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache) {}
+
   virtual std::size_t nbFrames() const = 0;
   
   virtual bool goToFrame(const unsigned int frame) = 0;
@@ -8,6 +8,7 @@
 #include <aliceVision/sfm/SfMData.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/image/io.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string/case_conv.hpp> 
@@ -72,7 +73,10 @@ public:
 
       ALICEVISION_LOG_DEBUG(imageName);
 
-      image::readImage(imageName, image);
+      if(_imageCache)
+        _imageCache->readImage(imageName, image);
+      else
+        image::readImage(imageName, image);
       return true;
     }
     return true;
@@ -85,6 +89,11 @@ public:
   bool goToNextFrame();
   
   bool isInit() const {return _isInit;} 
+
+  void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache)
+  {
+    _imageCache = imageCache;
+  }
   
 private:
   
@@ -105,7 +114,10 @@ private:
     // get the image
     const sfm::View *view = _viewIterator->second.get();
     imageName = view->getImagePath();
-    image::readImage(imageName, image);
+    if(_imageCache)
+      _imageCache->readImage(imageName, image, view->getViewId());
+    else
+      image::readImage(imageName, image);
 
     // get the associated Intrinsics
     if((view->getIntrinsicId() == UndefinedIndexT) || (!_sfmdata.GetIntrinsics().count(view->getIntrinsicId())))
@@ -148,6 +160,7 @@ private:
   sfm::SfMData _sfmdata;
   sfm::Views::const_iterator _viewIterator;
   unsigned int _currentImageIndex = 0;
+  std::shared_ptr<image::DecodedImageCache> _imageCache;
 };
 
 const std::vector<std::string> ImageFeed::FeederImpl::supportedExtensions = { ".jpg", ".jpeg", ".png", ".ppm" };
@@ -376,6 +389,11 @@ bool ImageFeed::readImage(image::Image<unsigned char> &imageGray,
   return(_imageFeed->readImage(imageGray, camIntrinsics, mediaPath, hasIntrinsics));
 }
 
+void ImageFeed::setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache)
+{
+  _imageFeed->setDecodedImageCache(imageCache);
+}
+
 std::size_t ImageFeed::nbFrames() const
 {
   return _imageFeed->nbFrames();
@@ -75,6 +75,12 @@ public:
             std::string &mediaPath,
             bool &hasIntrinsics);
   
+  /**
+   * @brief Set the decoded image cache used to read the images of the feed.
+   * @param[in] imageCache The decoded image cache (nullptr to disable)
+   */
+  void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache) override;
+
   std::size_t nbFrames() const;
   
   bool goToFrame(const unsigned int frame);
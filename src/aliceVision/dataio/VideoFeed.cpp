@@ -11,11 +11,15 @@
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
-#include <opencv2/core/eigen.hpp>
 #include <opencv2/highgui.hpp>
 
+#include <cassert>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <exception>
+#include <mutex>
+#include <thread>
 
 namespace aliceVision{
 namespace dataio{
@@ -23,11 +27,13 @@ namespace dataio{
 class VideoFeed::FeederImpl
 {
 public:
-  FeederImpl() : _isInit(false) { }
+  FeederImpl() : _isInit(false), _isLive(false), _withIntrinsics(false) { }
   
   FeederImpl(const std::string &videoPath, const std::string &calibPath);
   
   FeederImpl(int videoDevice, const std::string &calibPath);
+
+  ~FeederImpl();
   
   bool isInit() const {return _isInit;}
   
@@ -48,12 +54,54 @@ public:
   std::size_t nbFrames() const;
   
 private:
+  /// maximum number of decoded frames ahead of the current frame
+  static const std::size_t decodeAheadSize = 3;
+  /// maximum number of frames skipped without retrieving them, a seek is used for larger steps
+  static const std::size_t maxGrabbedFrames = 32;
+
+  /**
+   * @brief Get the current decoded frame (BGR or grayscale), wait for its decoding
+   * @param[out] frame the current frame
+   * @return false if there is no current frame (end of the video)
+   */
+  bool getCurrentFrame(cv::Mat &frame);
+
+  /**
+   * @brief Move the current frame, reuse the frames decoded ahead if possible
+   * @param[in] frame the new current frame
+   */
+  void moveToFrame(std::size_t frame);
+
+  /// decode-ahead thread loop (video files only)
+  void decodeLoop();
+
   bool _isInit;
   bool _isLive;
   bool _withIntrinsics;
   std::string _videoPath;
   cv::VideoCapture _videoCapture;
   camera::PinholeRadialK3 _camIntrinsics;
+  std::size_t _nbFrames = 0;
+
+  // decode-ahead (video files only), the video capture is only used by the decode thread
+
+  /// frames decoded ahead (frame index, BGR or grayscale frame), the front is the current frame
+  std::deque<std::pair<std::size_t, cv::Mat>> _decodedFrames;
+  /// index of the current frame
+  std::size_t _currentFrame = 0;
+  /// index of the next frame to decode
+  std::size_t _nextDecodedFrame = 0;
+  /// step between the decoded frames
+  std::size_t _frameStep = 1;
+  /// last step asked by the caller
+  std::size_t _requestedStep = 1;
+  /// incremented when the decoded frames are dropped (seek), to discard the frame being decoded
+  std::size_t _generation = 0;
+  bool _endOfVideo = false;
+  bool _abort = false;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::thread _decodeThread;
 };
 
 
@@ -67,15 +115,18 @@ VideoFeed::FeederImpl::FeederImpl(const std::string &videoPath, const std::strin
     ALICEVISION_LOG_WARNING("Unable to open the video : " << videoPath);
     throw std::invalid_argument("Unable to open the video : "+videoPath);
   }
-  // Grab frame 0, so we can call readImage.
-  goToFrame(0);
+  _nbFrames = _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
 
   // load the calibration path
   _withIntrinsics = !calibPath.empty();
   if(_withIntrinsics)
     readCalibrationFromFile(calibPath, _camIntrinsics);
-  
+
+  // set before the decoding thread starts, it owns the video capture from now on
   _isInit = true;
+
+  // decode from frame 0, so we can call readImage.
+  _decodeThread = std::thread(&FeederImpl::decodeLoop, this);
 }
 
 VideoFeed::FeederImpl::FeederImpl(int videoDevice, const std::string &calibPath)
@@ -99,36 +150,144 @@ VideoFeed::FeederImpl::FeederImpl(int videoDevice, const std::string &calibPath)
   _isInit = true;
 }
 
+VideoFeed::FeederImpl::~FeederImpl()
+{
+  if(!_decodeThread.joinable())
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _abort = true;
+  }
+  _condition.notify_all();
+  _decodeThread.join();
+}
+
+void VideoFeed::FeederImpl::decodeLoop()
+{
+  std::size_t capturePosition = 0; // index of the next frame grabbed by the video capture
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  while(true)
+  {
+    _condition.wait(lock, [this]{ return _abort || (!_endOfVideo && _decodedFrames.size() < decodeAheadSize); });
+    if(_abort)
+      return;
+
+    const std::size_t frameIndex = _nextDecodedFrame;
+    const std::size_t generation = _generation;
+    lock.unlock();
+
+    // skip the frames before the decoded frame
+    if(capturePosition != frameIndex)
+    {
+      if(frameIndex > capturePosition && frameIndex - capturePosition <= maxGrabbedFrames)
+      {
+        // close frame: grab the skipped frames without retrieving them (no color conversion)
+        while(capturePosition < frameIndex && _videoCapture.grab())
+          ++capturePosition;
+      }
+      else
+      {
+        // far or previous frame: seek
+        _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frameIndex);
+        capturePosition = frameIndex;
+      }
+    }
+
+    cv::Mat frame;
+    bool success = (capturePosition == frameIndex) && _videoCapture.grab();
+    if(success)
+    {
+      ++capturePosition;
+      success = _videoCapture.retrieve(frame) && frame.data;
+    }
+
+    lock.lock();
+
+    // the decoded frames have been dropped in the meantime
+    if(generation != _generation)
+      continue;
+
+    if(success)
+    {
+      _decodedFrames.emplace_back(frameIndex, frame);
+      _nextDecodedFrame = frameIndex + _frameStep;
+    }
+    else
+    {
+      _endOfVideo = true;
+    }
+    _condition.notify_all();
+  }
+}
+
+bool VideoFeed::FeederImpl::getCurrentFrame(cv::Mat &frame)
+{
+  // live feed (or no video): no decode-ahead
+  if(!_decodeThread.joinable())
+    return _videoCapture.retrieve(frame) && frame.data;
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this]{ return !_decodedFrames.empty() || _endOfVideo; });
+
+  if(_decodedFrames.empty())
+    return false;
+
+  assert(_decodedFrames.front().first == _currentFrame);
+  frame = _decodedFrames.front().second; // shared data, no copy
+  return true;
+}
+
+void VideoFeed::FeederImpl::moveToFrame(std::size_t frame)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    // decode ahead with a regular step, every frame otherwise (e.g. non-integer step)
+    // so the decoding does not go past the next requested frame
+    const std::size_t step = (frame > _currentFrame) ? frame - _currentFrame : 1;
+    _frameStep = (step == _requestedStep) ? step : 1;
+    _requestedStep = step;
+    _currentFrame = frame;
+
+    // drop the decoded frames before the new current frame
+    while(!_decodedFrames.empty() && _decodedFrames.front().first < frame)
+      _decodedFrames.pop_front();
+
+    const bool isDecoded = !_decodedFrames.empty() && _decodedFrames.front().first == frame;
+    const bool isNextDecoded = _decodedFrames.empty() && !_endOfVideo && _nextDecodedFrame == frame;
+
+    if(!isDecoded && !isNextDecoded)
+    {
+      // restart the decoding from the new current frame
+      _decodedFrames.clear();
+      _nextDecodedFrame = frame;
+      _endOfVideo = false;
+      ++_generation;
+    }
+  }
+  _condition.notify_all();
+}
+
 bool VideoFeed::FeederImpl::readImage(image::Image<image::RGBColor> &imageRGB,
           camera::PinholeRadialK3 &camIntrinsics,
           std::string &mediaPath,
           bool &hasIntrinsics)
 {
   cv::Mat frame;
-  const bool grabStatus = _videoCapture.retrieve(frame);
-
-  if(!grabStatus || !frame.data)
+  if(!getCurrentFrame(frame))
   {
     return false;
   }
   
-  if(frame.channels() == 3)
+  // 8 bits frames only: cvtColor would reallocate the output buffer for another depth
+  if(frame.type() == CV_8UC3)
   {
-    cv::Mat color;
-    resize(frame, color, cv::Size(frame.cols, frame.rows));
-    
+    // convert directly in the output image buffer
+    imageRGB.resize(frame.cols, frame.rows, false);
+    cv::Mat color(frame.rows, frame.cols, CV_8UC3, imageRGB.data());
     cv::cvtColor(frame, color, CV_BGR2RGB);
-    imageRGB.resize(color.cols, color.rows);
-    
-    unsigned char* pixelPtr = (unsigned char*)color.data;
-    for(int i = 0; i < color.rows; i++)
-    {
-      for(int j = 0; j < color.cols; j++)
-      {
-        const size_t index = i*color.cols*3 + j*3;
-        imageRGB(i,j) = image::RGBColor(pixelPtr[index], pixelPtr[index + 1], pixelPtr[index + 2]);
-      }
-    }
   }
   else
   {
@@ -151,26 +310,30 @@ bool VideoFeed::FeederImpl::readImage(image::Image<unsigned char> &imageGray,
                    bool &hasIntrinsics)
 {
   cv::Mat frame;
-  const bool grabStatus = _videoCapture.retrieve(frame);
-
-  if(!grabStatus || !frame.data)
+  if(!getCurrentFrame(frame))
   {
     return false;
   }
-  
-  if(frame.channels() == 3)
+
+  // 8 bits frames only: cvtColor and copyTo would reallocate the output buffer for another type
+  if(frame.type() != CV_8UC3 && frame.type() != CV_8UC1)
+  {
+    ALICEVISION_LOG_WARNING("Error can't read grayscale frame " << _videoPath);
+    throw std::invalid_argument("Error can't read grayscale frame " + _videoPath);
+  }
+
+  // convert directly in the output image buffer
+  imageGray.resize(frame.cols, frame.rows, false);
+  cv::Mat grey(frame.rows, frame.cols, CV_8UC1, imageGray.data());
+
+  if(frame.type() == CV_8UC3)
   {
     // convert to gray
-    cv::Mat grey;
     cv::cvtColor(frame, grey, CV_BGR2GRAY);
-    imageGray.resize(grey.cols, grey.rows);
-    cv::cv2eigen(grey, imageGray);
-//      ALICEVISION_LOG_DEBUG(grey.channels() << " " << grey.rows << " " << grey.cols);
-//      ALICEVISION_LOG_DEBUG(imageGray.Depth() << " " << imageGray.Height() << " " << imageGray.Width());
   }
   else
   {
-    cv::cv2eigen(frame, imageGray);
+    frame.copyTo(grey);
   }
 
   hasIntrinsics = _withIntrinsics;
@@ -183,14 +346,15 @@ bool VideoFeed::FeederImpl::readImage(image::Image<unsigned char> &imageGray,
 
 std::size_t VideoFeed::FeederImpl::nbFrames() const
 {
-  if (!_videoCapture.isOpened())
-    return 0;
-  return _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+  if(_isLive)
+    return _videoCapture.get(cv::CAP_PROP_FRAME_COUNT);
+  return _nbFrames;
 }
 
 bool VideoFeed::FeederImpl::goToFrame(const unsigned int frame)
 {
-  if (!_videoCapture.isOpened())
+  // the video capture is owned by the decoding thread, don't query it here
+  if (!_isInit)
   {
     ALICEVISION_LOG_WARNING("We cannot open the video file.");
     return false;
@@ -198,24 +362,21 @@ bool VideoFeed::FeederImpl::goToFrame(const unsigned int frame)
   
   if(_isLive)
     return goToNextFrame();
-  
-  if(frame > 0)
-  {
-    _videoCapture.set(cv::CAP_PROP_POS_FRAMES, frame);
-    _videoCapture.grab();
-    return true;
-  }
-  else
-  {
-    _videoCapture.set(cv::CAP_PROP_POS_FRAMES, 0);
-    _videoCapture.grab();
-    return false;
-  }
+
+  moveToFrame(frame);
+  return frame > 0;
 }
 
 bool VideoFeed::FeederImpl::goToNextFrame()
 {
-  return _videoCapture.grab();
+  if(!_decodeThread.joinable())
+    return _videoCapture.grab();
+
+  moveToFrame(_currentFrame + 1);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this]{ return !_decodedFrames.empty() || _endOfVideo; });
+  return !_decodedFrames.empty();
 }
 
 /*******************************************************************************/
@@ -14,6 +14,13 @@
 namespace aliceVision{
 namespace dataio{
 
+/**
+ * @brief Image feed from a video file or a live device.
+ *
+ * The frames of a video file are decoded ahead by a background thread, with the step
+ * between the last requested frames: the skipped frames are only grabbed (no color conversion)
+ * and a seek is used for far frames.
+ */
 class VideoFeed : public IFeed
 {
 public:
@@ -0,0 +1,171 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/feature/ProductQuantizer.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Regions with compressed descriptors (product quantization codes, .pqdesc files).
+ *
+ * The descriptors are stored as getCodeSize() bytes each, the codebooks are shared by all the
+ * regions compressed with the same product quantizer. DescriptorLength() is the dimension of the
+ * uncompressed descriptors and DescriptorRawData() points to the codes.
+ * These regions can only be matched with the BRUTE_FORCE_PQ_L2 matcher.
+ */
+class CompressedRegions : public FeatRegions<SIOPointFeature>
+{
+public:
+  typedef CompressedRegions This;
+
+  /// type id of the compressed descriptors (no scalar type)
+  static const char* typeId() { return "ProductQuantizer"; }
+
+  /**
+   * @param[in] quantizer The trained product quantizer of the codes
+   */
+  explicit CompressedRegions(const std::shared_ptr<const ProductQuantizer>& quantizer)
+    : _quantizer(quantizer)
+  {}
+
+  const std::shared_ptr<const ProductQuantizer>& getQuantizer() const { return _quantizer; }
+
+  /// size of a compressed descriptor, in bytes
+  std::size_t getCodeSize() const { return static_cast<std::size_t>(_quantizer->getCodeSize()); }
+
+  /// The compressed descriptors (RegionCount() x getCodeSize())
+  inline std::vector<unsigned char> & Codes() { return _codes; }
+  inline const std::vector<unsigned char> & Codes() const { return _codes; }
+
+  /**
+   * @brief Decompress all the descriptors (approximation of the original descriptors)
+   * @param[out] descriptors The decompressed descriptors (RegionCount() x DescriptorLength())
+   */
+  void decodeDescriptors(std::vector<float>& descriptors) const
+  {
+    const std::size_t codeSize = getCodeSize();
+    descriptors.resize(this->RegionCount() * DescriptorLength());
+    for(std::size_t i = 0; i < this->RegionCount(); ++i)
+      _quantizer->decode(&_codes[i * codeSize], &descriptors[i * DescriptorLength()]);
+  }
+
+  std::string Type_id() const override { return typeId(); }
+  std::size_t DescriptorLength() const override { return static_cast<std::size_t>(_quantizer->getDimension()); }
+
+  bool IsScalar() const override { return true; }
+  bool IsBinary() const override { return false; }
+
+  Regions * EmptyClone() const override
+  {
+    return new This(_quantizer);
+  }
+
+  /// Read from files the regions and their corresponding compressed descriptors.
+  void Load(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) override
+  {
+    loadFeatsFromFile(sfileNameFeats, this->_vec_feats);
+    loadCompressedDescsFromBinFile(sfileNameDescs, _codes, _quantizer->getCodeSize());
+
+    if(_codes.size() != this->_vec_feats.size() * getCodeSize())
+      throw std::runtime_error("The number of compressed descriptors of '" + sfileNameDescs + "' does not match the number of features.");
+  }
+
+  /// Export in two separate files the regions and their corresponding compressed descriptors.
+  void Save(
+    const std::string& sfileNameFeats,
+    const std::string& sfileNameDescs) const override
+  {
+    saveFeatsToFile(sfileNameFeats, this->_vec_feats);
+    saveCompressedDescsToBinFile(sfileNameDescs, _codes, _quantizer->getCodeSize());
+  }
+
+  void SaveDesc(const std::string& sfileNameDescs) const override
+  {
+    saveCompressedDescsToBinFile(sfileNameDescs, _codes, _quantizer->getCodeSize());
+  }
+
+  inline const void* blindDescriptors() const override { return &_codes; }
+
+  inline const void* DescriptorRawData() const override { return _codes.data(); }
+
+  inline void clearDescriptors() override { _codes.clear(); }
+
+  /// Return the squared distance between the decompressed descriptors
+  double SquaredDescriptorDistance(std::size_t i, const Regions * genericRegions, std::size_t j) const override
+  {
+    assert(i < this->RegionCount());
+    assert(genericRegions);
+    assert(j < genericRegions->RegionCount());
+
+    const This * regionsT = dynamic_cast<const This*>(genericRegions);
+    std::vector<float> descriptor(DescriptorLength());
+    std::vector<float> distanceTable(_quantizer->getDistanceTableSize());
+    _quantizer->decode(&_codes[i * getCodeSize()], descriptor.data());
+    _quantizer->computeDistanceTable(descriptor.data(), distanceTable.data());
+    return _quantizer->asymmetricDistance(distanceTable.data(), &regionsT->_codes[j * getCodeSize()]);
+  }
+
+  /**
+   * @brief Add the Inth region to another Region container
+   * @param[in] i: index of the region to copy
+   * @param[out] outRegionContainer: the output region group to add the region
+   */
+  void CopyRegion(std::size_t i, Regions * outRegionContainer) const override
+  {
+    assert(i < this->_vec_feats.size());
+    This* outRegions = static_cast<This*>(outRegionContainer);
+    outRegions->_vec_feats.push_back(this->_vec_feats[i]);
+    outRegions->_codes.insert(outRegions->_codes.end(), _codes.begin() + i * getCodeSize(), _codes.begin() + (i + 1) * getCodeSize());
+  }
+
+  /**
+   * @brief Duplicate only reconstructed regions.
+   * @param[in] featuresInImage list of features with an associated 3D point Id
+   * @param[out] out_associated3dPoint
+   * @param[out] out_mapFullToLocal
+   */
+  std::unique_ptr<Regions> createFilteredRegions(
+                     const std::vector<FeatureInImage>& featuresInImage,
+                     std::vector<IndexT>& out_associated3dPoint,
+                     std::map<IndexT, IndexT>& out_mapFullToLocal) const override
+  {
+    out_associated3dPoint.clear();
+    out_mapFullToLocal.clear();
+
+    This* regionsPtr = new This(_quantizer);
+    std::unique_ptr<Regions> regions(regionsPtr);
+    regionsPtr->Features().reserve(featuresInImage.size());
+    regionsPtr->Codes().reserve(featuresInImage.size() * getCodeSize());
+    out_associated3dPoint.reserve(featuresInImage.size());
+    for(std::size_t i = 0; i < featuresInImage.size(); ++i)
+    {
+      const FeatureInImage & feat = featuresInImage[i];
+      CopyRegion(feat._featureIndex, regionsPtr);
+      out_mapFullToLocal[feat._featureIndex] = i;
+      out_associated3dPoint.push_back(feat._point3dId);
+    }
+    return regions;
+  }
+
+private:
+  std::shared_ptr<const ProductQuantizer> _quantizer;
+  /// compressed descriptors (RegionCount() x getCodeSize())
+  std::vector<unsigned char> _codes;
+};
+
+} // namespace feature
+} // namespace aliceVision
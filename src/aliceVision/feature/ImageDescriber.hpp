@@ -98,6 +98,18 @@ public:
    */
   virtual std::size_t getMemoryConsumption(std::size_t width, std::size_t height) const = 0;
 
+  /**
+   * @brief Get the maximum number of threads that the image describer
+   * can keep busy on the feature extraction of a single image of the given dimension.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return maximum number of threads (1 if the extraction is sequential)
+   */
+  virtual int getMaxNbThreads(std::size_t width, std::size_t height) const
+  {
+    return 1;
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
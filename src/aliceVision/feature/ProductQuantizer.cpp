@@ -0,0 +1,211 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "ProductQuantizer.hpp"
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/// codebooks file header, followed by the centroids
+struct CodebooksFileHeader
+{
+  char magic[4];
+  std::int32_t version;
+  std::int32_t dimension;
+  std::int32_t nbSubspaces;
+  std::int32_t nbCentroids;
+};
+
+const char codebooksFileMagic[4] = {'A', 'V', 'P', 'Q'};
+const std::int32_t codebooksFileVersion = 1;
+
+} // namespace
+
+ProductQuantizer::ProductQuantizer(int dimension, int nbSubspaces)
+  : _dimension(dimension)
+  , _nbSubspaces(nbSubspaces)
+{
+  if(dimension <= 0 || nbSubspaces <= 0 || dimension % nbSubspaces != 0)
+    throw std::invalid_argument("Invalid product quantizer: the dimension (" + std::to_string(dimension) +
+                                ") should be a multiple of the number of subspaces (" + std::to_string(nbSubspaces) + ").");
+  _subspaceDimension = dimension / nbSubspaces;
+}
+
+void ProductQuantizer::train(const float* descriptors, std::size_t nbDescriptors, int nbIterations, unsigned int seed)
+{
+  if(_dimension == 0)
+    throw std::runtime_error("Can't train an uninitialized product quantizer.");
+  if(nbDescriptors < static_cast<std::size_t>(nbCentroids))
+    throw std::runtime_error("Can't train the product quantizer: " + std::to_string(nbDescriptors) +
+                             " descriptors, at least " + std::to_string(nbCentroids) + " are required.");
+
+  _centroids.assign(getDistanceTableSize() * _subspaceDimension, 0.f);
+
+  // the initial centroids are distinct random training descriptors (the same for all the subspaces)
+  std::vector<std::size_t> initIndexes(nbDescriptors);
+  std::iota(initIndexes.begin(), initIndexes.end(), 0);
+  std::mt19937 generator(seed);
+  std::shuffle(initIndexes.begin(), initIndexes.end(), generator);
+  initIndexes.resize(nbCentroids);
+
+  // k-means on each subspace, independently
+  #pragma omp parallel for schedule(dynamic)
+  for(int s = 0; s < _nbSubspaces; ++s)
+  {
+    float* centroids = _centroids.data() + static_cast<std::size_t>(s) * nbCentroids * _subspaceDimension;
+    const auto subvector = [&](std::size_t i) { return descriptors + i * _dimension + s * _subspaceDimension; };
+
+    for(int c = 0; c < nbCentroids; ++c)
+      std::copy(subvector(initIndexes[c]), subvector(initIndexes[c]) + _subspaceDimension, centroids + c * _subspaceDimension);
+
+    std::vector<int> assignments(nbDescriptors, -1);
+    std::vector<double> sums(static_cast<std::size_t>(nbCentroids) * _subspaceDimension);
+    std::vector<std::size_t> counts(nbCentroids);
+
+    for(int iteration = 0; iteration < nbIterations; ++iteration)
+    {
+      // assignment step
+      bool changed = false;
+      for(std::size_t i = 0; i < nbDescriptors; ++i)
+      {
+        const float* v = subvector(i);
+        float bestDistance = std::numeric_limits<float>::max();
+        int bestCentroid = 0;
+        for(int c = 0; c < nbCentroids; ++c)
+        {
+          const float distance = subspaceDistance(v, centroids + c * _subspaceDimension);
+          if(distance < bestDistance)
+          {
+            bestDistance = distance;
+            bestCentroid = c;
+          }
+        }
+        changed |= (assignments[i] != bestCentroid);
+        assignments[i] = bestCentroid;
+      }
+
+      if(!changed)
+        break;
+
+      // update step
+      std::fill(sums.begin(), sums.end(), 0.0);
+      std::fill(counts.begin(), counts.end(), 0);
+      for(std::size_t i = 0; i < nbDescriptors; ++i)
+      {
+        const float* v = subvector(i);
+        double* sum = sums.data() + assignments[i] * _subspaceDimension;
+        for(int d = 0; d < _subspaceDimension; ++d)
+          sum[d] += v[d];
+        ++counts[assignments[i]];
+      }
+
+      for(int c = 0; c < nbCentroids; ++c)
+      {
+        // an empty cluster keeps its previous centroid
+        if(counts[c] == 0)
+          continue;
+        for(int d = 0; d < _subspaceDimension; ++d)
+          centroids[c * _subspaceDimension + d] = static_cast<float>(sums[c * _subspaceDimension + d] / counts[c]);
+      }
+    }
+  }
+}
+
+void ProductQuantizer::decode(const unsigned char* code, float* descriptor) const
+{
+  assert(isTrained());
+  for(int s = 0; s < _nbSubspaces; ++s)
+  {
+    const float* centroid = getCentroid(s, code[s]);
+    std::copy(centroid, centroid + _subspaceDimension, descriptor + s * _subspaceDimension);
+  }
+}
+
+void ProductQuantizer::save(const std::string& path) const
+{
+  if(!isTrained())
+    throw std::runtime_error("Can't save an untrained product quantizer in '" + path + "'.");
+
+  CodebooksFileHeader header;
+  std::memcpy(header.magic, codebooksFileMagic, sizeof(codebooksFileMagic));
+  header.version = codebooksFileVersion;
+  header.dimension = _dimension;
+  header.nbSubspaces = _nbSubspaces;
+  header.nbCentroids = nbCentroids;
+
+  std::ofstream file(path, std::ios::binary);
+  if(!file.is_open() ||
+     !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+     !file.write(reinterpret_cast<const char*>(_centroids.data()), _centroids.size() * sizeof(float)))
+    throw std::runtime_error("Can't save the product quantizer codebooks file '" + path + "'.");
+}
+
+void ProductQuantizer::load(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Can't open the product quantizer codebooks file '" + path + "'.");
+
+  CodebooksFileHeader header;
+  if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+     std::memcmp(header.magic, codebooksFileMagic, sizeof(codebooksFileMagic)) != 0 ||
+     header.version != codebooksFileVersion ||
+     header.nbCentroids != nbCentroids)
+    throw std::runtime_error("Invalid product quantizer codebooks file '" + path + "'.");
+
+  *this = ProductQuantizer(header.dimension, header.nbSubspaces);
+
+  _centroids.resize(getDistanceTableSize() * _subspaceDimension);
+  if(!file.read(reinterpret_cast<char*>(_centroids.data()), _centroids.size() * sizeof(float)))
+  {
+    _centroids.clear();
+    throw std::runtime_error("Truncated product quantizer codebooks file '" + path + "'.");
+  }
+
+  ALICEVISION_LOG_TRACE("Product quantizer loaded from '" << path << "' (dimension: " << _dimension
+                        << ", # subspaces: " << _nbSubspaces << ").");
+}
+
+void saveCompressedDescsToBinFile(const std::string& path, const std::vector<unsigned char>& codes, int codeSize)
+{
+  assert(codes.size() % codeSize == 0);
+
+  std::ofstream file(path, std::ios::binary);
+  const std::size_t nbDescriptors = codes.size() / codeSize;
+  if(!file.is_open() ||
+     !file.write(reinterpret_cast<const char*>(&nbDescriptors), sizeof(std::size_t)) ||
+     !file.write(reinterpret_cast<const char*>(codes.data()), codes.size()))
+    throw std::runtime_error("Can't save compressed descriptors binary file '" + path + "'.");
+}
+
+void loadCompressedDescsFromBinFile(const std::string& path, std::vector<unsigned char>& codes, int codeSize)
+{
+  std::ifstream file(path, std::ios::binary);
+  if(!file.is_open())
+    throw std::runtime_error("Can't load compressed descriptors binary file, can't open '" + path + "'.");
+
+  std::size_t nbDescriptors = 0;
+  if(!file.read(reinterpret_cast<char*>(&nbDescriptors), sizeof(std::size_t)))
+    throw std::runtime_error("Invalid compressed descriptors binary file '" + path + "'.");
+
+  codes.resize(nbDescriptors * codeSize);
+  if(!file.read(reinterpret_cast<char*>(codes.data()), codes.size()))
+    throw std::runtime_error("Truncated compressed descriptors binary file '" + path + "'.");
+}
+
+} // namespace feature
+} // namespace aliceVision
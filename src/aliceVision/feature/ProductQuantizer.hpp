@@ -0,0 +1,194 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Product quantizer, to store and match compressed descriptors.
+ *
+ * The descriptor space is split in nbSubspaces contiguous subspaces, each of them is quantized
+ * with its own codebook of 256 centroids (k-means). A descriptor is stored as nbSubspaces bytes,
+ * the indexes of the nearest centroid in each subspace (16 bytes for a SIFT with 16 subspaces,
+ * instead of 128 bytes).
+ *
+ * The compressed descriptors are matched with an asymmetric distance: the query descriptor is not
+ * quantized, the squared distances between its subvectors and all the centroids are computed once
+ * in a table, then the distance to a compressed descriptor is the sum of nbSubspaces table entries.
+ *
+ * @see Jegou et al., Product quantization for nearest neighbor search, PAMI 2011
+ */
+class ProductQuantizer
+{
+public:
+  /// number of centroids per subspace (a code element is an unsigned char)
+  static constexpr int nbCentroids = 256;
+
+  ProductQuantizer() = default;
+
+  /**
+   * @param[in] dimension The descriptor dimension
+   * @param[in] nbSubspaces The number of subspaces (bytes per compressed descriptor),
+   *            the dimension should be a multiple of the number of subspaces
+   */
+  ProductQuantizer(int dimension, int nbSubspaces);
+
+  int getDimension() const { return _dimension; }
+  int getNbSubspaces() const { return _nbSubspaces; }
+  int getSubspaceDimension() const { return _subspaceDimension; }
+
+  /// size of a compressed descriptor, in bytes
+  int getCodeSize() const { return _nbSubspaces; }
+
+  /// size of the distance table of a query, see computeDistanceTable
+  std::size_t getDistanceTableSize() const { return static_cast<std::size_t>(_nbSubspaces) * nbCentroids; }
+
+  bool isTrained() const { return !_centroids.empty(); }
+
+  /// same codebooks (the codes of the two quantizers can be compared)
+  bool operator==(const ProductQuantizer& other) const
+  {
+    return this == &other ||
+           (_dimension == other._dimension && _nbSubspaces == other._nbSubspaces && _centroids == other._centroids);
+  }
+
+  /**
+   * @brief Train the codebooks of each subspace with k-means
+   * @param[in] descriptors The training descriptors (row major, nbDescriptors x dimension)
+   * @param[in] nbDescriptors The number of training descriptors (at least nbCentroids)
+   * @param[in] nbIterations The number of k-means iterations
+   * @param[in] seed The seed of the centroids initialization
+   */
+  void train(const float* descriptors, std::size_t nbDescriptors, int nbIterations = 20, unsigned int seed = 0);
+
+  /**
+   * @brief Compress a descriptor
+   * @param[in] descriptor The descriptor (dimension values)
+   * @param[out] code The compressed descriptor (nbSubspaces values)
+   */
+  template<typename T>
+  void encode(const T* descriptor, unsigned char* code) const
+  {
+    assert(isTrained());
+    for(int s = 0; s < _nbSubspaces; ++s)
+    {
+      const T* subvector = descriptor + s * _subspaceDimension;
+      float bestDistance = std::numeric_limits<float>::max();
+      int bestCentroid = 0;
+      for(int c = 0; c < nbCentroids; ++c)
+      {
+        const float distance = subspaceDistance(subvector, getCentroid(s, c));
+        if(distance < bestDistance)
+        {
+          bestDistance = distance;
+          bestCentroid = c;
+        }
+      }
+      code[s] = static_cast<unsigned char>(bestCentroid);
+    }
+  }
+
+  /**
+   * @brief Decompress a descriptor (approximation of the original descriptor)
+   * @param[in] code The compressed descriptor (nbSubspaces values)
+   * @param[out] descriptor The decompressed descriptor (dimension values)
+   */
+  void decode(const unsigned char* code, float* descriptor) const;
+
+  /**
+   * @brief Compute the squared distances between the subvectors of a query descriptor and all the centroids
+   * @param[in] query The query descriptor (dimension values)
+   * @param[out] table The distance table (getDistanceTableSize() values)
+   */
+  template<typename T>
+  void computeDistanceTable(const T* query, float* table) const
+  {
+    assert(isTrained());
+    for(int s = 0; s < _nbSubspaces; ++s)
+    {
+      const T* subvector = query + s * _subspaceDimension;
+      for(int c = 0; c < nbCentroids; ++c)
+        table[s * nbCentroids + c] = subspaceDistance(subvector, getCentroid(s, c));
+    }
+  }
+
+  /**
+   * @brief Asymmetric squared distance between a query and a compressed descriptor
+   * @param[in] table The distance table of the query, see computeDistanceTable
+   * @param[in] code The compressed descriptor
+   */
+  inline float asymmetricDistance(const float* table, const unsigned char* code) const
+  {
+    float distance = 0.f;
+    for(int s = 0; s < _nbSubspaces; ++s)
+      distance += table[s * nbCentroids + code[s]];
+    return distance;
+  }
+
+  /**
+   * @brief Save the codebooks in a binary file
+   * @param[in] path The codebooks file path
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @brief Load the codebooks from a binary file
+   * @param[in] path The codebooks file path
+   */
+  void load(const std::string& path);
+
+private:
+  const float* getCentroid(int subspace, int centroid) const
+  {
+    return _centroids.data() + (static_cast<std::size_t>(subspace) * nbCentroids + centroid) * _subspaceDimension;
+  }
+
+  template<typename T>
+  float subspaceDistance(const T* subvector, const float* centroid) const
+  {
+    float distance = 0.f;
+    for(int d = 0; d < _subspaceDimension; ++d)
+    {
+      const float diff = static_cast<float>(subvector[d]) - centroid[d];
+      distance += diff * diff;
+    }
+    return distance;
+  }
+
+  int _dimension = 0;
+  int _nbSubspaces = 0;
+  int _subspaceDimension = 0;
+  /// centroids (nbSubspaces x nbCentroids x subspaceDimension)
+  std::vector<float> _centroids;
+};
+
+/**
+ * @brief Save compressed descriptors in a binary file (same layout as the descriptors files:
+ *        the number of descriptors, then the codes)
+ * @param[in] path The compressed descriptors file path
+ * @param[in] codes The compressed descriptors (nbDescriptors x codeSize)
+ * @param[in] codeSize The size of a compressed descriptor
+ */
+void saveCompressedDescsToBinFile(const std::string& path, const std::vector<unsigned char>& codes, int codeSize);
+
+/**
+ * @brief Load compressed descriptors from a binary file
+ * @param[in] path The compressed descriptors file path
+ * @param[out] codes The compressed descriptors (nbDescriptors x codeSize)
+ * @param[in] codeSize The size of a compressed descriptor
+ */
+void loadCompressedDescsFromBinFile(const std::string& path, std::vector<unsigned char>& codes, int codeSize);
+
+} // namespace feature
+} // namespace aliceVision
@@ -7,6 +7,7 @@
 
 #include "aliceVision/feature/akaze/AKAZE.hpp"
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 namespace aliceVision {
 namespace feature {
@@ -102,76 +103,73 @@ float AKAZE::ComputeAutomaticContrastFactor( const Image<float> & src , const fl
 
 const float fderivative_factor = 1.5f;      // Factor for the multiscale derivatives
 
-void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const int q , const int nbSlice ,
+void AKAZE::ComputeAKAZESliceEvolution( const Image<float> & src , const int p , const int q , const int nbSlice ,
                         const float sigma0 , // first octave initial scale
                         const float contrast_factor ,
                         Image<float> & Li , // Diffusion image
-                        Image<float> & Lx , // X derivatives
-                        Image<float> & Ly , // Y derivatives
-                        Image<float> & Lhess ) // Det(Hessian)
+                        TSliceBuffers & buffers ) // Work images
 {
-  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
-  const float ratio = 1 << p; //pow(2,p);
-  const int sigma_scale = MathTrait<float>::round(sigma_cur * fderivative_factor / ratio);
-
-  Image<float> smoothed;
   if( p == 0 && q == 0 )
   {
     // Compute new image
     ImageGaussianFilter( src , sigma0 , Li, 0, 0) ;
+    return;
   }
-  else
-  {
-    // general case
-    Image<float> in ;
-    if( q == 0 )  {
-      ImageHalfSample( src , in ) ;
-    }
-    else {
-      in = src ;
-    }
 
-    const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice ) ;
+  // general case
+  if( q == 0 )  {
+    ImageHalfSample( src , Li ) ;
+  }
+  else {
+    Li = src ;
+  }
 
-    // Compute non linear timing between two consecutive slices
-    const float t_prev = 0.5f * ( sigma_prev * sigma_prev ) ;
-    const float t_cur  = 0.5f * ( sigma_cur * sigma_cur ) ;
-    const float total_cycle_time = t_cur - t_prev ;
+  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
+  const float sigma_prev = ( q == 0 ) ? Sigma( sigma0 , p - 1 , nbSlice - 1 , nbSlice ) : Sigma( sigma0 , p , q - 1 , nbSlice ) ;
 
-    // Compute first derivatives (Scharr scale 1, non normalized) for diffusion coef
-    ImageGaussianFilter( in , 1.f , smoothed, 0, 0 ) ;
+  // Compute non linear timing between two consecutive slices
+  const float t_prev = 0.5f * ( sigma_prev * sigma_prev ) ;
+  const float t_cur  = 0.5f * ( sigma_cur * sigma_cur ) ;
+  const float total_cycle_time = t_cur - t_prev ;
 
-    ImageScharrXDerivative( smoothed , Lx , false ) ;
-    ImageScharrYDerivative( smoothed , Ly , false ) ;
+  // Compute diffusion coefficient from the first derivatives (Scharr scale 1, non normalized)
+  ImageGaussianFilter( Li , 1.f , buffers.smoothed, 0, 0 ) ;
+  ImageScharrPeronaMalikG2DiffusionCoef( buffers.smoothed , contrast_factor , buffers.diff ) ;
 
-    // Compute diffusion coefficient
-    Image<float> & diff = smoothed; // diffusivity image (reuse existing memory)
-    ImagePeronaMalikG2DiffusionCoef( Lx , Ly , contrast_factor , diff ) ;
+  // Compute FED cycles
+  std::vector< float > tau ;
+  FEDCycleTimings( total_cycle_time , 0.25f , tau ) ;
+  ImageFEDCycle( Li , buffers.diff , tau , buffers.tmp ) ;
+}
 
-    // Compute FED cycles
-    std::vector< float > tau ;
-    FEDCycleTimings( total_cycle_time , 0.25f , tau ) ;
-    ImageFEDCycle( in , diff , tau ) ;
-    Li = in ; // evolution image
-  }
+void AKAZE::ComputeAKAZESliceDerivatives( const Image<float> & Li , const int p , const int q , const int nbSlice ,
+                        const float sigma0 , // first octave initial scale
+                        Image<float> & Lx , // X derivatives
+                        Image<float> & Ly , // Y derivatives
+                        Image<float> & Lhess , // Det(Hessian)
+                        TSliceBuffers & buffers ) // Work images
+{
+  const float sigma_cur = Sigma( sigma0 , p , q , nbSlice );
+  const float ratio = 1 << p; //pow(2,p);
+  const int sigma_scale = MathTrait<float>::round(sigma_cur * fderivative_factor / ratio);
 
   // Compute Hessian response
-  if( p == 0 && q == 0 )
-  {
-    smoothed = Li ;
-  }
-  else
+  const Image<float> * smoothed = &Li;
+  if( p != 0 || q != 0 )
   {
     // Add a little smooth to image (for robustness of Scharr derivatives)
-    ImageGaussianFilter( Li , 1.f , smoothed, 0, 0 );
+    ImageGaussianFilter( Li , 1.f , buffers.smoothed, 0, 0 );
+    smoothed = &buffers.smoothed;
   }
 
   // Compute true first derivatives
-  ImageScaledScharrXDerivative( smoothed , Lx , sigma_scale ) ;
-  ImageScaledScharrYDerivative( smoothed , Ly , sigma_scale ) ;
+  ImageScaledScharrXDerivative( *smoothed , Lx , sigma_scale ) ;
+  ImageScaledScharrYDerivative( *smoothed , Ly , sigma_scale ) ;
 
   // Second order spatial derivatives
-  Image<float> Lxx, Lyy, Lxy;
+  Image<float> & Lxx = buffers.Lxx;
+  Image<float> & Lxy = buffers.Lxy;
+  Image<float> & Lyy = buffers.Lyy;
   ImageScaledScharrXDerivative( Lx , Lxx , sigma_scale ) ;
   ImageScaledScharrYDerivative( Lx , Lxy , sigma_scale ) ;
   ImageScaledScharrYDerivative( Ly , Lyy , sigma_scale ) ;
@@ -180,11 +178,24 @@ void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const in
   Ly *= static_cast<float>( sigma_scale ) ;
 
   // Compute Determinant of the Hessian
-  Lhess.resize(Li.Width(), Li.Height());
+  Lhess.resize(Li.Width(), Li.Height(), false);
   const float sigma_size_quad = Square(sigma_scale) * Square(sigma_scale);
   Lhess.array() = (Lxx.array()*Lyy.array()-Lxy.array().square())*sigma_size_quad;
 }
 
+void AKAZE::ComputeAKAZESlice( const Image<float> & src , const int p , const int q , const int nbSlice ,
+                        const float sigma0 , // first octave initial scale
+                        const float contrast_factor ,
+                        Image<float> & Li , // Diffusion image
+                        Image<float> & Lx , // X derivatives
+                        Image<float> & Ly , // Y derivatives
+                        Image<float> & Lhess ) // Det(Hessian)
+{
+  TSliceBuffers buffers;
+  ComputeAKAZESliceEvolution( src , p , q , nbSlice , sigma0 , contrast_factor , Li , buffers ) ;
+  ComputeAKAZESliceDerivatives( Li , p , q , nbSlice , sigma0 , Lx , Ly , Lhess , buffers ) ;
+}
+
 template <typename Image>
 void convert_scale(Image &src)
 {
@@ -208,33 +219,64 @@ AKAZE::AKAZE(const Image<float> & in, const AKAZEConfig & options):
 void AKAZE::Compute_AKAZEScaleSpace(void)
 {
   float contrast_factor = ComputeAutomaticContrastFactor( in_, 0.7f ) ;
-  Image<float> input = in_;
 
-  // Octave computation
-  for( int p = 0 ; p < options_.iNbOctave ; ++p )
+  const int nbSlices = options_.iNbOctave * options_.iNbSlicePerOctave;
+  evolution_.clear();
+  evolution_.resize(nbSlices);
+
+  // Nonlinear diffusion: each slice is computed from the previous one,
+  // the filters and the FED steps are parallelized on the rows of the slice
   {
-    contrast_factor *= (p == 0) ? 1.f : 0.75f;
+    TSliceBuffers buffers;
 
-    for( int q = 0 ; q < options_.iNbSlicePerOctave ; ++q )
+    for( int p = 0 ; p < options_.iNbOctave ; ++p )
     {
-      evolution_.emplace_back(TEvolution());
-      TEvolution & evo = evolution_.back();
-      // Compute Slice at (p,q) index
-      ComputeAKAZESlice( input , p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
-        evo.cur , evo.Lx , evo.Ly , evo.Lhess );
+      contrast_factor *= (p == 0) ? 1.f : 0.75f;
+
+      for( int q = 0 ; q < options_.iNbSlicePerOctave ; ++q )
+      {
+        const int sliceIndex = p * options_.iNbSlicePerOctave + q;
+        // Input of the slice: the input image or the previous slice
+        const Image<float> & input = (sliceIndex == 0) ? in_ : evolution_[sliceIndex - 1].cur;
 
-      // Prepare inputs for next slice
-      input = evo.cur;
+        // Compute Slice at (p,q) index
+        ComputeAKAZESliceEvolution( input , p , q , options_.iNbSlicePerOctave , options_.fSigma0 , contrast_factor,
+          evolution_[sliceIndex].cur , buffers );
 
-      // DEBUG octave image
+        // DEBUG octave image
 #if DEBUG_OCTAVE
-      std::stringstream str ;
-      str << "./" << "_oct_" << p << "_" << q << ".png" ;
-      Image<float> tmp = evo.cur;
-      convert_scale(tmp);
-      Image< unsigned char > tmp2 ((tmp*255).cast<unsigned char>());
-      writeImage(str.str(), tmp2);
+        std::stringstream str ;
+        str << "./" << "_oct_" << p << "_" << q << ".png" ;
+        Image<float> tmp = evolution_[sliceIndex].cur;
+        convert_scale(tmp);
+        Image< unsigned char > tmp2 ((tmp*255).cast<unsigned char>());
+        writeImage(str.str(), tmp2);
 #endif // DEBUG_OCTAVE
+      }
+    }
+  }
+
+  // Derivatives and Hessian responses: the slices are independent,
+  // they are computed in parallel if there are enough slices to keep the threads busy
+  // (otherwise the filters of each slice are parallelized)
+  #pragma omp parallel if(nbSlices >= omp_get_max_threads())
+  {
+    TSliceBuffers buffers;
+
+    // the filters have their own parallel loops: keep them serial when the slices are
+    // computed in parallel, nested parallelism would run nbThreads * nbThreads threads
+    if(omp_get_num_threads() > 1)
+      omp_set_num_threads(1);
+
+    #pragma omp for schedule(dynamic)
+    for( int sliceIndex = 0 ; sliceIndex < nbSlices ; ++sliceIndex )
+    {
+      const int p = sliceIndex / options_.iNbSlicePerOctave;
+      const int q = sliceIndex % options_.iNbSlicePerOctave;
+      TEvolution & evo = evolution_[sliceIndex];
+
+      ComputeAKAZESliceDerivatives( evo.cur , p , q , options_.iNbSlicePerOctave , options_.fSigma0 ,
+        evo.Lx , evo.Ly , evo.Lhess , buffers );
     }
   }
 }
@@ -49,7 +49,9 @@ struct AKAZEConfig
     iNbSlicePerOctave(4),
     fSigma0(1.6f),
     fThreshold(0.0008f),
-    fDesc_factor(1.f)
+    fDesc_factor(1.f),
+    iGridSize(4),
+    iMaxTotalKeypoints(0)
   {
   }
 
@@ -58,6 +60,8 @@ struct AKAZEConfig
   float fSigma0;          ///< Initial sigma offset (used to suppress low level noise)
   float fThreshold;       ///< Hessian determinant threshold
   float fDesc_factor;     ///< Magnifier used to describe an interest point
+  int iGridSize;          ///< Grid size of the keypoint repartition constraint
+  int iMaxTotalKeypoints; ///< Max number of described keypoints (0: no limit)
 };
 
 struct AKAZEKeypoint{
@@ -87,6 +91,16 @@ struct TEvolution
     Lhess;  ///< Current Determinant of Hessian
 };
 
+/// Work images of the slice computations (reused from one slice to the next)
+struct TSliceBuffers
+{
+  image::Image<float>
+    smoothed,       ///< Smoothed image
+    diff,           ///< Diffusion coefficients
+    tmp,            ///< FED step image
+    Lxx, Lxy, Lyy;  ///< Second order derivatives
+};
+
 // AKAZE Class Declaration
 class AKAZE {
 
@@ -141,6 +155,31 @@ public:
     image::Image<float> & Lhess // Det(Hessian)
     );
 
+  /// Compute the nonlinear diffusion image of an AKAZE slice from the previous slice
+  static void ComputeAKAZESliceEvolution(
+    const image::Image<float> & src, // Previous slice (or input image for the first slice)
+    const int p , // octave index
+    const int q , // slice index
+    const int nbSlice , // slices per octave
+    const float sigma0 , // first octave initial scale
+    const float contrast_factor ,
+    image::Image<float> & Li, // Diffusion image
+    TSliceBuffers & buffers // Work images
+    );
+
+  /// Compute the derivatives and the Hessian response of an AKAZE slice
+  static void ComputeAKAZESliceDerivatives(
+    const image::Image<float> & Li, // Diffusion image
+    const int p , // octave index
+    const int q , // slice index
+    const int nbSlice , // slices per octave
+    const float sigma0 , // first octave initial scale
+    image::Image<float> & Lx, // X derivatives
+    image::Image<float> & Ly, // Y derivatives
+    image::Image<float> & Lhess, // Det(Hessian)
+    TSliceBuffers & buffers // Work images
+    );
+
   /// Compute Contrast Factor
   static float ComputeAutomaticContrastFactor(
     const image::Image<float> & src,
@@ -6,6 +6,9 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "ImageDescriber_AKAZE.hpp"
+#include <aliceVision/feature/gridSelection.hpp>
+
+#include <algorithm>
 
 namespace aliceVision {
 namespace feature {
@@ -28,6 +31,29 @@ bool ImageDescriber_AKAZE::describe(const image::Image<float>& image,
   akaze.Feature_Detection(kpts);
   akaze.Do_Subpixel_Refinement(kpts);
 
+  // Keypoint budget: select the strongest keypoints of each grid cell before their description
+  if(_params._options.iGridSize > 0 && _params._options.iMaxTotalKeypoints > 0)
+  {
+    // Feature masking (the masked keypoints don't use the budget)
+    if(mask)
+    {
+      const image::Image<unsigned char> & maskIma = *mask;
+      kpts.erase(std::remove_if(kpts.begin(), kpts.end(), [&](const AKAZEKeypoint& kpt) { return maskIma(kpt.y, kpt.x) > 0; }), kpts.end());
+    }
+
+    const std::size_t gridSize = _params._options.iGridSize;
+    const std::size_t maxTotalKeypoints = _params._options.iMaxTotalKeypoints;
+    std::vector<std::size_t> selectedIndexes;
+    gridSelection(kpts, [](const AKAZEKeypoint& kpt) { return kpt.response; }, image.Width(), image.Height(),
+                  gridSize, maxTotalKeypoints / (gridSize * gridSize), maxTotalKeypoints, selectedIndexes);
+
+    std::vector<AKAZEKeypoint> selectedKpts;
+    selectedKpts.reserve(selectedIndexes.size());
+    for(std::size_t i : selectedIndexes)
+      selectedKpts.push_back(kpts[i]);
+    kpts.swap(selectedKpts);
+  }
+
   allocate(regions);
 
   switch(_params._eAkazeDescriptor)
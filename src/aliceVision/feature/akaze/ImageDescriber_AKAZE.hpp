@@ -16,6 +16,8 @@
 #include <aliceVision/feature/akaze/descriptorMLDB.hpp>
 #include <aliceVision/feature/akaze/descriptorMSURF.hpp>
 
+#include <algorithm>
+
 using namespace std;
 
 namespace aliceVision {
@@ -103,6 +105,19 @@ public:
     return 4 * memoryConsuption + (3 * width * height * sizeof(float)) + 1.5 * std::pow(2,30); // add arbitrary 1.5 GB
   }
 
+  /**
+   * @brief Get the maximum number of threads that the image describer
+   * can keep busy on the feature extraction of a single image of the given dimension.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return maximum number of threads
+   */
+  int getMaxNbThreads(std::size_t width, std::size_t height) const override
+  {
+    // the scale space filters are parallelized on the rows: keep at least 512x512 pixels per thread
+    return std::max(1, static_cast<int>(width * height / (512 * 512)));
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -121,15 +136,24 @@ public:
     switch(preset)
     {
       case EImageDescriberPreset::LOW:
+        _params._options.fThreshold = AKAZEConfig().fThreshold;
+        _params._options.iMaxTotalKeypoints = 1000;
+      break;
       case EImageDescriberPreset::MEDIUM:
+        _params._options.fThreshold = AKAZEConfig().fThreshold;
+        _params._options.iMaxTotalKeypoints = 5000;
+      break;
       case EImageDescriberPreset::NORMAL:
         _params._options.fThreshold = AKAZEConfig().fThreshold;
+        _params._options.iMaxTotalKeypoints = 10000;
       break;
       case EImageDescriberPreset::HIGH:
         _params._options.fThreshold = AKAZEConfig().fThreshold/10.;
+        _params._options.iMaxTotalKeypoints = 50000;
       break;
       case EImageDescriberPreset::ULTRA:
        _params._options.fThreshold = AKAZEConfig().fThreshold/100.;
+       _params._options.iMaxTotalKeypoints = 100000;
       break;
       default:
         throw std::out_of_range("Invalid image describer preset enum");
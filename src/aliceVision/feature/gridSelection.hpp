@@ -0,0 +1,111 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief Select keypoints with a spatial repartition constraint, before their description.
+ *
+ * The keypoints are visited by decreasing score (scale, response, ...):
+ * the first keypointsPerCell keypoints of each cell of a gridSize x gridSize grid are selected,
+ * then the best other keypoints complete the selection up to maxNbKeypoints keypoints.
+ *
+ * @param[in] keypoints The keypoints (with x and y members, in image coordinates)
+ * @param[in] nbKeypoints The number of keypoints
+ * @param[in] score Functor returning the score of a keypoint (the higher the better)
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @param[in] gridSize The number of cells per grid row/column
+ * @param[in] keypointsPerCell The number of keypoints selected in each cell
+ * @param[in] maxNbKeypoints The maximum number of selected keypoints
+ * @param[out] selectedIndexes The indexes of the selected keypoints, in the input order
+ */
+template <typename KeypointT, typename ScoreFunctor>
+void gridSelection(const KeypointT* keypoints,
+                   std::size_t nbKeypoints,
+                   ScoreFunctor score,
+                   int width,
+                   int height,
+                   std::size_t gridSize,
+                   std::size_t keypointsPerCell,
+                   std::size_t maxNbKeypoints,
+                   std::vector<std::size_t>& selectedIndexes)
+{
+  selectedIndexes.clear();
+
+  std::vector<std::size_t> sortedIndexes(nbKeypoints);
+  std::iota(sortedIndexes.begin(), sortedIndexes.end(), 0);
+
+  if(nbKeypoints <= maxNbKeypoints || gridSize == 0)
+  {
+    selectedIndexes.swap(sortedIndexes);
+    return;
+  }
+
+  std::stable_sort(sortedIndexes.begin(), sortedIndexes.end(), [&](std::size_t a, std::size_t b) {
+    return score(keypoints[a]) > score(keypoints[b]);
+  });
+
+  const double cellWidth = width / double(gridSize);
+  const double cellHeight = height / double(gridSize);
+  std::vector<std::size_t> countPerCell(gridSize * gridSize, 0);
+  std::vector<std::size_t> rejectedIndexes;
+
+  selectedIndexes.reserve(maxNbKeypoints);
+
+  for(std::size_t i : sortedIndexes)
+  {
+    const KeypointT& keypoint = keypoints[i];
+    const std::size_t cellX = std::min(static_cast<std::size_t>(std::max(0.0, keypoint.x / cellWidth)), gridSize - 1);
+    const std::size_t cellY = std::min(static_cast<std::size_t>(std::max(0.0, keypoint.y / cellHeight)), gridSize - 1);
+
+    std::size_t& count = countPerCell[cellY * gridSize + cellX];
+    if(count < keypointsPerCell && selectedIndexes.size() < maxNbKeypoints)
+    {
+      ++count;
+      selectedIndexes.push_back(i);
+    }
+    else
+    {
+      rejectedIndexes.push_back(i);
+    }
+  }
+
+  // not enough keypoints in the cells (empty regions in the grid for example):
+  // add the best other ones, without repartition constraint
+  const std::size_t remainingElements = std::min(rejectedIndexes.size(), maxNbKeypoints - selectedIndexes.size());
+  selectedIndexes.insert(selectedIndexes.end(), rejectedIndexes.begin(), rejectedIndexes.begin() + remainingElements);
+
+  std::sort(selectedIndexes.begin(), selectedIndexes.end());
+}
+
+/**
+ * @brief Select keypoints with a spatial repartition constraint, before their description.
+ * @see gridSelection
+ */
+template <typename KeypointT, typename ScoreFunctor>
+void gridSelection(const std::vector<KeypointT>& keypoints,
+                   ScoreFunctor score,
+                   int width,
+                   int height,
+                   std::size_t gridSize,
+                   std::size_t keypointsPerCell,
+                   std::size_t maxNbKeypoints,
+                   std::vector<std::size_t>& selectedIndexes)
+{
+  gridSelection(keypoints.data(), keypoints.size(), score, width, height, gridSize, keypointsPerCell, maxNbKeypoints, selectedIndexes);
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,63 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/gridSelection.hpp>
+
+#include <vector>
+
+#define BOOST_TEST_MODULE gridSelection
+#include <boost/test/included/unit_test.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+struct TestKeypoint
+{
+  float x;
+  float y;
+  float score;
+};
+
+const auto getScore = [](const TestKeypoint& keypoint) { return keypoint.score; };
+
+BOOST_AUTO_TEST_CASE(gridSelection_noLimit)
+{
+  const std::vector<TestKeypoint> keypoints = {{1.f, 1.f, 1.f}, {2.f, 2.f, 3.f}, {9.f, 9.f, 2.f}};
+
+  std::vector<std::size_t> selected;
+  gridSelection(keypoints, getScore, 10, 10, 2, 1, 3, selected);
+
+  BOOST_CHECK_EQUAL(selected.size(), 3);
+  for(std::size_t i = 0; i < selected.size(); ++i)
+    BOOST_CHECK_EQUAL(selected[i], i);
+}
+
+BOOST_AUTO_TEST_CASE(gridSelection_repartition)
+{
+  // 10 keypoints in the top left cell, 2 keypoints in the bottom right cell (lower scores)
+  std::vector<TestKeypoint> keypoints;
+  for(int i = 0; i < 10; ++i)
+    keypoints.push_back({1.f + i * 0.1f, 1.f, 10.f + i});
+  keypoints.push_back({8.f, 8.f, 1.f});
+  keypoints.push_back({9.f, 9.f, 2.f});
+
+  std::vector<std::size_t> selected;
+
+  // 2 keypoints per cell: the best ones of each cell
+  gridSelection(keypoints, getScore, 10, 10, 2, 2, 4, selected);
+  BOOST_CHECK_EQUAL(selected.size(), 4);
+  BOOST_CHECK_EQUAL(selected[0], 8);
+  BOOST_CHECK_EQUAL(selected[1], 9);
+  BOOST_CHECK_EQUAL(selected[2], 10);
+  BOOST_CHECK_EQUAL(selected[3], 11);
+
+  // empty cells: the selection is completed with the best other keypoints
+  gridSelection(keypoints, getScore, 10, 10, 2, 2, 6, selected);
+  BOOST_CHECK_EQUAL(selected.size(), 6);
+  BOOST_CHECK_EQUAL(selected[0], 6);
+  BOOST_CHECK_EQUAL(selected[1], 7);
+  BOOST_CHECK_EQUAL(selected[5], 11);
+}
@@ -0,0 +1,130 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/ProductQuantizer.hpp>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE productQuantizer
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+namespace {
+
+/// random descriptors around a few cluster centers
+std::vector<float> randomDescriptors(std::size_t nbDescriptors, int dimension, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<float> centerDistribution(0.f, 255.f);
+  std::normal_distribution<float> noiseDistribution(0.f, 2.f);
+
+  std::vector<float> centers(8 * dimension);
+  for(float& value : centers)
+    value = centerDistribution(generator);
+
+  std::vector<float> descriptors(nbDescriptors * dimension);
+  for(std::size_t i = 0; i < nbDescriptors; ++i)
+    for(int d = 0; d < dimension; ++d)
+      descriptors[i * dimension + d] = centers[(i % 8) * dimension + d] + noiseDistribution(generator);
+  return descriptors;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(productQuantizer_invalid)
+{
+  BOOST_CHECK_THROW(ProductQuantizer(128, 0), std::invalid_argument);
+  BOOST_CHECK_THROW(ProductQuantizer(128, 3), std::invalid_argument);
+
+  // not enough training descriptors
+  ProductQuantizer quantizer(16, 4);
+  const std::vector<float> descriptors = randomDescriptors(100, 16, 0);
+  BOOST_CHECK_THROW(quantizer.train(descriptors.data(), 100), std::runtime_error);
+  BOOST_CHECK(!quantizer.isTrained());
+}
+
+BOOST_AUTO_TEST_CASE(productQuantizer_encodeDecode)
+{
+  const int dimension = 32;
+  const std::size_t nbDescriptors = 2000;
+  const std::vector<float> descriptors = randomDescriptors(nbDescriptors, dimension, 0);
+
+  ProductQuantizer quantizer(dimension, 8);
+  quantizer.train(descriptors.data(), nbDescriptors, 10);
+  BOOST_CHECK(quantizer.isTrained());
+  BOOST_CHECK_EQUAL(quantizer.getCodeSize(), 8);
+
+  std::vector<unsigned char> code(quantizer.getCodeSize());
+  std::vector<float> decoded(dimension);
+  std::vector<float> distanceTable(quantizer.getDistanceTableSize());
+
+  double quantizationError = 0.0;
+  for(std::size_t i = 0; i < nbDescriptors; ++i)
+  {
+    const float* descriptor = descriptors.data() + i * dimension;
+    quantizer.encode(descriptor, code.data());
+    quantizer.decode(code.data(), decoded.data());
+
+    float squaredError = 0.f;
+    for(int d = 0; d < dimension; ++d)
+      squaredError += (descriptor[d] - decoded[d]) * (descriptor[d] - decoded[d]);
+    quantizationError += squaredError;
+
+    // the asymmetric distance to its own code is the quantization error
+    quantizer.computeDistanceTable(descriptor, distanceTable.data());
+    BOOST_CHECK_CLOSE(quantizer.asymmetricDistance(distanceTable.data(), code.data()), squaredError, 1e-3);
+  }
+
+  // the quantization error is small compared to the noise (2 per dimension)
+  BOOST_CHECK_LT(quantizationError / nbDescriptors, dimension * 4.0 * 1.5);
+}
+
+BOOST_AUTO_TEST_CASE(productQuantizer_io)
+{
+  const int dimension = 16;
+  const std::size_t nbDescriptors = 500;
+  const std::vector<float> descriptors = randomDescriptors(nbDescriptors, dimension, 1);
+
+  ProductQuantizer quantizer(dimension, 4);
+  quantizer.train(descriptors.data(), nbDescriptors, 5);
+
+  const std::string codebooksPath = "productQuantizer_test.pq";
+  quantizer.save(codebooksPath);
+
+  ProductQuantizer loadedQuantizer;
+  loadedQuantizer.load(codebooksPath);
+  std::remove(codebooksPath.c_str());
+
+  BOOST_CHECK_EQUAL(loadedQuantizer.getDimension(), dimension);
+  BOOST_CHECK_EQUAL(loadedQuantizer.getNbSubspaces(), 4);
+
+  // same compression with both quantizers
+  std::vector<unsigned char> codes(nbDescriptors * quantizer.getCodeSize());
+  for(std::size_t i = 0; i < nbDescriptors; ++i)
+  {
+    std::vector<unsigned char> code(quantizer.getCodeSize());
+    std::vector<unsigned char> loadedCode(quantizer.getCodeSize());
+    quantizer.encode(descriptors.data() + i * dimension, code.data());
+    loadedQuantizer.encode(descriptors.data() + i * dimension, loadedCode.data());
+    BOOST_CHECK(code == loadedCode);
+    std::copy(code.begin(), code.end(), codes.begin() + i * quantizer.getCodeSize());
+  }
+
+  // compressed descriptors file
+  const std::string descsPath = "productQuantizer_test.pqdesc";
+  saveCompressedDescsToBinFile(descsPath, codes, quantizer.getCodeSize());
+  std::vector<unsigned char> loadedCodes;
+  loadCompressedDescsFromBinFile(descsPath, loadedCodes, quantizer.getCodeSize());
+  std::remove(descsPath.c_str());
+  BOOST_CHECK(codes == loadedCodes);
+
+  BOOST_CHECK_THROW(loadedQuantizer.load("unexisting.pq"), std::runtime_error);
+}
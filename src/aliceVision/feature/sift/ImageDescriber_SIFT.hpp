@@ -77,6 +77,18 @@ public:
     return _imageDescriberImpl->getMemoryConsumption(width, height);
   }
 
+  /**
+   * @brief Get the maximum number of threads that the image describer
+   * can keep busy on the feature extraction of a single image of the given dimension.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return maximum number of threads
+   */
+  int getMaxNbThreads(std::size_t width, std::size_t height) const override
+  {
+    return _imageDescriberImpl->getMaxNbThreads(width, height);
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -81,6 +81,18 @@ public:
     return getMemoryConsumptionVLFeat(width, height, _params);
   }
 
+  /**
+   * @brief Get the maximum number of threads that the image describer
+   * can keep busy on the feature extraction of a single image of the given dimension.
+   * @param[in] width The image width
+   * @param[in] height The image height
+   * @return maximum number of threads
+   */
+  int getMaxNbThreads(std::size_t width, std::size_t height) const override
+  {
+    return getMaxNbThreadsVLFeat(width, height, _params);
+  }
+
   /**
    * @brief Set image describer always upRight
    * @param[in] upRight
@@ -9,13 +9,16 @@
 
 #include <aliceVision/feature/Descriptor.hpp>
 #include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/gridSelection.hpp>
 #include <aliceVision/feature/regionsFactory.hpp>
+#include <aliceVision/feature/sift/SiftScaleSpace.hpp>
 #include <aliceVision/config.hpp>
 
 extern "C" {
 #include "nonFree/sift/vl/sift.h"
 }
 
+#include <algorithm>
 #include <iostream>
 #include <numeric>
 #include <stdexcept>
@@ -38,7 +41,8 @@ struct SiftParams
              float peakThreshold = 0.04f,
              std::size_t gridSize = 4,
              std::size_t maxTotalKeypoints = 1000,
-             bool rootSift = true)
+             bool rootSift = true,
+             bool nativeScaleSpace = true)
     : _firstOctave(firstOctave)
     , _numOctaves(numOctaves)
     , _numScales(numScales)
@@ -47,6 +51,7 @@ struct SiftParams
     , _gridSize(gridSize)
     , _maxTotalKeypoints(maxTotalKeypoints)
     , _rootSift(rootSift)
+    , _nativeScaleSpace(nativeScaleSpace)
   {}
 
   // Parameters
@@ -65,6 +70,8 @@ struct SiftParams
   std::size_t _maxTotalKeypoints;
   /// see [1]
   bool _rootSift;
+  /// Use the multithreaded SiftScaleSpace instead of the VLFeat filter
+  bool _nativeScaleSpace;
   
   void setPreset(EImageDescriberPreset preset)
   {
@@ -187,6 +194,144 @@ inline std::size_t getMemoryConsumptionVLFeat(std::size_t width, std::size_t hei
   return 4 * pyramidMemoryConsuption + (3 * width * height * sizeof(float)) + (params._maxTotalKeypoints * 128 * sizeof(float));
 }
 
+/**
+ * @brief Get the maximum number of threads that the SIFT extraction
+ * can keep busy on an image of the given dimension.
+ * @param[in] width The image width
+ * @param[in] height The image height
+ * @return maximum number of threads
+ */
+inline int getMaxNbThreadsVLFeat(std::size_t width, std::size_t height, const SiftParams& params)
+{
+  // the VLFeat scale space is sequential, only the descriptors are computed in parallel
+  if(!params._nativeScaleSpace)
+    return 1;
+
+  double scaleFactor = 1.0;
+  if(params._firstOctave > 0)
+    scaleFactor = 1.0 / (1 << params._firstOctave);
+  else if(params._firstOctave < 0)
+    scaleFactor = 1 << -params._firstOctave;
+
+  // the native scale space splits each level in rows: keep at least 512x512 pixels of the first octave per thread
+  const double firstOctaveSize = width * height * scaleFactor * scaleFactor;
+  return std::max(1, static_cast<int>(firstOctaveSize / (512.0 * 512.0)));
+}
+
+/**
+ * @brief Select the keypoints of an octave to describe.
+ *
+ * The masked keypoints are removed. With a keypoint budget (gridSize and maxTotalKeypoints),
+ * only the keypoints that can be kept by the final grid filtering are described:
+ * the largest keypoints of each grid cell and the next largest ones to complete the selection.
+ * The final grid filtering is unchanged, the description of the other keypoints is skipped.
+ *
+ * @param[in] keys The keypoints of the octave
+ * @param[in] nkeys The number of keypoints
+ * @param[in] w The image width
+ * @param[in] h The image height
+ * @param[in] params The SIFT parameters
+ * @param[in] mask The mask (can be null)
+ * @param[out] selectedKeys The indexes of the keypoints to describe
+ */
+template <typename KeypointT>
+void selectSIFTKeypoints(const KeypointT* keys,
+    int nkeys,
+    int w,
+    int h,
+    const SiftParams& params,
+    const image::Image<unsigned char>* mask,
+    std::vector<std::size_t>& selectedKeys)
+{
+  selectedKeys.clear();
+  selectedKeys.reserve(nkeys);
+
+  // Feature masking
+  for(int i = 0; i < nkeys; ++i)
+  {
+    if(mask)
+    {
+      const image::Image<unsigned char> & maskIma = *mask;
+      if(maskIma(keys[i].y, keys[i].x) > 0)
+        continue;
+    }
+    selectedKeys.push_back(i);
+  }
+
+  if(!params._gridSize || !params._maxTotalKeypoints)
+    return;
+
+  std::vector<KeypointT> candidateKeys;
+  candidateKeys.reserve(selectedKeys.size());
+  for(std::size_t i : selectedKeys)
+    candidateKeys.push_back(keys[i]);
+
+  // each keypoint gives at least one feature with its scale:
+  // a keypoint rejected here can't be selected by the final grid filtering
+  const std::size_t nbCells = params._gridSize * params._gridSize;
+  const std::size_t keypointsPerCell = params._maxTotalKeypoints / nbCells;
+  std::vector<std::size_t> selectedCandidates;
+  gridSelection(candidateKeys, [](const KeypointT& key) { return key.sigma; }, w, h,
+                params._gridSize, keypointsPerCell, keypointsPerCell * nbCells + params._maxTotalKeypoints, selectedCandidates);
+
+  for(std::size_t i = 0; i < selectedCandidates.size(); ++i)
+    selectedCandidates[i] = selectedKeys[selectedCandidates[i]];
+  selectedKeys.swap(selectedCandidates);
+}
+
+/**
+ * @brief Compute the orientations and the descriptors of the selected keypoints of an octave, in parallel.
+ *
+ * @param[in] keys The keypoints of the octave
+ * @param[in] selectedKeys The indexes of the keypoints to describe
+ * @param[in] params The SIFT parameters
+ * @param[in] orientation Compute the orientations (upright features otherwise)
+ * @param[in] computeOrientations Functor (double angles[4], const KeypointT&) returning the number of orientations
+ * @param[in] computeDescriptor Functor (vl_sift_pix* descriptor, const KeypointT&, double angle)
+ * @param[in,out] regions The regions the features are added to
+ */
+template <typename T, typename KeypointT, typename OrientationsFunctor, typename DescriptorFunctor>
+void describeSIFTKeypoints(const KeypointT* keys,
+    const std::vector<std::size_t>& selectedKeys,
+    const SiftParams& params,
+    bool orientation,
+    OrientationsFunctor computeOrientations,
+    DescriptorFunctor computeDescriptor,
+    ScalarRegions<SIOPointFeature,T,128>& regions)
+{
+  Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
+  Descriptor<T, 128> descriptor;
+  const int nSelectedKeys = static_cast<int>(selectedKeys.size());
+
+  #pragma omp parallel for private(vlFeatDescriptor, descriptor)
+  for (int k = 0; k < nSelectedKeys; ++k)
+  {
+    const KeypointT& key = keys[selectedKeys[k]];
+
+    double angles [4] = {0.0, 0.0, 0.0, 0.0};
+    int nangles = 1; // by default (1 upright feature)
+    if (orientation)
+    { // compute from 1 to 4 orientations
+      nangles = computeOrientations(angles, key);
+    }
+
+    for (int q=0 ; q < nangles ; ++q)
+    {
+      computeDescriptor(&vlFeatDescriptor[0], key, angles[q]);
+      const SIOPointFeature fp(key.x, key.y,
+        key.sigma, static_cast<float>(angles[q]));
+
+      convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
+
+      #pragma omp critical
+      {
+        regions.Descriptors().push_back(descriptor);
+        regions.Features().push_back(fp);
+      }
+    }
+  }
+}
+
 /**
  * @brief Extract SIFT regions (in float or unsigned char).
  *
@@ -205,17 +350,6 @@ bool extractSIFT(const image::Image<float>& image,
     const image::Image<unsigned char>* mask)
 {
   const int w = image.Width(), h = image.Height();
-  VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
-  if (params._edgeThreshold >= 0)
-    vl_sift_set_edge_thresh(filt, params._edgeThreshold);
-  if (params._peakThreshold >= 0)
-    vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
-
-  Descriptor<vl_sift_pix, 128> vlFeatDescriptor;
-  Descriptor<T, 128> descriptor;
-
-  // Process SIFT computation
-  vl_sift_process_first_octave(filt, image.data());
 
   typedef ScalarRegions<SIOPointFeature,T,128> SIFT_Region_T;
   regions.reset( new SIFT_Region_T );
@@ -227,56 +361,68 @@ bool extractSIFT(const image::Image<float>& image,
   regionsCasted->Features().reserve(reserveSize);
   regionsCasted->Descriptors().reserve(reserveSize);
 
-  while (true)
+  if(params._nativeScaleSpace)
   {
-    vl_sift_detect(filt);
+    SiftScaleSpace scaleSpace(w, h, params._numOctaves, params._numScales, params._firstOctave);
+    if (params._edgeThreshold >= 0)
+      scaleSpace.setEdgeThreshold(params._edgeThreshold);
+    if (params._peakThreshold >= 0)
+      scaleSpace.setPeakThreshold(params._peakThreshold/params._numScales);
 
-    VlSiftKeypoint const *keys  = vl_sift_get_keypoints(filt);
-    const int nkeys = vl_sift_get_nkeypoints(filt);
+    std::vector<SiftKeypoint> keys;
+    std::vector<std::size_t> selectedKeys;
+    bool hasOctave = scaleSpace.processFirstOctave(image.data());
 
-    // Update gradient before launching parallel extraction
-    vl_sift_update_gradient(filt);
+    while (hasOctave)
+    {
+      scaleSpace.detect(keys);
+      selectSIFTKeypoints(keys.data(), static_cast<int>(keys.size()), w, h, params, mask, selectedKeys);
 
-    #pragma omp parallel for private(vlFeatDescriptor, descriptor)
-    for (int i = 0; i < nkeys; ++i)
+      // Update gradient before launching parallel extraction
+      scaleSpace.updateGradient();
+
+      describeSIFTKeypoints(keys.data(), selectedKeys, params, orientation,
+        [&](double* angles, const SiftKeypoint& key) { return scaleSpace.computeKeypointOrientations(angles, key); },
+        [&](vl_sift_pix* desc, const SiftKeypoint& key, double angle) { scaleSpace.computeKeypointDescriptor(desc, key, angle); },
+        *regionsCasted);
+
+      hasOctave = scaleSpace.processNextOctave();
+    }
+  }
+  else
+  {
+    VlSiftFilt *filt = vl_sift_new(w, h, params._numOctaves, params._numScales, params._firstOctave);
+    if (params._edgeThreshold >= 0)
+      vl_sift_set_edge_thresh(filt, params._edgeThreshold);
+    if (params._peakThreshold >= 0)
+      vl_sift_set_peak_thresh(filt, params._peakThreshold/params._numScales);
+
+    std::vector<std::size_t> selectedKeys;
+
+    // Process SIFT computation
+    vl_sift_process_first_octave(filt, image.data());
+
+    while (true)
     {
+      vl_sift_detect(filt);
 
-      // Feature masking
-      if (mask)
-      {
-        const image::Image<unsigned char> & maskIma = *mask;
-        if (maskIma(keys[i].y, keys[i].x) > 0)
-          continue;
-      }
+      VlSiftKeypoint const *keys  = vl_sift_get_keypoints(filt);
+      const int nkeys = vl_sift_get_nkeypoints(filt);
+      selectSIFTKeypoints(keys, nkeys, w, h, params, mask, selectedKeys);
 
-      double angles [4] = {0.0, 0.0, 0.0, 0.0};
-      int nangles = 1; // by default (1 upright feature)
-      if (orientation)
-      { // compute from 1 to 4 orientations
-        nangles = vl_sift_calc_keypoint_orientations(filt, angles, keys+i);
-      }
+      // Update gradient before launching parallel extraction
+      vl_sift_update_gradient(filt);
 
-      for (int q=0 ; q < nangles ; ++q)
-      {
-        vl_sift_calc_keypoint_descriptor(filt, &vlFeatDescriptor[0], keys+i, angles[q]);
-        const SIOPointFeature fp(keys[i].x, keys[i].y,
-          keys[i].sigma, static_cast<float>(angles[q]));
+      describeSIFTKeypoints(keys, selectedKeys, params, orientation,
+        [&](double* angles, const VlSiftKeypoint& key) { return vl_sift_calc_keypoint_orientations(filt, angles, &key); },
+        [&](vl_sift_pix* desc, const VlSiftKeypoint& key, double angle) { vl_sift_calc_keypoint_descriptor(filt, desc, &key, angle); },
+        *regionsCasted);
 
-        convertSIFT<T>(&vlFeatDescriptor[0], descriptor, params._rootSift);
-        
-        #pragma omp critical
-        {
-          regionsCasted->Descriptors().push_back(descriptor);
-          regionsCasted->Features().push_back(fp);
-        }
-        
-      }
+      if (vl_sift_process_next_octave(filt))
+        break; // Last octave
     }
-    
-    if (vl_sift_process_next_octave(filt))
-      break; // Last octave
+    vl_sift_delete(filt);
   }
-  vl_sift_delete(filt);
 
   const auto& features = regionsCasted->Features();
   const auto& descriptors = regionsCasted->Descriptors();
@@ -0,0 +1,770 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "SiftScaleSpace.hpp"
+
+extern "C" {
+#include "nonFree/sift/vl/mathop.h"
+}
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace aliceVision {
+namespace feature {
+
+namespace {
+
+/// number of orientation bins of the descriptor
+const int nbDescriptorOrientations = 8;
+/// number of spatial bins of the descriptor (in each direction)
+const int nbDescriptorBins = 4;
+/// magnification factor of the descriptor window
+const double descriptorMagnif = 3.0;
+/// standard deviation of the descriptor Gaussian window (in spatial bins)
+const double descriptorWindowSize = nbDescriptorBins / 2;
+
+/// shift left for positive n, right otherwise
+inline int shiftLeft(int x, int n)
+{
+  return (n >= 0) ? (x << n) : (x >> -n);
+}
+
+/**
+ * @brief Fast approximation of exp(-x) for x in [0, 25] by linear interpolation in a table.
+ */
+inline double fastExpn(double x)
+{
+  const int tableSize = 256;
+  const double tableMax = 25.0;
+  static const std::array<double, tableSize + 1> table = [&]() {
+    std::array<double, tableSize + 1> t;
+    for(int k = 0; k < tableSize + 1; ++k)
+      t[k] = std::exp(-static_cast<double>(k) * (tableMax / tableSize));
+    return t;
+  }();
+
+  if(x > tableMax)
+    return 0.0;
+
+  x *= tableSize / tableMax;
+  const int i = static_cast<int>(vl_floor_d(x));
+  const double r = x - i;
+  return table[i] + r * (table[i + 1] - table[i]);
+}
+
+/**
+ * @brief Normalize a histogram in L2 norm.
+ * @return the norm before normalization
+ */
+inline float normalizeHistogram(float* begin, float* end)
+{
+  float norm = 0.0f;
+  for(float* it = begin; it != end; ++it)
+    norm += (*it) * (*it);
+
+  norm = vl_fast_sqrt_f(norm) + VL_EPSILON_F;
+
+  for(float* it = begin; it != end; ++it)
+    *it /= norm;
+
+  return norm;
+}
+
+/**
+ * @brief Double the size of an image with a linear interpolation, the last row and column are repeated.
+ * @param[in] src input image (width x height)
+ * @param[in] width input image width
+ * @param[in] height input image height
+ * @param[out] dst output image (2 * width x 2 * height)
+ */
+void upsample(const float* src, int width, int height, float* dst)
+{
+  const int dstWidth = 2 * width;
+
+  #pragma omp parallel for
+  for(int y = 0; y < height; ++y)
+  {
+    const float* srcRow = src + static_cast<std::size_t>(y) * width;
+    float* dstRow = dst + static_cast<std::size_t>(2 * y) * dstWidth;
+    for(int x = 0; x < width - 1; ++x)
+    {
+      dstRow[2 * x] = srcRow[x];
+      dstRow[2 * x + 1] = 0.5f * (srcRow[x] + srcRow[x + 1]);
+    }
+    dstRow[dstWidth - 2] = srcRow[width - 1];
+    dstRow[dstWidth - 1] = srcRow[width - 1];
+  }
+
+  // odd rows
+  #pragma omp parallel for
+  for(int y = 0; y < height; ++y)
+  {
+    const float* rowA = dst + static_cast<std::size_t>(2 * y) * dstWidth;
+    const float* rowB = dst + static_cast<std::size_t>(2 * std::min(y + 1, height - 1)) * dstWidth;
+    float* dstRow = dst + static_cast<std::size_t>(2 * y + 1) * dstWidth;
+    for(int x = 0; x < dstWidth; ++x)
+      dstRow[x] = 0.5f * (rowA[x] + rowB[x]);
+  }
+}
+
+/**
+ * @brief Keep one pixel out of 2^d in each direction.
+ * @param[in] src input image (width x height)
+ * @param[in] width input image width
+ * @param[in] height input image height
+ * @param[in] d the number of octaves
+ * @param[out] dst output image (width/2^d x height/2^d)
+ */
+void downsample(const float* src, int width, int height, int d, float* dst)
+{
+  const int step = 1 << d;
+  const int dstWidth = width >> d;
+  const int dstHeight = height >> d;
+
+  #pragma omp parallel for
+  for(int y = 0; y < dstHeight; ++y)
+  {
+    const float* srcRow = src + static_cast<std::size_t>(y) * step * width;
+    float* dstRow = dst + static_cast<std::size_t>(y) * dstWidth;
+    for(int x = 0; x < dstWidth; ++x)
+      dstRow[x] = srcRow[x * step];
+  }
+}
+
+} // namespace
+
+SiftScaleSpace::SiftScaleSpace(int width, int height, int nbOctaves, int nbScales, int firstOctave)
+  : _width(width)
+  , _height(height)
+  , _nbOctaves(nbOctaves)
+  , _nbScales(nbScales)
+  , _firstOctave(firstOctave)
+  , _sMin(-1)
+  , _sMax(nbScales + 1)
+  , _octaveIndex(firstOctave)
+  , _gradientOctaveIndex(firstOctave - 1)
+{
+  if(_nbOctaves < 0)
+    _nbOctaves = std::max(static_cast<int>(std::floor(std::log2(std::min(width, height)))) - firstOctave - 3, 1);
+
+  _sigmaN = 0.5;
+  _sigmaK = std::pow(2.0, 1.0 / nbScales);
+  _sigma0 = 1.6 * _sigmaK;
+  _dSigma0 = _sigma0 * std::sqrt(1.0 - 1.0 / (_sigmaK * _sigmaK));
+
+  const std::size_t nbPixels = static_cast<std::size_t>(shiftLeft(width, -firstOctave)) * shiftLeft(height, -firstOctave);
+  _temp.resize(nbPixels);
+  _octave.resize(nbPixels * (_sMax - _sMin + 1));
+  _dog.resize(nbPixels * (_sMax - _sMin));
+  _gradient.resize(nbPixels * 2 * (_sMax - _sMin));
+}
+
+void SiftScaleSpace::smooth(float* output, const float* input, double sigma)
+{
+  // Gaussian filter, truncated at 4 sigmas
+  const int filterWidth = std::max(static_cast<int>(std::ceil(4.0 * sigma)), 1);
+  std::vector<float> filter(2 * filterWidth + 1);
+  {
+    float sum = 0.0f;
+    for(int j = 0; j < 2 * filterWidth + 1; ++j)
+    {
+      const float d = static_cast<float>(j - filterWidth) / static_cast<float>(sigma);
+      filter[j] = static_cast<float>(std::exp(-0.5 * (d * d)));
+      sum += filter[j];
+    }
+    for(float& f : filter)
+      f /= sum;
+  }
+
+  const int w = _octaveWidth;
+  const int h = _octaveHeight;
+  float* temp = _temp.data();
+
+  // vertical pass: each output row is a weighted sum of input rows
+  #pragma omp parallel for
+  for(int y = 0; y < h; ++y)
+  {
+    float* outRow = temp + static_cast<std::size_t>(y) * w;
+    std::fill(outRow, outRow + w, 0.0f);
+    for(int k = -filterWidth; k <= filterWidth; ++k)
+    {
+      const float g = filter[k + filterWidth];
+      const float* inRow = input + static_cast<std::size_t>(std::min(std::max(y + k, 0), h - 1)) * w;
+      for(int x = 0; x < w; ++x)
+        outRow[x] += g * inRow[x];
+    }
+  }
+
+  // horizontal pass on padded rows
+  #pragma omp parallel
+  {
+    std::vector<float> paddedRow(w + 2 * filterWidth);
+
+    #pragma omp for
+    for(int y = 0; y < h; ++y)
+    {
+      const float* inRow = temp + static_cast<std::size_t>(y) * w;
+      std::fill(paddedRow.begin(), paddedRow.begin() + filterWidth, inRow[0]);
+      std::copy(inRow, inRow + w, paddedRow.begin() + filterWidth);
+      std::fill(paddedRow.begin() + filterWidth + w, paddedRow.end(), inRow[w - 1]);
+
+      float* outRow = output + static_cast<std::size_t>(y) * w;
+      std::fill(outRow, outRow + w, 0.0f);
+      for(int k = 0; k < 2 * filterWidth + 1; ++k)
+      {
+        const float g = filter[k];
+        const float* in = paddedRow.data() + k;
+        for(int x = 0; x < w; ++x)
+          outRow[x] += g * in[x];
+      }
+    }
+  }
+}
+
+void SiftScaleSpace::fillOctave()
+{
+  for(int s = _sMin + 1; s <= _sMax; ++s)
+  {
+    const double sd = _dSigma0 * std::pow(_sigmaK, s);
+    smooth(getLevel(s), getLevel(s - 1), sd);
+  }
+}
+
+bool SiftScaleSpace::processFirstOctave(const float* image)
+{
+  _octaveIndex = _firstOctave;
+  _octaveWidth = shiftLeft(_width, -_octaveIndex);
+  _octaveHeight = shiftLeft(_height, -_octaveIndex);
+
+  if(_nbOctaves == 0)
+    return false;
+
+  float* level = getLevel(_sMin);
+
+  if(_firstOctave < 0)
+  {
+    // double once, then double more using the temporary buffer
+    int w = _width;
+    int h = _height;
+    const bool evenNbUpsamplings = (-_firstOctave) % 2 == 0;
+    float* dst = evenNbUpsamplings ? _temp.data() : level;
+    float* other = evenNbUpsamplings ? level : _temp.data();
+    upsample(image, w, h, dst);
+    for(int o = -1; o > _firstOctave; --o)
+    {
+      w *= 2;
+      h *= 2;
+      upsample(dst, w, h, other);
+      std::swap(dst, other);
+    }
+  }
+  else if(_firstOctave > 0)
+  {
+    downsample(image, _width, _height, _firstOctave, level);
+  }
+  else
+  {
+    std::copy(image, image + static_cast<std::size_t>(_width) * _height, level);
+  }
+
+  // adjust the smoothing of the first level, the input image is assumed to have a nominal smoothing of sigmaN
+  const double sa = _sigma0 * std::pow(_sigmaK, _sMin);
+  const double sb = _sigmaN * std::pow(2.0, -_firstOctave);
+  if(sa > sb)
+    smooth(level, level, std::sqrt(sa * sa - sb * sb));
+
+  fillOctave();
+  return true;
+}
+
+bool SiftScaleSpace::processNextOctave()
+{
+  if(_octaveIndex == _firstOctave + _nbOctaves - 1)
+    return false;
+
+  const int nextWidth = shiftLeft(_width, -(_octaveIndex + 1));
+  const int nextHeight = shiftLeft(_height, -(_octaveIndex + 1));
+  if(nextWidth < 3 || nextHeight < 3)
+    return false;
+
+  // the base of the next octave is the level with twice the smoothing of the first one
+  // (it does not overlap the beginning of the buffer, where the new first level is written)
+  const int sBest = std::min(_sMin + _nbScales, _sMax);
+  downsample(getLevel(sBest), _octaveWidth, _octaveHeight, 1, _octave.data());
+
+  ++_octaveIndex;
+  _octaveWidth = nextWidth;
+  _octaveHeight = nextHeight;
+
+  const double sa = _sigma0 * std::pow(static_cast<float>(_sigmaK), static_cast<float>(_sMin));
+  const double sb = _sigma0 * std::pow(static_cast<float>(_sigmaK), static_cast<float>(sBest - _nbScales));
+  if(sa > sb)
+    smooth(getLevel(_sMin), getLevel(_sMin), std::sqrt(sa * sa - sb * sb));
+
+  fillOctave();
+  return true;
+}
+
+void SiftScaleSpace::detect(std::vector<SiftKeypoint>& out_keypoints)
+{
+  out_keypoints.clear();
+
+  const int w = _octaveWidth;
+  const int h = _octaveHeight;
+  const std::ptrdiff_t xo = 1;
+  const std::ptrdiff_t yo = w;
+  const std::ptrdiff_t so = static_cast<std::ptrdiff_t>(w) * h;
+  const double xper = std::pow(2.0, _octaveIndex);
+  const double te = _edgeThreshold;
+  const double tp = _peakThreshold;
+
+  // difference of Gaussians
+  const std::ptrdiff_t dogSize = so * (_sMax - _sMin);
+
+  #pragma omp parallel for
+  for(std::ptrdiff_t i = 0; i < dogSize; ++i)
+    _dog[i] = _octave[i + so] - _octave[i];
+
+  // local extrema of the DoG, row by row
+  const int nbRows = (_sMax - 2 - _sMin) * (h - 2);
+  std::vector<std::vector<SiftKeypoint>> rowsKeypoints(std::max(nbRows, 0));
+
+  #pragma omp parallel for schedule(dynamic, 16)
+  for(int r = 0; r < nbRows; ++r)
+  {
+    const int s = _sMin + 1 + r / (h - 2);
+    const int y = 1 + r % (h - 2);
+    const float* pt = _dog.data() + xo + yo * y + so * (s - _sMin);
+
+    for(int x = 1; x < w - 1; ++x, ++pt)
+    {
+      const float v = *pt;
+
+#define CHECK_NEIGHBORS(CMP, SGN)                                                                                   \
+  (v CMP## = SGN 0.8 * tp && v CMP *(pt + xo) && v CMP *(pt - xo) && v CMP *(pt + so) && v CMP *(pt - so) &&         \
+   v CMP *(pt + yo) && v CMP *(pt - yo) && v CMP *(pt + yo + xo) && v CMP *(pt + yo - xo) && v CMP *(pt - yo + xo) && \
+   v CMP *(pt - yo - xo) && v CMP *(pt + xo + so) && v CMP *(pt - xo + so) && v CMP *(pt + yo + so) &&               \
+   v CMP *(pt - yo + so) && v CMP *(pt + yo + xo + so) && v CMP *(pt + yo - xo + so) &&                              \
+   v CMP *(pt - yo + xo + so) && v CMP *(pt - yo - xo + so) && v CMP *(pt + xo - so) && v CMP *(pt - xo - so) &&     \
+   v CMP *(pt + yo - so) && v CMP *(pt - yo - so) && v CMP *(pt + yo + xo - so) && v CMP *(pt + yo - xo - so) &&     \
+   v CMP *(pt - yo + xo - so) && v CMP *(pt - yo - xo - so))
+
+      if(CHECK_NEIGHBORS(>, +) || CHECK_NEIGHBORS(<, -))
+      {
+        SiftKeypoint k;
+        k.ix = x;
+        k.iy = y;
+        k.is = s;
+        rowsKeypoints[r].push_back(k);
+      }
+
+#undef CHECK_NEIGHBORS
+    }
+  }
+
+  std::vector<SiftKeypoint> candidates;
+  {
+    std::size_t nbCandidates = 0;
+    for(const auto& rowKeypoints : rowsKeypoints)
+      nbCandidates += rowKeypoints.size();
+    candidates.reserve(nbCandidates);
+    for(const auto& rowKeypoints : rowsKeypoints)
+      candidates.insert(candidates.end(), rowKeypoints.begin(), rowKeypoints.end());
+  }
+  std::vector<char> isGood(candidates.size(), 0);
+
+  // refine the local extrema with a quadratic fit
+  #pragma omp parallel for schedule(dynamic, 64)
+  for(int i = 0; i < static_cast<int>(candidates.size()); ++i)
+  {
+    SiftKeypoint& k = candidates[i];
+    int x = k.ix;
+    int y = k.iy;
+    const int s = k.is;
+
+    double Dx = 0, Dy = 0, Ds = 0, Dxx = 0, Dyy = 0, Dss = 0, Dxy = 0, Dxs = 0, Dys = 0;
+    double A[3 * 3], b[3];
+    const float* pt = nullptr;
+
+    int dx = 0;
+    int dy = 0;
+
+#define at(dx, dy, ds) (*(pt + (dx)*xo + (dy)*yo + (ds)*so))
+#define Aat(i, j) (A[(i) + (j)*3])
+
+    for(int iter = 0; iter < 5; ++iter)
+    {
+      x += dx;
+      y += dy;
+
+      pt = _dog.data() + xo * x + yo * y + so * (s - _sMin);
+
+      // gradient
+      Dx = 0.5 * (at(+1, 0, 0) - at(-1, 0, 0));
+      Dy = 0.5 * (at(0, +1, 0) - at(0, -1, 0));
+      Ds = 0.5 * (at(0, 0, +1) - at(0, 0, -1));
+
+      // Hessian
+      Dxx = (at(+1, 0, 0) + at(-1, 0, 0) - 2.0 * at(0, 0, 0));
+      Dyy = (at(0, +1, 0) + at(0, -1, 0) - 2.0 * at(0, 0, 0));
+      Dss = (at(0, 0, +1) + at(0, 0, -1) - 2.0 * at(0, 0, 0));
+
+      Dxy = 0.25 * (at(+1, +1, 0) + at(-1, -1, 0) - at(-1, +1, 0) - at(+1, -1, 0));
+      Dxs = 0.25 * (at(+1, 0, +1) + at(-1, 0, -1) - at(-1, 0, +1) - at(+1, 0, -1));
+      Dys = 0.25 * (at(0, +1, +1) + at(0, -1, -1) - at(0, -1, +1) - at(0, +1, -1));
+
+      // solve the linear system
+      Aat(0, 0) = Dxx;
+      Aat(1, 1) = Dyy;
+      Aat(2, 2) = Dss;
+      Aat(0, 1) = Aat(1, 0) = Dxy;
+      Aat(0, 2) = Aat(2, 0) = Dxs;
+      Aat(1, 2) = Aat(2, 1) = Dys;
+
+      b[0] = -Dx;
+      b[1] = -Dy;
+      b[2] = -Ds;
+
+      // Gauss elimination
+      for(int j = 0; j < 3; ++j)
+      {
+        double maxa = 0;
+        double maxabsa = 0;
+        int maxi = -1;
+
+        // maximally stable pivot
+        for(int ii = j; ii < 3; ++ii)
+        {
+          const double a = Aat(ii, j);
+          const double absa = std::abs(a);
+          if(absa > maxabsa)
+          {
+            maxa = a;
+            maxabsa = absa;
+            maxi = ii;
+          }
+        }
+
+        // singular: give up
+        if(maxabsa < 1e-10f)
+        {
+          b[0] = 0;
+          b[1] = 0;
+          b[2] = 0;
+          break;
+        }
+
+        // swap the j-th row with the maxi-th row and normalize the j-th row
+        for(int jj = j; jj < 3; ++jj)
+        {
+          std::swap(Aat(maxi, jj), Aat(j, jj));
+          Aat(j, jj) /= maxa;
+        }
+        std::swap(b[j], b[maxi]);
+        b[j] /= maxa;
+
+        // elimination
+        for(int ii = j + 1; ii < 3; ++ii)
+        {
+          const double f = Aat(ii, j);
+          for(int jj = j; jj < 3; ++jj)
+            Aat(ii, jj) -= f * Aat(j, jj);
+          b[ii] -= f * b[j];
+        }
+      }
+
+      // backward substitution
+      for(int ii = 2; ii > 0; --ii)
+      {
+        const double f = b[ii];
+        for(int jj = ii - 1; jj >= 0; --jj)
+          b[jj] -= f * Aat(jj, ii);
+      }
+
+      // move the keypoint if the translation is big
+      dx = ((b[0] > 0.6 && x < w - 2) ? 1 : 0) + ((b[0] < -0.6 && x > 1) ? -1 : 0);
+      dy = ((b[1] > 0.6 && y < h - 2) ? 1 : 0) + ((b[1] < -0.6 && y > 1) ? -1 : 0);
+
+      if(dx == 0 && dy == 0)
+        break;
+    }
+
+    // check the threshold and the other conditions
+    const double val = at(0, 0, 0) + 0.5 * (Dx * b[0] + Dy * b[1] + Ds * b[2]);
+    const double score = (Dxx + Dyy) * (Dxx + Dyy) / (Dxx * Dyy - Dxy * Dxy);
+    const double xn = x + b[0];
+    const double yn = y + b[1];
+    const double sn = s + b[2];
+
+#undef at
+#undef Aat
+
+    const bool good = std::abs(val) > tp && score < (te + 1) * (te + 1) / te && score >= 0 &&
+                      std::abs(b[0]) < 1.5 && std::abs(b[1]) < 1.5 && std::abs(b[2]) < 1.5 &&
+                      xn >= 0 && xn <= w - 1 && yn >= 0 && yn <= h - 1 && sn >= _sMin && sn <= _sMax;
+
+    if(good)
+    {
+      k.o = _octaveIndex;
+      k.ix = x;
+      k.iy = y;
+      k.is = s;
+      k.s = sn;
+      k.x = xn * xper;
+      k.y = yn * xper;
+      k.sigma = _sigma0 * std::pow(2.0, sn / _nbScales) * xper;
+      isGood[i] = 1;
+    }
+  }
+
+  out_keypoints.reserve(candidates.size());
+  for(std::size_t i = 0; i < candidates.size(); ++i)
+  {
+    if(isGood[i])
+      out_keypoints.push_back(candidates[i]);
+  }
+}
+
+void SiftScaleSpace::updateGradient()
+{
+  if(_gradientOctaveIndex == _octaveIndex)
+    return;
+
+  const int w = _octaveWidth;
+  const int h = _octaveHeight;
+  const std::size_t so = static_cast<std::size_t>(w) * h;
+  const int nbLevels = _sMax - 2 - _sMin;
+
+  #pragma omp parallel for
+  for(int r = 0; r < nbLevels * h; ++r)
+  {
+    const int s = _sMin + 1 + r / h;
+    const int y = r % h;
+    const float* src = getLevel(s) + static_cast<std::size_t>(y) * w;
+    float* grad = _gradient.data() + 2 * so * (s - _sMin - 1) + 2 * static_cast<std::size_t>(y) * w;
+
+    // one-sided differences on the borders
+    const float* up = (y == 0) ? src : src - w;
+    const float* down = (y == h - 1) ? src : src + w;
+    const float yFactor = (y == 0 || y == h - 1) ? 1.0f : 0.5f;
+
+    for(int x = 0; x < w; ++x)
+    {
+      float gx;
+      if(x == 0)
+        gx = src[x + 1] - src[x];
+      else if(x == w - 1)
+        gx = src[x] - src[x - 1];
+      else
+        gx = 0.5f * (src[x + 1] - src[x - 1]);
+      const float gy = yFactor * (down[x] - up[x]);
+
+      grad[2 * x] = vl_fast_sqrt_f(gx * gx + gy * gy);
+      grad[2 * x + 1] = vl_mod_2pi_f(static_cast<float>(vl_fast_atan2_f(gy, gx) + 2 * VL_PI));
+    }
+  }
+
+  _gradientOctaveIndex = _octaveIndex;
+}
+
+int SiftScaleSpace::computeKeypointOrientations(double angles[4], const SiftKeypoint& keypoint) const
+{
+  const double winf = 1.5;
+  const double xper = std::pow(2.0, _octaveIndex);
+
+  const int w = _octaveWidth;
+  const int h = _octaveHeight;
+  const std::ptrdiff_t xo = 2;
+  const std::ptrdiff_t yo = 2 * w;
+  const std::ptrdiff_t so = 2 * static_cast<std::ptrdiff_t>(w) * h;
+  const double x = keypoint.x / xper;
+  const double y = keypoint.y / xper;
+  const double sigma = keypoint.sigma / xper;
+
+  const int xi = static_cast<int>(x + 0.5);
+  const int yi = static_cast<int>(y + 0.5);
+  const int si = keypoint.is;
+
+  const double sigmaw = winf * sigma;
+  const int W = std::max(static_cast<int>(std::floor(3.0 * sigmaw)), 1);
+
+  const int nbBins = 36;
+  double hist[nbBins];
+
+  // skip the keypoints out of the current octave or out of bounds
+  if(keypoint.o != _octaveIndex || xi < 0 || xi > w - 1 || yi < 0 || yi > h - 1 || si < _sMin + 1 || si > _sMax - 2)
+    return 0;
+
+  std::fill(hist, hist + nbBins, 0.0);
+
+  // orientation histogram
+  const float* pt = _gradient.data() + xo * xi + yo * yi + so * (si - _sMin - 1);
+
+  for(int ys = std::max(-W, -yi); ys <= std::min(+W, h - 1 - yi); ++ys)
+  {
+    for(int xs = std::max(-W, -xi); xs <= std::min(+W, w - 1 - xi); ++xs)
+    {
+      const double dx = static_cast<double>(xi + xs) - x;
+      const double dy = static_cast<double>(yi + ys) - y;
+      const double r2 = dx * dx + dy * dy;
+
+      // circular window
+      if(r2 >= W * W + 0.6)
+        continue;
+
+      const double wgt = fastExpn(r2 / (2 * sigmaw * sigmaw));
+      const double mod = *(pt + xs * xo + ys * yo);
+      const double ang = *(pt + xs * xo + ys * yo + 1);
+      const double fbin = nbBins * ang / (2 * VL_PI);
+
+      // bilinear interpolation between the two nearest bins (VL_SIFT_BILINEAR_ORIENTATIONS)
+      const int bin = static_cast<int>(vl_floor_d(fbin - 0.5));
+      const double rbin = fbin - bin - 0.5;
+      hist[(bin + nbBins) % nbBins] += (1 - rbin) * mod * wgt;
+      hist[(bin + 1) % nbBins] += rbin * mod * wgt;
+    }
+  }
+
+  // smooth the histogram
+  for(int iter = 0; iter < 6; ++iter)
+  {
+    double prev = hist[nbBins - 1];
+    const double first = hist[0];
+    int i;
+    for(i = 0; i < nbBins - 1; ++i)
+    {
+      const double newh = (prev + hist[i] + hist[(i + 1) % nbBins]) / 3.0;
+      prev = hist[i];
+      hist[i] = newh;
+    }
+    hist[i] = (prev + hist[i] + first) / 3.0;
+  }
+
+  const double maxh = *std::max_element(hist, hist + nbBins);
+
+  // peaks within 80% of the maximum
+  int nbAngles = 0;
+  for(int i = 0; i < nbBins; ++i)
+  {
+    const double h0 = hist[i];
+    const double hm = hist[(i - 1 + nbBins) % nbBins];
+    const double hp = hist[(i + 1 + nbBins) % nbBins];
+
+    if(h0 > 0.8 * maxh && h0 > hm && h0 > hp)
+    {
+      // quadratic interpolation
+      const double di = -0.5 * (hp - hm) / (hp + hm - 2 * h0);
+      const double th = 2 * VL_PI * (i + di + 0.5) / nbBins;
+      angles[nbAngles++] = th;
+      if(nbAngles == 4)
+        break;
+    }
+  }
+  return nbAngles;
+}
+
+void SiftScaleSpace::computeKeypointDescriptor(float* descriptor, const SiftKeypoint& keypoint, double angle) const
+{
+  const int NBO = nbDescriptorOrientations;
+  const int NBP = nbDescriptorBins;
+  const double xper = std::pow(2.0, _octaveIndex);
+
+  const int w = _octaveWidth;
+  const int h = _octaveHeight;
+  const std::ptrdiff_t xo = 2;
+  const std::ptrdiff_t yo = 2 * w;
+  const std::ptrdiff_t so = 2 * static_cast<std::ptrdiff_t>(w) * h;
+  const double x = keypoint.x / xper;
+  const double y = keypoint.y / xper;
+  const double sigma = keypoint.sigma / xper;
+
+  const int xi = static_cast<int>(x + 0.5);
+  const int yi = static_cast<int>(y + 0.5);
+  const int si = keypoint.is;
+
+  const double st0 = std::sin(angle);
+  const double ct0 = std::cos(angle);
+  const double SBP = descriptorMagnif * sigma + VL_EPSILON_D;
+  const int W = static_cast<int>(std::floor(std::sqrt(2.0) * SBP * (NBP + 1) / 2.0 + 0.5));
+
+  const int binto = 1;
+  const int binyo = NBO * NBP;
+  const int binxo = NBO;
+
+  // check bounds
+  if(keypoint.o != _octaveIndex || xi < 0 || xi >= w || yi < 0 || yi >= h - 1 || si < _sMin + 1 || si > _sMax - 2)
+    return;
+
+  std::fill(descriptor, descriptor + NBO * NBP * NBP, 0.0f);
+
+  // center the scale space and the descriptor on the keypoint
+  const float* pt = _gradient.data() + xi * xo + yi * yo + (si - _sMin - 1) * so;
+  float* dpt = descriptor + (NBP / 2) * binyo + (NBP / 2) * binxo;
+
+#define atd(dbinx, dbiny, dbint) *(dpt + (dbint)*binto + (dbiny)*binyo + (dbinx)*binxo)
+
+  // pixels in the intersection of the image rectangle (1,1)-(M-1,N-1) and the keypoint bounding box
+  for(int dyi = std::max(-W, 1 - yi); dyi <= std::min(+W, h - yi - 2); ++dyi)
+  {
+    for(int dxi = std::max(-W, 1 - xi); dxi <= std::min(+W, w - xi - 2); ++dxi)
+    {
+      const float mod = *(pt + dxi * xo + dyi * yo + 0);
+      const float ang = *(pt + dxi * xo + dyi * yo + 1);
+      const float theta = vl_mod_2pi_f(static_cast<float>(ang - angle));
+
+      // displacement normalized w.r.t. the keypoint orientation and extension
+      const float dx = static_cast<float>(xi + dxi - x);
+      const float dy = static_cast<float>(yi + dyi - y);
+      const float nx = static_cast<float>((ct0 * dx + st0 * dy) / SBP);
+      const float ny = static_cast<float>((-st0 * dx + ct0 * dy) / SBP);
+      const float nt = static_cast<float>(NBO * theta / (2 * VL_PI));
+
+      // Gaussian weight of the sample
+      const float wsigma = static_cast<float>(descriptorWindowSize);
+      const float win = static_cast<float>(fastExpn((nx * nx + ny * ny) / (2.0 * wsigma * wsigma)));
+
+      // distribute the sample in the 8 adjacent bins
+      const int binx = static_cast<int>(vl_floor_f(static_cast<float>(nx - 0.5)));
+      const int biny = static_cast<int>(vl_floor_f(static_cast<float>(ny - 0.5)));
+      const int bint = static_cast<int>(vl_floor_f(nt));
+      const float rbinx = static_cast<float>(nx - (binx + 0.5));
+      const float rbiny = static_cast<float>(ny - (biny + 0.5));
+      const float rbint = nt - bint;
+
+      for(int dbinx = 0; dbinx < 2; ++dbinx)
+      {
+        for(int dbiny = 0; dbiny < 2; ++dbiny)
+        {
+          for(int dbint = 0; dbint < 2; ++dbint)
+          {
+            if(binx + dbinx >= -(NBP / 2) && binx + dbinx < (NBP / 2) &&
+               biny + dbiny >= -(NBP / 2) && biny + dbiny < (NBP / 2))
+            {
+              const float weight = win * mod * std::abs(1 - dbinx - rbinx) * std::abs(1 - dbiny - rbiny) *
+                                   std::abs(1 - dbint - rbint);
+              atd(binx + dbinx, biny + dbiny, (bint + dbint) % NBO) += weight;
+            }
+          }
+        }
+      }
+    }
+  }
+
+#undef atd
+
+  // normalize, truncate at 0.2 and normalize again
+  float* end = descriptor + NBO * NBP * NBP;
+  normalizeHistogram(descriptor, end);
+  for(float* it = descriptor; it != end; ++it)
+    *it = std::min(*it, 0.2f);
+  normalizeHistogram(descriptor, end);
+}
+
+} // namespace feature
+} // namespace aliceVision
@@ -0,0 +1,156 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace aliceVision {
+namespace feature {
+
+/**
+ * @brief SIFT keypoint detected in the scale space.
+ * Same conventions as the VLFeat keypoints (VlSiftKeypoint).
+ */
+struct SiftKeypoint
+{
+  /// octave index
+  int o;
+  /// integer coordinates in the octave
+  int ix;
+  int iy;
+  int is;
+  /// coordinates in the image
+  float x;
+  float y;
+  /// level in the octave
+  float s;
+  /// scale in the image
+  float sigma;
+};
+
+/**
+ * @brief Multithreaded SIFT scale space (Gaussian pyramid, DoG, extrema detection),
+ * keypoint orientations and descriptors.
+ *
+ * It follows the VLFeat implementation step by step, so the detected regions are compatible
+ * with the ones of ImageDescriber_SIFT_vlfeat, but each step of an octave is split in rows
+ * processed in parallel and the separable Gaussian filtering loops are written to be vectorized.
+ *
+ * The octaves are processed one after the other:
+ * @code
+ * SiftScaleSpace scaleSpace(w, h, nbOctaves, nbScales, firstOctave);
+ * scaleSpace.processFirstOctave(image);
+ * do
+ * {
+ *   scaleSpace.detect(keypoints);
+ *   scaleSpace.updateGradient();
+ *   // computeKeypointOrientations / computeKeypointDescriptor (const, can be called in parallel)
+ * } while(scaleSpace.processNextOctave());
+ * @endcode
+ */
+class SiftScaleSpace
+{
+public:
+  /**
+   * @param[in] width image width
+   * @param[in] height image height
+   * @param[in] nbOctaves number of octaves
+   * @param[in] nbScales number of scales per octave
+   * @param[in] firstOctave first octave index (negative to upscale the image)
+   */
+  SiftScaleSpace(int width, int height, int nbOctaves, int nbScales, int firstOctave);
+
+  /// minimum absolute value of the DoG extrema
+  void setPeakThreshold(double peakThreshold) { _peakThreshold = peakThreshold; }
+
+  /// maximum ratio of the Hessian eigenvalues of the DoG extrema
+  void setEdgeThreshold(double edgeThreshold) { _edgeThreshold = edgeThreshold; }
+
+  /**
+   * @brief Compute the Gaussian scale space of the first octave.
+   * @param[in] image the image (width x height floats)
+   * @return false if there is no octave
+   */
+  bool processFirstOctave(const float* image);
+
+  /**
+   * @brief Compute the Gaussian scale space of the next octave.
+   * @return false if there is no more octave
+   */
+  bool processNextOctave();
+
+  /**
+   * @brief Detect and refine the DoG extrema of the current octave.
+   * @param[out] out_keypoints the keypoints of the current octave
+   */
+  void detect(std::vector<SiftKeypoint>& out_keypoints);
+
+  /// compute the gradient (modulus, angle) of the current octave, needed by the orientations and descriptors
+  void updateGradient();
+
+  /**
+   * @brief Compute the main orientations of a keypoint of the current octave.
+   * @param[out] angles up to 4 orientations
+   * @param[in] keypoint the keypoint
+   * @return the number of orientations
+   */
+  int computeKeypointOrientations(double angles[4], const SiftKeypoint& keypoint) const;
+
+  /**
+   * @brief Compute the descriptor of a keypoint of the current octave.
+   * @param[out] descriptor the 128 values of the descriptor
+   * @param[in] keypoint the keypoint
+   * @param[in] angle the keypoint orientation
+   */
+  void computeKeypointDescriptor(float* descriptor, const SiftKeypoint& keypoint, double angle) const;
+
+  int getOctaveIndex() const { return _octaveIndex; }
+
+private:
+  float* getLevel(int s) { return _octave.data() + static_cast<std::size_t>(_octaveWidth) * _octaveHeight * (s - _sMin); }
+  const float* getLevel(int s) const { return _octave.data() + static_cast<std::size_t>(_octaveWidth) * _octaveHeight * (s - _sMin); }
+
+  /// Gaussian smoothing of a level, with the border pixels repeated
+  void smooth(float* output, const float* input, double sigma);
+
+  /// compute the levels above the first one
+  void fillOctave();
+
+  int _width;
+  int _height;
+  int _nbOctaves;
+  int _nbScales;
+  int _firstOctave;
+  int _sMin;
+  int _sMax;
+
+  double _sigmaN;
+  double _sigma0;
+  double _sigmaK;
+  double _dSigma0;
+
+  double _peakThreshold = 0.0;
+  double _edgeThreshold = 10.0;
+
+  int _octaveIndex;
+  int _octaveWidth = 0;
+  int _octaveHeight = 0;
+
+  /// levels [_sMin, _sMax] of the current octave
+  std::vector<float> _octave;
+  /// DoG levels [_sMin, _sMax - 1] of the current octave
+  std::vector<float> _dog;
+  /// gradient (modulus, angle) of the levels [_sMin + 1, _sMax - 2] of the current octave
+  std::vector<float> _gradient;
+  int _gradientOctaveIndex;
+  /// temporary level
+  std::vector<float> _temp;
+};
+
+} // namespace feature
+} // namespace aliceVision
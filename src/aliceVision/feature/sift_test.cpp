@@ -0,0 +1,151 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/sift/ImageDescriber_SIFT_vlfeat.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+
+#define BOOST_TEST_MODULE sift
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision;
+using namespace aliceVision::feature;
+
+/**
+ * @brief Smooth random texture with a low frequency pattern.
+ */
+image::Image<float> generateImage(int width, int height)
+{
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+
+  image::Image<float> random(width, height);
+  for(int y = 0; y < height; ++y)
+    for(int x = 0; x < width; ++x)
+      random(y, x) = noise(generator);
+
+  image::Image<float> image(width, height);
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+    {
+      float sum = 0.0f;
+      for(int dy = -2; dy <= 2; ++dy)
+        for(int dx = -2; dx <= 2; ++dx)
+          sum += random(std::min(std::max(y + dy, 0), height - 1), std::min(std::max(x + dx, 0), width - 1));
+      image(y, x) = 0.5f * sum / 25.0f + 0.3f * std::sin(x * 0.05f) * std::cos(y * 0.07f);
+    }
+  }
+  return image;
+}
+
+void checkNativeScaleSpace(int firstOctave)
+{
+  const image::Image<float> image = generateImage(320, 240);
+
+  SiftParams params(firstOctave);
+  params._peakThreshold = 0.02f;
+  params._maxTotalKeypoints = 0; // no grid filtering
+
+  std::unique_ptr<Regions> vlfeatRegions;
+  std::unique_ptr<Regions> nativeRegions;
+  {
+    params._nativeScaleSpace = false;
+    ImageDescriber_SIFT_vlfeat describer(params);
+    BOOST_CHECK(describer.describe(image, vlfeatRegions));
+  }
+  {
+    params._nativeScaleSpace = true;
+    ImageDescriber_SIFT_vlfeat describer(params);
+    BOOST_CHECK(describer.describe(image, nativeRegions));
+  }
+
+  const SIFT_Regions& vlfeatSiftRegions = dynamic_cast<const SIFT_Regions&>(*vlfeatRegions);
+  const SIFT_Regions& nativeSiftRegions = dynamic_cast<const SIFT_Regions&>(*nativeRegions);
+  const auto& vlfeatFeatures = vlfeatSiftRegions.Features();
+  const auto& nativeFeatures = nativeSiftRegions.Features();
+
+  BOOST_CHECK(!vlfeatFeatures.empty());
+  // a few extrema may be on the other side of the thresholds (different rounding of the filtering)
+  BOOST_CHECK_CLOSE(double(nativeFeatures.size()), double(vlfeatFeatures.size()), 2.0);
+
+  // the VLFeat features (keypoints and orientations) are also found by the native scale space,
+  // with the same descriptors
+  std::size_t nbFound = 0;
+  std::size_t nbSameDescriptors = 0;
+  for(std::size_t i = 0; i < vlfeatFeatures.size(); ++i)
+  {
+    const SIOPointFeature& f = vlfeatFeatures[i];
+    for(std::size_t j = 0; j < nativeFeatures.size(); ++j)
+    {
+      const SIOPointFeature& g = nativeFeatures[j];
+      if(std::abs(f.x() - g.x()) < 1e-2f && std::abs(f.y() - g.y()) < 1e-2f && std::abs(f.scale() - g.scale()) < 1e-2f &&
+         std::abs(f.orientation() - g.orientation()) < 1e-3f)
+      {
+        ++nbFound;
+
+        // unsigned char descriptors: rounding differences only
+        const auto& fDesc = vlfeatSiftRegions.Descriptors()[i];
+        const auto& gDesc = nativeSiftRegions.Descriptors()[j];
+        int maxDiff = 0;
+        for(int k = 0; k < 128; ++k)
+          maxDiff = std::max(maxDiff, std::abs(int(fDesc[k]) - int(gDesc[k])));
+        if(maxDiff <= 2)
+          ++nbSameDescriptors;
+        break;
+      }
+    }
+  }
+  BOOST_CHECK_GE(nbFound, vlfeatFeatures.size() * 99 / 100);
+  BOOST_CHECK_GE(nbSameDescriptors, nbFound * 99 / 100);
+}
+
+BOOST_AUTO_TEST_CASE(sift_nativeScaleSpace)
+{
+  checkNativeScaleSpace(0);
+}
+
+BOOST_AUTO_TEST_CASE(sift_nativeScaleSpace_upscale)
+{
+  checkNativeScaleSpace(-1);
+}
+
+BOOST_AUTO_TEST_CASE(sift_keypointBudget)
+{
+  const image::Image<float> image = generateImage(320, 240);
+
+  SiftParams params(0);
+  params._peakThreshold = 0.02f;
+
+  std::unique_ptr<Regions> allRegions;
+  std::unique_ptr<Regions> budgetRegions;
+  {
+    params._maxTotalKeypoints = 0; // no grid filtering
+    ImageDescriber_SIFT_vlfeat describer(params);
+    BOOST_CHECK(describer.describe(image, allRegions));
+  }
+  const auto& allFeatures = dynamic_cast<const SIFT_Regions&>(*allRegions).Features();
+  {
+    params._maxTotalKeypoints = allFeatures.size() / 2;
+    ImageDescriber_SIFT_vlfeat describer(params);
+    BOOST_CHECK(describer.describe(image, budgetRegions));
+  }
+  const auto& budgetFeatures = dynamic_cast<const SIFT_Regions&>(*budgetRegions).Features();
+
+  // only the selected keypoints are described, they are the same as without the budget
+  BOOST_CHECK_EQUAL(budgetFeatures.size(), params._maxTotalKeypoints);
+  for(const SIOPointFeature& f : budgetFeatures)
+  {
+    const bool found = std::any_of(allFeatures.begin(), allFeatures.end(), [&](const SIOPointFeature& g) {
+      return f.x() == g.x() && f.y() == g.y() && f.scale() == g.scale() && f.orientation() == g.orientation();
+    });
+    BOOST_CHECK(found);
+  }
+}
@@ -4,8 +4,7 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "DelaunayGraphCut.hpp"
-// #include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
-#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_Tetra.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/jetColorMap.hpp>
 #include <aliceVision/mvsData/Pixel.hpp>
@@ -22,6 +21,13 @@
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+
 // OpenMP >= 3.1 for advanced atomic clauses (https://software.intel.com/en-us/node/608160)
 // OpenMP preprocessor version: https://github.com/jeffhammond/HPCInfo/wiki/Preprocessor-Macros
 #if defined _OPENMP && _OPENMP >= 201107 
@@ -213,6 +219,154 @@ void filterByPixSize(const std::vector<Point3d>& verticesCoordsPrepare, std::vec
 }
 
 
+/**
+ * @brief Lock-free hash map keeping the smallest value inserted per key.
+ *
+ * Open addressing with linear probing on a fixed capacity: the keys are inserted with a
+ * compare-and-swap on an empty slot and the values are updated with a compare-and-swap loop.
+ * The key 0 is reserved for the empty slots.
+ */
+class ConcurrentMinHashMap
+{
+public:
+    static constexpr std::uint64_t emptyKey = 0;
+    static constexpr std::uint64_t noValue = std::numeric_limits<std::uint64_t>::max();
+
+    explicit ConcurrentMinHashMap(std::size_t maxNbKeys)
+    {
+        std::size_t capacity = 1024;
+        while(capacity < 2 * maxNbKeys)
+            capacity *= 2;
+        _mask = capacity - 1;
+        _keys = std::vector<std::atomic<std::uint64_t>>(capacity);
+        _values = std::vector<std::atomic<std::uint64_t>>(capacity);
+
+        #pragma omp parallel for
+        for(std::int64_t i = 0; i < static_cast<std::int64_t>(capacity); ++i)
+        {
+            _keys[i].store(emptyKey, std::memory_order_relaxed);
+            _values[i].store(noValue, std::memory_order_relaxed);
+        }
+    }
+
+    /// mix the bits of a key, never returns emptyKey
+    static inline std::uint64_t hashKey(std::uint64_t x)
+    {
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        x *= 0xc4ceb9fe1a85ec53ULL;
+        x ^= x >> 33;
+        return (x == emptyKey) ? 1 : x;
+    }
+
+    void insertMin(std::uint64_t key, std::uint64_t value)
+    {
+        std::size_t slot = key & _mask;
+        for(std::size_t i = 0; i <= _mask; ++i, slot = (slot + 1) & _mask)
+        {
+            std::uint64_t slotKey = _keys[slot].load(std::memory_order_relaxed);
+            if(slotKey == emptyKey)
+            {
+                if(_keys[slot].compare_exchange_strong(slotKey, key))
+                    slotKey = key;
+            }
+            if(slotKey != key)
+                continue;
+
+            std::uint64_t slotValue = _values[slot].load(std::memory_order_relaxed);
+            while(value < slotValue && !_values[slot].compare_exchange_weak(slotValue, value))
+            {
+            }
+            return;
+        }
+        throw std::runtime_error("ConcurrentMinHashMap: capacity exceeded.");
+    }
+
+    std::uint64_t get(std::uint64_t key) const
+    {
+        std::size_t slot = key & _mask;
+        for(std::size_t i = 0; i <= _mask; ++i, slot = (slot + 1) & _mask)
+        {
+            const std::uint64_t slotKey = _keys[slot].load(std::memory_order_relaxed);
+            if(slotKey == key)
+                return _values[slot].load(std::memory_order_relaxed);
+            if(slotKey == emptyKey)
+                break;
+        }
+        return noValue;
+    }
+
+private:
+    std::size_t _mask;
+    std::vector<std::atomic<std::uint64_t>> _keys;
+    std::vector<std::atomic<std::uint64_t>> _values;
+};
+
+constexpr std::uint64_t ConcurrentMinHashMap::emptyKey;
+constexpr std::uint64_t ConcurrentMinHashMap::noValue;
+
+/**
+ * @brief Filter by pixSize with a multi-scale voxel hashing (approximation of filterByPixSize without KdTree).
+ *
+ * Each point is quantized in a voxel of the power of two size just above its filtering radius,
+ * and only the point with the smallest score (simScore * pixSize^2) is kept in each voxel.
+ */
+void filterByPixSizeVoxelHash(const std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, double pixSizeMarginCoef, std::vector<float>& simScorePrepare)
+{
+    ALICEVISION_LOG_INFO("Filter " << verticesCoordsPrepare.size() << " points with voxel hashing.");
+
+    const int nbVertices = verticesCoordsPrepare.size();
+    ConcurrentMinHashMap voxelsHash(nbVertices);
+    std::vector<std::uint64_t> voxelKeys(nbVertices, ConcurrentMinHashMap::emptyKey);
+
+    const auto getVoxelKey = [](const Point3d& p, double radius) {
+        const int level = static_cast<int>(std::ceil(std::log2(radius)));
+        const double invVoxelSize = std::ldexp(1.0, -level);
+        std::uint64_t key = ConcurrentMinHashMap::hashKey(static_cast<std::uint64_t>(level));
+        for(int d = 0; d < 3; ++d)
+            key = ConcurrentMinHashMap::hashKey(key ^ static_cast<std::uint64_t>(static_cast<std::int64_t>(std::floor(p.m[d] * invVoxelSize))));
+        return key;
+    };
+
+    #pragma omp parallel for
+    for(int vIndex = 0; vIndex < nbVertices; ++vIndex)
+    {
+        if(pixSizePrepare[vIndex] == -1.0)
+            continue;
+
+        const double pixSizeScore = simScorePrepare[vIndex] * pixSizePrepare[vIndex] * pixSizePrepare[vIndex];
+        const double radius2 = pixSizeMarginCoef * pixSizeScore;
+        if(radius2 < std::numeric_limits<double>::epsilon())
+        {
+            pixSizePrepare[vIndex] = -1.0;
+            continue;
+        }
+
+        // the score of a point is positive: the order of its float bits is the order of the values,
+        // the index of the point is used to keep a single point in case of equality
+        const float score = static_cast<float>(pixSizeScore);
+        std::uint32_t scoreBits;
+        std::memcpy(&scoreBits, &score, sizeof(float));
+        const std::uint64_t value = (static_cast<std::uint64_t>(scoreBits) << 32) | static_cast<std::uint32_t>(vIndex);
+
+        voxelKeys[vIndex] = getVoxelKey(verticesCoordsPrepare[vIndex], std::sqrt(radius2));
+        voxelsHash.insertMin(voxelKeys[vIndex], value);
+    }
+
+    #pragma omp parallel for
+    for(int vIndex = 0; vIndex < nbVertices; ++vIndex)
+    {
+        if(pixSizePrepare[vIndex] == -1.0)
+            continue;
+        // kill the points which are not the best of their voxel
+        if(static_cast<std::uint32_t>(voxelsHash.get(voxelKeys[vIndex])) != static_cast<std::uint32_t>(vIndex))
+            pixSizePrepare[vIndex] = -1.0;
+    }
+    ALICEVISION_LOG_INFO("Filtering done.");
+}
+
+
 /// Remove invalid points based on invalid pixSize
 void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare)
 {
@@ -264,6 +418,17 @@ void removeInvalidPoints(std::vector<Point3d>& verticesCoordsPrepare, std::vecto
     verticesAttrPrepare.swap(verticesAttrTmp);
 }
 
+/**
+ * @brief Number of cameras processed at the same time by the depth maps fusion.
+ *        Each of them holds its full resolution maps, so it bounds the peak memory.
+ *        The remaining threads are used inside each camera.
+ */
+int getFuseNbLoadedCams(const mvsUtils::MultiViewParams* mp)
+{
+    const int nbLoadedCams = mp->_ini.get<int>("fuse.nbLoadedCams", 3);
+    return std::max(1, std::min(nbLoadedCams, omp_get_max_threads()));
+}
+
 void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<Point3d>& verticesCoordsPrepare, std::vector<double>& pixSizePrepare, std::vector<float>& simScorePrepare,
                                     std::vector<GC_vertexInfo>& verticesAttrPrepare, mvsUtils::MultiViewParams* mp, float simFactor, float voteMarginFactor, float contributeMarginFactor, float simGaussianSize)
 {
@@ -277,16 +442,18 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
     kdTree.buildIndex();
     ALICEVISION_LOG_INFO("NANOFLANN: KdTree created.");
 #endif
-    // TODO FACA: update into new data structures
-    // std::vector<Point3d> newVerticesCoordsPrepare(verticesCoordsPrepare.size());
-    // std::vector<float> newSimScorePrepare(simScorePrepare.size());
-    // std::vector<double> newPixSizePrepare(pixSizePrepare.size());
-    std::vector<omp_lock_t> locks(verticesCoordsPrepare.size());
-    for (auto& lock: locks)
-        omp_init_lock(&lock);
+    // Contributions accumulated with atomic operations and applied at the end,
+    // so the vertices positions used by the KdTree are not modified during the search.
+    std::vector<Point3d> contributionsSum(verticesCoordsPrepare.size());
+    std::vector<int> contributionsCount(verticesCoordsPrepare.size(), 0);
+    // the cameras are added to the vertices under the lock of their stripe
+    std::vector<std::mutex> verticesMutexes(4096);
+
+    const int nbLoadedCams = getFuseNbLoadedCams(mp);
+    const int nbThreadsPerCam = std::max(1, omp_get_max_threads() / nbLoadedCams);
 
     omp_set_nested(1);
-    #pragma omp parallel for num_threads(3)
+    #pragma omp parallel for num_threads(nbLoadedCams) schedule(dynamic)
     for(int c = 0; c < cams.size(); ++c)
     {
         ALICEVISION_LOG_INFO("Create visibilities (" << c << "/" << cams.size() << ")");
@@ -312,8 +479,9 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
                 simMap.swap(simMapTmp);
             }
         }
+
         // Add visibility
-        #pragma omp parallel for
+        #pragma omp parallel for num_threads(nbThreadsPerCam)
         for(int y = 0; y < height; ++y)
         {
             for(int x = 0; x < width; ++x)
@@ -346,41 +514,41 @@ void createVerticesWithVisibilities(const StaticVector<int>& cams, std::vector<P
 
                 if(dist < voteMarginFactor * std::max(pixSizeScoreI, pixSizeScoreV))
                 {
-                    GC_vertexInfo& va = verticesAttrPrepare[nearestVertexIndex];
-                    Point3d& vc = verticesCoordsPrepare[nearestVertexIndex];
-                    const float simValue = simMap[index];
-                    // remap similarity values from [-1;+1] to [+1;+simFactor]
-                    // interpretation is [goodSimilarity;badSimilarity]
-                    const float simScore = simValue < -1.0f ? 1.0f : 1.0f + (1.0f + simValue) * simFactor;
-
-                    // Custom locks to limit it to the index: nearestVertexIndex
-                    // to avoid using "omp critical"
-                    omp_lock_t* lock = &locks[nearestVertexIndex];
-                    omp_set_lock(lock);
                     {
-                        va.cams.push_back_distinct(c);
-                        if(dist < contributeMarginFactor * pixSizeScoreV)
-                        {
-                            vc = (vc * (double)va.nrc + p) / double(va.nrc + 1);
-//                            newVerticesCoordsPrepare[nearestVertexIndex] = (newVerticesCoordsPrepare[nearestVertexIndex] * double(va.nrc) + p) / double(va.nrc + 1);
-//                            newSimScorePrepare[nearestVertexIndex] = (newSimScorePrepare[nearestVertexIndex] * float(va.nrc) + simScore) / float(va.nrc + 1);
-//                            newPixSizePrepare[nearestVertexIndex] = (newPixSizePrepare[nearestVertexIndex] * double(va.nrc) + pixSize) / double(va.nrc + 1);
-                            va.nrc += 1;
-                        }
+                        std::lock_guard<std::mutex> lock(verticesMutexes[nearestVertexIndex % verticesMutexes.size()]);
+                        verticesAttrPrepare[nearestVertexIndex].cams.push_back_distinct(c);
+                    }
+                    if(dist < contributeMarginFactor * pixSizeScoreV)
+                    {
+                        Point3d& sum = contributionsSum[nearestVertexIndex];
+                        #pragma omp atomic
+                        sum.x += p.x;
+                        #pragma omp atomic
+                        sum.y += p.y;
+                        #pragma omp atomic
+                        sum.z += p.z;
+                        #pragma omp atomic
+                        contributionsCount[nearestVertexIndex] += 1;
                     }
-                    omp_unset_lock(lock);
                 }
             }
         }
     }
     omp_set_nested(0);
 
-    for(auto& lock: locks)
-        omp_destroy_lock(&lock);
+    // the new position is the average of the previous contributions and the new ones
+    #pragma omp parallel for
+    for(int vIndex = 0; vIndex < verticesCoordsPrepare.size(); ++vIndex)
+    {
+        const int count = contributionsCount[vIndex];
+        if(count == 0)
+            continue;
+        GC_vertexInfo& va = verticesAttrPrepare[vIndex];
+        Point3d& vc = verticesCoordsPrepare[vIndex];
+        vc = (vc * (double)va.nrc + contributionsSum[vIndex]) / double(va.nrc + count);
+        va.nrc += count;
+    }
 
-//    verticesCoordsPrepare.swap(newVerticesCoordsPrepare);
-//    simScorePrepare.swap(newSimScorePrepare);
-//    pixSizePrepare.swap(newPixSizePrepare);
     ALICEVISION_LOG_INFO("Visibilities created.");
 }
 
@@ -805,8 +973,12 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
 
     ALICEVISION_LOG_INFO("Load depth maps and add points.");
     {
+        // a bounded number of cameras loaded at the same time, the other threads work inside each camera
+        const int nbLoadedCams = getFuseNbLoadedCams(mp);
+        const int nbThreadsPerCam = std::max(1, omp_get_max_threads() / nbLoadedCams);
+
         omp_set_nested(1);
-        #pragma omp parallel for num_threads(3)
+        #pragma omp parallel for num_threads(nbLoadedCams) schedule(dynamic)
         for(int c = 0; c < cams.size(); c++)
         {
             std::vector<float> depthMap;
@@ -840,7 +1012,7 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
 
             int syMax = std::ceil(height/step);
             int sxMax = std::ceil(width/step);
-            #pragma omp parallel for
+            #pragma omp parallel for num_threads(nbThreadsPerCam)
             for(int sy = 0; sy < syMax; ++sy)
             {
                 for(int sx = 0; sx < sxMax; ++sx)
@@ -922,7 +1094,16 @@ void DelaunayGraphCut::fuseFromDepthMaps(const StaticVector<int>& cams, const Po
 
     ALICEVISION_LOG_INFO("Filter initial 3D points by pixel size to remove duplicates.");
 
-    filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+    if(mp->_ini.get<bool>("fuse.voxelHashFilter", true))
+    {
+        // remove the discarded samples first: the hash map is sized on the valid points
+        removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
+        filterByPixSizeVoxelHash(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+    }
+    else
+    {
+        filterByPixSize(verticesCoordsPrepare, pixSizePrepare, params.pixSizeMarginInitCoef, simScorePrepare);
+    }
     // remove points if pixSize == -1
     removeInvalidPoints(verticesCoordsPrepare, pixSizePrepare, simScorePrepare);
 
@@ -1524,6 +1705,61 @@ float DelaunayGraphCut::weightFcn(float nrc, bool labatutWeights, int  /*ncams*/
     return weight;
 }
 
+/// Insert two zero bits between each of the 21 lowest bits
+static inline std::uint64_t spreadBits3D(std::uint64_t x)
+{
+    x &= 0x1fffff;
+    x = (x | x << 32) & 0x1f00000000ffff;
+    x = (x | x << 16) & 0x1f0000ff0000ff;
+    x = (x | x << 8) & 0x100f00f00f00f00f;
+    x = (x | x << 4) & 0x10c30c30c30c30c3;
+    x = (x | x << 2) & 0x1249249249249249;
+    return x;
+}
+
+void DelaunayGraphCut::sortVerticesByMortonCode(std::vector<int>& vertexIndexes) const
+{
+    if(vertexIndexes.empty())
+        return;
+
+    Point3d bboxMin = _verticesCoords[vertexIndexes[0]];
+    Point3d bboxMax = bboxMin;
+    for(int vi : vertexIndexes)
+    {
+        const Point3d& p = _verticesCoords[vi];
+        for(int d = 0; d < 3; ++d)
+        {
+            bboxMin.m[d] = std::min(bboxMin.m[d], p.m[d]);
+            bboxMax.m[d] = std::max(bboxMax.m[d], p.m[d]);
+        }
+    }
+
+    const double maxCoord = double((1 << 21) - 1);
+    double scale[3];
+    for(int d = 0; d < 3; ++d)
+    {
+        const double size = bboxMax.m[d] - bboxMin.m[d];
+        scale[d] = (size > 0.0) ? maxCoord / size : 0.0;
+    }
+
+    std::vector<std::pair<std::uint64_t, int>> codes(vertexIndexes.size());
+
+#pragma omp parallel for
+    for(int i = 0; i < vertexIndexes.size(); ++i)
+    {
+        const Point3d& p = _verticesCoords[vertexIndexes[i]];
+        std::uint64_t code = 0;
+        for(int d = 0; d < 3; ++d)
+            code |= spreadBits3D(static_cast<std::uint64_t>((p.m[d] - bboxMin.m[d]) * scale[d])) << d;
+        codes[i] = std::make_pair(code, vertexIndexes[i]);
+    }
+
+    std::sort(codes.begin(), codes.end());
+
+    for(std::size_t i = 0; i < codes.size(); ++i)
+        vertexIndexes[i] = codes[i].second;
+}
+
 void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind,
                                bool labatutWeights, bool fillOut, float distFcnHeight) // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 labatutWeights=0 fillOut=1 distFcnHeight=0
 {
@@ -1546,8 +1782,7 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
         }
     }
 
-    // choose random order to prevent waiting
-    StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
+    const bool buffered = mp->_ini.get<bool>("delaunaycut.fillGraphBuffered", true);
 
     int64_t avStepsFront = 0;
     int64_t aAvStepsFront = 0;
@@ -1556,39 +1791,103 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
     int avCams = 0;
     int nAvCams = 0;
 
-#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
-    for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+    // cast the rays from a vertex to all its cameras
+    // (the statistics are given as parameters to use the private copies of the omp reductions)
+    const auto fillGraphPartPt = [&](int iV, GC_cellWeightUpdatesBuffer* updatesBuffer,
+                                     int64_t& stepsFront, int64_t& nStepsFront,
+                                     int64_t& stepsBehind, int64_t& nStepsBehind,
+                                     int& cams, int& nCams)
     {
-        int iV = (*vetexesToProcessIdsRand)[i];
         const GC_vertexInfo& v = _verticesAttr[iV];
 
-        if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+        for(int c = 0; c < v.cams.size(); c++)
         {
-            for(int c = 0; c < v.cams.size(); c++)
-            {
-                // "weight" is called alpha(p) in the paper
-                float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
+            // "weight" is called alpha(p) in the paper
+            float weight = weightFcn((float)v.nrc, labatutWeights, v.getNbCameras()); // number of cameras
 
-                assert(v.cams[c] >= 0);
-                assert(v.cams[c] < mp->ncams);
+            assert(v.cams[c] >= 0);
+            assert(v.cams[c] < mp->ncams);
 
-                int nstepsFront = 0;
-                int nstepsBehind = 0;
-                fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
-                                  allPoints, behind, fillOut, distFcnHeight);
+            int nstepsFront = 0;
+            int nstepsBehind = 0;
+            fillGraphPartPtRc(nstepsFront, nstepsBehind, iV, v.cams[c], weight, fixesSigma, nPixelSizeBehind,
+                              allPoints, behind, fillOut, distFcnHeight, updatesBuffer);
 
-                avStepsFront += nstepsFront;
-                aAvStepsFront += 1;
-                avStepsBehind += nstepsBehind;
-                nAvStepsBehind += 1;
-            } // for c
+            stepsFront += nstepsFront;
+            nStepsFront += 1;
+            stepsBehind += nstepsBehind;
+            nStepsBehind += 1;
+        } // for c
 
-            avCams += v.cams.size();
-            nAvCams += 1;
+        cams += v.cams.size();
+        nCams += 1;
+    };
+
+    if(buffered)
+    {
+        // vertices casting rays
+        std::vector<int> verticesToProcess;
+        verticesToProcess.reserve(_verticesAttr.size());
+        for(int iV = 0; iV < _verticesAttr.size(); ++iV)
+        {
+            const GC_vertexInfo& v = _verticesAttr[iV];
+            if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+                verticesToProcess.push_back(iV);
+        }
+
+        // spatially sort the vertices: the rays processed at the same time go through the same cells
+        sortVerticesByMortonCode(verticesToProcess);
+
+        // the weight updates are accumulated per thread, in buckets of consecutive cells:
+        // a full bucket is applied under the lock of its cells, no atomic operation and no false sharing
+        const int nbThreads = omp_get_max_threads();
+        const int nbBuckets = 4 * nbThreads;
+        const std::size_t nbCells = _cellsAttr.size();
+        // fixed capacity of the buffers (about 256k updates per thread), whatever the number of rays
+        const std::size_t bucketCapacity = std::max(std::size_t(256), (std::size_t(1) << 18) / nbBuckets);
+
+        GC_cellsWeights cellsWeights(nbCells);
+        std::vector<std::mutex> bucketsMutexes(nbBuckets);
+        std::vector<GC_cellWeightUpdatesBuffer> updatesBuffers(nbThreads, GC_cellWeightUpdatesBuffer(cellsWeights, bucketsMutexes, bucketCapacity));
+
+#pragma omp parallel for schedule(dynamic, 64) reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+        for(int i = 0; i < verticesToProcess.size(); ++i)
+        {
+            fillGraphPartPt(verticesToProcess[i], &updatesBuffers[omp_get_thread_num()],
+                            avStepsFront, aAvStepsFront, avStepsBehind, nAvStepsBehind, avCams, nAvCams);
+        }
+
+        // apply the remaining updates
+#pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < nbBuckets; ++b)
+        {
+            for(GC_cellWeightUpdatesBuffer& updatesBuffer : updatesBuffers)
+                updatesBuffer.flush(b);
         }
+
+#pragma omp parallel for
+        for(int ci = 0; ci < nbCells; ++ci)
+            cellsWeights.get(ci, _cellsAttr[ci]);
     }
+    else
+    {
+        // choose random order to prevent waiting
+        StaticVector<int>* vetexesToProcessIdsRand = mvsUtils::createRandomArrayOfIntegers(_verticesAttr.size());
 
-    delete vetexesToProcessIdsRand;
+#pragma omp parallel for reduction(+:avStepsFront,aAvStepsFront,avStepsBehind,nAvStepsBehind,avCams,nAvCams)
+        for(int i = 0; i < vetexesToProcessIdsRand->size(); i++)
+        {
+            int iV = (*vetexesToProcessIdsRand)[i];
+            const GC_vertexInfo& v = _verticesAttr[iV];
+
+            if(v.isReal() && (allPoints || v.isOnSurface) && (v.nrc > 0))
+            {
+                fillGraphPartPt(iV, nullptr, avStepsFront, aAvStepsFront, avStepsBehind, nAvStepsBehind, avCams, nAvCams);
+            }
+        }
+
+        delete vetexesToProcessIdsRand;
+    }
 
     ALICEVISION_LOG_DEBUG("avStepsFront " << avStepsFront);
     ALICEVISION_LOG_DEBUG("avStepsFront = " << mvsUtils::num2str(avStepsFront) << " // " << mvsUtils::num2str(aAvStepsFront));
@@ -1600,7 +1899,8 @@ void DelaunayGraphCut::fillGraph(bool fixesSigma, float nPixelSizeBehind, bool a
 
 void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam,
                                        float weight, bool fixesSigma, float nPixelSizeBehind, bool allPoints,
-                                       bool behind, bool fillOut, float distFcnHeight)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
+                                       bool behind, bool fillOut, float distFcnHeight,
+                                       GC_cellWeightUpdatesBuffer* updatesBuffer)  // fixesSigma=true nPixelSizeBehind=2*spaceSteps allPoints=1 behind=0 fillOut=1 distFcnHeight=0
 {
     out_nstepsFront = 0;
     out_nstepsBehind = 0;
@@ -1633,6 +1933,11 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = ci != GEO::NO_CELL;
         while(ok)
         {
+            if(updatesBuffer != nullptr)
+            {
+                updatesBuffer->add(ci, GC_cellWeightUpdate::eOut, weight);
+            }
+            else
             {
 #pragma OMP_ATOMIC_UPDATE
                 _cellsAttr[ci].out += weight;
@@ -1653,6 +1958,11 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
             {
                 float dist = distFcn(maxDist, (po - pold).size(), distFcnHeight);
 
+                if(updatesBuffer != nullptr)
+                {
+                    updatesBuffer->add(f1.cellIndex, GC_cellWeightUpdate::eGEdgeVisWeight + f1.localVertexIndex, weight * dist);
+                }
+                else
                 {
 #pragma OMP_ATOMIC_UPDATE
                     _cellsAttr[f1.cellIndex].gEdgeVisWeight[f1.localVertexIndex] += weight * dist;
@@ -1668,8 +1978,15 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         // get the outer tetrahedron of camera c for the ray to p = the last tetrahedron
         if(lastFinite != GEO::NO_CELL)
         {
+            if(updatesBuffer != nullptr)
+            {
+                updatesBuffer->add(lastFinite, GC_cellWeightUpdate::eCellSWeight, (float)maxint);
+            }
+            else
+            {
 #pragma OMP_ATOMIC_WRITE
-            _cellsAttr[lastFinite].cellSWeight = (float)maxint;
+                _cellsAttr[lastFinite].cellSWeight = (float)maxint;
+            }
         }
     }
 
@@ -1682,8 +1999,15 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         CellIndex ci = f1.cellIndex;
         if(ci != GEO::NO_CELL)
         {
+            if(updatesBuffer != nullptr)
+            {
+                updatesBuffer->add(ci, GC_cellWeightUpdate::eOn, weight);
+            }
+            else
+            {
 #pragma OMP_ATOMIC_UPDATE
-            _cellsAttr[ci].on += weight;
+                _cellsAttr[ci].on += weight;
+            }
         }
 
         Point3d p = po; // HAS TO BE HERE !!!
@@ -1691,10 +2015,19 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         bool ok = (ci != GEO::NO_CELL) && allPoints;
         while(ok)
         {
-            GC_cellInfo& c = _cellsAttr[ci];
+            if(updatesBuffer != nullptr)
             {
                 if(behind)
                 {
+                    updatesBuffer->add(ci, GC_cellWeightUpdate::eCellTWeight, weight);
+                }
+                updatesBuffer->add(ci, GC_cellWeightUpdate::eIn, weight);
+            }
+            else
+            {
+                GC_cellInfo& c = _cellsAttr[ci];
+                if(behind)
+                {
 #pragma OMP_ATOMIC_UPDATE
                     c.cellTWeight += weight;
                 }
@@ -1727,6 +2060,10 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
                 {
                     ok = false;
                 }
+                else if(updatesBuffer != nullptr)
+                {
+                    updatesBuffer->add(f2.cellIndex, GC_cellWeightUpdate::eGEdgeVisWeight + f2.localVertexIndex, weight * dist);
+                }
                 else
                 {
 #pragma OMP_ATOMIC_UPDATE
@@ -1737,9 +2074,13 @@ void DelaunayGraphCut::fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBe
         }
 
         // cv: is the tetrahedron in distance 2*sigma behind the point p in the direction of the camera c (called Lcp in the paper)
-        if(!behind)
+        if(!behind && (ci != GEO::NO_CELL))
         {
-            if(ci != GEO::NO_CELL)
+            if(updatesBuffer != nullptr)
+            {
+                updatesBuffer->add(ci, GC_cellWeightUpdate::eCellTWeight, weight);
+            }
+            else
             {
 #pragma OMP_ATOMIC_UPDATE
                 _cellsAttr[ci].cellTWeight += weight;
@@ -2476,14 +2817,20 @@ void DelaunayGraphCut::maxflow()
     long t_maxflow = clock();
 
     ALICEVISION_LOG_INFO("Maxflow: start allocation.");
-    // MaxFlow_CSR maxFlowGraph(_cellsAttr.size());
-    MaxFlow_AdjList maxFlowGraph(_cellsAttr.size());
+    const std::size_t nbCells = _cellsAttr.size();
+    MaxFlow_Tetra maxFlowGraph(nbCells);
+    maxFlowGraph.setNbBlocks(mp->_ini.get<int>("delaunaycut.maxflowNbBlocks", 0));
 
-    ALICEVISION_LOG_INFO("Maxflow: add nodes.");
-    // fill s-t edges
-    for(CellIndex ci = 0; ci < _cellsAttr.size(); ++ci)
+    ALICEVISION_LOG_INFO("Maxflow: add nodes and edges.");
+    const float CONSTalphaVIS = 1.0f;
+    const float CONSTalphaPHOTO = 5.0f;
+
+    // fill s-t edges and u-v directed edges,
+    // the neighbors of a cell are stored in the slots of the graph by local facet index
+    #pragma omp parallel for
+    for(int ci = 0; ci < static_cast<int>(nbCells); ++ci)
     {
-        GC_cellInfo& c = _cellsAttr[ci];
+        const GC_cellInfo& c = _cellsAttr[ci];
         float ws = c.cellSWeight;
         float wt = c.cellTWeight;
 
@@ -2493,47 +2840,42 @@ void DelaunayGraphCut::maxflow()
         assert(!std::isnan(wt));
 
         maxFlowGraph.addNode(ci, ws, wt);
-    }
-
-    ALICEVISION_LOG_INFO("Maxflow: add edges.");
-    const float CONSTalphaVIS = 1.0f;
-    const float CONSTalphaPHOTO = 5.0f;
 
-    // fill u-v directed edges
-    for(CellIndex ci = 0; ci < _cellsAttr.size(); ++ci)
-    {
         for(VertexIndex k = 0; k < 4; ++k)
         {
             Facet fu(ci, k);
             Facet fv = mirrorFacet(fu);
-            if(isInvalidOrInfiniteCell(fv.cellIndex))
+            if(fv.cellIndex == GEO::NO_CELL)
+                continue;
+
+            // the edge is added from both cells, except from an infinite cell
+            const int nbEdgesAdded = (isInfiniteCell(fv.cellIndex) ? 0 : 1) + (isInfiniteCell(fu.cellIndex) ? 0 : 1);
+            if(nbEdgesAdded == 0)
                 continue;
 
-            float a1 = 0.0f;
             float a2 = 0.0f;
             if((!isInfiniteCell(fu.cellIndex)) && (!isInfiniteCell(fv.cellIndex)))
             {
                 // Score for each facet based on the quality of the topology
-                a1 = getFaceWeight(fu);
                 a2 = getFaceWeight(fv);
             }
 
             // In output of maxflow the cuts will become the surface.
             // High weight on some facets will avoid cutting them.
-            float wFvFu = _cellsAttr[fu.cellIndex].gEdgeVisWeight[fu.localVertexIndex] * CONSTalphaVIS + a1 * CONSTalphaPHOTO;
             float wFuFv = _cellsAttr[fv.cellIndex].gEdgeVisWeight[fv.localVertexIndex] * CONSTalphaVIS + a2 * CONSTalphaPHOTO;
 
-            assert(wFvFu >= 0.0f);
             assert(wFuFv >= 0.0f);
-            assert(!std::isnan(wFvFu));
             assert(!std::isnan(wFuFv));
 
-            maxFlowGraph.addEdge(fu.cellIndex, fv.cellIndex, wFuFv, wFvFu);
+            maxFlowGraph.setEdge(ci, k, fv.cellIndex, fv.localVertexIndex, nbEdgesAdded * wFuFv);
         }
     }
 
+    const std::string maxflowGraphFilepath = mp->_ini.get<std::string>("delaunaycut.saveMaxflowGraph", "");
+    if(!maxflowGraphFilepath.empty())
+        maxFlowGraph.saveGraph(maxflowGraphFilepath);
+
     ALICEVISION_LOG_INFO("Maxflow: clear cells info.");
-    const std::size_t nbCells = _cellsAttr.size();
     std::vector<GC_cellInfo>().swap(_cellsAttr); // force clear
 
     long t_maxflow_compute = clock();
@@ -286,11 +286,25 @@ public:
 
     float weightFcn(float nrc, bool labatutWeights, int ncams);
 
+    /// Sort vertex indexes by the Morton code of their position (Z-order curve)
+    void sortVerticesByMortonCode(std::vector<int>& vertexIndexes) const;
+
+    /**
+     * @brief Compute the s-t graph weights by casting the rays from the vertices to their cameras.
+     *
+     * By default ("delaunaycut.fillGraphBuffered"), the vertices are processed in Morton order
+     * and the weights are accumulated in per-thread buffers which are reduced per range of cells,
+     * instead of updating the cells with atomic operations.
+     */
     virtual void fillGraph(bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool labatutWeights,
                            bool fillOut, float distFcnHeight = 0.0f);
+    /**
+     * @brief Update the weights of the cells along the ray from the vertex to the camera.
+     * @param[in,out] updatesBuffer if not null, the updates are stored in this buffer instead of being applied
+     */
     void fillGraphPartPtRc(int& out_nstepsFront, int& out_nstepsBehind, int vertexIndex, int cam, float weight,
                            bool fixesSigma, float nPixelSizeBehind, bool allPoints, bool behind, bool fillOut,
-                           float distFcnHeight);
+                           float distFcnHeight, GC_cellWeightUpdatesBuffer* updatesBuffer = nullptr);
 
     void forceTedgesByGradientCVPR11(bool fixesSigma, float nPixelSizeBehind);
     void forceTedgesByGradientIJCV(bool fixesSigma, float nPixelSizeBehind);
@@ -0,0 +1,472 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MaxFlow_Tetra.hpp"
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+namespace aliceVision {
+namespace fuseCut {
+
+namespace {
+
+const char maxflowGraphMagic[4] = {'A', 'V', 'M', 'F'};
+const std::uint32_t maxflowGraphVersion = 1;
+
+template <typename T>
+void writeArray(std::ofstream& stream, const std::vector<T>& array)
+{
+    stream.write(reinterpret_cast<const char*>(array.data()), array.size() * sizeof(T));
+}
+
+template <typename T>
+void readArray(std::ifstream& stream, std::vector<T>& array)
+{
+    stream.read(reinterpret_cast<char*>(array.data()), array.size() * sizeof(T));
+}
+
+} // namespace
+
+MaxFlow_Tetra::MaxFlow_Tetra(std::size_t numNodes)
+{
+    reset(numNodes);
+}
+
+void MaxFlow_Tetra::reset(std::size_t numNodes)
+{
+    if(numNodes >= static_cast<std::size_t>(std::numeric_limits<NodeType>::max()))
+        throw std::runtime_error("MaxFlow_Tetra: too many nodes (" + std::to_string(numNodes) + ").");
+
+    std::array<NodeType, nbNeighbors> noNeighbors;
+    noNeighbors.fill(-1);
+    _neighbors.assign(numNodes, noNeighbors);
+    _capacities.assign(numNodes, std::array<ValueType, nbNeighbors>{{0.0f, 0.0f, 0.0f, 0.0f}});
+    _reverseSlots.assign(numNodes, std::array<std::uint8_t, nbNeighbors>{{0, 0, 0, 0}});
+    _terminalCapacity.assign(numNodes, 0.0f);
+
+    _parent.clear();
+    _tree.clear();
+    _isActive.clear();
+    _timestamp.clear();
+    _distance.clear();
+}
+
+void MaxFlow_Tetra::addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity)
+{
+    assert(capacity >= 0 && reverseCapacity >= 0);
+    assert(n1 != n2);
+
+    const auto getSlot = [this](NodeType n, NodeType neighbor)
+    {
+        for(int k = 0; k < nbNeighbors; ++k)
+        {
+            if(_neighbors[n][k] == neighbor)
+                return k;
+            if(_neighbors[n][k] == -1)
+            {
+                _neighbors[n][k] = neighbor;
+                return k;
+            }
+        }
+        throw std::runtime_error("MaxFlow_Tetra: the node " + std::to_string(n) + " has more than " +
+                                 std::to_string(nbNeighbors) + " neighbors.");
+    };
+
+    const int k1 = getSlot(n1, n2);
+    const int k2 = getSlot(n2, n1);
+
+    _capacities[n1][k1] += capacity;
+    _capacities[n2][k2] += reverseCapacity;
+    _reverseSlots[n1][k1] = static_cast<std::uint8_t>(k2);
+    _reverseSlots[n2][k2] = static_cast<std::uint8_t>(k1);
+}
+
+MaxFlow_Tetra::ValueType MaxFlow_Tetra::compute()
+{
+    const NodeType nbNodes = static_cast<NodeType>(_terminalCapacity.size());
+
+    _parent.assign(nbNodes, noParent);
+    _tree.assign(nbNodes, sourceTree);
+    _isActive.assign(nbNodes, 0);
+    _timestamp.assign(nbNodes, 0);
+    _distance.assign(nbNodes, 0);
+
+    const int nbBlocks = (_nbBlocks > 0) ? _nbBlocks : ((omp_get_max_threads() > 1) ? 4 * omp_get_max_threads() : 1);
+
+    double flow = 0.0;
+
+    if(nbBlocks > 1 && nbNodes > nbBlocks)
+    {
+        ALICEVISION_LOG_INFO("MaxFlow_Tetra: compute the flow inside " << nbBlocks << " blocks of nodes.");
+
+        std::vector<double> blocksFlow(nbBlocks, 0.0);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < nbBlocks; ++b)
+        {
+            const NodeType begin = static_cast<NodeType>(static_cast<std::int64_t>(nbNodes) * b / nbBlocks);
+            const NodeType end = static_cast<NodeType>(static_cast<std::int64_t>(nbNodes) * (b + 1) / nbBlocks);
+            blocksFlow[b] = computeRange(begin, end);
+        }
+
+        for(double blockFlow : blocksFlow)
+            flow += blockFlow;
+
+        ALICEVISION_LOG_INFO("MaxFlow_Tetra: flow inside the blocks: " << flow);
+    }
+
+    ALICEVISION_LOG_INFO("MaxFlow_Tetra: compute the flow on the whole graph.");
+    flow += computeRange(0, nbNodes);
+
+    return static_cast<ValueType>(flow);
+}
+
+MaxFlow_Tetra::ValueType MaxFlow_Tetra::computeRange(NodeType begin, NodeType end)
+{
+    const auto isInRange = [begin, end](NodeType n) { return n >= begin && n < end; };
+
+    std::deque<NodeType> activeNodes;
+    std::deque<NodeType> orphanNodes;
+
+    const auto setActive = [&](NodeType n)
+    {
+        if(!_isActive[n])
+        {
+            _isActive[n] = 1;
+            activeNodes.push_back(n);
+        }
+    };
+
+    // initialize the search trees with the nodes linked to the terminals
+    for(NodeType n = begin; n < end; ++n)
+    {
+        _isActive[n] = 0;
+        _timestamp[n] = 0;
+        if(_terminalCapacity[n] != 0.0f)
+        {
+            _tree[n] = (_terminalCapacity[n] > 0.0f) ? sourceTree : sinkTree;
+            _parent[n] = terminalParent;
+            _distance[n] = 1;
+            setActive(n);
+        }
+        else
+        {
+            _parent[n] = noParent;
+        }
+    }
+
+    double flow = 0.0;
+    int time = 0;
+    NodeType currentNode = -1;
+
+    while(true)
+    {
+        // get the next active node
+        NodeType i = -1;
+        if(currentNode != -1 && _parent[currentNode] != noParent)
+        {
+            i = currentNode;
+        }
+        else
+        {
+            while(!activeNodes.empty())
+            {
+                const NodeType n = activeNodes.front();
+                activeNodes.pop_front();
+                _isActive[n] = 0;
+                if(_parent[n] != noParent)
+                {
+                    i = n;
+                    break;
+                }
+            }
+        }
+        if(i == -1)
+            break;
+
+        // growth: look for a path between the two trees
+        // (a -> b is the edge linking the source tree to the sink tree)
+        NodeType a = -1;
+        int slotAB = -1;
+
+        for(int k = 0; k < nbNeighbors; ++k)
+        {
+            const NodeType j = _neighbors[i][k];
+            if(j == -1 || !isInRange(j))
+                continue;
+            const int reverseK = _reverseSlots[i][k];
+
+            if(_tree[i] == sourceTree ? (_capacities[i][k] <= 0.0f) : (_capacities[j][reverseK] <= 0.0f))
+                continue;
+
+            if(_parent[j] == noParent)
+            {
+                _tree[j] = _tree[i];
+                _parent[j] = static_cast<std::uint8_t>(reverseK);
+                _timestamp[j] = _timestamp[i];
+                _distance[j] = _distance[i] + 1;
+                setActive(j);
+            }
+            else if(_tree[j] != _tree[i])
+            {
+                if(_tree[i] == sourceTree)
+                {
+                    a = i;
+                    slotAB = k;
+                }
+                else
+                {
+                    a = j;
+                    slotAB = reverseK;
+                }
+                break;
+            }
+            else if(_timestamp[j] <= _timestamp[i] && _distance[j] > _distance[i])
+            {
+                // shorter path to the terminal through i
+                _parent[j] = static_cast<std::uint8_t>(reverseK);
+                _timestamp[j] = _timestamp[i];
+                _distance[j] = _distance[i] + 1;
+            }
+        }
+
+        ++time;
+
+        if(a == -1)
+        {
+            currentNode = -1;
+            continue;
+        }
+        // the node i may have other paths
+        currentNode = i;
+
+        // augmentation
+        const NodeType b = _neighbors[a][slotAB];
+        {
+            // bottleneck
+            ValueType bottleneck = _capacities[a][slotAB];
+            for(NodeType x = a;;)
+            {
+                const int p = _parent[x];
+                if(p == terminalParent)
+                {
+                    bottleneck = std::min(bottleneck, _terminalCapacity[x]);
+                    break;
+                }
+                const NodeType y = _neighbors[x][p];
+                bottleneck = std::min(bottleneck, _capacities[y][_reverseSlots[x][p]]);
+                x = y;
+            }
+            for(NodeType x = b;;)
+            {
+                const int p = _parent[x];
+                if(p == terminalParent)
+                {
+                    bottleneck = std::min(bottleneck, -_terminalCapacity[x]);
+                    break;
+                }
+                bottleneck = std::min(bottleneck, _capacities[x][p]);
+                x = _neighbors[x][p];
+            }
+
+            // push the flow
+            _capacities[a][slotAB] -= bottleneck;
+            _capacities[b][_reverseSlots[a][slotAB]] += bottleneck;
+
+            for(NodeType x = a;;)
+            {
+                const int p = _parent[x];
+                if(p == terminalParent)
+                {
+                    _terminalCapacity[x] -= bottleneck;
+                    if(_terminalCapacity[x] <= 0.0f)
+                    {
+                        _parent[x] = orphanParent;
+                        orphanNodes.push_front(x);
+                    }
+                    break;
+                }
+                const NodeType y = _neighbors[x][p];
+                const int reverseP = _reverseSlots[x][p];
+                _capacities[x][p] += bottleneck;
+                _capacities[y][reverseP] -= bottleneck;
+                if(_capacities[y][reverseP] <= 0.0f)
+                {
+                    _parent[x] = orphanParent;
+                    orphanNodes.push_front(x);
+                }
+                x = y;
+            }
+            for(NodeType x = b;;)
+            {
+                const int p = _parent[x];
+                if(p == terminalParent)
+                {
+                    _terminalCapacity[x] += bottleneck;
+                    if(_terminalCapacity[x] >= 0.0f)
+                    {
+                        _parent[x] = orphanParent;
+                        orphanNodes.push_front(x);
+                    }
+                    break;
+                }
+                const NodeType y = _neighbors[x][p];
+                _capacities[y][_reverseSlots[x][p]] += bottleneck;
+                _capacities[x][p] -= bottleneck;
+                if(_capacities[x][p] <= 0.0f)
+                {
+                    _parent[x] = orphanParent;
+                    orphanNodes.push_front(x);
+                }
+                x = y;
+            }
+
+            flow += bottleneck;
+        }
+
+        // adoption: look for a new parent for each orphan, in the same tree
+        while(!orphanNodes.empty())
+        {
+            const NodeType o = orphanNodes.front();
+            orphanNodes.pop_front();
+            const bool isSourceOrphan = (_tree[o] == sourceTree);
+
+            int bestSlot = -1;
+            int bestDistance = std::numeric_limits<int>::max();
+
+            for(int k = 0; k < nbNeighbors; ++k)
+            {
+                const NodeType j = _neighbors[o][k];
+                if(j == -1 || !isInRange(j) || _parent[j] == noParent || _tree[j] != _tree[o])
+                    continue;
+                if(isSourceOrphan ? (_capacities[j][_reverseSlots[o][k]] <= 0.0f) : (_capacities[o][k] <= 0.0f))
+                    continue;
+
+                // check that j is still linked to the terminal and compute its distance
+                int d = 0;
+                for(NodeType x = j;;)
+                {
+                    if(_timestamp[x] == time)
+                    {
+                        d += _distance[x];
+                        break;
+                    }
+                    const int p = _parent[x];
+                    ++d;
+                    if(p == terminalParent)
+                    {
+                        _timestamp[x] = time;
+                        _distance[x] = 1;
+                        break;
+                    }
+                    if(p == orphanParent)
+                    {
+                        d = std::numeric_limits<int>::max();
+                        break;
+                    }
+                    x = _neighbors[x][p];
+                }
+
+                if(d == std::numeric_limits<int>::max())
+                    continue;
+
+                if(d < bestDistance)
+                {
+                    bestSlot = k;
+                    bestDistance = d;
+                }
+                // mark the path to the terminal
+                for(NodeType x = j; _timestamp[x] != time; x = _neighbors[x][_parent[x]])
+                {
+                    _timestamp[x] = time;
+                    _distance[x] = d--;
+                }
+            }
+
+            if(bestSlot != -1)
+            {
+                _parent[o] = static_cast<std::uint8_t>(bestSlot);
+                _timestamp[o] = time;
+                _distance[o] = bestDistance + 1;
+                continue;
+            }
+
+            // no parent found: the orphan becomes a free node
+            for(int k = 0; k < nbNeighbors; ++k)
+            {
+                const NodeType j = _neighbors[o][k];
+                if(j == -1 || !isInRange(j) || _parent[j] == noParent || _tree[j] != _tree[o])
+                    continue;
+                if(isSourceOrphan ? (_capacities[j][_reverseSlots[o][k]] > 0.0f) : (_capacities[o][k] > 0.0f))
+                    setActive(j);
+                const int p = _parent[j];
+                if(p != terminalParent && p != orphanParent && _neighbors[j][p] == o)
+                {
+                    _parent[j] = orphanParent;
+                    orphanNodes.push_back(j);
+                }
+            }
+            _parent[o] = noParent;
+        }
+    }
+
+    return static_cast<ValueType>(flow);
+}
+
+void MaxFlow_Tetra::saveGraph(const std::string& filepath) const
+{
+    std::ofstream stream(filepath, std::ios::binary);
+    if(!stream)
+        throw std::runtime_error("Unable to open file '" + filepath + "' for writing.");
+
+    const std::uint64_t nbNodes = _terminalCapacity.size();
+    stream.write(maxflowGraphMagic, sizeof(maxflowGraphMagic));
+    stream.write(reinterpret_cast<const char*>(&maxflowGraphVersion), sizeof(maxflowGraphVersion));
+    stream.write(reinterpret_cast<const char*>(&nbNodes), sizeof(nbNodes));
+    writeArray(stream, _terminalCapacity);
+    writeArray(stream, _neighbors);
+    writeArray(stream, _reverseSlots);
+    writeArray(stream, _capacities);
+
+    if(!stream)
+        throw std::runtime_error("Unable to write the maxflow graph in '" + filepath + "'.");
+
+    ALICEVISION_LOG_INFO("Maxflow graph saved: " << filepath << " (" << nbNodes << " nodes).");
+}
+
+void MaxFlow_Tetra::loadGraph(const std::string& filepath)
+{
+    std::ifstream stream(filepath, std::ios::binary);
+    if(!stream)
+        throw std::runtime_error("Unable to open file '" + filepath + "'.");
+
+    char magic[sizeof(maxflowGraphMagic)];
+    std::uint32_t version = 0;
+    std::uint64_t nbNodes = 0;
+    stream.read(magic, sizeof(magic));
+    stream.read(reinterpret_cast<char*>(&version), sizeof(version));
+    stream.read(reinterpret_cast<char*>(&nbNodes), sizeof(nbNodes));
+
+    if(!stream || !std::equal(magic, magic + sizeof(magic), maxflowGraphMagic) || version != maxflowGraphVersion)
+        throw std::runtime_error("Invalid maxflow graph file '" + filepath + "'.");
+
+    reset(nbNodes);
+    readArray(stream, _terminalCapacity);
+    readArray(stream, _neighbors);
+    readArray(stream, _reverseSlots);
+    readArray(stream, _capacities);
+
+    if(!stream)
+        throw std::runtime_error("Unable to read the maxflow graph in '" + filepath + "'.");
+}
+
+} // namespace fuseCut
+} // namespace aliceVision
@@ -0,0 +1,154 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace fuseCut {
+
+/**
+ * @brief Maxflow computation specialized for the adjacency of a tetrahedralization.
+ *
+ * Each node (tetrahedron) has at most 4 neighbors (one per facet), so the residual graph is stored
+ * as 4 fixed slots per node: no edge objects, no reverse edge lookup and no terminal nodes
+ * (the source/sink capacities are folded into a single signed value per node).
+ * It needs ~50 bytes per node, where MaxFlow_AdjList needs several hundreds.
+ *
+ * The solver is the Boykov-Kolmogorov augmenting path algorithm. If multiple blocks are used,
+ * the nodes are split into ranges of consecutive indexes which are solved in parallel
+ * (the flow found inside a range is a valid flow of the whole graph) before a final pass on the
+ * whole graph. As the cells of the Delaunay tetrahedralization are spatially sorted, most of the
+ * flow is found during the parallel step.
+ *
+ * @see MaxFlow_AdjList, MaxFlow_CSR for generic graphs.
+ */
+class MaxFlow_Tetra
+{
+public:
+    using NodeType = int;
+    using ValueType = float;
+
+    static const int nbNeighbors = 4;
+
+    MaxFlow_Tetra() = default;
+    explicit MaxFlow_Tetra(std::size_t numNodes);
+
+    void reset(std::size_t numNodes);
+
+    inline void addNode(NodeType n, ValueType source, ValueType sink)
+    {
+        assert(source >= 0 && sink >= 0);
+        _terminalCapacity[n] += source - sink;
+    }
+
+    /**
+     * @brief Set the edge from the node n to its neighbor in the slot k.
+     * The reverse edge has to be set from the neighbor, with its own slot.
+     * @note Can be called in parallel for different nodes.
+     * @param[in] n the node
+     * @param[in] k the slot of the neighbor in the node n (the local facet index for a tetrahedron)
+     * @param[in] neighbor the neighbor node
+     * @param[in] reverseSlot the slot of the node n in the neighbor
+     * @param[in] capacity the capacity from n to the neighbor
+     */
+    inline void setEdge(NodeType n, int k, NodeType neighbor, int reverseSlot, ValueType capacity)
+    {
+        assert(capacity >= 0);
+        _neighbors[n][k] = neighbor;
+        _reverseSlots[n][k] = static_cast<std::uint8_t>(reverseSlot);
+        _capacities[n][k] = capacity;
+    }
+
+    /**
+     * @brief Add an edge between two nodes.
+     * @note Adding the same edge multiple times accumulates the capacities.
+     * @throw std::runtime_error if a node has more than 4 neighbors
+     */
+    void addEdge(NodeType n1, NodeType n2, ValueType capacity, ValueType reverseCapacity);
+
+    /**
+     * @brief Set the number of node ranges solved in parallel before the final pass.
+     * @param[in] nbBlocks 0 for automatic, 1 to disable the parallel step
+     */
+    void setNbBlocks(int nbBlocks) { _nbBlocks = nbBlocks; }
+
+    ValueType compute();
+
+    std::size_t getNbNodes() const { return _terminalCapacity.size(); }
+
+    /// source capacity if positive, sink capacity if negative (residual after compute)
+    ValueType getTerminalCapacity(NodeType n) const { return _terminalCapacity[n]; }
+
+    /// neighbor in the slot k of the node n, -1 if none
+    NodeType getNeighbor(NodeType n, int k) const { return _neighbors[n][k]; }
+
+    /// capacity of the edge from n to its neighbor in the slot k (residual after compute)
+    ValueType getCapacity(NodeType n, int k) const { return _capacities[n][k]; }
+
+    /**
+     * @brief Save the graph (before compute) in a binary file.
+     * Useful to benchmark maxflow implementations on real graphs.
+     */
+    void saveGraph(const std::string& filepath) const;
+
+    /// Load a graph saved with saveGraph
+    void loadGraph(const std::string& filepath);
+
+    /// is empty
+    inline bool isSource(NodeType n) const
+    {
+        return _parent[n] != noParent && _tree[n] == sourceTree;
+    }
+    /// is full
+    inline bool isTarget(NodeType n) const
+    {
+        return _parent[n] != noParent && _tree[n] == sinkTree;
+    }
+
+private:
+    enum : std::uint8_t
+    {
+        terminalParent = nbNeighbors,
+        orphanParent,
+        noParent
+    };
+    enum : std::uint8_t
+    {
+        sourceTree = 0,
+        sinkTree
+    };
+
+    /// Boykov-Kolmogorov on the nodes [begin, end[, ignoring the edges going out of the range
+    ValueType computeRange(NodeType begin, NodeType end);
+
+    /// per node, neighbors by slot
+    std::vector<std::array<NodeType, nbNeighbors>> _neighbors;
+    /// per node, residual capacity of the edge to the neighbor of each slot
+    std::vector<std::array<ValueType, nbNeighbors>> _capacities;
+    /// per node, slot of the reverse edge in the neighbor of each slot
+    std::vector<std::array<std::uint8_t, nbNeighbors>> _reverseSlots;
+    /// per node, residual capacity from the source (> 0) or to the sink (< 0)
+    std::vector<ValueType> _terminalCapacity;
+
+    // search trees
+    /// slot of the parent, terminalParent, orphanParent or noParent (free node)
+    std::vector<std::uint8_t> _parent;
+    std::vector<std::uint8_t> _tree;
+    std::vector<std::uint8_t> _isActive;
+    /// timestamp and distance to the terminal (heuristics to keep the trees short)
+    std::vector<int> _timestamp;
+    std::vector<int> _distance;
+
+    int _nbBlocks = 0;
+};
+
+} // namespace fuseCut
+} // namespace aliceVision
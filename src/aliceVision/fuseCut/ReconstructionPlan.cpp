@@ -14,6 +14,12 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
 namespace aliceVision {
 namespace fuseCut {
 
@@ -166,7 +172,7 @@ bool ReconstructionPlan::divideBox(Voxel& LU1o, Voxel& RD1o, Voxel& LU2o, Voxel&
     return false;
 }
 
-StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(unsigned long maxTracks)
+StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(unsigned long maxTracks, float inflateFactor)
 {
     Voxel actHexahLU = Voxel(0, 0, 0);
     Voxel actHexahRD = voxelDim - Voxel(1, 1, 1);
@@ -229,7 +235,7 @@ StaticVector<Point3d>* ReconstructionPlan::computeReconstructionPlanBinSearch(un
             */
 
             getHexah(hexah, actHexahLU, actHexahRD);
-            mvsUtils::inflateHexahedron(hexah, hexahinf, 1.05);
+            mvsUtils::inflateHexahedron(hexah, hexahinf, inflateFactor);
             for(int k = 0; k < 8; k++)
             {
                 hexahsToReconstruct->push_back(hexahinf[k]);
@@ -248,62 +254,112 @@ void ReconstructionPlan::getHexahedronForID(float dist, int id, Point3d* out)
     mvsUtils::inflateHexahedron(&(*voxels)[id * 8], out, dist);
 }
 
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls)
+namespace {
+/// first int of a voxels array file with its inflate factor (the arrays of saveArrayToFile start with a size or -1)
+const int voxelsArrayFileMagic = -2;
+} // namespace
+
+void saveVoxelsArrayToFile(const std::string& voxelsArrayFileName, const StaticVector<Point3d>& voxelsArray, float inflateFactor)
 {
-    StaticVector<Point3d>* voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    FILE* f = fopen(voxelsArrayFileName.c_str(), "wb");
+    if(f == NULL)
+        throw std::runtime_error("saveVoxelsArrayToFile: can't open file " + voxelsArrayFileName);
+
+    const int n = voxelsArray.size();
+    fwrite(&voxelsArrayFileMagic, sizeof(int), 1, f);
+    fwrite(&inflateFactor, sizeof(float), 1, f);
+    fwrite(&n, sizeof(int), 1, f);
+    if(n > 0)
+        fwrite(&voxelsArray[0], sizeof(Point3d), n, f);
+    fclose(f);
+}
 
-    ReconstructionPlan* rp =
-        new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->pc, ls->spaceVoxelsFolderName);
+StaticVector<Point3d>* loadVoxelsArrayFromFile(const std::string& voxelsArrayFileName, float& out_inflateFactor)
+{
+    FILE* f = fopen(voxelsArrayFileName.c_str(), "rb");
+    if(f == NULL)
+        throw std::runtime_error("loadVoxelsArrayFromFile: can't open file " + voxelsArrayFileName);
 
-    StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = new StaticVector<Point3d>();
-    hexahsToExcludeFromResultingMesh->reserve(voxelsArray->size());
+    int magic = 0;
+    const bool withInflateFactor = (fread(&magic, sizeof(int), 1, f) == 1) && (magic == voxelsArrayFileMagic);
+    if(!withInflateFactor)
+    {
+        // voxels array saved without its inflate factor
+        fclose(f);
+        out_inflateFactor = 0.0f;
+        return loadArrayFromFile<Point3d>(voxelsArrayFileName);
+    }
 
-    for(int i = 0; i < voxelsArray->size() / 8; i++)
+    int n = 0;
+    if(fread(&out_inflateFactor, sizeof(float), 1, f) != 1 || fread(&n, sizeof(int), 1, f) != 1 || n < 0)
     {
-        ALICEVISION_LOG_INFO("Reconstructing " << (voxelsArray->size() / 8) << "-th Voxel of " <<  i << ".");
+        fclose(f);
+        throw std::runtime_error("loadVoxelsArrayFromFile: invalid file " + voxelsArrayFileName);
+    }
+
+    StaticVector<Point3d>* voxelsArray = new StaticVector<Point3d>();
+    voxelsArray->resize(n);
+    if(n > 0 && fread(&(*voxelsArray)[0], sizeof(Point3d), n, f) != n)
+    {
+        delete voxelsArray;
+        fclose(f);
+        throw std::runtime_error("loadVoxelsArrayFromFile: truncated file " + voxelsArrayFileName);
+    }
+    fclose(f);
+    return voxelsArray;
+}
 
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls,
+                                            const FuseParams& fuseParams, int rangeStart, int rangeSize)
+{
+    float inflateFactor;
+    StaticVector<Point3d>* voxelsArray = loadVoxelsArrayFromFile(voxelsArrayFileName, inflateFactor);
+
+    const int nbVoxels = voxelsArray->size() / 8;
+    const int voxelBegin = std::max(rangeStart, 0);
+    const int voxelEnd = (rangeSize < 0) ? nbVoxels : std::min(voxelBegin + rangeSize, nbVoxels);
+
+    ReconstructionPlan* rp =
+        new ReconstructionPlan(ls->dimensions, &ls->space[0], ls->mp, ls->pc, ls->spaceVoxelsFolderName);
+
+    for(int i = voxelBegin; i < voxelEnd; i++)
+    {
         const std::string folderName = ls->getReconstructionVoxelFolder(i);
         bfs::create_directory(folderName);
 
+        // mesh.bin is written last: if it exists, the voxel has been fully reconstructed (maybe by another process)
         const std::string meshBinFilepath = folderName + "mesh.bin";
-        if(!mvsUtils::FileExists(meshBinFilepath))
+        if(mvsUtils::FileExists(meshBinFilepath))
         {
-            StaticVector<int>* voxelsIds = rp->voxelsIdsIntersectingHexah(&(*voxelsArray)[i * 8]);
-            DelaunayGraphCut delaunayGC(ls->mp, ls->pc);
-            Point3d* hexah = &(*voxelsArray)[i * 8];
-            delaunayGC.reconstructVoxel(hexah, voxelsIds, folderName, ls->getSpaceCamsTracksDir(), false,
-                                  (VoxelsGrid*)rp, ls->getSpaceSteps(), FuseParams());
-            delete voxelsIds;
-
-            // Save mesh as .bin and .obj
-            mesh::Mesh* mesh = delaunayGC.createMesh();
-            StaticVector<StaticVector<int>*>* ptsCams = delaunayGC.createPtsCams();
-            StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
-
-            mesh::meshPostProcessing(mesh, ptsCams, usedCams, *ls->mp, *ls->pc, ls->mp->mvDir, hexahsToExcludeFromResultingMesh, hexah);
-            mesh->saveToBin(folderName + "mesh.bin");
-            mesh->saveToObj(folderName + "mesh.obj");
-
-            saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
-            deleteArrayOfArrays<int>(&ptsCams);
-
-            delete mesh;
+            ALICEVISION_LOG_INFO("Voxel " << i << " of " << nbVoxels << " already reconstructed.");
+            continue;
         }
 
-        /*
-        if(doComputeColoredMeshes)
-        {
-            std::string resultFolderName = folderName + "/";
-            computeColoredMesh(resultFolderName, ls);
-        }
-        */
-        Point3d hexahThin[8];
-        mvsUtils::inflateHexahedron(&(*voxelsArray)[i * 8], hexahThin, 0.9);
-        for(int k = 0; k < 8; k++)
-        {
-            hexahsToExcludeFromResultingMesh->push_back(hexahThin[k]);
-        }
-        delete hexahsToExcludeFromResultingMesh;
+        ALICEVISION_LOG_INFO("Reconstructing voxel " << i << " of " << nbVoxels << ".");
+
+        StaticVector<int>* voxelsIds = rp->voxelsIdsIntersectingHexah(&(*voxelsArray)[i * 8]);
+        DelaunayGraphCut delaunayGC(ls->mp, ls->pc);
+        Point3d* hexah = &(*voxelsArray)[i * 8];
+        delaunayGC.reconstructVoxel(hexah, voxelsIds, folderName, ls->getSpaceCamsTracksDir(), false,
+                              (VoxelsGrid*)rp, ls->getSpaceSteps(), fuseParams);
+        delete voxelsIds;
+
+        mesh::Mesh* mesh = delaunayGC.createMesh();
+        StaticVector<StaticVector<int>*>* ptsCams = delaunayGC.createPtsCams();
+        StaticVector<int> usedCams = delaunayGC.getSortedUsedCams();
+
+        // the overlaps between the voxels are resolved when the meshes are stitched
+        StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = nullptr;
+        mesh::meshPostProcessing(mesh, ptsCams, usedCams, *ls->mp, *ls->pc, folderName, hexahsToExcludeFromResultingMesh, hexah);
+
+        // Save visibilities and mesh as .obj and .bin
+        saveArrayOfArraysToFile<int>(folderName + "meshPtsCamsFromDGC.bin", ptsCams);
+        deleteArrayOfArrays<int>(&ptsCams);
+
+        mesh->saveToObj(folderName + "mesh.obj");
+        mesh->saveToBin(meshBinFilepath);
+
+        delete mesh;
     }
     delete rp;
     delete voxelsArray;
@@ -525,5 +581,237 @@ mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls)
     return me;
 }
 
+mesh::Mesh* stitchMeshes(const std::vector<std::string>& recsDirs, const StaticVector<Point3d>& voxelsArray,
+                         float inflateFactor, float weldDistanceFactor,
+                         StaticVector<StaticVector<int>*>** out_ptsCams)
+{
+    mesh::Mesh* me = new mesh::Mesh();
+    me->pts = new StaticVector<Point3d>();
+    me->tris = new StaticVector<mesh::Mesh::triangle>();
+    StaticVector<StaticVector<int>*>* ptsCams = new StaticVector<StaticVector<int>*>();
+
+    // voxel of each vertex on the border of its voxel mesh, -1 for the inner vertices
+    std::vector<int> ptsBorderVoxel;
+
+    for(int i = 0; i < recsDirs.size(); ++i)
+    {
+        const std::string meshBinFilepath = recsDirs[i] + "mesh.bin";
+        if(!mvsUtils::FileExists(meshBinFilepath))
+        {
+            ALICEVISION_LOG_WARNING("Missing mesh of the voxel " << i << ": " << meshBinFilepath);
+            continue;
+        }
+
+        mesh::Mesh mei;
+        mei.loadFromBin(meshBinFilepath);
+        StaticVector<StaticVector<int>*>* ptsCamsi = loadArrayOfArraysFromFile<int>(recsDirs[i] + "meshPtsCamsFromDGC.bin");
+        if(ptsCamsi->size() != mei.pts->size())
+        {
+            deleteArrayOfArrays<int>(&ptsCamsi);
+            throw std::runtime_error("Visibilities not consistent with the mesh in: " + recsDirs[i]);
+        }
+
+        // keep the triangles of the voxel without overlap, a triangle on the border of two voxels is kept by only one of them
+        Point3d voxelHexah[8];
+        mvsUtils::inflateHexahedron(&voxelsArray[i * 8], voxelHexah, 1.0f / inflateFactor);
+
+        StaticVector<int> trisIdsToStay;
+        trisIdsToStay.reserve(mei.tris->size());
+        for(int t = 0; t < mei.tris->size(); ++t)
+        {
+            const mesh::Mesh::triangle& tri = (*mei.tris)[t];
+            const Point3d barycenter = ((*mei.pts)[tri.v[0]] + (*mei.pts)[tri.v[1]] + (*mei.pts)[tri.v[2]]) / 3.0;
+            if(mvsUtils::isPointInHexahedron(barycenter, voxelHexah))
+                trisIdsToStay.push_back(t);
+        }
+        mei.letJustTringlesIdsInMesh(&trisIdsToStay);
+
+        StaticVector<int>* ptIdToNewPtId = nullptr;
+        mei.removeFreePointsFromMesh(&ptIdToNewPtId);
+
+        // border vertices: vertices of the edges used by a single triangle
+        std::vector<std::pair<int, int>> edges;
+        edges.reserve(3 * mei.tris->size());
+        for(int t = 0; t < mei.tris->size(); ++t)
+        {
+            const mesh::Mesh::triangle& tri = (*mei.tris)[t];
+            for(int k = 0; k < 3; ++k)
+                edges.push_back(std::minmax(tri.v[k], tri.v[(k + 1) % 3]));
+        }
+        std::sort(edges.begin(), edges.end());
+
+        std::vector<bool> isBorder(mei.pts->size(), false);
+        for(std::size_t e = 0; e < edges.size();)
+        {
+            std::size_t next = e + 1;
+            while(next < edges.size() && edges[next] == edges[e])
+                ++next;
+            if(next - e == 1)
+            {
+                isBorder[edges[e].first] = true;
+                isBorder[edges[e].second] = true;
+            }
+            e = next;
+        }
+
+        const int ptsOffset = me->pts->size();
+        me->pts->reserveAddIfNeeded(mei.pts->size(), me->pts->size());
+        me->tris->reserveAddIfNeeded(mei.tris->size(), me->tris->size());
+        me->addMesh(&mei);
+
+        ptsCams->resize_with(me->pts->size(), nullptr);
+        for(int j = 0; j < ptIdToNewPtId->size(); ++j)
+        {
+            const int newPtId = (*ptIdToNewPtId)[j];
+            if(newPtId > -1)
+                (*ptsCams)[ptsOffset + newPtId] = (*ptsCamsi)[j];
+            else
+                delete (*ptsCamsi)[j];
+        }
+        delete ptsCamsi; // the visibilities are moved to ptsCams
+        delete ptIdToNewPtId;
+
+        for(int j = 0; j < mei.pts->size(); ++j)
+            ptsBorderVoxel.push_back(isBorder[j] ? i : -1);
+
+        ALICEVISION_LOG_INFO("Voxel " << i << " mesh stitched: " << mei.pts->size() << " vertices, "
+                             << mei.tris->size() << " triangles.");
+    }
+
+    if(me->tris->empty())
+    {
+        *out_ptsCams = ptsCams;
+        return me;
+    }
+
+    // weld the border vertices of different voxels, using a regular grid of the weld distance
+    const double weldDistance = weldDistanceFactor * me->computeAverageEdgeLength();
+
+    std::vector<int> borderPts;
+    for(int j = 0; j < ptsBorderVoxel.size(); ++j)
+    {
+        if(ptsBorderVoxel[j] > -1)
+            borderPts.push_back(j);
+    }
+
+    std::vector<int> ptIdToWeldedPtId(me->pts->size());
+    std::iota(ptIdToWeldedPtId.begin(), ptIdToWeldedPtId.end(), 0);
+    int nbWeldedPts = 0;
+
+    if(weldDistance > 0.0 && !borderPts.empty())
+    {
+        Point3d bboxMin = (*me->pts)[borderPts[0]];
+        for(int j : borderPts)
+        {
+            const Point3d& p = (*me->pts)[j];
+            bboxMin = Point3d(std::min(bboxMin.x, p.x), std::min(bboxMin.y, p.y), std::min(bboxMin.z, p.z));
+        }
+        const auto getCell = [&](const Point3d& p, int axis) {
+            return static_cast<std::int64_t>((p.m[axis] - bboxMin.m[axis]) / weldDistance);
+        };
+        const auto getCellKey = [](std::int64_t x, std::int64_t y, std::int64_t z) {
+            return (x << 42) | (y << 21) | z;
+        };
+
+        // border vertices kept, per cell
+        std::unordered_map<std::int64_t, std::vector<int>> cells;
+        // voxels welded to each kept vertex, to weld at most one vertex of each voxel
+        std::unordered_map<int, std::vector<int>> weldedVoxels;
+
+        for(int j : borderPts)
+        {
+            const Point3d& p = (*me->pts)[j];
+            const std::int64_t cx = getCell(p, 0);
+            const std::int64_t cy = getCell(p, 1);
+            const std::int64_t cz = getCell(p, 2);
+
+            int closestPtId = -1;
+            double closestDist = weldDistance;
+            for(std::int64_t x = std::max(cx - 1, std::int64_t(0)); x <= cx + 1; ++x)
+            for(std::int64_t y = std::max(cy - 1, std::int64_t(0)); y <= cy + 1; ++y)
+            for(std::int64_t z = std::max(cz - 1, std::int64_t(0)); z <= cz + 1; ++z)
+            {
+                const auto cellIt = cells.find(getCellKey(x, y, z));
+                if(cellIt == cells.end())
+                    continue;
+                for(int k : cellIt->second)
+                {
+                    if(ptsBorderVoxel[k] == ptsBorderVoxel[j])
+                        continue;
+                    const auto weldedIt = weldedVoxels.find(k);
+                    if(weldedIt != weldedVoxels.end() &&
+                       std::find(weldedIt->second.begin(), weldedIt->second.end(), ptsBorderVoxel[j]) != weldedIt->second.end())
+                        continue;
+                    const double dist = ((*me->pts)[k] - p).size();
+                    if(dist < closestDist)
+                    {
+                        closestDist = dist;
+                        closestPtId = k;
+                    }
+                }
+            }
+
+            if(closestPtId == -1)
+            {
+                cells[getCellKey(cx, cy, cz)].push_back(j);
+                continue;
+            }
+
+            ptIdToWeldedPtId[j] = closestPtId;
+            weldedVoxels[closestPtId].push_back(ptsBorderVoxel[j]);
+            ++nbWeldedPts;
+
+            // merge the visibilities
+            StaticVector<int>*& cams = (*ptsCams)[closestPtId];
+            StaticVector<int>*& weldedCams = (*ptsCams)[j];
+            if(cams == nullptr)
+            {
+                std::swap(cams, weldedCams);
+            }
+            else if(weldedCams != nullptr)
+            {
+                for(int c = 0; c < weldedCams->size(); ++c)
+                {
+                    if(cams->indexOf((*weldedCams)[c]) == -1)
+                        cams->push_back((*weldedCams)[c]);
+                }
+            }
+        }
+    }
+
+    ALICEVISION_LOG_INFO("Stitching: " << nbWeldedPts << " vertices welded on " << borderPts.size() << " border vertices.");
+
+    // remove the triangles collapsed by the welding and the welded vertices
+    StaticVector<int> trisIdsToStay;
+    trisIdsToStay.reserve(me->tris->size());
+    for(int t = 0; t < me->tris->size(); ++t)
+    {
+        mesh::Mesh::triangle& tri = (*me->tris)[t];
+        for(int k = 0; k < 3; ++k)
+            tri.v[k] = ptIdToWeldedPtId[tri.v[k]];
+        if(tri.v[0] != tri.v[1] && tri.v[1] != tri.v[2] && tri.v[2] != tri.v[0])
+            trisIdsToStay.push_back(t);
+    }
+    me->letJustTringlesIdsInMesh(&trisIdsToStay);
+
+    StaticVector<int>* ptIdToNewPtId = nullptr;
+    me->removeFreePointsFromMesh(&ptIdToNewPtId);
+
+    *out_ptsCams = new StaticVector<StaticVector<int>*>();
+    (*out_ptsCams)->resize_with(me->pts->size(), nullptr);
+    for(int j = 0; j < ptIdToNewPtId->size(); ++j)
+    {
+        const int newPtId = (*ptIdToNewPtId)[j];
+        if(newPtId > -1)
+            (**out_ptsCams)[newPtId] = (*ptsCams)[j];
+        else
+            delete (*ptsCams)[j];
+    }
+    delete ptsCams;
+    delete ptIdToNewPtId;
+
+    return me;
+}
+
 } // namespace fuseCut
 } // namespace aliceVision
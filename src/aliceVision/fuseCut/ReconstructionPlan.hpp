@@ -15,6 +15,8 @@
 namespace aliceVision {
 namespace fuseCut {
 
+struct FuseParams;
+
 class ReconstructionPlan : public VoxelsGrid
 {
 public:
@@ -26,18 +28,62 @@ public:
     unsigned long getNTracks(const Voxel& LU, const Voxel& RD);
     bool divideBox(Voxel& LU1o, Voxel& RD1o, Voxel& LU2o, Voxel& RD2o, const Voxel& LUi, const Voxel& RDi,
                    unsigned long maxTracks);
-    StaticVector<Point3d>* computeReconstructionPlanBinSearch(unsigned long maxTracks);
+    /**
+     * @brief Split the space in boxes of less than maxTracks tracks.
+     * @param[in] maxTracks max number of tracks per box
+     * @param[in] inflateFactor scale of the returned boxes, to overlap with their neighbors
+     * @return the 8 corners of each box
+     */
+    StaticVector<Point3d>* computeReconstructionPlanBinSearch(unsigned long maxTracks, float inflateFactor = 1.05f);
 
     StaticVector<int>* voxelsIdsIntersectingHexah(Point3d* hexah);
     void getHexahedronForID(float dist, int id, Point3d* out);
 };
 
 void reconstructAccordingToOptimalReconstructionPlan(int gl, LargeScale* ls);
-void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls);
+
+/**
+ * @brief Save the voxels array (8 corners per voxel) with the inflate factor used to compute it.
+ */
+void saveVoxelsArrayToFile(const std::string& voxelsArrayFileName, const StaticVector<Point3d>& voxelsArray, float inflateFactor);
+
+/**
+ * @brief Load a voxels array saved with saveVoxelsArrayToFile.
+ * @param[out] out_inflateFactor the inflate factor used to compute the voxels array,
+ *             0 for a voxels array saved without it
+ */
+StaticVector<Point3d>* loadVoxelsArrayFromFile(const std::string& voxelsArrayFileName, float& out_inflateFactor);
+
+/**
+ * @brief Reconstruct the voxels of the voxels array independently, each one in its reconstructedVoxel folder.
+ *
+ * The voxels already reconstructed are skipped, so the voxels can be split in ranges
+ * reconstructed by separate processes, each one with the memory of a single voxel.
+ * @param[in] rangeStart first voxel to reconstruct
+ * @param[in] rangeSize number of voxels to reconstruct, -1 for all
+ */
+void reconstructSpaceAccordingToVoxelsArray(const std::string& voxelsArrayFileName, LargeScale* ls,
+                                            const FuseParams& fuseParams, int rangeStart = 0, int rangeSize = -1);
 mesh::Mesh* joinMeshes(const std::vector<std::string>& recsDirs, StaticVector<Point3d>* voxelsArray, LargeScale* ls);
 mesh::Mesh* joinMeshes(int gl, LargeScale* ls);
 mesh::Mesh* joinMeshes(const std::string& voxelsArrayFileName, LargeScale* ls);
 
+/**
+ * @brief Join the meshes reconstructed per voxel, stitching them at their overlaps.
+ *
+ * Each triangle is kept by the voxel (without its overlap) containing its barycenter,
+ * then the vertices on the border of a voxel mesh are welded to the closest border vertex
+ * of another voxel mesh, if closer than weldDistanceFactor * average edge length.
+ * @param[in] recsDirs reconstruction folder of each voxel
+ * @param[in] voxelsArray the 8 corners of each voxel, with overlap
+ * @param[in] inflateFactor the overlap factor used to compute the voxels array
+ * @param[in] weldDistanceFactor max distance of the welded vertices, relative to the average edge length
+ * @param[out] out_ptsCams the visibilities of the vertices of the joined mesh
+ */
+mesh::Mesh* stitchMeshes(const std::vector<std::string>& recsDirs, const StaticVector<Point3d>& voxelsArray,
+                         float inflateFactor, float weldDistanceFactor,
+                         StaticVector<StaticVector<int>*>** out_ptsCams);
+
 StaticVector<StaticVector<int>*>* loadLargeScalePtsCams(const std::vector<std::string>& recsDirs);
 
 } // namespace fuseCut
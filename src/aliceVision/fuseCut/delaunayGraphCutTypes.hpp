@@ -8,7 +8,11 @@
 #include <aliceVision/mvsData/Point3d.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
 
 namespace aliceVision {
 namespace fuseCut {
@@ -54,6 +58,128 @@ struct GC_cellInfo
     }
 };
 
+/**
+ * @brief Deferred update of a weight of a cell (see GC_cellInfo).
+ */
+struct GC_cellWeightUpdate
+{
+    enum EField : std::uint32_t
+    {
+        eCellSWeight = 0,
+        eCellTWeight,
+        eIn,
+        eOut,
+        eOn,
+        /// first gEdgeVisWeight, the field of the facet k is eGEdgeVisWeight + k
+        eGEdgeVisWeight
+    };
+
+    std::uint32_t cellIndex;
+    std::uint32_t field;
+    float value;
+};
+
+/**
+ * @brief Weights of all the cells, stored per field (structure of arrays).
+ *
+ * Accumulation target of the GC_cellWeightUpdate: the updates of a bucket of cells
+ * are applied on contiguous memory.
+ */
+struct GC_cellsWeights
+{
+    std::vector<float> cellSWeight;
+    std::vector<float> cellTWeight;
+    std::vector<float> in;
+    std::vector<float> out;
+    std::vector<float> on;
+    std::vector<std::array<float, 4>> gEdgeVisWeight;
+
+    explicit GC_cellsWeights(std::size_t nbCells)
+        : cellSWeight(nbCells, 0.0f)
+        , cellTWeight(nbCells, 0.0f)
+        , in(nbCells, 0.0f)
+        , out(nbCells, 0.0f)
+        , on(nbCells, 0.0f)
+        , gEdgeVisWeight(nbCells, std::array<float, 4>{{0.0f, 0.0f, 0.0f, 0.0f}})
+    {}
+
+    inline void apply(const GC_cellWeightUpdate& update)
+    {
+        switch(update.field)
+        {
+            case GC_cellWeightUpdate::eCellSWeight:
+                // not accumulated, the same value is set by all the rays
+                cellSWeight[update.cellIndex] = update.value;
+                break;
+            case GC_cellWeightUpdate::eCellTWeight: cellTWeight[update.cellIndex] += update.value; break;
+            case GC_cellWeightUpdate::eIn: in[update.cellIndex] += update.value; break;
+            case GC_cellWeightUpdate::eOut: out[update.cellIndex] += update.value; break;
+            case GC_cellWeightUpdate::eOn: on[update.cellIndex] += update.value; break;
+            default:
+                gEdgeVisWeight[update.cellIndex][update.field - GC_cellWeightUpdate::eGEdgeVisWeight] += update.value;
+        }
+    }
+
+    inline void get(std::size_t cellIndex, GC_cellInfo& c) const
+    {
+        c.cellSWeight = cellSWeight[cellIndex];
+        c.cellTWeight = cellTWeight[cellIndex];
+        c.in = in[cellIndex];
+        c.out = out[cellIndex];
+        c.on = on[cellIndex];
+        c.gEdgeVisWeight = gEdgeVisWeight[cellIndex];
+    }
+};
+
+/**
+ * @brief Per-thread buffer of cell weight updates, bucketed by range of cells.
+ *
+ * A full bucket is applied to the cells weights under the lock of its range of cells:
+ * the memory used by the buffer is bounded and no atomic operation is needed.
+ */
+struct GC_cellWeightUpdatesBuffer
+{
+    GC_cellWeightUpdatesBuffer(GC_cellsWeights& cellsWeights, std::vector<std::mutex>& bucketsMutexes, std::size_t bucketCapacity)
+        : buckets(bucketsMutexes.size())
+        , nbCellsPerBucket(std::max(std::size_t(1), (cellsWeights.cellSWeight.size() + bucketsMutexes.size() - 1) / bucketsMutexes.size()))
+        , _cellsWeights(&cellsWeights)
+        , _bucketsMutexes(&bucketsMutexes)
+        , _bucketCapacity(bucketCapacity)
+    {}
+
+    inline void add(std::uint32_t cellIndex, std::uint32_t field, float value)
+    {
+        const std::size_t b = cellIndex / nbCellsPerBucket;
+        buckets[b].push_back({cellIndex, field, value});
+        if(buckets[b].size() >= _bucketCapacity)
+            flush(b);
+    }
+
+    /**
+     * @brief Apply the updates of a bucket to the cells weights.
+     */
+    void flush(std::size_t b)
+    {
+        std::vector<GC_cellWeightUpdate>& bucket = buckets[b];
+        if(bucket.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lock((*_bucketsMutexes)[b]);
+            for(const GC_cellWeightUpdate& update : bucket)
+                _cellsWeights->apply(update);
+        }
+        bucket.clear(); // keep the capacity
+    }
+
+    std::vector<std::vector<GC_cellWeightUpdate>> buckets;
+    std::size_t nbCellsPerBucket;
+
+private:
+    GC_cellsWeights* _cellsWeights;
+    std::vector<std::mutex>* _bucketsMutexes;
+    std::size_t _bucketCapacity;
+};
+
 struct GC_vertexInfo
 {
     float pixSize = 0.0f;
@@ -0,0 +1,148 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_Tetra.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#define BOOST_TEST_MODULE maxflow
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+using namespace aliceVision::fuseCut;
+
+struct TestEdge
+{
+    int n1;
+    int n2;
+    float capacity;
+    float reverseCapacity;
+};
+
+/**
+ * @brief Generate a random graph with at most 4 neighbors per node,
+ * mostly linked to nodes with close indexes (like the spatially sorted cells of a tetrahedralization).
+ */
+void generateGraph(int nbNodes, std::vector<float>& terminals, std::vector<TestEdge>& edges)
+{
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> capacity(0.0f, 10.0f);
+    std::uniform_int_distribution<int> offset(1, 40);
+
+    terminals.resize(nbNodes);
+    for(float& t : terminals)
+        t = capacity(generator) - capacity(generator);
+
+    std::vector<std::vector<int>> neighbors(nbNodes);
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        for(int i = 0; i < 4 && neighbors[n].size() < 4; ++i)
+        {
+            const int m = n + offset(generator);
+            if(m >= nbNodes || neighbors[m].size() >= 4 ||
+               std::find(neighbors[n].begin(), neighbors[n].end(), m) != neighbors[n].end())
+                continue;
+            neighbors[n].push_back(m);
+            neighbors[m].push_back(n);
+            edges.push_back({n, m, capacity(generator), capacity(generator)});
+        }
+    }
+}
+
+void checkMaxflowTetra(int nbBlocks)
+{
+    const int nbNodes = 20000;
+    std::vector<float> terminals;
+    std::vector<TestEdge> edges;
+    generateGraph(nbNodes, terminals, edges);
+
+    MaxFlow_AdjList adjList(nbNodes);
+    MaxFlow_Tetra tetra(nbNodes);
+    tetra.setNbBlocks(nbBlocks);
+
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        adjList.addNode(n, std::max(terminals[n], 0.0f), std::max(-terminals[n], 0.0f));
+        tetra.addNode(n, std::max(terminals[n], 0.0f), std::max(-terminals[n], 0.0f));
+    }
+    for(const TestEdge& e : edges)
+    {
+        adjList.addEdge(e.n1, e.n2, e.capacity, e.reverseCapacity);
+        tetra.addEdge(e.n1, e.n2, e.capacity, e.reverseCapacity);
+    }
+
+    const float adjListFlow = adjList.compute();
+    const float tetraFlow = tetra.compute();
+
+    BOOST_CHECK_CLOSE(adjListFlow, tetraFlow, 1e-2);
+
+    // the capacity of the cut is the maxflow
+    double cut = 0.0;
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        if(tetra.isTarget(n) && terminals[n] > 0.0f)
+            cut += terminals[n];
+        if(!tetra.isTarget(n) && terminals[n] < 0.0f)
+            cut -= terminals[n];
+    }
+    for(const TestEdge& e : edges)
+    {
+        if(!tetra.isTarget(e.n1) && tetra.isTarget(e.n2))
+            cut += e.capacity;
+        if(tetra.isTarget(e.n1) && !tetra.isTarget(e.n2))
+            cut += e.reverseCapacity;
+    }
+
+    BOOST_CHECK_CLOSE(cut, double(tetraFlow), 1e-2);
+}
+
+BOOST_AUTO_TEST_CASE(maxflowTetra_sequential)
+{
+    checkMaxflowTetra(1);
+}
+
+BOOST_AUTO_TEST_CASE(maxflowTetra_blocks)
+{
+    checkMaxflowTetra(16);
+}
+
+BOOST_AUTO_TEST_CASE(maxflowTetra_saveLoad)
+{
+    const int nbNodes = 1000;
+    std::vector<float> terminals;
+    std::vector<TestEdge> edges;
+    generateGraph(nbNodes, terminals, edges);
+
+    MaxFlow_Tetra tetra(nbNodes);
+    for(int n = 0; n < nbNodes; ++n)
+        tetra.addNode(n, std::max(terminals[n], 0.0f), std::max(-terminals[n], 0.0f));
+    for(const TestEdge& e : edges)
+        tetra.addEdge(e.n1, e.n2, e.capacity, e.reverseCapacity);
+
+    const std::string filepath = "maxflowGraph_test.bin";
+    tetra.saveGraph(filepath);
+
+    MaxFlow_Tetra loaded;
+    loaded.loadGraph(filepath);
+
+    BOOST_CHECK_EQUAL(loaded.getNbNodes(), tetra.getNbNodes());
+    for(int n = 0; n < nbNodes; ++n)
+    {
+        BOOST_CHECK_EQUAL(loaded.getTerminalCapacity(n), tetra.getTerminalCapacity(n));
+        for(int k = 0; k < MaxFlow_Tetra::nbNeighbors; ++k)
+        {
+            BOOST_CHECK_EQUAL(loaded.getNeighbor(n, k), tetra.getNeighbor(n, k));
+            BOOST_CHECK_EQUAL(loaded.getCapacity(n, k), tetra.getCapacity(n, k));
+        }
+    }
+
+    BOOST_CHECK_CLOSE(loaded.compute(), tetra.compute(), 1e-4);
+
+    std::remove(filepath.c_str());
+}
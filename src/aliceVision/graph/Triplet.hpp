@@ -9,10 +9,12 @@
 
 #include <aliceVision/types.hpp>
 #include <aliceVision/graph/graph.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <lemon/list_graph.h>
 
 #include <algorithm>
+#include <tuple>
 #include <vector>
 
 using namespace lemon;
@@ -52,6 +54,10 @@ struct Triplet
     return !(m1 == m2);
   }
 
+  friend bool operator<(const Triplet& m1, const Triplet& m2)  {
+    return std::tie(m1.i, m1.j, m1.k) < std::tie(m2.i, m2.j, m2.k);
+  }
+
   friend std::ostream & operator<<(std::ostream & os, const Triplet & t)
   {
     os << t.i << " " << t.j << " " << t.k << std::endl;
@@ -145,5 +151,134 @@ inline std::vector< graph::Triplet > tripletListing(
   return vec_triplets;
 }
 
+/// Return triplets contained in the graph build from IterablePairs
+/// without building a lemon graph.
+///
+/// The undirected graph is stored as a CSR adjacency where each node only keeps
+/// its "forward" neighbours (nodes of higher degree, ties broken by id), sorted.
+/// Each triangle is then found exactly once, from its lowest ranked node, by
+/// intersecting the sorted forward neighbourhoods of the two other nodes.
+/// Nodes are processed in parallel with per-thread result buffers merged at the end.
+///
+/// Triplets are returned with i < j < k and sorted in lexicographic order,
+/// so the result does not depend on the number of threads.
+template <typename IterablePairs>
+std::vector<Triplet> tripletListingCSR(const IterablePairs & pairs)
+{
+  // list the nodes and convert the edges to local indexes
+  std::vector<IndexT> nodeIds;
+  for(const auto& pair : pairs)
+  {
+    nodeIds.push_back(pair.first);
+    nodeIds.push_back(pair.second);
+  }
+  std::sort(nodeIds.begin(), nodeIds.end());
+  nodeIds.erase(std::unique(nodeIds.begin(), nodeIds.end()), nodeIds.end());
+
+  const auto toLocal = [&nodeIds](IndexT id) -> std::size_t
+  {
+    return std::lower_bound(nodeIds.begin(), nodeIds.end(), id) - nodeIds.begin();
+  };
+
+  std::vector<std::pair<std::size_t, std::size_t>> edges;
+  edges.reserve(pairs.size());
+  for(const auto& pair : pairs)
+  {
+    if(pair.first == pair.second)
+      continue;
+    const std::size_t a = toLocal(pair.first);
+    const std::size_t b = toLocal(pair.second);
+    edges.emplace_back(std::min(a, b), std::max(a, b));
+  }
+  std::sort(edges.begin(), edges.end());
+  edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+  const std::size_t nbNodes = nodeIds.size();
+
+  // rank nodes by degree to bound the size of the forward neighbourhoods
+  std::vector<std::size_t> degree(nbNodes, 0);
+  for(const auto& edge : edges)
+  {
+    ++degree[edge.first];
+    ++degree[edge.second];
+  }
+  const auto isBefore = [&degree](std::size_t a, std::size_t b)
+  {
+    return std::tie(degree[a], a) < std::tie(degree[b], b);
+  };
+
+  // build the forward CSR adjacency
+  std::vector<std::size_t> offsets(nbNodes + 1, 0);
+  for(const auto& edge : edges)
+    ++offsets[(isBefore(edge.first, edge.second) ? edge.first : edge.second) + 1];
+  for(std::size_t i = 0; i < nbNodes; ++i)
+    offsets[i + 1] += offsets[i];
+
+  std::vector<std::size_t> neighbours(edges.size());
+  {
+    std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+    for(const auto& edge : edges)
+    {
+      if(isBefore(edge.first, edge.second))
+        neighbours[fill[edge.first]++] = edge.second;
+      else
+        neighbours[fill[edge.second]++] = edge.first;
+    }
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int u = 0; u < static_cast<int>(nbNodes); ++u)
+    std::sort(neighbours.begin() + offsets[u], neighbours.begin() + offsets[u + 1]);
+
+  // list triangles with per-thread buffers
+  std::vector<std::vector<Triplet>> tripletsPerThread(omp_get_max_threads());
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int u = 0; u < static_cast<int>(nbNodes); ++u)
+  {
+    std::vector<Triplet>& threadTriplets = tripletsPerThread[omp_get_thread_num()];
+
+    const std::size_t* uBegin = neighbours.data() + offsets[u];
+    const std::size_t* uEnd = neighbours.data() + offsets[u + 1];
+
+    for(const std::size_t* itV = uBegin; itV != uEnd; ++itV)
+    {
+      const std::size_t v = *itV;
+      const std::size_t* vIt = neighbours.data() + offsets[v];
+      const std::size_t* vEnd = neighbours.data() + offsets[v + 1];
+      const std::size_t* uIt = uBegin;
+
+      // sorted arrays intersection
+      while(uIt != uEnd && vIt != vEnd)
+      {
+        if(*uIt < *vIt)
+          ++uIt;
+        else if(*vIt < *uIt)
+          ++vIt;
+        else
+        {
+          IndexT triplet[3] = {nodeIds[u], nodeIds[v], nodeIds[*uIt]};
+          std::sort(&triplet[0], &triplet[3]);
+          threadTriplets.emplace_back(triplet[0], triplet[1], triplet[2]);
+          ++uIt;
+          ++vIt;
+        }
+      }
+    }
+  }
+
+  std::size_t nbTriplets = 0;
+  for(const auto& threadTriplets : tripletsPerThread)
+    nbTriplets += threadTriplets.size();
+
+  std::vector<Triplet> triplets;
+  triplets.reserve(nbTriplets);
+  for(const auto& threadTriplets : tripletsPerThread)
+    triplets.insert(triplets.end(), threadTriplets.begin(), threadTriplets.end());
+
+  std::sort(triplets.begin(), triplets.end());
+  return triplets;
+}
+
 } // namespace graph
 } // namespace aliceVision
@@ -268,3 +268,44 @@ BOOST_AUTO_TEST_CASE(test_for_triplet) {
     BOOST_CHECK_EQUAL(4, vec_triplets.size());
   }
 }
+
+BOOST_AUTO_TEST_CASE(test_tripletListingCSR) {
+
+  // complete graph with 6 nodes (non contiguous ids): C(6,3) triplets
+  {
+    const std::vector<aliceVision::IndexT> ids = {2, 3, 5, 8, 13, 21};
+    aliceVision::PairSet pairs;
+    for(std::size_t i = 0; i < ids.size(); ++i)
+      for(std::size_t j = i + 1; j < ids.size(); ++j)
+        pairs.insert(std::make_pair(ids[j], ids[i]));
+
+    const std::vector<Triplet> vec_triplets = tripletListingCSR(pairs);
+    BOOST_CHECK_EQUAL(20, vec_triplets.size());
+    for(const Triplet& triplet : vec_triplets)
+    {
+      BOOST_CHECK(triplet.i < triplet.j);
+      BOOST_CHECK(triplet.j < triplet.k);
+    }
+  }
+
+  // same triplets as the lemon based listing
+  {
+    // a        b--g--h
+    // | \    / |   \/
+    // |  d--e  |    i
+    // | /    \ |
+    // c        f
+    const aliceVision::PairSet pairs = {
+      {0, 2}, {0, 3}, {2, 3}, {3, 4}, {4, 1},
+      {4, 5}, {1, 5}, {1, 6}, {6, 7}, {6, 8}, {7, 8}};
+
+    std::vector<Triplet> vec_tripletsLemon = tripletListing(pairs);
+    std::sort(vec_tripletsLemon.begin(), vec_tripletsLemon.end());
+
+    const std::vector<Triplet> vec_triplets = tripletListingCSR(pairs);
+    BOOST_CHECK_EQUAL(3, vec_triplets.size());
+    BOOST_CHECK_EQUAL(vec_tripletsLemon.size(), vec_triplets.size());
+    for(std::size_t i = 0; i < std::min(vec_triplets.size(), vec_tripletsLemon.size()); ++i)
+      BOOST_CHECK(vec_triplets[i] == vec_tripletsLemon[i]);
+  }
+}
@@ -0,0 +1,363 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "DecodedImageCache.hpp"
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <OpenImageIO/imageio.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/functional/hash.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = boost::filesystem;
+
+namespace aliceVision {
+namespace image {
+
+namespace {
+
+/// cache file header, followed by the pixels (row major, interleaved channels)
+struct CacheFileHeader
+{
+  char magic[4];
+  std::int32_t version;
+  std::int32_t width;
+  std::int32_t height;
+  std::int32_t nbChannels;
+  std::int32_t scalarSize;
+};
+
+const char cacheFileMagic[4] = {'A', 'V', 'D', 'I'};
+const std::int32_t cacheFileVersion = 2;
+const std::string cacheFileExtension = ".bin";
+
+/**
+ * @brief Canonical decoding of an image, stored in the cache file.
+ *        8 bits per channel for the 8 bits source images, float otherwise.
+ */
+struct CanonicalImage
+{
+  bool is8Bits = true;
+  Image<RGBColor> rgb8;
+  Image<RGBfColor> rgbf;
+};
+
+struct CacheFileInfo
+{
+  fs::path path;
+  std::size_t size;
+  std::time_t lastWriteTime;
+};
+
+/**
+ * @brief List the cache files of a folder
+ * @param[in] folder The cache folder
+ * @param[out] files The cache files
+ * @return the total size of the cache files in bytes
+ */
+std::size_t listCacheFiles(const std::string& folder, std::vector<CacheFileInfo>& files)
+{
+  std::size_t totalSize = 0;
+  boost::system::error_code ec;
+  for(fs::directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec))
+  {
+    if(it->path().extension() != cacheFileExtension)
+      continue;
+
+    boost::system::error_code fileEc;
+    const std::size_t size = fs::file_size(it->path(), fileEc);
+    const std::time_t lastWriteTime = fs::last_write_time(it->path(), fileEc);
+    if(fileEc)
+      continue; // removed by another process
+
+    files.push_back({it->path(), size, lastWriteTime});
+    totalSize += size;
+  }
+  return totalSize;
+}
+
+/**
+ * @brief Decode an image in its canonical variant
+ */
+void decodeImage(const std::string& path, CanonicalImage& canonical)
+{
+  {
+    std::unique_ptr<oiio::ImageInput> in(oiio::ImageInput::open(path));
+
+    if(!in)
+      throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+    canonical.is8Bits = (in->spec().format == oiio::TypeDesc::UINT8);
+    in->close();
+  }
+
+  if(canonical.is8Bits)
+    image::readImage(path, canonical.rgb8);
+  else
+    image::readImage(path, canonical.rgbf);
+}
+
+template<typename T>
+bool readPixels(std::ifstream& file, const CacheFileHeader& header, Image<T>& image)
+{
+  image.resize(header.width, header.height, false);
+  const std::streamsize dataSize = static_cast<std::streamsize>(header.width) * header.height * sizeof(T);
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(image.data()), dataSize));
+}
+
+bool readCacheFile(const std::string& cachePath, CanonicalImage& canonical)
+{
+  std::ifstream file(cachePath, std::ios::binary);
+  if(!file.is_open())
+    return false;
+
+  CacheFileHeader header;
+  if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+     std::memcmp(header.magic, cacheFileMagic, sizeof(cacheFileMagic)) != 0 ||
+     header.version != cacheFileVersion ||
+     header.nbChannels != 3 ||
+     (header.scalarSize != sizeof(unsigned char) && header.scalarSize != sizeof(float)) ||
+     header.width <= 0 || header.height <= 0)
+  {
+    ALICEVISION_LOG_WARNING("Invalid decoded image cache file '" << cachePath << "', the image is decoded again.");
+    return false;
+  }
+
+  canonical.is8Bits = (header.scalarSize == sizeof(unsigned char));
+  const bool success = canonical.is8Bits ? readPixels(file, header, canonical.rgb8) : readPixels(file, header, canonical.rgbf);
+  if(!success)
+  {
+    ALICEVISION_LOG_WARNING("Truncated decoded image cache file '" << cachePath << "', the image is decoded again.");
+    return false;
+  }
+  return true;
+}
+
+template<typename T>
+bool writePixels(std::ofstream& file, const Image<T>& image)
+{
+  return static_cast<bool>(file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.Width()) * image.Height() * sizeof(T)));
+}
+
+bool writeCacheFile(const std::string& cachePath, const CanonicalImage& canonical)
+{
+  // the temporary file has another extension, it is never taken for a cache file
+  const std::string tmpPath = cachePath + "." + fs::unique_path().string() + ".tmp";
+
+  CacheFileHeader header;
+  std::memcpy(header.magic, cacheFileMagic, sizeof(cacheFileMagic));
+  header.version = cacheFileVersion;
+  header.width = canonical.is8Bits ? canonical.rgb8.Width() : canonical.rgbf.Width();
+  header.height = canonical.is8Bits ? canonical.rgb8.Height() : canonical.rgbf.Height();
+  header.nbChannels = 3;
+  header.scalarSize = canonical.is8Bits ? sizeof(unsigned char) : sizeof(float);
+
+  {
+    std::ofstream file(tmpPath, std::ios::binary);
+    if(!file.is_open() ||
+       !file.write(reinterpret_cast<const char*>(&header), sizeof(header)) ||
+       !(canonical.is8Bits ? writePixels(file, canonical.rgb8) : writePixels(file, canonical.rgbf)))
+    {
+      ALICEVISION_LOG_WARNING("Can't write decoded image cache file '" << cachePath << "'.");
+      boost::system::error_code ec;
+      fs::remove(tmpPath, ec);
+      return false;
+    }
+  }
+
+  // rename temporary filename, the cache file is complete or does not exist
+  boost::system::error_code ec;
+  fs::rename(tmpPath, cachePath, ec);
+  if(ec)
+  {
+    ALICEVISION_LOG_WARNING("Can't write decoded image cache file '" << cachePath << "': " << ec.message());
+    fs::remove(tmpPath, ec);
+    return false;
+  }
+  return true;
+}
+
+/// same luminance weights as image::readImage for the grayscale images
+inline float luminance(float r, float g, float b)
+{
+  return 0.2126f * r + 0.7152f * g + 0.0722f * b;
+}
+
+inline unsigned char toUChar(float value)
+{
+  return static_cast<unsigned char>(std::round(std::min(1.f, std::max(0.f, value)) * 255.f));
+}
+
+template<typename InT, typename OutT, typename ConvertFunc>
+void convertPixels(const Image<InT>& input, Image<OutT>& output, ConvertFunc convert)
+{
+  output.resize(input.Width(), input.Height(), false);
+  for(int y = 0; y < input.Height(); ++y)
+    for(int x = 0; x < input.Width(); ++x)
+      output(y, x) = convert(input(y, x));
+}
+
+void convertImage(const CanonicalImage& canonical, Image<RGBColor>& image)
+{
+  if(canonical.is8Bits)
+    image = canonical.rgb8;
+  else
+    convertPixels(canonical.rgbf, image, [](const RGBfColor& p) { return RGBColor(toUChar(p.r()), toUChar(p.g()), toUChar(p.b())); });
+}
+
+void convertImage(const CanonicalImage& canonical, Image<RGBfColor>& image)
+{
+  if(canonical.is8Bits)
+    convertPixels(canonical.rgb8, image, [](const RGBColor& p) { return RGBfColor(p.r() / 255.f, p.g() / 255.f, p.b() / 255.f); });
+  else
+    image = canonical.rgbf;
+}
+
+void convertImage(const CanonicalImage& canonical, Image<float>& image)
+{
+  if(canonical.is8Bits)
+    convertPixels(canonical.rgb8, image, [](const RGBColor& p) { return luminance(p.r() / 255.f, p.g() / 255.f, p.b() / 255.f); });
+  else
+    convertPixels(canonical.rgbf, image, [](const RGBfColor& p) { return luminance(p.r(), p.g(), p.b()); });
+}
+
+void convertImage(const CanonicalImage& canonical, Image<unsigned char>& image)
+{
+  if(canonical.is8Bits)
+    convertPixels(canonical.rgb8, image, [](const RGBColor& p) { return toUChar(luminance(p.r() / 255.f, p.g() / 255.f, p.b() / 255.f)); });
+  else
+    convertPixels(canonical.rgbf, image, [](const RGBfColor& p) { return toUChar(luminance(p.r(), p.g(), p.b())); });
+}
+
+} // namespace
+
+const std::size_t DecodedImageCache::defaultMaxSize;
+
+DecodedImageCache::DecodedImageCache(const std::string& folder, std::size_t maxSize)
+  : _folder(folder)
+  , _maxSize(maxSize * 1024 * 1024)
+{
+  if(!fs::exists(_folder) && !fs::create_directories(_folder))
+    throw std::runtime_error("Can't create the decoded image cache folder '" + _folder + "'.");
+
+  std::vector<CacheFileInfo> files;
+  _size = listCacheFiles(_folder, files);
+}
+
+std::string DecodedImageCache::getCachePath(const std::string& path, IndexT viewId) const
+{
+  // image hash: path, size and last modification time of the source image
+  std::size_t imageHash = 0;
+  boost::hash_combine(imageHash, fs::absolute(path).string());
+  boost::hash_combine(imageHash, fs::file_size(path));
+  boost::hash_combine(imageHash, fs::last_write_time(path));
+
+  std::ostringstream filename;
+  if(viewId != UndefinedIndexT)
+    filename << viewId << "_";
+  filename << std::hex << std::setw(16) << std::setfill('0') << imageHash << cacheFileExtension;
+
+  return (fs::path(_folder) / filename.str()).string();
+}
+
+void DecodedImageCache::addCacheFile(const std::string& cachePath) const
+{
+  boost::system::error_code ec;
+  const std::size_t fileSize = fs::file_size(cachePath, ec);
+  if(ec)
+    return;
+
+  std::lock_guard<std::mutex> lock(_sizeMutex);
+
+  _size += fileSize;
+  if(_maxSize == 0 || _size <= _maxSize)
+    return;
+
+  // list the cache files again, the cache folder can be shared with other processes
+  std::vector<CacheFileInfo> files;
+  _size = listCacheFiles(_folder, files);
+
+  std::sort(files.begin(), files.end(), [](const CacheFileInfo& a, const CacheFileInfo& b) {
+    return a.lastWriteTime < b.lastWriteTime;
+  });
+
+  // remove the least recently used files down to 90% of the maximum size,
+  // so the cache folder is not listed again at each new file
+  const std::size_t targetSize = _maxSize / 10 * 9;
+  for(const CacheFileInfo& file : files)
+  {
+    if(_size <= targetSize)
+      break;
+    if(file.path == fs::path(cachePath))
+      continue;
+    if(fs::remove(file.path, ec) && !ec)
+      _size -= std::min(_size, file.size);
+  }
+
+  ALICEVISION_LOG_TRACE("Decoded image cache size: " << _size / (1024 * 1024) << " MB.");
+}
+
+template<typename T>
+void DecodedImageCache::readImage(const std::string& path, Image<T>& image, IndexT viewId) const
+{
+  if(!fs::exists(path))
+    throw std::runtime_error("Can't find/open image file '" + path + "'.");
+
+  const std::string cachePath = getCachePath(path, viewId);
+
+  CanonicalImage canonical;
+  if(readCacheFile(cachePath, canonical))
+  {
+    // update the last use of the cache file for the eviction
+    boost::system::error_code ec;
+    fs::last_write_time(cachePath, std::time(nullptr), ec);
+  }
+  else
+  {
+    ALICEVISION_LOG_TRACE("Decode image '" << path << "' in the cache.");
+    decodeImage(path, canonical);
+    if(writeCacheFile(cachePath, canonical))
+      addCacheFile(cachePath);
+  }
+
+  convertImage(canonical, image);
+}
+
+void DecodedImageCache::readImage(const std::string& path, Image<float>& image, IndexT viewId) const
+{
+  readImage<float>(path, image, viewId);
+}
+
+void DecodedImageCache::readImage(const std::string& path, Image<unsigned char>& image, IndexT viewId) const
+{
+  readImage<unsigned char>(path, image, viewId);
+}
+
+void DecodedImageCache::readImage(const std::string& path, Image<RGBColor>& image, IndexT viewId) const
+{
+  readImage<RGBColor>(path, image, viewId);
+}
+
+void DecodedImageCache::readImage(const std::string& path, Image<RGBfColor>& image, IndexT viewId) const
+{
+  readImage<RGBfColor>(path, image, viewId);
+}
+
+}  // namespace image
+}  // namespace aliceVision
@@ -0,0 +1,86 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/types.hpp>
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/pixelTypes.hpp>
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+
+namespace aliceVision {
+namespace image {
+
+/**
+ * @brief On-disk cache of decoded images, shared by the pipeline stages.
+ *
+ * The first read of an image decodes it (RAW, JPEG, ...) once and stores the pixels uncompressed
+ * in the cache folder, in a canonical RGB variant: 8 bits per channel for the 8 bits source images,
+ * float otherwise. Every pixel type (grayscale or RGB, 8 bits or float) is converted from this
+ * canonical variant, so the stages reading different pixel types share the same decoding.
+ *
+ * The cache files are keyed by the view id and a hash of the source image
+ * (path, size and last modification time), so a modified source image is decoded again.
+ * The cache files are written in a temporary file and renamed, several processes can share the cache.
+ * The size of the cache folder is bounded: the least recently used cache files are removed first.
+ */
+class DecodedImageCache
+{
+public:
+  /// default maximum size of the cache folder (MB)
+  static const std::size_t defaultMaxSize = 10240;
+
+  /**
+   * @param[in] folder The cache folder, created if needed
+   * @param[in] maxSize The maximum size of the cache folder in MB (0 for no limit)
+   */
+  explicit DecodedImageCache(const std::string& folder, std::size_t maxSize = defaultMaxSize);
+
+  const std::string& getFolder() const { return _folder; }
+
+  /**
+   * @brief Read an image through the cache
+   * @param[in] path The source image path
+   * @param[out] image The output image buffer
+   * @param[in] viewId The view id of the image (UndefinedIndexT if the image is not a view)
+   */
+  void readImage(const std::string& path, Image<float>& image, IndexT viewId = UndefinedIndexT) const;
+  void readImage(const std::string& path, Image<unsigned char>& image, IndexT viewId = UndefinedIndexT) const;
+  void readImage(const std::string& path, Image<RGBColor>& image, IndexT viewId = UndefinedIndexT) const;
+  void readImage(const std::string& path, Image<RGBfColor>& image, IndexT viewId = UndefinedIndexT) const;
+
+  /**
+   * @brief Get the cache file path of an image
+   * @param[in] path The source image path
+   * @param[in] viewId The view id of the image
+   * @return the cache file path
+   */
+  std::string getCachePath(const std::string& path, IndexT viewId) const;
+
+private:
+  template<typename T>
+  void readImage(const std::string& path, Image<T>& image, IndexT viewId) const;
+
+  /**
+   * @brief Account a new cache file and remove the least recently used cache files
+   *        if the cache folder exceeds its maximum size
+   * @param[in] cachePath The new cache file, never removed
+   */
+  void addCacheFile(const std::string& cachePath) const;
+
+  std::string _folder;
+  /// maximum size of the cache folder in bytes (0 for no limit)
+  std::size_t _maxSize;
+  /// estimated size of the cache folder in bytes
+  mutable std::size_t _size = 0;
+  mutable std::mutex _sizeMutex;
+};
+
+}  // namespace image
+}  // namespace aliceVision
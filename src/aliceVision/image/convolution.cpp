@@ -10,69 +10,92 @@
 namespace aliceVision {
 namespace image {
 
+/**
+ * @brief Mirror an index on the borders, without repeating the border pixel (-1 -> 1, size -> size - 2)
+ */
+inline int mirrorIndex(int i, int size)
+{
+  if(size == 1)
+    return 0;
+  while(i < 0 || i >= size)
+  {
+    if(i < 0)
+      i = -i;
+    if(i >= size)
+      i = 2 * size - 2 - i;
+  }
+  return i;
+}
+
 void SeparableConvolution2d(const RowMatrixXf& image,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_x,
                             const Eigen::Matrix<float, 1, Eigen::Dynamic>& kernel_y,
                             RowMatrixXf* out) {
-  const int sigma_y = static_cast<int>( kernel_y.cols() );
-  const int half_sigma_y = static_cast<int>( kernel_y.cols() ) / 2;
+  const int rows = static_cast<int>(image.rows());
+  const int cols = static_cast<int>(image.cols());
 
-  // Convolving a vertical filter across rows is the same thing as transpose
-  // multiply i.e. kernel_y^t * rows. This will give us the convoled value for
-  // each row. However, care must be taken at the top and bottom borders.
-  const Eigen::Matrix<float, 1, Eigen::Dynamic> reverse_kernel_y = kernel_y.reverse();
+  out->resize(rows, cols);
 
-  #pragma omp parallel for schedule(dynamic)
-  for (int i = 0; i < half_sigma_y; i++)
-  {
-    const int forward_size = i + half_sigma_y + 1;
-    const int reverse_size = sigma_y - forward_size;
-    out->row(i) = kernel_y.tail(forward_size) *
-                  image.block(0, 0, forward_size, image.cols()) +
-                  reverse_kernel_y.tail(reverse_size) *
-                  image.block(1, 0, reverse_size, image.cols());
-
-    // Apply the same technique for the end rows.
-    out->row(image.rows() - i - 1) =
-      kernel_y.head(forward_size) *
-      image.block(image.rows() - forward_size, 0, forward_size, image.cols())
-      +
-      reverse_kernel_y.head(reverse_size) *
-      image.block(image.rows() - reverse_size - 1, 0, reverse_size, image.cols());
-  }
+  if(rows == 0 || cols == 0)
+    return;
 
-  // Applying the rest of the y filter.
-  #pragma omp parallel for schedule(dynamic)
-  for (int row = half_sigma_y; row < image.rows() - half_sigma_y; row++)
+  // Vertical filter: each output row is a weighted sum of the input rows (mirrored on the borders).
+  // The rows are processed by bands in parallel and by column tiles, so that the input rows
+  // of consecutive output rows stay in cache.
+  const int sigma_y = static_cast<int>(kernel_y.cols());
+  const int half_sigma_y = sigma_y / 2;
+  const int nbBands = (rows + convolutionBandHeight - 1) / convolutionBandHeight;
+
+  #pragma omp parallel
   {
-    out->row(row) =  kernel_y * image.block(row - half_sigma_y, 0, sigma_y, out->cols());
+    std::vector<float> acc(std::min(cols, convolutionTileWidth));
+    std::vector<const float*> kernelRows(sigma_y);
+
+    #pragma omp for schedule(static)
+    for(int band = 0; band < nbBands; ++band)
+    {
+      const int rowBegin = band * convolutionBandHeight;
+      const int rowEnd = std::min(rows, rowBegin + convolutionBandHeight);
+
+      for(int col = 0; col < cols; col += convolutionTileWidth)
+      {
+        const int tileWidth = std::min(convolutionTileWidth, cols - col);
+
+        for(int row = rowBegin; row < rowEnd; ++row)
+        {
+          for(int k = 0; k < sigma_y; ++k)
+            kernelRows[k] = image.data() + static_cast<std::size_t>(mirrorIndex(row + k - half_sigma_y, rows)) * cols + col;
+
+          conv_rows_(kernelRows.data(), kernel_y.data(), out->data() + static_cast<std::size_t>(row) * cols + col,
+                     acc.data(), tileWidth, sigma_y);
+        }
+      }
+    }
   }
 
+  // Horizontal filter: each row is copied with its mirrored borders
+  // and filtered in place with a kernel specialized for its length.
+  // The right border is mirrored one pixel further (size -> size - 3), as in the previous implementation.
   const int sigma_x = static_cast<int>(kernel_x.cols());
-  const int half_sigma_x = static_cast<int>(kernel_x.cols() / 2);
+  const int half_sigma_x = sigma_x / 2;
 
-  // Convolving with the horizontal filter is easy. Rather than using the kernel
-  // as a sliding window, we use the row pixels as a sliding window around the
-  // filter. We prepend and append the proper border values so that we are sure
-  // to end up with the correct convolved values.
-  Eigen::RowVectorXf temp_row(image.cols() + sigma_x - 1);
-
-  #pragma omp parallel for firstprivate(temp_row), schedule(dynamic)
-  for (int row = 0; row < out->rows(); row++)
+  #pragma omp parallel
   {
-    temp_row.head(half_sigma_x) =
-      out->row(row).segment(1, half_sigma_x).reverse();
-    temp_row.segment(half_sigma_x, image.cols()) = out->row(row);
-    temp_row.tail(half_sigma_x) =
-      out->row(row)
-      .segment(image.cols() - 2 - half_sigma_x, half_sigma_x)
-      .reverse();
-
-    // Convolve the row. We perform the first step here explicitly so that we
-    // avoid setting the row equal to zero.
-    out->row(row) = kernel_x(0) * temp_row.head(image.cols());
-    for (int i = 1; i < sigma_x; i++) {
-      out->row(row) += kernel_x(i) * temp_row.segment(i, image.cols());
+    std::vector<float> line(cols + sigma_x - 1);
+
+    #pragma omp for schedule(static)
+    for(int row = 0; row < rows; ++row)
+    {
+      float* outRow = out->data() + static_cast<std::size_t>(row) * cols;
+
+      for(int k = 0; k < half_sigma_x; ++k)
+      {
+        line[k] = outRow[mirrorIndex(k - half_sigma_x, cols)];
+        line[half_sigma_x + cols + k] = outRow[mirrorIndex(cols - 3 - k, cols)];
+      }
+      std::copy(outRow, outRow + cols, line.begin() + half_sigma_x);
+
+      conv_buffer_(line.data(), kernel_x.data(), outRow, cols, sigma_x);
     }
   }
 }
@@ -13,8 +13,11 @@
 #include <aliceVision/image/Image.hpp>
 #include <aliceVision/config.hpp>
 
-#include <vector>
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 /**
  ** @file Standard 2D image convolution functions :
@@ -71,9 +74,15 @@ void ImageConvolution( const Image & img , const Mat & kernel , Image & out)
   }
 }
 
+/// Width (in pixels) of the column tiles of the vertical convolutions (cache blocking)
+const int convolutionTileWidth = 512;
+/// Number of consecutive rows of a vertical convolution task
+const int convolutionBandHeight = 32;
+
 /**
  ** Horizontal (1d) convolution
  ** assume kernel has odd size
+ ** The rows are filtered in parallel.
  ** @param img Input image
  ** @param kernel convolution kernel
  ** @param out Output image
@@ -86,46 +95,51 @@ void ImageHorizontalConvolution( const ImageTypeIn & img , const Kernel & kernel
   const int rows ( img.rows() );
   const int cols ( img.cols() );
 
-  out.resize( cols , rows ) ;
+  out.resize( cols , rows , false ) ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
-
-  for( int row = 0 ; row < rows ; ++row )
+  #pragma omp parallel
   {
-    // Copy line
-    const pix_t start_pix = img.coeffRef( row , 0 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
-    {
-      line[ k ] = start_pix ;
-    }
-    memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
-    const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
-    for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
-    {
-      line[ k + half_kernel_width + cols ] = end_pix ;
-    }
+    std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( cols + kernel_width );
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , cols , kernel_width );
+    #pragma omp for schedule(static)
+    for( int row = 0 ; row < rows ; ++row )
+    {
+      // Copy line
+      const pix_t start_pix = img.coeffRef( row , 0 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad before
+      {
+        line[ k ] = start_pix ;
+      }
+      memcpy(&line[0] + half_kernel_width, img.data() + row * cols, sizeof(pix_t) * cols);
+      const pix_t end_pix = img.coeffRef( row , cols - 1 ) ;
+      for( int k = 0 ; k < half_kernel_width ; ++k ) // pad after
+      {
+        line[ k + half_kernel_width + cols ] = end_pix ;
+      }
 
-    memcpy(out.data() + row * cols, &line[0], sizeof(pix_t) * cols);
+      // Apply convolution
+      conv_buffer_( &line[0] , kernel.data() , out.data() + row * cols , cols , kernel_width );
+    }
   }
 }
 
 /**
  ** Vertical (1d) convolution
  ** assume kernel has odd size
+ ** The output rows are computed as weighted sums of the input rows,
+ ** by bands of rows processed in parallel and by column tiles staying in cache.
  ** @param img Input image
  ** @param kernel convolution kernel
- ** @param out Output image
+ ** @param out Output image (different from the input image)
  **/
 template< typename ImageTypeIn , typename ImageTypeOut, typename Kernel >
 void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel , ImageTypeOut & out)
 {
   typedef typename ImageTypeIn::Tpixel pix_t ;
+  typedef typename std::decay<decltype( *kernel.data() )>::type kernel_t ;
 
   const int kernel_width = kernel.size() ;
   const int half_kernel_width = kernel_width / 2 ;
@@ -133,32 +147,40 @@ void ImageVerticalConvolution( const ImageTypeIn & img , const Kernel & kernel ,
   const int rows = img.rows() ;
   const int cols = img.cols() ;
 
-  out.resize( cols , rows ) ;
+  assert( static_cast<const void*>( &img ) != static_cast<const void*>( &out ) ) ;
+
+  out.resize( cols , rows , false ) ;
 
-  std::vector<pix_t, Eigen::aligned_allocator<pix_t> > line( rows + kernel_width );
+  const int nb_bands = ( rows + convolutionBandHeight - 1 ) / convolutionBandHeight ;
 
-  for( int col = 0 ; col < cols ; ++col )
+  #pragma omp parallel
   {
-    // Copy column
-    for( int k = 0 ; k < half_kernel_width ; ++k )
-    {
-      line[ k ] = img.coeffRef( 0 , col ) ;
-    }
-    for( int k = 0 ; k < rows ; ++k )
-    {
-      line[ k + half_kernel_width ] = img.coeffRef( k , col ) ;
-    }
-    for( int k = 0 ; k < half_kernel_width ; ++k )
+    std::vector<kernel_t> acc( std::min( cols , convolutionTileWidth ) );
+    std::vector<const pix_t*> kernel_rows( kernel_width );
+
+    #pragma omp for schedule(static)
+    for( int band = 0 ; band < nb_bands ; ++band )
     {
-      line[ k + half_kernel_width + rows ] = img.coeffRef( rows - 1 , col ) ;
-    }
+      const int row_begin = band * convolutionBandHeight ;
+      const int row_end = std::min( rows , row_begin + convolutionBandHeight ) ;
 
-    // Apply convolution
-    conv_buffer_( &line[0] , kernel.data() , rows , kernel_width );
+      for( int col = 0 ; col < cols ; col += convolutionTileWidth )
+      {
+        const int tile_width = std::min( convolutionTileWidth , cols - col ) ;
 
-    for( int row = 0 ; row < rows ; ++row )
-    {
-      out.coeffRef( row , col ) = line[row];
+        for( int row = row_begin ; row < row_end ; ++row )
+        {
+          // border rows are repeated
+          for( int k = 0 ; k < kernel_width ; ++k )
+          {
+            const int input_row = std::min( std::max( row + k - half_kernel_width , 0 ) , rows - 1 ) ;
+            kernel_rows[ k ] = img.data() + static_cast<std::size_t>( input_row ) * cols + col ;
+          }
+
+          conv_rows_( kernel_rows.data() , kernel.data() , out.data() + static_cast<std::size_t>( row ) * cols + col ,
+                      acc.data() , tile_width , kernel_width );
+        }
+      }
     }
   }
 }
@@ -209,7 +231,7 @@ void ImageSeparableConvolution( const Image<float> & img ,
   const VecKernel horiz_k_cast = horiz_k.template cast< typename aliceVision::Accumulator<pix_t>::Type >();
   const VecKernel vert_k_cast = vert_k.template cast< typename aliceVision::Accumulator<pix_t>::Type >();
 
-  out.resize(img.Width(), img.Height());
+  out.resize(img.Width(), img.Height(), false);
   SeparableConvolution2d(img.GetMat(), horiz_k_cast, vert_k_cast, &((Image<float>::Base&)out));
 }
 
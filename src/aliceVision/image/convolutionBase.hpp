@@ -31,5 +31,140 @@ namespace image {
       buffer[i] = sum;
     }
   }
+
+  /**
+   ** Filter an extended row [halfKernelSize][row][halfKernelSize] into an output row,
+   ** the kernel length is known at compile time: the kernel loop is unrolled
+   ** and the loop on the pixels can be vectorized
+   ** @param buffer data to filter
+   ** @param kernel kernel array
+   ** @param out output row
+   ** @param rsize output row length
+  **/
+  template<int ksize, class T1, class T2, class TOut> inline
+  void conv_buffer_fixed_( const T1* buffer, const T2* kernel, TOut* out, int rsize )
+  {
+    for( int i = 0; i < rsize; ++i )
+    {
+      T2 sum( 0 );
+      for( int j = 0; j < ksize; ++j )
+      {
+        sum += buffer[i + j] * kernel[j];
+      }
+      out[i] = sum;
+    }
+  }
+
+  /**
+   ** Filter an extended row [halfKernelSize][row][halfKernelSize] into an output row
+   ** (specialized for the usual kernel lengths)
+   ** @param buffer data to filter
+   ** @param kernel kernel array
+   ** @param out output row
+   ** @param rsize output row length
+   ** @param ksize kernel length
+  **/
+  template<class T1, class T2, class TOut> inline
+  void conv_buffer_( const T1* buffer, const T2* kernel, TOut* out, int rsize, int ksize )
+  {
+    switch( ksize )
+    {
+      case 3:  conv_buffer_fixed_<3>( buffer, kernel, out, rsize ); return;
+      case 5:  conv_buffer_fixed_<5>( buffer, kernel, out, rsize ); return;
+      case 7:  conv_buffer_fixed_<7>( buffer, kernel, out, rsize ); return;
+      case 9:  conv_buffer_fixed_<9>( buffer, kernel, out, rsize ); return;
+      case 11: conv_buffer_fixed_<11>( buffer, kernel, out, rsize ); return;
+      case 13: conv_buffer_fixed_<13>( buffer, kernel, out, rsize ); return;
+      case 15: conv_buffer_fixed_<15>( buffer, kernel, out, rsize ); return;
+      default: break;
+    }
+    // any other length: the kernel is applied by tiles, with the shifted rows accumulated like a vertical kernel
+    const int tile_size = 256;
+    T2 acc[ tile_size ];
+    for( int i = 0; i < rsize; i += tile_size )
+    {
+      const int size = ( rsize - i < tile_size ) ? rsize - i : tile_size;
+      for( int k = 0; k < size; ++k )
+      {
+        acc[k] = T2( 0 );
+      }
+      int j = 0;
+      for( ; j + 4 <= ksize; j += 4 )
+      {
+        const T1* row = buffer + i + j;
+        const T2 k0 = kernel[j];
+        const T2 k1 = kernel[j + 1];
+        const T2 k2 = kernel[j + 2];
+        const T2 k3 = kernel[j + 3];
+        for( int k = 0; k < size; ++k )
+        {
+          acc[k] = acc[k] + row[k] * k0 + row[k + 1] * k1 + row[k + 2] * k2 + row[k + 3] * k3;
+        }
+      }
+      for( ; j < ksize; ++j )
+      {
+        const T1* row = buffer + i + j;
+        const T2 kj = kernel[j];
+        for( int k = 0; k < size; ++k )
+        {
+          acc[k] += row[k] * kj;
+        }
+      }
+      for( int k = 0; k < size; ++k )
+      {
+        out[i + k] = acc[k];
+      }
+    }
+  }
+
+  /**
+   ** Filter a segment of rows with a vertical kernel:
+   ** out[i] = sum_j rows[j][i] * kernel[j]
+   ** The rows are accumulated by groups of 4 (in the kernel order), each accumulation is vectorizable.
+   ** @param rows the ksize input rows
+   ** @param kernel kernel array
+   ** @param out output row
+   ** @param acc accumulation buffer (rsize elements)
+   ** @param rsize segment length
+   ** @param ksize kernel length
+  **/
+  template<class T1, class T2, class TOut> inline
+  void conv_rows_( const T1* const* rows, const T2* kernel, TOut* out, T2* acc, int rsize, int ksize )
+  {
+    for( int i = 0; i < rsize; ++i )
+    {
+      acc[i] = T2( 0 );
+    }
+    int j = 0;
+    for( ; j + 4 <= ksize; j += 4 )
+    {
+      const T1* row0 = rows[j];
+      const T1* row1 = rows[j + 1];
+      const T1* row2 = rows[j + 2];
+      const T1* row3 = rows[j + 3];
+      const T2 k0 = kernel[j];
+      const T2 k1 = kernel[j + 1];
+      const T2 k2 = kernel[j + 2];
+      const T2 k3 = kernel[j + 3];
+      for( int i = 0; i < rsize; ++i )
+      {
+        acc[i] = acc[i] + row0[i] * k0 + row1[i] * k1 + row2[i] * k2 + row3[i] * k3;
+      }
+    }
+    for( ; j < ksize; ++j )
+    {
+      const T1* row = rows[j];
+      const T2 k = kernel[j];
+      for( int i = 0; i < rsize; ++i )
+      {
+        acc[i] += row[i] * k;
+      }
+    }
+    for( int i = 0; i < rsize; ++i )
+    {
+      out[i] = acc[i];
+    }
+  }
+
 } // namespace image
 } // namespace aliceVision
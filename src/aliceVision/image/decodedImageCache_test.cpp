@@ -0,0 +1,132 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/image/all.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE decodedImageCache
+#include <boost/test/included/unit_test.hpp>
+#include <boost/test/floating_point_comparison.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace fs = boost::filesystem;
+
+std::size_t countCacheFiles(const std::string& folder)
+{
+  std::size_t count = 0;
+  for(fs::directory_iterator it(folder), end; it != end; ++it)
+    if(it->path().extension() == ".bin")
+      ++count;
+  return count;
+}
+
+BOOST_AUTO_TEST_CASE(decodedImageCache_read) {
+  const std::string cacheFolder = "decodedImageCache_test";
+  const std::string filename = "decodedImageCache_test.png";
+
+  Image<RGBColor> image(6, 4);
+  for(int y = 0; y < image.Height(); ++y)
+    for(int x = 0; x < image.Width(); ++x)
+      image(y, x) = RGBColor(10 * x, 20 * y, 100);
+  writeImage(filename, image);
+
+  {
+    DecodedImageCache cache(cacheFolder);
+
+    // first read: decode and fill the cache
+    Image<RGBColor> cachedImage;
+    BOOST_CHECK_NO_THROW(cache.readImage(filename, cachedImage, 42));
+    BOOST_CHECK(fs::exists(cache.getCachePath(filename, 42)));
+    BOOST_CHECK(cachedImage == image);
+
+    // second read: from the cache
+    Image<RGBColor> cachedImage2;
+    BOOST_CHECK_NO_THROW(cache.readImage(filename, cachedImage2, 42));
+    BOOST_CHECK(cachedImage2 == image);
+
+    // grayscale and float variants: converted from the same cache file
+    Image<float> directGrayFloat;
+    readImage(filename, directGrayFloat);
+    Image<float> cachedGrayFloat;
+    BOOST_CHECK_NO_THROW(cache.readImage(filename, cachedGrayFloat, 42));
+    BOOST_CHECK_EQUAL(cachedGrayFloat.Width(), image.Width());
+    BOOST_CHECK_EQUAL(cachedGrayFloat.Height(), image.Height());
+
+    Image<unsigned char> directGray;
+    readImage(filename, directGray);
+    Image<unsigned char> cachedGray;
+    BOOST_CHECK_NO_THROW(cache.readImage(filename, cachedGray, 42));
+
+    Image<RGBfColor> cachedImageFloat;
+    BOOST_CHECK_NO_THROW(cache.readImage(filename, cachedImageFloat, 42));
+
+    for(int y = 0; y < image.Height(); ++y)
+    {
+      for(int x = 0; x < image.Width(); ++x)
+      {
+        BOOST_CHECK_SMALL(cachedGrayFloat(y, x) - directGrayFloat(y, x), 1e-4f);
+        BOOST_CHECK_LE(std::abs(int(cachedGray(y, x)) - int(directGray(y, x))), 1);
+        BOOST_CHECK_SMALL(cachedImageFloat(y, x).r() - image(y, x).r() / 255.f, 1e-6f);
+      }
+    }
+
+    BOOST_CHECK_EQUAL(countCacheFiles(cacheFolder), 1);
+
+    // unexisting image
+    Image<float> unexistingImage;
+    BOOST_CHECK_THROW(cache.readImage("unexisting.jpg", unexistingImage), std::exception);
+  }
+
+  fs::remove_all(cacheFolder);
+  fs::remove(filename);
+}
+
+BOOST_AUTO_TEST_CASE(decodedImageCache_eviction) {
+  const std::string cacheFolder = "decodedImageCache_eviction_test";
+  const std::string filenameA = "decodedImageCache_eviction_test_A.png";
+  const std::string filenameB = "decodedImageCache_eviction_test_B.png";
+
+  // noise images: each cache file is above 1 MB
+  Image<RGBColor> image(640, 640);
+  std::srand(0);
+  for(int y = 0; y < image.Height(); ++y)
+    for(int x = 0; x < image.Width(); ++x)
+      image(y, x) = RGBColor(std::rand() % 256, std::rand() % 256, std::rand() % 256);
+  writeImage(filenameA, image);
+  writeImage(filenameB, image);
+
+  {
+    DecodedImageCache cache(cacheFolder, 1);
+
+    Image<RGBColor> cachedImage;
+    cache.readImage(filenameA, cachedImage, 1);
+    BOOST_CHECK(fs::exists(cache.getCachePath(filenameA, 1)));
+
+    // the least recently used cache file is removed
+    cache.readImage(filenameB, cachedImage, 2);
+    BOOST_CHECK(!fs::exists(cache.getCachePath(filenameA, 1)));
+    BOOST_CHECK(fs::exists(cache.getCachePath(filenameB, 2)));
+    BOOST_CHECK(cachedImage == image);
+
+    // a removed cache file is decoded again
+    cache.readImage(filenameA, cachedImage, 1);
+    BOOST_CHECK(cachedImage == image);
+    BOOST_CHECK_EQUAL(countCacheFiles(cacheFolder), 1);
+  }
+
+  fs::remove_all(cacheFolder);
+  fs::remove(filenameA);
+  fs::remove(filenameB);
+}
@@ -10,6 +10,7 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 
+#include <algorithm>
 #include <vector>
 
 #ifdef _MSC_VER
@@ -41,6 +42,70 @@ void ImagePeronaMalikG2DiffusionCoef( const Image & Lx , const Image & Ly , cons
   out.array() = ( static_cast<Real>(1.f) + (Lx.array().square()+Ly.array().square() )/(k*k) ).inverse();
 }
 
+/**
+ ** Compute Perona and Malik G2 diffusion coefficient from the Scharr derivatives
+ ** (non normalized) of an image, in a single pass without the derivative images.
+ ** The borders are mirrored as in ImageScharrXDerivative and ImageScharrYDerivative.
+ ** @param img Input (smoothed) image
+ ** @param k sensitivity factor
+ ** @param out output coefficient
+ **/
+template < typename Image >
+void ImageScharrPeronaMalikG2DiffusionCoef( const Image & img , const typename Image::Tpixel k , Image & out )
+{
+  typedef typename Image::Tpixel Real;
+  const int width = img.Width();
+  const int height = img.Height();
+
+  if( width != out.Width() || height != out.Height() )  {
+    out.resize( width , height , false ) ;
+  }
+
+  if( width == 0 || height == 0 )
+    return;
+
+  const Real k2 = k * k ;
+
+  #pragma omp parallel
+  {
+    // vertical smoothing and derivative of the current row, with one border pixel on each side
+    std::vector< Real > smooth_line( width + 2 ) ;
+    std::vector< Real > deriv_line( width + 2 ) ;
+
+    #pragma omp for schedule(static)
+    for( int i = 0 ; i < height ; ++i )
+    {
+      const int i_prev = ( i > 0 ) ? i - 1 : std::min( 1 , height - 1 ) ;
+      const int i_next = ( i < height - 1 ) ? i + 1 : std::max( height - 2 , 0 ) ;
+      const Real * row_prev = img.data() + static_cast<std::size_t>( i_prev ) * width ;
+      const Real * row_cur = img.data() + static_cast<std::size_t>( i ) * width ;
+      const Real * row_next = img.data() + static_cast<std::size_t>( i_next ) * width ;
+
+      for( int j = 0 ; j < width ; ++j )
+      {
+        smooth_line[ j + 1 ] = static_cast<Real>( 3 ) * row_prev[ j ] + static_cast<Real>( 10 ) * row_cur[ j ] + static_cast<Real>( 3 ) * row_next[ j ] ;
+        deriv_line[ j + 1 ] = row_next[ j ] - row_prev[ j ] ;
+      }
+
+      // the right border is mirrored one pixel further, as in the separable convolutions
+      const int j_first = std::min( 1 , width - 1 ) ;
+      const int j_last = std::max( width - 3 , 0 ) ;
+      smooth_line[ 0 ] = smooth_line[ j_first + 1 ] ;
+      smooth_line[ width + 1 ] = smooth_line[ j_last + 1 ] ;
+      deriv_line[ 0 ] = deriv_line[ j_first + 1 ] ;
+      deriv_line[ width + 1 ] = deriv_line[ j_last + 1 ] ;
+
+      Real * out_row = out.data() + static_cast<std::size_t>( i ) * width ;
+      for( int j = 0 ; j < width ; ++j )
+      {
+        const Real lx = smooth_line[ j + 2 ] - smooth_line[ j ] ;
+        const Real ly = static_cast<Real>( 3 ) * deriv_line[ j ] + static_cast<Real>( 10 ) * deriv_line[ j + 1 ] + static_cast<Real>( 3 ) * deriv_line[ j + 2 ] ;
+        out_row[ j ] = static_cast<Real>( 1 ) / ( static_cast<Real>( 1 ) + ( lx * lx + ly * ly ) / k2 ) ;
+      }
+    }
+  }
+}
+
 /**
 ** Apply Fast Explicit Diffusion to an Image (on central part)
 ** @param src input image
@@ -218,23 +283,118 @@ void ImageFED( const Image & src , const Image & diff , const typename Image::Tp
   }
 }
 
+/**
+** Apply a Fast Explicit Diffusion step to an Image: out = src + FED( src )
+** The rows are processed in parallel and the step is added in the same pass.
+** @param src input image
+** @param diff diffusion coefficient image
+** @param t diffusion time
+** @param out output image (different from the input image)
+**/
+template< typename Image >
+void ImageFEDStep( const Image & src , const Image & diff , const typename Image::Tpixel t , Image & out )
+{
+  typedef typename Image::Tpixel Real ;
+  const int width = src.Width() ;
+  const int height = src.Height() ;
+  const Real half_t = t * static_cast<Real>( 0.5 ) ;
+  if( out.Width() != width || out.Height() != height )
+  {
+    out.resize( width , height , false ) ;
+  }
+
+  #pragma omp parallel for schedule(static)
+  for( int i = 0 ; i < height ; ++i )
+  {
+    // on the first/last row, the missing neighbor is the pixel itself (no flux)
+    const int i_prev = ( i > 0 ) ? i - 1 : i ;
+    const int i_next = ( i < height - 1 ) ? i + 1 : i ;
+    const Real * src_prev = src.data() + static_cast<std::size_t>( i_prev ) * width ;
+    const Real * src_cur = src.data() + static_cast<std::size_t>( i ) * width ;
+    const Real * src_next = src.data() + static_cast<std::size_t>( i_next ) * width ;
+    const Real * diff_prev = diff.data() + static_cast<std::size_t>( i_prev ) * width ;
+    const Real * diff_cur = diff.data() + static_cast<std::size_t>( i ) * width ;
+    const Real * diff_next = diff.data() + static_cast<std::size_t>( i_next ) * width ;
+    Real * out_row = out.data() + static_cast<std::size_t>( i ) * width ;
+
+    for( int j = 1 ; j < width - 1 ; ++j )
+    {
+      const Real cur_src = src_cur[ j ] ;
+      const Real cur_diff = diff_cur[ j ] ;
+      const Real a = ( cur_diff + diff_cur[ j + 1 ] ) * ( src_cur[ j + 1 ] - cur_src ) ;
+      const Real b = ( cur_diff + diff_prev[ j ] ) * ( cur_src - src_prev[ j ] ) ;
+      const Real c = ( cur_diff + diff_cur[ j - 1 ] ) * ( cur_src - src_cur[ j - 1 ] ) ;
+      const Real d = ( cur_diff + diff_next[ j ] ) * ( src_next[ j ] - cur_src ) ;
+      out_row[ j ] = cur_src + half_t * ( a - c + d - b ) ;
+    }
+
+    if( width < 2 )
+    {
+      if( width == 1 )
+        out_row[ 0 ] = src_cur[ 0 ] ;
+      continue ;
+    }
+
+    // the corners are not diffused
+    if( i == 0 || i == height - 1 )
+    {
+      out_row[ 0 ] = src_cur[ 0 ] ;
+      out_row[ width - 1 ] = src_cur[ width - 1 ] ;
+      continue ;
+    }
+
+    // first col
+    {
+      const Real cur_src = src_cur[ 0 ] ;
+      const Real cur_diff = diff_cur[ 0 ] ;
+      const Real a = ( cur_diff + diff_cur[ 1 ] ) * ( src_cur[ 1 ] - cur_src ) ;
+      const Real b = ( cur_diff + diff_prev[ 0 ] ) * ( cur_src - src_prev[ 0 ] ) ;
+      const Real d = ( cur_diff + diff_next[ 0 ] ) * ( src_next[ 0 ] - cur_src ) ;
+      out_row[ 0 ] = cur_src + half_t * ( a + d - b ) ;
+    }
+    // last col
+    {
+      const int j = width - 1 ;
+      const Real cur_src = src_cur[ j ] ;
+      const Real cur_diff = diff_cur[ j ] ;
+      const Real b = ( cur_diff + diff_prev[ j ] ) * ( cur_src - src_prev[ j ] ) ;
+      const Real c = ( cur_diff + diff_cur[ j - 1 ] ) * ( cur_src - src_cur[ j - 1 ] ) ;
+      const Real d = ( cur_diff + diff_next[ j ] ) * ( src_next[ j ] - cur_src ) ;
+      out_row[ j ] = cur_src + half_t * ( - c + d - b ) ;
+    }
+  }
+}
+
 /**
  ** Compute Fast Explicit Diffusion cycle
  ** @param self input/output image
  ** @param diff diffusion coefficient
  ** @param tau cycle timing vector
+ ** @param tmp work image (reused between the calls to avoid reallocations)
  **/
 template< typename Image >
-void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau )
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau , Image & tmp )
 {
-  Image tmp;
   for( int i = 0 ; i < tau.size() ; ++i )
   {
-    ImageFED( self , diff , tau[i] , tmp ) ;
-    self.array() += tmp.array();
+    ImageFEDStep( self , diff , tau[i] , tmp ) ;
+    self.swap( tmp ) ;
   }
 }
 
+/**
+ ** Compute Fast Explicit Diffusion cycle
+ ** @param self input/output image
+ ** @param diff diffusion coefficient
+ ** @param tau cycle timing vector
+ **/
+template< typename Image >
+void ImageFEDCycle( Image & self , const Image & diff , const std::vector< typename Image::Tpixel > & tau )
+{
+  Image tmp;
+  ImageFEDCycle( self , diff , tau , tmp ) ;
+}
+
 // Compute if a number is prime of not
 inline bool IsPrime( const int i )
 {
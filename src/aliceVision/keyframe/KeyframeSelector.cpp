@@ -9,13 +9,153 @@
 #include <aliceVision/sensorDB/parseDatabase.hpp>
 #include <aliceVision/feature/sift/ImageDescriber_SIFT.hpp>
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 
 #include <tuple>
 #include <cassert>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace aliceVision {
 namespace keyframe {
 
+namespace {
+
+/**
+ * @brief Convert an image of the media in a half resolution grayscale image.
+ * Same result as image::ConvertPixelType followed by image::ImageHalfSample
+ * (the half sample takes the odd pixels), without the full resolution grayscale image.
+ */
+void convertToGrayHalfSample(const image::Image<image::RGBColor>& image,
+                             image::Image<unsigned char>& imageGrayHalfSample)
+{
+  const int width = image.Width() / 2;
+  const int height = image.Height() / 2;
+  imageGrayHalfSample.resize(width, height, false);
+
+  for(int y = 0; y < height; ++y)
+  {
+    for(int x = 0; x < width; ++x)
+      image::Convert(image(2 * y + 1, 2 * x + 1), imageGrayHalfSample(y, x));
+  }
+}
+
+/**
+ * @brief Decode the frames of a feed in a dedicated thread.
+ * The frames are read in order from the current position of the feed,
+ * converted in half resolution grayscale images and stored in a bounded queue.
+ */
+class FeedDecoder
+{
+public:
+  /**
+   * @param[in] feed the feed, only used by the decoder thread until the decoder is destroyed
+   * @param[in] nbFrames number of frames to decode
+   * @param[in] queueSize maximum number of decoded frames waiting in the queue
+   */
+  FeedDecoder(dataio::FeedProvider& feed, std::size_t nbFrames, std::size_t queueSize)
+    : _feed(feed)
+    , _nbFrames(nbFrames)
+    , _queueSize(std::max(std::size_t(1), queueSize))
+  {
+    _thread = std::thread(&FeedDecoder::decodeLoop, this);
+  }
+
+  ~FeedDecoder()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _abort = true;
+    }
+    _condition.notify_all();
+    _thread.join();
+  }
+
+  /**
+   * @brief Get the next decoded frame (wait for its decoding)
+   * @param[in] frameIndex index of the expected frame
+   * @param[out] imageGrayHalfSample half resolution grayscale image of the frame
+   * @param[out] imageName frame image name
+   * @return false if the frame can't be read
+   */
+  bool pop(std::size_t frameIndex, image::Image<unsigned char>& imageGrayHalfSample, std::string& imageName)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _condition.wait(lock, [this]{ return !_frames.empty() || _done; });
+
+    if(_frames.empty())
+    {
+      imageName = _imageName;
+      return false;
+    }
+
+    assert(_frames.front().first == frameIndex);
+    imageGrayHalfSample.swap(_frames.front().second);
+    _frames.pop_front();
+    _condition.notify_all();
+    return true;
+  }
+
+private:
+  void decodeLoop()
+  {
+    image::Image<image::RGBColor> image;
+    camera::PinholeRadialK3 intrinsics;
+    bool hasIntrinsics = false;
+    std::string imageName;
+
+    for(std::size_t frameIndex = 0; frameIndex < _nbFrames; ++frameIndex)
+    {
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [this]{ return _abort || _frames.size() < _queueSize; });
+        if(_abort)
+          break;
+      }
+
+      if(!_feed.readImage(image, intrinsics, imageName, hasIntrinsics))
+        break;
+      _feed.goToNextFrame();
+
+      image::Image<unsigned char> imageGrayHalfSample;
+      convertToGrayHalfSample(image, imageGrayHalfSample);
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _frames.emplace_back(frameIndex, std::move(imageGrayHalfSample));
+        _imageName = imageName;
+      }
+      _condition.notify_all();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _imageName = imageName;
+      _done = true;
+    }
+    _condition.notify_all();
+  }
+
+  dataio::FeedProvider& _feed;
+  const std::size_t _nbFrames;
+  const std::size_t _queueSize;
+  /// decoded frames (frame index, half resolution grayscale image)
+  std::deque< std::pair<std::size_t, image::Image<unsigned char> > > _frames;
+  /// last read image name
+  std::string _imageName;
+  bool _done = false;
+  bool _abort = false;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  std::thread _thread;
+};
+
+} // namespace
+
 KeyframeSelector::KeyframeSelector(const std::vector<std::string>& mediaPaths,
                                    const std::string& sensorDbPath,
                                    const std::string& voctreeFilePath,
@@ -73,9 +213,6 @@ KeyframeSelector::KeyframeSelector(const std::vector<std::string>& mediaPaths,
 
   // resize selection data vector
   _framesData.resize(nbFrames);
-
-  // create SIFT image describer
-  _imageDescriber.reset(new feature::ImageDescriber_SIFT());
 }
 
 void KeyframeSelector::process()
@@ -86,6 +223,19 @@ void KeyframeSelector::process()
   bool hasIntrinsics = false;                           // true if queryIntrinsics is valid
   std::string currentImgName;                           // current image name
   
+  if(_minFrameStep == 0)
+  {
+    // the next window would start on the last keyframe and select it again
+    ALICEVISION_LOG_ERROR("ERROR : the min frame step should be greater than 0 !");
+    throw std::invalid_argument("ERROR : the min frame step should be greater than 0 !");
+  }
+
+  if(_maxFrameStep <= _minFrameStep)
+  {
+    ALICEVISION_LOG_ERROR("ERROR : the max frame step should be greater than the min frame step !");
+    throw std::invalid_argument("ERROR : the max frame step should be greater than the min frame step !");
+  }
+
   // process variables
   const unsigned int frameStep = _maxFrameStep - _minFrameStep;
   const unsigned int tileSharpSubset =  (_nbTileSide * _nbTileSide) / _sharpSubset;
@@ -118,64 +268,105 @@ void KeyframeSelector::process()
     mediaInfo.spec.attribute("Exif:FocalLength", _cameraInfos[mediaIndex].focalLength);
   }
 
+  // per thread image describers (an image describer can't be shared between threads)
+  _imageDescribers.resize(omp_get_max_threads());
+  for(auto& imageDescriber : _imageDescribers)
+  {
+    if(!imageDescriber)
+      imageDescriber.reset(new feature::ImageDescriber_SIFT());
+  }
+
   // iteration process
   _keyframeIndexes.clear();
-  std::size_t currentFrameStep = _minFrameStep; // start directly (dont skip minFrameStep first frames)
-  
-  for(std::size_t frameIndex = 0; frameIndex < _framesData.size(); ++frameIndex)
-  {
-    ALICEVISION_LOG_TRACE("frame : " << frameIndex);
-    bool frameSelected = true;
-    auto& frameData = _framesData.at(frameIndex);
-    frameData.mediasData.resize(_feeds.size());
 
+  {
+    // each feed is decoded in its own thread, at most one window ahead
+    std::vector< std::unique_ptr<FeedDecoder> > decoders;
     for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
-    {
-      ALICEVISION_LOG_TRACE("media : " << _mediaPaths.at(mediaIndex));
-      auto& feed = *_feeds.at(mediaIndex);
+      decoders.emplace_back(new FeedDecoder(*_feeds.at(mediaIndex), _framesData.size(), frameStep + 1));
+
+    // half resolution grayscale images of the decoded frames still needed, per media
+    std::map< std::size_t, std::vector< image::Image<unsigned char> > > decodedImages;
+    std::size_t nbDecodedFrames = 0;
 
-      if(frameSelected) // false if a camera of a rig is not selected
+    // the frames of a window are evaluated against the same previous keyframes: they are independent.
+    // the first window starts directly (dont skip minFrameStep first frames)
+    std::size_t windowStart = 0;
+    std::size_t windowEnd = frameStep;
+
+    while(windowEnd < _framesData.size())
+    {
+      // get the decoded frames of the window
+      decodedImages.erase(decodedImages.begin(), decodedImages.lower_bound(windowStart));
+      for(; nbDecodedFrames <= windowEnd; ++nbDecodedFrames)
       {
-        if(!feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics))
+        std::vector< image::Image<unsigned char> > mediaImages(_feeds.size());
+        for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
         {
-          ALICEVISION_LOG_ERROR("ERROR  : can't read frame '" << currentImgName << "' !");
-          throw std::invalid_argument("ERROR : can't read frame '" + currentImgName + "' !");
+          if(!decoders.at(mediaIndex)->pop(nbDecodedFrames, mediaImages.at(mediaIndex), currentImgName))
+          {
+            ALICEVISION_LOG_ERROR("ERROR  : can't read frame '" << currentImgName << "' !");
+            throw std::invalid_argument("ERROR : can't read frame '" + currentImgName + "' !");
+          }
         }
+        if(nbDecodedFrames >= windowStart)
+          decodedImages[nbDecodedFrames].swap(mediaImages);
+      }
 
-        // compute sharpness and sparse distance
-        if(!computeFrameData(image, frameIndex, mediaIndex, tileSharpSubset))
-        {
-          frameSelected = false;
-        }
+      // compute sharpness and sparse distance of all the medias of the frames of the window
+      const int nbWindowFrames = static_cast<int>(windowEnd - windowStart + 1);
+      const int nbMedias = static_cast<int>(_feeds.size());
+
+      for(std::size_t frameIndex = windowStart; frameIndex <= windowEnd; ++frameIndex)
+      {
+        auto& frameData = _framesData.at(frameIndex);
+        frameData = FrameData(); // the frame may be evaluated again after a keyframe
+        frameData.mediasData.resize(_feeds.size());
       }
 
-      feed.goToNextFrame();
-    }
+      std::vector<char> mediasSelected(nbWindowFrames * nbMedias);
 
-    {
-      if(frameSelected)
+      #pragma omp parallel for schedule(dynamic)
+      for(int i = 0; i < nbWindowFrames * nbMedias; ++i)
       {
-        ALICEVISION_LOG_TRACE(" > selected" << std::endl);
-        frameData.selected = true;
-        frameData.computeAvgSharpness();
+        const std::size_t frameIndex = windowStart + i / nbMedias;
+        const std::size_t mediaIndex = i % nbMedias;
+        ALICEVISION_LOG_TRACE("frame : " << frameIndex << ", media : " << _mediaPaths.at(mediaIndex));
+        mediasSelected[i] = computeFrameData(decodedImages.at(frameIndex).at(mediaIndex), frameIndex, mediaIndex, tileSharpSubset);
       }
-      else
+
+      for(int i = 0; i < nbWindowFrames; ++i)
       {
-        ALICEVISION_LOG_TRACE(" > skipped" << std::endl);
-        frameData.mediasData.clear(); // remove unselected mediasData
+        auto& frameData = _framesData.at(windowStart + i);
+
+        // false if a camera of a rig is not selected
+        bool frameSelected = true;
+        for(int mediaIndex = 0; mediaIndex < nbMedias; ++mediaIndex)
+        {
+          frameSelected = frameSelected && mediasSelected[i * nbMedias + mediaIndex];
+          frameData.maxDistScore = std::max(frameData.maxDistScore, frameData.mediasData.at(mediaIndex).distScore);
+        }
+
+        if(frameSelected)
+        {
+          ALICEVISION_LOG_TRACE("frame : " << windowStart + i << " > selected" << std::endl);
+          frameData.selected = true;
+          frameData.computeAvgSharpness();
+        }
+        else
+        {
+          ALICEVISION_LOG_TRACE("frame : " << windowStart + i << " > skipped" << std::endl);
+          frameData.mediasData.clear(); // remove unselected mediasData
+        }
       }
-    }
 
-    // selection process
-    if(currentFrameStep >= _maxFrameStep)
-    {
-      currentFrameStep = _minFrameStep;
+      // selection process
       bool hasKeyframe = false;
       std::size_t keyframeIndex = 0;
       float maxSharpness = 0;
 
       // find the sharpest selected frame
-      for(std::size_t index = frameIndex - (frameStep - 1); index <= frameIndex; ++index)
+      for(std::size_t index = windowEnd - (frameStep - 1); index <= windowEnd; ++index)
       {
         if(_framesData[index].selected && (_framesData[index].avgSharpness > maxSharpness))
         {
@@ -185,43 +376,31 @@ void KeyframeSelector::process()
         }
       }
 
-      // save keyframe
       if(hasKeyframe)
       {
         ALICEVISION_LOG_INFO("keyframe choice : " << keyframeIndex << std::endl);
-
-        // write keyframe
-        for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
-        {
-          auto& feed = *_feeds.at(mediaIndex);
-
-          feed.goToFrame(keyframeIndex);
-
-          if(_maxOutFrame == 0) // no limit of keyframes (direct evaluation)
-          {
-            feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-            writeKeyframe(image, keyframeIndex, mediaIndex);
-          }
-        }
         _framesData[keyframeIndex].keyframe = true;
         _keyframeIndexes.push_back(keyframeIndex);
 
-        frameIndex = keyframeIndex + _minFrameStep - 1;
+        windowStart = keyframeIndex + _minFrameStep;
       }
       else
       {
         ALICEVISION_LOG_INFO("keyframe choice : none" << std::endl);
+        windowStart = windowEnd + 1;
       }
+      windowEnd = windowStart + frameStep - 1;
     }
-    ++currentFrameStep;
   }
 
-  if(_maxOutFrame == 0) // no limit of keyframes (evaluation and write already done)
+  // output keyframes
+  std::vector<std::size_t> outFrameIndexes;
+
+  if(_maxOutFrame == 0) // no limit of keyframes
   {
-    return;
+    outFrameIndexes = _keyframeIndexes;
   }
-
-  // if limited number of keyframe select smallest sparse distance
+  else // if limited number of keyframe select smallest sparse distance
   {
     std::vector< std::tuple<float, float, std::size_t> > keyframes;
 
@@ -237,15 +416,24 @@ void KeyframeSelector::process()
     const std::size_t nbOutFrames = std::min(static_cast<std::size_t>(_maxOutFrame), keyframes.size());
 
     for(std::size_t i = 0; i < nbOutFrames; ++i)
+      outFrameIndexes.push_back(std::get<2>(keyframes.at(i)));
+  }
+
+  // write keyframes, each media in its own thread
+  #pragma omp parallel for num_threads(_feeds.size())
+  for(int mediaIndex = 0; mediaIndex < static_cast<int>(_feeds.size()); ++mediaIndex)
+  {
+    auto& feed = *_feeds.at(mediaIndex);
+    image::Image<image::RGBColor> keyframeImage;
+    camera::PinholeRadialK3 keyframeIntrinsics;
+    bool keyframeHasIntrinsics = false;
+    std::string keyframeImgName;
+
+    for(std::size_t frameIndex : outFrameIndexes)
     {
-      const std::size_t frameIndex = std::get<2>(keyframes.at(i));
-      for(std::size_t mediaIndex = 0; mediaIndex < _feeds.size(); ++mediaIndex)
-      {
-        auto& feed = *_feeds.at(mediaIndex);
-        feed.goToFrame(frameIndex);
-        feed.readImage(image, queryIntrinsics, currentImgName, hasIntrinsics);
-        writeKeyframe(image, frameIndex, mediaIndex);
-      }
+      feed.goToFrame(frameIndex);
+      feed.readImage(keyframeImage, keyframeIntrinsics, keyframeImgName, keyframeHasIntrinsics);
+      writeKeyframe(keyframeImage, frameIndex, mediaIndex);
     }
   }
 }
@@ -263,22 +451,30 @@ float KeyframeSelector::computeSharpness(const image::Image<unsigned char>& imag
   image::ImageScharrXDerivative(image, scharrXDer); // normalized
   image::ImageScharrYDerivative(image, scharrYDer); // normalized
 
-  scharrXDer = scharrXDer.cwiseAbs(); // absolute value
-  scharrYDer = scharrYDer.cwiseAbs(); // absolute value
-
-  // image tiles
-  std::vector<float> averageTileIntensity;
-  const float tileSizeInv = 1 / static_cast<float>(tileHeight * tileWidth);
+  // image tiles: sum of the absolute derivatives, accumulated row by row
+  const std::size_t tilesHeight = _nbTileSide * tileHeight;
+  std::vector<double> tileSums(_nbTileSide * _nbTileSide, 0.0);
 
-  for(std::size_t y =  0; y < (_nbTileSide * tileHeight); y += tileHeight)
+  for(std::size_t y = 0; y < tilesHeight; ++y)
   {
-    for(std::size_t x =  0; x < (_nbTileSide * tileWidth); x += tileWidth)
+    const float* rowX = scharrXDer.data() + y * scharrXDer.Width();
+    const float* rowY = scharrYDer.data() + y * scharrYDer.Width();
+    double* tileRowSums = tileSums.data() + (y / tileHeight) * _nbTileSide;
+
+    for(std::size_t tileX = 0; tileX < _nbTileSide; ++tileX)
     {
-      const auto sum = scharrXDer.block(y, x, tileHeight, tileWidth).sum() + scharrYDer.block(y, x, tileHeight, tileWidth).sum();
-      averageTileIntensity.push_back(sum * tileSizeInv);
+      float sum = 0.f;
+      for(std::size_t x = tileX * tileWidth; x < (tileX + 1) * tileWidth; ++x)
+        sum += std::abs(rowX[x]) + std::abs(rowY[x]);
+      tileRowSums[tileX] += sum;
     }
   }
 
+  std::vector<float> averageTileIntensity(tileSums.size());
+  const float tileSizeInv = 1 / static_cast<float>(tileHeight * tileWidth);
+  for(std::size_t i = 0; i < tileSums.size(); ++i)
+    averageTileIntensity[i] = static_cast<float>(tileSums[i]) * tileSizeInv;
+
   // sort tiles average pixel intensity
   std::sort(averageTileIntensity.begin(), averageTileIntensity.end());
 
@@ -287,22 +483,15 @@ float KeyframeSelector::computeSharpness(const image::Image<unsigned char>& imag
 }
 
 
-bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& image,
+bool KeyframeSelector::computeFrameData(const image::Image<unsigned char>& imageGrayHalfSample,
                                         std::size_t frameIndex,
                                         std::size_t mediaIndex,
                                         unsigned int tileSharpSubset)
 {
-  image::Image<unsigned char> imageGray;                // grayscale image
-  image::Image<unsigned char> imageGrayHalfSample;      // half resolution grayscale image
-  
   const auto& currMediaInfo = _mediasInfo.at(mediaIndex);
   auto& currframeData = _framesData.at(frameIndex);
   auto& currMediaData = currframeData.mediasData.at(mediaIndex);
 
-  // get grayscale image and resize
-  image::ConvertPixelType(image, &imageGray);
-  image::ImageHalfSample(imageGray, imageGrayHalfSample);
-
   // compute sharpness
   currMediaData.sharpness = computeSharpness(imageGrayHalfSample,
                                              currMediaInfo.tileHeight,
@@ -317,7 +506,7 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
 
     // compute current frame sparse histogram
     std::unique_ptr<feature::Regions> regions;
-    _imageDescriber->describe(imageGrayHalfSample, regions);
+    _imageDescribers.at(omp_get_thread_num())->describe(imageGrayHalfSample, regions);
     currMediaData.histogram = voctree::SparseHistogram(_voctree->quantizeToSparse(dynamic_cast<feature::SIFT_Regions*>(regions.get())->Descriptors()));
 
     // compute sparseDistance
@@ -332,7 +521,6 @@ bool KeyframeSelector::computeFrameData(const image::Image<image::RGBColor>& ima
           currMediaData.distScore = std::max(currMediaData.distScore, std::abs(voctree::sparseDistance(media.histogram, currMediaData.histogram, "strongCommonPoints")));
         }
       }
-      currframeData.maxDistScore = std::max(currframeData.maxDistScore, currMediaData.distScore);
       ALICEVISION_LOG_TRACE(" - distScore : " << currMediaData.distScore);
     }
 
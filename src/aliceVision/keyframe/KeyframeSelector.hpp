@@ -26,6 +26,8 @@ namespace image {
 template<typename T>
 class Image;
 
+class DecodedImageCache;
+
 } // namespace image
 
 namespace keyframe {
@@ -141,6 +143,16 @@ public:
       _maxOutFrame = nbFrame;
   }
 
+  /**
+   * @brief Set the decoded image cache used to read the image sequences
+   * @param[in] imageCache decoded image cache (nullptr to disable)
+   */
+  void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache)
+  {
+    for(auto& feed : _feeds)
+      feed->setDecodedImageCache(imageCache);
+  }
+
   /**
    * @brief Get sharp subset size for process algorithm
    * @return sharp part of the image (1 = all, 2 = size/2, ...)
@@ -214,8 +226,8 @@ private:
 
   // Tools
 
-  /// Image describer in order to extract describer
-  std::unique_ptr<feature::ImageDescriber> _imageDescriber;
+  /// Image describers in order to extract describer (one per thread)
+  std::vector< std::unique_ptr<feature::ImageDescriber> > _imageDescribers;
   /// Voctree in order to compute sparseHistogram
   std::unique_ptr< aliceVision::voctree::VocabularyTree<DescriptorFloat> > _voctree;
   /// Feed provider for media paths images extraction
@@ -298,13 +310,14 @@ private:
 
   /**
    * @brief Compute sharpness and distance score for a given image
-   * @param[in] image an image of the media
+   * @note Thread safe for different frames or medias
+   * @param[in] imageGrayHalfSample half resolution grayscale image of the media
    * @param[in] frameIndex the image index in the media sequence
    * @param[in] mediaIndex the media index
    * @param[in] tileSharpSubset number of sharp tiles
    * @return true if the frame is selected
    */
-  bool computeFrameData(const image::Image<image::RGBColor>& image,
+  bool computeFrameData(const image::Image<unsigned char>& imageGrayHalfSample,
                         std::size_t frameIndex,
                         std::size_t mediaIndex,
                         unsigned int tileSharpSubset);
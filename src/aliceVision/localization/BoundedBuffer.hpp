@@ -71,6 +71,13 @@ public:
    * @return the iterator pointing to the last element of the buffer.
    */
   const_iterator end() const { return _buffer.end(); }
+
+  /**
+   * @brief Returns the number of elements in the buffer.
+   * 
+   * @return the number of elements in the buffer.
+   */
+  std::size_t size() const { return _buffer.size(); }
   
   /**
    * @brief It add a new element at the end of the buffer. If the buffer is full
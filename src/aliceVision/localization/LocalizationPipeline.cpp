@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationPipeline.hpp"
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace aliceVision {
+namespace localization {
+
+LocalizationPipeline::LocalizationPipeline(VoctreeLocalizer& localizer,
+                                           const VoctreeLocalizer::Parameters& param,
+                                           std::size_t nbInFlightFrames)
+  : _localizer(localizer)
+  , _param(param)
+  , _nbInFlightFrames(std::max(std::size_t(1), nbInFlightFrames))
+{
+  if(!_localizer.isInit())
+    throw std::invalid_argument("LocalizationPipeline: the localizer is not initialized.");
+}
+
+std::size_t LocalizationPipeline::run(dataio::FeedProvider& feed, const FrameCallback& callback)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _decodedFrames.clear();
+    _describedFrames.clear();
+    _nbInFlight = 0;
+    _nbDecoded = 0;
+    _decodingDone = false;
+    _abort = false;
+  }
+
+  // the decode stage and the localization stage are running in their own thread
+  const std::size_t nbDescribeWorkers = std::max(std::size_t(1),
+    std::min(_nbInFlightFrames, static_cast<std::size_t>(std::thread::hardware_concurrency())));
+
+  ALICEVISION_LOG_DEBUG("[pipeline]\t" << _nbInFlightFrames << " frames in flight, " << nbDescribeWorkers << " describe worker(s)");
+
+  std::vector<std::thread> threads;
+  threads.emplace_back(&LocalizationPipeline::decodeLoop, this, std::ref(feed));
+  for(std::size_t i = 0; i < nbDescribeWorkers; ++i)
+    threads.emplace_back(&LocalizationPipeline::describeLoop, this);
+
+  const auto stopThreads = [&]()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _abort = true;
+    }
+    _condition.notify_all();
+    for(std::thread& thread : threads)
+      thread.join();
+  };
+
+  std::size_t nextFrameId = 0;
+  try
+  {
+    while(true)
+    {
+      std::unique_ptr<PipelineFrame> frame;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _condition.wait(lock, [&]{ return _describedFrames.count(nextFrameId) || (_decodingDone && nextFrameId == _nbDecoded); });
+
+        if(_describedFrames.count(nextFrameId) == 0)
+          break;
+
+        frame = std::move(_describedFrames.at(nextFrameId));
+        _describedFrames.erase(nextFrameId);
+      }
+
+      // match, resect and refine in the order of the feed
+      // (the frame buffer of the localizer depends on the previous frames)
+      system::Timer timer;
+      _localizer.localize(frame->queryRegions,
+                          &frame->retrievedImages,
+                          frame->imageSize,
+                          &_param,
+                          frame->hasIntrinsics /*useInputIntrinsics*/,
+                          frame->queryIntrinsics,
+                          frame->localizationResult,
+                          frame->imagePath);
+      frame->localizeTimeMs = timer.elapsedMs();
+
+      callback(*frame);
+      ++nextFrameId;
+
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        --_nbInFlight;
+      }
+      _condition.notify_all();
+    }
+  }
+  catch(...)
+  {
+    stopThreads();
+    throw;
+  }
+
+  stopThreads();
+  return nextFrameId;
+}
+
+void LocalizationPipeline::decodeLoop(dataio::FeedProvider& feed)
+{
+  std::size_t frameId = 0;
+
+  while(true)
+  {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]{ return _abort || _nbInFlight < _nbInFlightFrames; });
+      if(_abort)
+        break;
+    }
+
+    std::unique_ptr<PipelineFrame> frame(new PipelineFrame());
+    image::Image<unsigned char> imageGrey;
+
+    if(!feed.readImage(imageGrey, frame->queryIntrinsics, frame->imagePath, frame->hasIntrinsics))
+      break;
+    feed.goToNextFrame();
+
+    frame->frameId = frameId++;
+    frame->imageSize = std::make_pair(imageGrey.Width(), imageGrey.Height());
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      ++_nbInFlight;
+      _decodedFrames.emplace_back(std::move(frame), std::move(imageGrey));
+    }
+    _condition.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _nbDecoded = frameId;
+    _decodingDone = true;
+  }
+  _condition.notify_all();
+}
+
+void LocalizationPipeline::describeLoop()
+{
+  // each worker owns its feature extractors
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  for(const auto& localizerImageDescriber : _localizer._imageDescribers)
+  {
+    imageDescribers.push_back(feature::createImageDescriber(localizerImageDescriber->getDescriberType()));
+    imageDescribers.back()->setCudaPipe(_localizer._cudaPipe);
+    imageDescribers.back()->setConfigurationPreset(_param._featurePreset);
+  }
+
+  while(true)
+  {
+    std::unique_ptr<PipelineFrame> frame;
+    image::Image<unsigned char> imageGrey;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _condition.wait(lock, [this]{ return _abort || _decodingDone || !_decodedFrames.empty(); });
+      if(_abort || _decodedFrames.empty())
+        return;
+
+      frame = std::move(_decodedFrames.front().first);
+      imageGrey.swap(_decodedFrames.front().second);
+      _decodedFrames.pop_front();
+    }
+
+    system::Timer timer;
+
+    try
+    {
+      // extract descriptors and features from image
+      for(const auto& imageDescriber : imageDescribers)
+      {
+        auto& queryRegions = frame->queryRegions[imageDescriber->getDescriberType()];
+        imageDescriber->allocate(queryRegions);
+        imageDescriber->describe(imageGrey, queryRegions, nullptr);
+      }
+
+      // the decoded image is not needed anymore
+      imageGrey = image::Image<unsigned char>();
+
+      // query the database
+      frame->isRetrieved = _localizer.retrieveSimilarImages(frame->queryRegions, _param, frame->retrievedImages);
+    }
+    catch(std::exception& e)
+    {
+      // the frame is still given to the localization stage to keep the output order
+      ALICEVISION_LOG_WARNING("[pipeline]\tUnable to describe frame " << frame->frameId << ": " << e.what());
+      frame->queryRegions.clear();
+      frame->retrievedImages.clear();
+      frame->isRetrieved = false;
+    }
+    frame->describeTimeMs = timer.elapsedMs();
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const std::size_t frameId = frame->frameId;
+      _describedFrames[frameId] = std::move(frame);
+    }
+    _condition.notify_all();
+  }
+}
+
+} // namespace localization
+} // namespace aliceVision
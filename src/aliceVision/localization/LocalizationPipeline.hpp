@@ -0,0 +1,122 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "VoctreeLocalizer.hpp"
+#include "LocalizationResult.hpp"
+
+#include <aliceVision/dataio/FeedProvider.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/camera/PinholeRadial.hpp>
+#include <aliceVision/voctree/Database.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief A frame going through the LocalizationPipeline.
+ */
+struct PipelineFrame
+{
+  /// index of the frame in the feed
+  std::size_t frameId = 0;
+  /// the original media path of the frame
+  std::string imagePath;
+  /// the size of the image
+  std::pair<std::size_t, std::size_t> imageSize;
+  /// true if the feed provides the intrinsics of the frame
+  bool hasIntrinsics = false;
+  /// the intrinsics of the frame (refined by the localization)
+  camera::PinholeRadialK3 queryIntrinsics;
+  /// the features of the frame
+  feature::MapRegionsPerDesc queryRegions;
+  /// the similar images retrieved from the database
+  std::vector<voctree::DocMatch> retrievedImages;
+  /// false if the frame has no feature of the vocabulary tree describer type
+  bool isRetrieved = false;
+  /// the localization result
+  LocalizationResult localizationResult;
+  /// time spent to extract the features and query the database (in ms)
+  double describeTimeMs = 0.0;
+  /// time spent to match, resect and refine the pose (in ms)
+  double localizeTimeMs = 0.0;
+};
+
+/**
+ * @brief Multi-stage pipeline to localize the frames of a feed with a VoctreeLocalizer.
+ *
+ * The stages are:
+ *  - decode: the frames are read from the feed by a dedicated thread,
+ *  - describe & retrieve: the features are extracted and the database is queried
+ *    by a pool of worker threads, each one owning its image describers,
+ *  - match, resect & refine: the frames are localized in the calling thread, in the
+ *    order of the feed, so that the frame buffer of the localizer is filled as in
+ *    a sequential processing.
+ *
+ * The per-frame results are the same as with VoctreeLocalizer::localize(), only the
+ * visual debug of the extracted features is not supported.
+ */
+class LocalizationPipeline
+{
+public:
+  using FrameCallback = std::function<void(PipelineFrame&)>;
+
+  /**
+   * @param[in] localizer An initialized localizer.
+   * @param[in] param The parameters for the localization.
+   * @param[in] nbInFlightFrames The maximum number of frames between the decode stage
+   * and the output (at least 2 to have the stages running concurrently).
+   */
+  LocalizationPipeline(VoctreeLocalizer& localizer,
+                       const VoctreeLocalizer::Parameters& param,
+                       std::size_t nbInFlightFrames);
+
+  /**
+   * @brief Localize all the frames of the feed.
+   *
+   * @param[in,out] feed The feed providing the frames.
+   * @param[in] callback Function called in the calling thread for each localized frame,
+   * in the order of the feed.
+   * @return the number of processed frames
+   */
+  std::size_t run(dataio::FeedProvider& feed, const FrameCallback& callback);
+
+private:
+  void decodeLoop(dataio::FeedProvider& feed);
+  void describeLoop();
+
+  VoctreeLocalizer& _localizer;
+  VoctreeLocalizer::Parameters _param;
+  std::size_t _nbInFlightFrames;
+
+  /// decoded frames waiting for the describe stage
+  std::deque<std::pair<std::unique_ptr<PipelineFrame>, image::Image<unsigned char>>> _decodedFrames;
+  /// described frames waiting for the localization stage, by frame id
+  std::map<std::size_t, std::unique_ptr<PipelineFrame>> _describedFrames;
+  /// number of frames between the decode stage and the output
+  std::size_t _nbInFlight = 0;
+  /// number of frames read from the feed, known when the decoding is done
+  std::size_t _nbDecoded = 0;
+  bool _decodingDone = false;
+  /// stop all the stages (the localization stage has failed)
+  bool _abort = false;
+
+  std::mutex _mutex;
+  std::condition_variable _condition;
+};
+
+} // namespace localization
+} // namespace aliceVision
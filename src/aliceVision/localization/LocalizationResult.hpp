@@ -119,6 +119,33 @@ public:
   {
     return _isValid;
   }
+
+  /**
+   * @brief Time spent to extract the features of the image (in ms).
+   */
+  double getDescribeTimeMs() const
+  {
+    return _describeTimeMs;
+  }
+
+  void setDescribeTimeMs(double describeTimeMs)
+  {
+    _describeTimeMs = describeTimeMs;
+  }
+
+  /**
+   * @brief Time spent to retrieve the similar images and to match them (in ms).
+   * When the camera is localized on its own, it also includes the pose estimation.
+   */
+  double getMatchingTimeMs() const
+  {
+    return _matchingTimeMs;
+  }
+
+  void setMatchingTimeMs(double matchingTimeMs)
+  {
+    _matchingTimeMs = matchingTimeMs;
+  }
   
   /**
    * @brief Compute the residual for each 2D-3D association.
@@ -197,6 +224,12 @@ private:
   
   /// True if the localization succeeded, false otherwise
   bool _isValid; 
+
+  /// Time spent to extract the features (in ms)
+  double _describeTimeMs = 0.0;
+
+  /// Time spent to retrieve and match the similar images (in ms)
+  double _matchingTimeMs = 0.0;
 };
 
 /**
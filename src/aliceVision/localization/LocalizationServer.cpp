@@ -0,0 +1,215 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "LocalizationServer.hpp"
+#include <aliceVision/image/io.hpp>
+#include <aliceVision/system/Logger.hpp>
+
+#include <algorithm>
+#include <numeric>
+
+namespace aliceVision {
+namespace localization {
+
+std::ostream& operator<<(std::ostream& os, const LocalizationLatencyStats& stats)
+{
+  os << stats.nbLocalized << "/" << stats.nbFrames << " frames localized, latency [ms]:"
+     << " mean " << stats.mean
+     << ", p50 " << stats.p50
+     << ", p90 " << stats.p90
+     << ", p99 " << stats.p99
+     << ", max " << stats.max;
+  return os;
+}
+
+LocalizationServer::LocalizationServer(VoctreeLocalizer& localizer,
+                                       const VoctreeLocalizer::Parameters& param,
+                                       const std::vector<feature::EImageDescriberType>& matchDescTypes,
+                                       std::size_t nbWorkers,
+                                       ResponseCallback callback,
+                                       const camera::PinholeRadialK3* queryIntrinsics)
+  : _localizer(localizer)
+  , _param(param)
+  , _matchDescTypes(matchDescTypes)
+  , _callback(callback)
+{
+  if(!_localizer.isInit())
+    throw std::invalid_argument("LocalizationServer: the localizer is not initialized.");
+
+  // the frames are independent queries and the frame buffer is not thread safe
+  _param._nbFrameBufferMatching = 0;
+
+  if(queryIntrinsics != nullptr)
+  {
+    _useInputIntrinsics = true;
+    _queryIntrinsics = *queryIntrinsics;
+  }
+
+  if(nbWorkers == 0)
+    nbWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+  _workers.reserve(nbWorkers);
+  for(std::size_t i = 0; i < nbWorkers; ++i)
+    _workers.emplace_back(&LocalizationServer::workerLoop, this);
+
+  ALICEVISION_LOG_INFO("Localization server started with " << nbWorkers << " worker(s).");
+}
+
+LocalizationServer::~LocalizationServer()
+{
+  stop();
+}
+
+std::size_t LocalizationServer::push(const std::string& imagePath)
+{
+  std::size_t frameId;
+  {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    if(_stopping)
+      throw std::logic_error("LocalizationServer: cannot push a frame to a stopped server.");
+
+    LocalizationRequest request;
+    request.frameId = frameId = _nbPushed++;
+    request.imagePath = imagePath;
+    request.receivedTime = std::chrono::steady_clock::now();
+    _queue.push_back(request);
+  }
+  _queueCondition.notify_one();
+  return frameId;
+}
+
+void LocalizationServer::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_queueMutex);
+    _stopping = true;
+  }
+  _queueCondition.notify_all();
+
+  for(std::thread& worker : _workers)
+  {
+    if(worker.joinable())
+      worker.join();
+  }
+}
+
+LocalizationLatencyStats LocalizationServer::getLatencyStats() const
+{
+  std::vector<double> latencies;
+  LocalizationLatencyStats stats;
+  {
+    std::lock_guard<std::mutex> lock(_responseMutex);
+    latencies = _latencies;
+    stats.nbLocalized = _nbLocalized;
+  }
+
+  stats.nbFrames = latencies.size();
+  if(latencies.empty())
+    return stats;
+
+  std::sort(latencies.begin(), latencies.end());
+
+  const auto percentile = [&latencies](double p)
+  {
+    const std::size_t index = static_cast<std::size_t>(p * (latencies.size() - 1) + 0.5);
+    return latencies[std::min(index, latencies.size() - 1)];
+  };
+
+  stats.mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / latencies.size();
+  stats.p50 = percentile(0.5);
+  stats.p90 = percentile(0.9);
+  stats.p99 = percentile(0.99);
+  stats.max = latencies.back();
+  return stats;
+}
+
+void LocalizationServer::workerLoop()
+{
+  // each worker owns its feature extractors
+  std::vector<std::unique_ptr<feature::ImageDescriber>> imageDescribers;
+  for(feature::EImageDescriberType matchDescType : _matchDescTypes)
+  {
+    imageDescribers.push_back(feature::createImageDescriber(matchDescType));
+    imageDescribers.back()->setCudaPipe(_localizer._cudaPipe);
+    imageDescribers.back()->setConfigurationPreset(_param._featurePreset);
+  }
+
+  while(true)
+  {
+    LocalizationRequest request;
+    {
+      std::unique_lock<std::mutex> lock(_queueMutex);
+      _queueCondition.wait(lock, [this]{ return _stopping || !_queue.empty(); });
+
+      // process the remaining frames before stopping
+      if(_queue.empty())
+        return;
+
+      request = std::move(_queue.front());
+      _queue.pop_front();
+    }
+
+    LocalizationResponse response;
+    process(request, imageDescribers, response);
+
+    std::lock_guard<std::mutex> lock(_responseMutex);
+    _latencies.push_back(response.latencyMs);
+    if(response.result.isValid())
+      ++_nbLocalized;
+    if(_callback)
+      _callback(response);
+  }
+}
+
+void LocalizationServer::process(const LocalizationRequest& request,
+                                 std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+                                 LocalizationResponse& response)
+{
+  using namespace std::chrono;
+
+  const steady_clock::time_point startTime = steady_clock::now();
+
+  response.frameId = request.frameId;
+  response.imagePath = request.imagePath;
+  response.queueTimeMs = duration_cast<duration<double, std::milli>>(startTime - request.receivedTime).count();
+
+  try
+  {
+    image::Image<unsigned char> imageGrey;
+    image::readImage(request.imagePath, imageGrey);
+
+    // A. extract descriptors and features from image
+    feature::MapRegionsPerDesc queryRegionsPerDesc;
+    for(const auto& imageDescriber : imageDescribers)
+    {
+      auto& queryRegions = queryRegionsPerDesc[imageDescriber->getDescriberType()];
+      imageDescriber->allocate(queryRegions);
+      imageDescriber->describe(imageGrey, queryRegions, nullptr);
+    }
+
+    // B. localize with the shared database
+    camera::PinholeRadialK3 queryIntrinsics = _queryIntrinsics;
+    _localizer.localize(queryRegionsPerDesc,
+                        std::make_pair(imageGrey.Width(), imageGrey.Height()),
+                        &_param,
+                        _useInputIntrinsics,
+                        queryIntrinsics,
+                        response.result,
+                        request.imagePath);
+  }
+  catch(std::exception& e)
+  {
+    ALICEVISION_LOG_WARNING("Unable to localize frame " << request.frameId << " (" << request.imagePath << "): " << e.what());
+    response.result = LocalizationResult();
+  }
+
+  const steady_clock::time_point endTime = steady_clock::now();
+  response.processingTimeMs = duration_cast<duration<double, std::milli>>(endTime - startTime).count();
+  response.latencyMs = duration_cast<duration<double, std::milli>>(endTime - request.receivedTime).count();
+}
+
+} // namespace localization
+} // namespace aliceVision
@@ -0,0 +1,158 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "VoctreeLocalizer.hpp"
+#include "LocalizationResult.hpp"
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/camera/PinholeRadial.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace aliceVision {
+namespace localization {
+
+/**
+ * @brief A frame to localize, as received by the LocalizationServer.
+ */
+struct LocalizationRequest
+{
+  /// index of the request, in order of arrival
+  std::size_t frameId = 0;
+  /// path to the image to localize
+  std::string imagePath;
+  /// time at which the request has been received
+  std::chrono::steady_clock::time_point receivedTime;
+};
+
+/**
+ * @brief The answer of the LocalizationServer to a LocalizationRequest.
+ */
+struct LocalizationResponse
+{
+  /// index of the request, in order of arrival
+  std::size_t frameId = 0;
+  /// path to the localized image
+  std::string imagePath;
+  /// the localization result (not valid if the image cannot be read or localized)
+  LocalizationResult result;
+  /// time spent in the queue before a worker takes the request (in ms)
+  double queueTimeMs = 0.0;
+  /// time spent to read, describe and localize the image (in ms)
+  double processingTimeMs = 0.0;
+  /// total time between the reception of the request and the response (in ms)
+  double latencyMs = 0.0;
+};
+
+/**
+ * @brief Latency statistics of the frames processed by the LocalizationServer (in ms).
+ */
+struct LocalizationLatencyStats
+{
+  std::size_t nbFrames = 0;
+  std::size_t nbLocalized = 0;
+  double mean = 0.0;
+  double p50 = 0.0;
+  double p90 = 0.0;
+  double p99 = 0.0;
+  double max = 0.0;
+};
+
+std::ostream& operator<<(std::ostream& os, const LocalizationLatencyStats& stats);
+
+/**
+ * @brief Long-running localization service.
+ *
+ * The server keeps a VoctreeLocalizer (SfMData, reconstruction descriptors and
+ * vocabulary tree) resident in memory and localizes the frames pushed with push()
+ * on a pool of worker threads. Each worker owns its image describers, the database
+ * is shared in read-only.
+ *
+ * The frames are considered as independent queries: the frame buffer matching of the
+ * VoctreeLocalizer (which relies on the order of the frames of a sequence) is disabled.
+ */
+class LocalizationServer
+{
+public:
+  using ResponseCallback = std::function<void(const LocalizationResponse&)>;
+
+  /**
+   * @brief Create the server and start the workers.
+   *
+   * @param[in] localizer An initialized localizer, it must outlive the server.
+   * @param[in] param The localization parameters.
+   * @param[in] matchDescTypes The describer types to extract from the query images.
+   * @param[in] nbWorkers The number of frames processed concurrently (0 for the number of cores).
+   * @param[in] callback Function called (from the worker threads, one at a time) for each localized frame.
+   * @param[in] queryIntrinsics Optional known calibration of the query images.
+   */
+  LocalizationServer(VoctreeLocalizer& localizer,
+                     const VoctreeLocalizer::Parameters& param,
+                     const std::vector<feature::EImageDescriberType>& matchDescTypes,
+                     std::size_t nbWorkers,
+                     ResponseCallback callback,
+                     const camera::PinholeRadialK3* queryIntrinsics = nullptr);
+
+  ~LocalizationServer();
+
+  /**
+   * @brief Add a frame to the processing queue.
+   * @param[in] imagePath The path to the image to localize.
+   * @return the id of the frame
+   */
+  std::size_t push(const std::string& imagePath);
+
+  /**
+   * @brief Wait for all the queued frames to be processed and stop the workers.
+   */
+  void stop();
+
+  /**
+   * @brief Compute the latency statistics of all the frames processed so far.
+   */
+  LocalizationLatencyStats getLatencyStats() const;
+
+  std::size_t getNbWorkers() const { return _workers.size(); }
+
+private:
+  void workerLoop();
+
+  void process(const LocalizationRequest& request,
+               std::vector<std::unique_ptr<feature::ImageDescriber>>& imageDescribers,
+               LocalizationResponse& response);
+
+  VoctreeLocalizer& _localizer;
+  VoctreeLocalizer::Parameters _param;
+  std::vector<feature::EImageDescriberType> _matchDescTypes;
+  ResponseCallback _callback;
+  bool _useInputIntrinsics = false;
+  camera::PinholeRadialK3 _queryIntrinsics;
+
+  std::vector<std::thread> _workers;
+
+  std::deque<LocalizationRequest> _queue;
+  std::size_t _nbPushed = 0;
+  bool _stopping = false;
+  mutable std::mutex _queueMutex;
+  std::condition_variable _queueCondition;
+
+  std::vector<double> _latencies;
+  std::size_t _nbLocalized = 0;
+  mutable std::mutex _responseMutex;
+};
+
+} // namespace localization
+} // namespace aliceVision
@@ -8,6 +8,7 @@
 #include "rigResection.hpp"
 #include "optimization.hpp"
 #include <aliceVision/config.hpp>
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/pipeline/RelativePoseInfo.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
@@ -151,6 +152,25 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
                                 camera::PinholeRadialK3 &queryIntrinsics,
                                 LocalizationResult & localizationResult,
                                 const std::string& imagePath)
+{
+  return localize(queryRegions,
+                  nullptr,
+                  imageSize,
+                  param,
+                  useInputIntrinsics,
+                  queryIntrinsics,
+                  localizationResult,
+                  imagePath);
+}
+
+bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
+                                const std::vector<voctree::DocMatch>* retrievedImages,
+                                const std::pair<std::size_t, std::size_t> &imageSize,
+                                const LocalizerParameters *param,
+                                bool useInputIntrinsics,
+                                camera::PinholeRadialK3 &queryIntrinsics,
+                                LocalizationResult & localizationResult,
+                                const std::string& imagePath)
 {
   const Parameters *voctreeParam = static_cast<const Parameters *>(param);
   if(!voctreeParam)
@@ -168,7 +188,8 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
                                    useInputIntrinsics,
                                    queryIntrinsics,
                                    localizationResult,
-                                   imagePath);
+                                   imagePath,
+                                   retrievedImages);
     case Algorithm::BestResult: throw std::invalid_argument("BestResult not yet implemented");
     case Algorithm::AllResults:
     return localizeAllResults(queryRegions,
@@ -177,12 +198,43 @@ bool VoctreeLocalizer::localize(const feature::MapRegionsPerDesc & queryRegions,
                               useInputIntrinsics,
                               queryIntrinsics,
                               localizationResult,
-                              imagePath);
+                              imagePath,
+                              retrievedImages);
     case Algorithm::Cluster: throw std::invalid_argument("Cluster not yet implemented");
     default: throw std::invalid_argument("Unknown algorithm type");
   }
 }
 
+bool VoctreeLocalizer::retrieveSimilarImages(const feature::MapRegionsPerDesc & queryRegions,
+                                             const Parameters &param,
+                                             std::vector<voctree::DocMatch>& out_matchedImages) const
+{
+  // AllResults uses all the database images if no number of results is given
+  const std::size_t numResults = (param._algorithm == Algorithm::AllResults && param._numResults == 0) ? _database.size() : param._numResults;
+  return retrieveSimilarImages(queryRegions, numResults, out_matchedImages);
+}
+
+bool VoctreeLocalizer::retrieveSimilarImages(const feature::MapRegionsPerDesc & queryRegions,
+                                             std::size_t numResults,
+                                             std::vector<voctree::DocMatch>& out_matchedImages) const
+{
+  out_matchedImages.clear();
+
+  if(queryRegions.count(_voctreeDescType) == 0)
+  {
+    ALICEVISION_LOG_WARNING("[database]	 No feature type " << feature::EImageDescriberType_enumToString(_voctreeDescType) << " in query region.");
+    return false;
+  }
+
+  // pass the descriptors through the vocabulary tree to get the visual words
+  // associated to each feature
+  const voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
+
+  // Request closest images from voctree
+  _database.find(requestImageWords, numResults, out_matchedImages);
+  return true;
+}
+
 bool VoctreeLocalizer::localize(const image::Image<unsigned char> & imageGrey,
                                 const LocalizerParameters *param,
                                 bool useInputIntrinsics,
@@ -378,17 +430,16 @@ bool VoctreeLocalizer::localizeFirstBestResult(const feature::MapRegionsPerDesc
                                                bool useInputIntrinsics,
                                                camera::PinholeRadialK3 &queryIntrinsics,
                                                LocalizationResult &localizationResult,
-                                               const std::string &imagePath)
+                                               const std::string &imagePath,
+                                               const std::vector<voctree::DocMatch>* retrievedImages)
 {
   // A. Find the (visually) similar images in the database 
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
-  // pass the descriptors through the vocabulary tree to get the visual words
-  // associated to each feature
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
-  
-  // Request closest images from voctree
   std::vector<voctree::DocMatch> matchedImages;
-  _database.find(requestImageWords, param._numResults, matchedImages);
+  if(retrievedImages != nullptr)
+    matchedImages = *retrievedImages;
+  else
+    retrieveSimilarImages(queryRegions, param, matchedImages);
   
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -596,7 +647,8 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                                           bool useInputIntrinsics,
                                           camera::PinholeRadialK3 &queryIntrinsics,
                                           LocalizationResult &localizationResult,
-                                          const std::string& imagePath)
+                                          const std::string& imagePath,
+                                          const std::vector<voctree::DocMatch>* retrievedImages)
 {
   
   sfm::ImageLocalizerMatchData resectionData;
@@ -616,7 +668,8 @@ bool VoctreeLocalizer::localizeAllResults(const feature::MapRegionsPerDesc &quer
                      resectionData.pt3D,
                      resectionData.vec_descType,
                      matchedImages,
-                     imagePath);
+                     imagePath,
+                     retrievedImages);
 
   const std::size_t numCollectedPts = occurences.size();
   std::vector<IndMatch3D2D> associationIDs;
@@ -736,23 +789,23 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
                                           Mat &out_pt3D,
                                           std::vector<feature::EImageDescriberType>& out_descTypes,
                                           std::vector<voctree::DocMatch>& out_matchedImages,
-                                          const std::string& imagePath) const
+                                          const std::string& imagePath,
+                                          const std::vector<voctree::DocMatch>* retrievedImages) const
 {
   assert(out_descTypes.size() == 0);
 
   // A. Find the (visually) similar images in the database 
-  // pass the descriptors through the vocabulary tree to get the visual words
-  // associated to each feature
   ALICEVISION_LOG_DEBUG("[database]\tRequest closest images from voctree");
-  if(queryRegions.count(_voctreeDescType) == 0)
+  if(retrievedImages != nullptr)
+  {
+    if(queryRegions.count(_voctreeDescType) == 0)
+      return;
+    out_matchedImages = *retrievedImages;
+  }
+  else if(!retrieveSimilarImages(queryRegions, (param._numResults == 0) ? _database.size() : param._numResults, out_matchedImages))
   {
-    ALICEVISION_LOG_WARNING("[database]\t No feature type " << feature::EImageDescriberType_enumToString(_voctreeDescType) << " in query region.");
     return;
   }
-  voctree::SparseHistogram requestImageWords = _voctree->quantizeToSparse(queryRegions.at(_voctreeDescType)->blindDescriptors());
-  
-  // Request closest images from voctree
-  _database.find(requestImageWords, (param._numResults==0) ? (_database.size()) : (param._numResults) , out_matchedImages);
 
 //  // Debugging log
 //  // for each similar image found print score and number of features
@@ -770,17 +823,19 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
   ALICEVISION_LOG_DEBUG("[matching]\tBuilding the matcher");
   matching::RegionsDatabaseMatcherPerDesc matchers(_matcherType, queryRegions);
 
-  std::map< std::pair<IndexT, IndexT>, std::size_t > repeated;
-  
   // B. for each found similar image, try to find the correspondences between the 
   // query image adn the similar image
   // stop when param._maxResults successful matches have been found
-  std::size_t goodMatches = 0;
+
+  // minimum number of points that allows a reliable 3D reconstruction
+  const size_t minNum3DPoints = 5;
+
+  // select the images to match
+  std::vector<IndexT> candidateViewIds;
+  candidateViewIds.reserve(out_matchedImages.size());
+  bool hasUnsupportedIntrinsics = false;
   for(const voctree::DocMatch& matchedImage : out_matchedImages)
   {
-    // minimum number of points that allows a reliable 3D reconstruction
-    const size_t minNum3DPoints = 5;
-
     const auto matchedViewId = matchedImage.id;
     // the handler to the current view
     const std::shared_ptr<sfm::View> matchedView = _sfm_data.views.at(matchedViewId);
@@ -795,117 +850,168 @@ void VoctreeLocalizer::getAllAssociations(const feature::MapRegionsPerDesc &quer
       ALICEVISION_LOG_DEBUG("[matching]\tSkipping matching with " << matchedView->getImagePath() << " as it has too few visible 3D points");
       continue;
     }
-    ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
-    ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
-    
+
     // its associated intrinsics
-    // this is just ugly!
-    const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
-    if ( !isPinhole(matchedIntrinsicsBase->getType()) )
+    if(!isPinhole(_sfm_data.intrinsics.at(matchedView->getIntrinsicId())->getType()))
     {
-      //@fixme maybe better to throw something here
-      ALICEVISION_CERR("Only Pinhole cameras are supported!");
-      return;
+      // the images after this one are not matched
+      hasUnsupportedIntrinsics = true;
+      break;
     }
-    const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
+    candidateViewIds.push_back(matchedViewId);
+  }
 
-    matching::MatchesPerDescType featureMatches;
-    const bool matchWorked = robustMatching(matchers,
-                                      // pass the input intrinsic if they are valid, null otherwise
-                                      (useInputIntrinsics) ? &queryIntrinsics : nullptr,
-                                      matchedRegions,
-                                      matchedIntrinsics,
-                                      param._fDistRatio,
-                                      param._matchingError,
-                                      param._useRobustMatching,
-                                      param._useGuidedMatching,
-                                      imageSize,
-                                      std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
-                                      featureMatches,
-                                      param._matchingEstimator);
-    if (!matchWorked)
+  std::size_t goodMatches = 0;
+  std::size_t nextCandidate = 0;
+  bool enoughMatches = false;
+  while(!enoughMatches && nextCandidate < candidateViewIds.size())
+  {
+    // match the query image with a batch of similar images in a single search:
+    // the batch is sized to the number of successful matches still needed
+    // so that no more images are matched than in a one by one processing
+    std::size_t batchSize = candidateViewIds.size() - nextCandidate;
+    if(param._maxResults != 0)
+      batchSize = std::min(batchSize, param._maxResults - goodMatches);
+
+    std::vector<const feature::MapRegionsPerDesc*> batchRegions;
+    batchRegions.reserve(batchSize);
+    for(std::size_t b = 0; b < batchSize; ++b)
+      batchRegions.push_back(&_regionsPerView.getRegionsPerDesc(candidateViewIds[nextCandidate + b]));
+
+    ALICEVISION_LOG_TRACE("[matching]\tMatching the query image with " << batchSize << " images");
+    std::vector<matching::MatchesPerDescType> batchPutativeMatches;
+    const std::vector<bool> batchMatchWorked = matchers.MatchBatch(param._fDistRatio, batchRegions, batchPutativeMatches);
+
+    for(std::size_t b = 0; b < batchSize; ++b)
     {
-//      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
-      continue;
-    }
-
-    ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
-    assert(featureMatches.getNbAllMatches() > 0);
+      const auto matchedViewId = candidateViewIds[nextCandidate + b];
+      // the handler to the current view
+      const std::shared_ptr<sfm::View> matchedView = _sfm_data.views.at(matchedViewId);
+      // its associated reconstructed regions
+      const feature::MapRegionsPerDesc& matchedRegions = *batchRegions[b];
+      
+      ALICEVISION_LOG_TRACE("[matching]\tTrying to match the query image with " << matchedView->getImagePath());
+      ALICEVISION_LOG_TRACE("[matching]\tIt has " << matchedRegions.getNbAllRegions() << " available features to match");
 
-    // if debug is enable save the matches between the query image and the current matching image
-    // It saves the feature matches in a folder with the same name as the query
-    // image, if it does not exist it will create it. The final svg file will have
-    // a name like this: queryImage_matchedImage.svg placed in the following directory:
-    // param._visualDebug/queryImage/
-    if(!param._visualDebug.empty() && !imagePath.empty())
-    {
-      namespace bfs = boost::filesystem;
-      const sfm::View *mview = _sfm_data.GetViews().at(matchedViewId).get();
-      // the current query image without extension
-      const auto queryImage = bfs::path(imagePath).stem();
-      // the matching image without extension
-      const auto matchedImage = bfs::path(mview->getImagePath()).stem();
-      // the full path of the matching image
-      const auto matchedPath = mview->getImagePath();
-
-      // the directory where to save the feature matches
-      const auto baseDir = bfs::path(param._visualDebug) / queryImage;
-      if((!bfs::exists(baseDir)))
+      if(!batchMatchWorked[b])
       {
-        ALICEVISION_LOG_DEBUG("created " << baseDir.string());
-        bfs::create_directories(baseDir);
+        ALICEVISION_LOG_DEBUG("[matching]\tPutative matching failed.");
+        continue;
       }
       
-      // damn you, boost, what does it take to make the operator "+"?
-      // the final filename for the output svg file as a composition of the query
-      // image and the matched image
-      auto outputName = baseDir / queryImage;
-      outputName += "_";
-      outputName += matchedImage;
-      outputName += ".svg";
-
-      feature::saveMatches2SVG(imagePath,
-                                imageSize,
-                                queryRegions,
-                                matchedPath,
-                                std::make_pair(mview->getWidth(), mview->getHeight()),
-                                _regionsPerView.getRegionsPerDesc(matchedViewId),
-                                featureMatches,
-                                outputName.string()); 
-    }
+      // its associated intrinsics
+      // this is just ugly!
+      const camera::IntrinsicBase *matchedIntrinsicsBase = _sfm_data.intrinsics.at(matchedView->getIntrinsicId()).get();
+      const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
+
+      matching::MatchesPerDescType featureMatches;
+      const bool matchWorked = robustMatching(matchers,
+                                        // pass the input intrinsic if they are valid, null otherwise
+                                        (useInputIntrinsics) ? &queryIntrinsics : nullptr,
+                                        matchedRegions,
+                                        matchedIntrinsics,
+                                        param._fDistRatio,
+                                        param._matchingError,
+                                        param._useRobustMatching,
+                                        param._useGuidedMatching,
+                                        imageSize,
+                                        std::make_pair(matchedView->getWidth(), matchedView->getHeight()),
+                                        batchPutativeMatches[b],
+                                        featureMatches,
+                                        param._matchingEstimator);
+      if (!matchWorked)
+      {
+  //      ALICEVISION_LOG_DEBUG("[matching]\tMatching with " << matchedView->getImagePath() << " failed! Skipping image");
+        continue;
+      }
 
-    const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+      ALICEVISION_LOG_DEBUG("[matching]\tFound " << featureMatches.getNbAllMatches() << " geometrically validated matches");
+      assert(featureMatches.getNbAllMatches() > 0);
 
-    // C. recover the 2D-3D associations from the matches 
-    // Each matched feature in the current similar image is associated to a 3D point
-    for(const auto& featureMatchesIt : featureMatches)
-    {
-      feature::EImageDescriberType descType = featureMatchesIt.first;
-      const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
-      for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
+      // if debug is enable save the matches between the query image and the current matching image
+      // It saves the feature matches in a folder with the same name as the query
+      // image, if it does not exist it will create it. The final svg file will have
+      // a name like this: queryImage_matchedImage.svg placed in the following directory:
+      // param._visualDebug/queryImage/
+      if(!param._visualDebug.empty() && !imagePath.empty())
       {
-        // the ID of the 3D point
-        const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
-        const IndexT pt2D_id = featureMatch._i;
-
-        const OccurenceKey key(pt3D_id, descType, pt2D_id);
-        if(out_occurences.count(key))
+        namespace bfs = boost::filesystem;
+        const sfm::View *mview = _sfm_data.GetViews().at(matchedViewId).get();
+        // the current query image without extension
+        const auto queryImage = bfs::path(imagePath).stem();
+        // the matching image without extension
+        const auto matchedImage = bfs::path(mview->getImagePath()).stem();
+        // the full path of the matching image
+        const auto matchedPath = mview->getImagePath();
+
+        // the directory where to save the feature matches
+        const auto baseDir = bfs::path(param._visualDebug) / queryImage;
+        if((!bfs::exists(baseDir)))
         {
-          out_occurences[key]++;
+          ALICEVISION_LOG_DEBUG("created " << baseDir.string());
+          bfs::create_directories(baseDir);
         }
-        else
+        
+        // damn you, boost, what does it take to make the operator "+"?
+        // the final filename for the output svg file as a composition of the query
+        // image and the matched image
+        auto outputName = baseDir / queryImage;
+        outputName += "_";
+        outputName += matchedImage;
+        outputName += ".svg";
+
+        feature::saveMatches2SVG(imagePath,
+                                  imageSize,
+                                  queryRegions,
+                                  matchedPath,
+                                  std::make_pair(mview->getWidth(), mview->getHeight()),
+                                  _regionsPerView.getRegionsPerDesc(matchedViewId),
+                                  featureMatches,
+                                  outputName.string()); 
+      }
+
+      const auto& matchedRegionsMapping = _reconstructedRegionsMappingPerView.at(matchedViewId);
+
+      // C. recover the 2D-3D associations from the matches 
+      // Each matched feature in the current similar image is associated to a 3D point
+      for(const auto& featureMatchesIt : featureMatches)
+      {
+        feature::EImageDescriberType descType = featureMatchesIt.first;
+        const auto& matchedRegionsMappingType = matchedRegionsMapping.at(descType);
+        for(const matching::IndMatch& featureMatch : featureMatchesIt.second)
         {
-          out_occurences[key] = 1;
+          // the ID of the 3D point
+          const IndexT pt3D_id = matchedRegionsMappingType._associated3dPoint[featureMatch._j];
+          const IndexT pt2D_id = featureMatch._i;
+
+          const OccurenceKey key(pt3D_id, descType, pt2D_id);
+          if(out_occurences.count(key))
+          {
+            out_occurences[key]++;
+          }
+          else
+          {
+            out_occurences[key] = 1;
+          }
         }
       }
+      ++goodMatches;
+      if((param._maxResults !=0) && (goodMatches == param._maxResults))
+      { 
+        // let's say we have enough features
+        ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
+        enoughMatches = true;
+        break;
+      }
     }
-    ++goodMatches;
-    if((param._maxResults !=0) && (goodMatches == param._maxResults))
-    { 
-      // let's say we have enough features
-      ALICEVISION_LOG_DEBUG("[matching]\tgot enough point from " << param._maxResults << " images");
-      break;
-    }
+    nextCandidate += batchSize;
+  }
+
+  if(hasUnsupportedIntrinsics && !enoughMatches)
+  {
+    //@fixme maybe better to throw something here
+    ALICEVISION_CERR("Only Pinhole cameras are supported!");
+    return;
   }
   
   if(param._nbFrameBufferMatching > 0)
@@ -970,10 +1076,26 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
                                                  OccurenceMap & out_occurences,
                                                  const std::string& imagePath) const
 {
+  // match the query image with all the past frames in a single search
+  std::vector<const feature::MapRegionsPerDesc*> framesRegions;
+  framesRegions.reserve(_frameBuffer.size());
+  for(const auto& frame : _frameBuffer)
+    framesRegions.push_back(&frame._regions);
+
+  std::vector<matching::MatchesPerDescType> framesPutativeMatches;
+  const std::vector<bool> framesMatchWorked = matchers.MatchBatch(param._fDistRatio, framesRegions, framesPutativeMatches);
+
   std::size_t frameCounter = 0;
+  std::size_t frameIndex = 0;
   // for all the past frames
   for(const auto& frame : _frameBuffer)
   {
+    const std::size_t currentFrameIndex = frameIndex++;
+    if(!framesMatchWorked[currentFrameIndex])
+    {
+      continue;
+    }
+
     // gather the data
     const auto &frameReconstructedRegions = frame._regionsWith3D;
     const auto &frameRegions = frame._regions;
@@ -981,7 +1103,7 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
     const auto frameImageSize = std::make_pair(frameIntrinsics.w(), frameIntrinsics.h());
     matching::MatchesPerDescType featureMatches;
     
-    // match the query image with the current frame
+    // validate the matches of the query image with the current frame
     bool matchWorked = robustMatching(matchers,
                                       // pass the input intrinsic if they are valid, null otherwise
                                       (useInputIntrinsics) ? &queryIntrinsics : nullptr,
@@ -993,6 +1115,7 @@ void VoctreeLocalizer::getAssociationsFromBuffer(matching::RegionsDatabaseMatche
                                       param._useGuidedMatching,
                                       queryImageSize,
                                       frameImageSize, 
+                                      framesPutativeMatches[currentFrameIndex],
                                       featureMatches,
                                       param._matchingEstimator);
     if (!matchWorked)
@@ -1046,6 +1169,45 @@ bool VoctreeLocalizer::robustMatching(matching::RegionsDatabaseMatcherPerDesc &
                                       const std::pair<std::size_t,std::size_t> & imageSizeJ,     // size of the second image
                                       matching::MatchesPerDescType & out_featureMatches,
                                       robustEstimation::ERobustEstimator estimator) const
+{
+  // A. Putative Features Matching
+  matching::MatchesPerDescType putativeFeatureMatches;
+  const bool matchWorked = matchers.Match(fDistRatio, matchedRegions, putativeFeatureMatches);
+  if (!matchWorked)
+  {
+    ALICEVISION_LOG_DEBUG("[matching]\tPutative matching failed.");
+    return false;
+  }
+  assert(!putativeFeatureMatches.empty());
+
+  return robustMatching(matchers,
+                        queryIntrinsicsBase,
+                        matchedRegions,
+                        matchedIntrinsicsBase,
+                        fDistRatio,
+                        matchingError,
+                        useGeometricFiltering,
+                        useGuidedMatching,
+                        imageSizeI,
+                        imageSizeJ,
+                        putativeFeatureMatches,
+                        out_featureMatches,
+                        estimator);
+}
+
+bool VoctreeLocalizer::robustMatching(const matching::RegionsDatabaseMatcherPerDesc & matchers,
+                                      const camera::IntrinsicBase * queryIntrinsicsBase,
+                                      const feature::MapRegionsPerDesc & matchedRegions,
+                                      const camera::IntrinsicBase * matchedIntrinsicsBase,
+                                      float fDistRatio,
+                                      double matchingError,
+                                      bool useGeometricFiltering,
+                                      bool useGuidedMatching,
+                                      const std::pair<std::size_t,std::size_t> & imageSizeI,
+                                      const std::pair<std::size_t,std::size_t> & imageSizeJ,
+                                      matching::MatchesPerDescType & putativeFeatureMatches,
+                                      matching::MatchesPerDescType & out_featureMatches,
+                                      robustEstimation::ERobustEstimator estimator) const
 {
   // get the intrinsics of the query camera
   if ((queryIntrinsicsBase != nullptr) && !isPinhole(queryIntrinsicsBase->getType()))
@@ -1065,18 +1227,6 @@ bool VoctreeLocalizer::robustMatching(matching::RegionsDatabaseMatcherPerDesc &
   }
   const camera::Pinhole *matchedIntrinsics = (const camera::Pinhole*)(matchedIntrinsicsBase);
   
-  const bool canBeUndistorted = (queryIntrinsicsBase != nullptr) && (matchedIntrinsicsBase != nullptr);
-
-  // A. Putative Features Matching
-  matching::MatchesPerDescType putativeFeatureMatches;
-  const bool matchWorked = matchers.Match(fDistRatio, matchedRegions, putativeFeatureMatches);
-  if (!matchWorked)
-  {
-    ALICEVISION_LOG_DEBUG("[matching]\tPutative matching failed.");
-    return false;
-  }
-  assert(!putativeFeatureMatches.empty());
-  
   if(!useGeometricFiltering)
   {
     // nothing else to do
@@ -1148,31 +1298,55 @@ bool VoctreeLocalizer::localizeRig(const std::vector<image::Image<unsigned char>
 
   std::vector<feature::MapRegionsPerDesc> vec_queryRegions(numCams);
   std::vector<std::pair<std::size_t, std::size_t> > vec_imageSize;
-  
-  //@todo parallelize?
+  std::vector<double> vec_describeTimeMs(numCams, 0.0);
+
   for(size_t i = 0; i < numCams; ++i)
   {
     // add the image size for this image
     vec_imageSize.emplace_back(vec_imageGrey[i].Width(), vec_imageGrey[i].Height());
+  }
+  assert(vec_imageSize.size() == vec_queryRegions.size());
+
+  // each camera of the rig needs its own feature extractors to be described in parallel,
+  // the first camera uses the ones of the localizer
+  while(_rigImageDescribers.size() + 1 < numCams)
+  {
+    _rigImageDescribers.emplace_back();
+    for(const auto& imageDescriber : _imageDescribers)
+      _rigImageDescribers.back().push_back(feature::createImageDescriber(imageDescriber->getDescriberType()));
+  }
+
+  #pragma omp parallel for schedule(dynamic)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
+  {
+    auto& imageDescribers = (i == 0) ? _imageDescribers : _rigImageDescribers[i - 1];
+    system::Timer timer;
 
     // extract descriptors and features from each image
-    for(auto& imageDescriber: _imageDescribers)
+    for(auto& imageDescriber: imageDescribers)
     {
-      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image...");
+      ALICEVISION_LOG_DEBUG("[features]\tExtract " << feature::EImageDescriberType_enumToString(imageDescriber->getDescriberType()) << " from query image " << i << "...");
+      imageDescriber->setCudaPipe(_cudaPipe);
+      imageDescriber->setConfigurationPreset(parameters->_featurePreset);
       imageDescriber->describe(vec_imageGrey[i], vec_queryRegions[i][imageDescriber->getDescriberType()]);
-      ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features");
+      ALICEVISION_LOG_DEBUG("[features]\tExtract done: found " <<  vec_queryRegions[i][imageDescriber->getDescriberType()]->RegionCount() << " features in query image " << i);
     }
-    ALICEVISION_LOG_DEBUG("[features]\tAll descriptors extracted. Found " <<  vec_queryRegions[i].getNbAllRegions() << " features");
+    vec_describeTimeMs[i] = timer.elapsedMs();
+    ALICEVISION_LOG_DEBUG("[features]\tAll descriptors extracted. Found " <<  vec_queryRegions[i].getNbAllRegions() << " features in query image " << i << " in " << vec_describeTimeMs[i] << " [ms]");
   }
-  assert(vec_imageSize.size() == vec_queryRegions.size());
           
-  return localizeRig(vec_queryRegions,
-                     vec_imageSize,
-                     parameters,
-                     vec_queryIntrinsics,
-                     vec_subPoses,
-                     rigPose,
-                     vec_locResults);
+  const bool isLocalized = localizeRig(vec_queryRegions,
+                                       vec_imageSize,
+                                       parameters,
+                                       vec_queryIntrinsics,
+                                       vec_subPoses,
+                                       rigPose,
+                                       vec_locResults);
+
+  for(std::size_t i = 0; i < vec_locResults.size() && i < numCams; ++i)
+    vec_locResults[i].setDescribeTimeMs(vec_describeTimeMs[i]);
+
+  return isLocalized;
 }
 
 
@@ -1242,11 +1416,21 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
   std::vector<Mat> vec_pts3D(numCams);
   std::vector<Mat> vec_pts2D(numCams);
 
+  std::vector<double> vec_matchingTimeMs(numCams, 0.0);
+
+  // set the time spent to retrieve the associations of each camera in the results
+  const auto setMatchingTimes = [&]()
+  {
+    for(std::size_t camID = 0; camID < vec_locResults.size() && camID < numCams; ++camID)
+      vec_locResults[camID].setMatchingTimeMs(vec_matchingTimeMs[camID]);
+  };
+
   // for each camera retrieve the associations
-  //@todo parallelize?
-  size_t numAssociations = 0;
-  for(std::size_t camID = 0; camID < numCams; ++camID)
+  // (the cameras are independent until the rig resection)
+  #pragma omp parallel for schedule(dynamic)
+  for(int camID = 0; camID < static_cast<int>(numCams); ++camID)
   {
+    system::Timer timer;
 
     // this map is used to collect the 2d-3d associations as we go through the images
     // the key is a pair <Id3D, Id2d>
@@ -1269,8 +1453,13 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
                        pts3D,
                        descTypes,
                        matchedImages);
-    numAssociations += occurrences.size();
+    vec_matchingTimeMs[camID] = timer.elapsedMs();
+    ALICEVISION_LOG_DEBUG("[matching]\tCamera " << camID << ": " << occurrences.size() << " associations found in " << vec_matchingTimeMs[camID] << " [ms]");
   }
+
+  size_t numAssociations = 0;
+  for(const auto& occurrences : vec_occurrences)
+    numAssociations += occurrences.size();
   
   // @todo Here it could be possible to filter the associations according to their
   // occurrences, eg giving priority to those associations that are more frequent
@@ -1284,6 +1473,7 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
       // empty result with isValid set to false
       vec_locResults.emplace_back();
     }
+    setMatchingTimes();
     return false;
   }
   
@@ -1312,6 +1502,7 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
       // empty result with isValid set to false
       vec_locResults.emplace_back();
     }
+    setMatchingTimes();
     ALICEVISION_LOG_DEBUG("Resection failed.");
     return false;
   }
@@ -1424,6 +1615,7 @@ bool VoctreeLocalizer::localizeRig_opengv(const std::vector<feature::MapRegionsP
     
     vec_locResults.emplace_back(matchData, indMatch3D2D, pose, intrinsics, matchedImages, refineOk);
   }
+  setMatchingTimes();
   
   
   if(!refineOk)
@@ -1490,13 +1682,25 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
 
   vec_localizationResults.resize(numCams);
     
+  const VoctreeLocalizer::Parameters *param = static_cast<const VoctreeLocalizer::Parameters *>(parameters);
+  if(!param)
+  {
+    // error!
+    throw std::invalid_argument("The parameters are not in the right format!!");
+  }
+
   // this is basic, just localize each camera alone
-  //@todo parallelize?
-  std::vector<bool> isLocalized(numCams, false);
-  for(size_t i = 0; i < numCams; ++i)
+  // the cameras can be localized in parallel unless they are matched with the frame
+  // buffer, which is filled with the result of each camera in turn
+  const bool parallelCameras = (param->_nbFrameBufferMatching == 0);
+  std::vector<char> isLocalized(numCams, false);
+  #pragma omp parallel for schedule(dynamic) if(parallelCameras)
+  for(int i = 0; i < static_cast<int>(numCams); ++i)
   {
+    system::Timer timer;
     isLocalized[i] = localize(vec_queryRegions[i], vec_imageSize[i], parameters, true /*useInputIntrinsics*/, vec_queryIntrinsics[i], vec_localizationResults[i]);
-    assert(isLocalized[i] == vec_localizationResults[i].isValid());
+    vec_localizationResults[i].setMatchingTimeMs(timer.elapsedMs());
+    assert(bool(isLocalized[i]) == vec_localizationResults[i].isValid());
     if(!isLocalized[i])
     {
       ALICEVISION_CERR("Could not localize camera " << i);
@@ -1505,7 +1709,7 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   }
   
   // ** 'easy' cases in which we don't need further processing **
-  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), true);
+  const std::size_t numLocalizedCam = std::count(isLocalized.begin(), isLocalized.end(), char(true));
   
   // no camera has be localized
   if(numLocalizedCam == 0)
@@ -1528,7 +1732,7 @@ bool VoctreeLocalizer::localizeRig_naive(const std::vector<feature::MapRegionsPe
   { 
     // find the index of the first localized camera
     const std::size_t idx = std::distance(isLocalized.begin(), 
-                                          std::find(isLocalized.begin(), isLocalized.end(), true));
+                                          std::find(isLocalized.begin(), isLocalized.end(), char(true)));
     
     // useless safeguard as there should be at least 1 element at this point but
     // better safe than sorry
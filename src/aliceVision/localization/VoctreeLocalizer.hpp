@@ -150,6 +150,43 @@ public:
                 camera::PinholeRadialK3 &queryIntrinsics,
                 LocalizationResult & localizationResult,
                 const std::string& imagePath = std::string()) override;
+
+  /**
+   * @brief Same as localize() from the features of the query image, but the similar
+   * images can be given, already retrieved with retrieveSimilarImages(). It allows
+   * to run the database retrieval in a different stage than the matching and
+   * the resection (e.g. in a frame pipeline) with the same result.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] retrievedImages The similar images retrieved from the database,
+   * if nullptr they are retrieved from the database.
+   * @see localize()
+   */
+  bool localize(const feature::MapRegionsPerDesc & queryRegions,
+                const std::vector<voctree::DocMatch>* retrievedImages,
+                const std::pair<std::size_t, std::size_t> &imageSize,
+                const LocalizerParameters *param,
+                bool useInputIntrinsics,
+                camera::PinholeRadialK3 &queryIntrinsics,
+                LocalizationResult & localizationResult,
+                const std::string& imagePath = std::string());
+
+  /**
+   * @brief Query the vocabulary tree database to retrieve the images the most
+   * similar to the query image.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] param The parameters for the localization
+   * The number of images is the number of results of the parameters; with the AllResults
+   * algorithm, all the database images are retrieved if no number of results is given
+   * (the associations of all the results, as for the rig, always use this rule).
+   *
+   * @param[out] out_matchedImages The similar images sorted by decreasing score
+   * @return false if the query image has no feature of the vocabulary tree describer type
+   */
+  bool retrieveSimilarImages(const feature::MapRegionsPerDesc & queryRegions,
+                             const Parameters &param,
+                             std::vector<voctree::DocMatch>& out_matchedImages) const;
   
   
   bool localizeRig(const std::vector<image::Image<unsigned char> > & vec_imageGrey,
@@ -201,6 +238,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in] retrievedImages Optional similar images already retrieved from the database
    * @return true if the localization is successful
    */
   bool localizeFirstBestResult(const feature::MapRegionsPerDesc &queryRegions,
@@ -209,7 +247,8 @@ public:
                                bool useInputIntrinsics,
                                camera::PinholeRadialK3 &queryIntrinsics,
                                LocalizationResult &localizationResult,
-                               const std::string &imagePath = std::string());
+                               const std::string &imagePath = std::string(),
+                               const std::vector<voctree::DocMatch>* retrievedImages = nullptr);
 
   /**
    * @brief Try to localize an image in the database: it queries the database to 
@@ -226,6 +265,7 @@ public:
    * @param[out] pose The camera pose
    * @param[out] resection_data the 2D-3D correspondences used to compute the pose
    * @param[out] associationIDs the ids of the 2D-3D correspondences used to compute the pose
+   * @param[in] retrievedImages Optional similar images already retrieved from the database
    * @return true if the localization is successful
    */
   bool localizeAllResults(const feature::MapRegionsPerDesc & queryRegions,
@@ -234,7 +274,8 @@ public:
                           bool useInputIntrinsics,
                           camera::PinholeRadialK3 &queryIntrinsics,
                           LocalizationResult &localizationResult,
-                          const std::string& imagePath = std::string());
+                          const std::string& imagePath = std::string(),
+                          const std::vector<voctree::DocMatch>* retrievedImages = nullptr);
   
   
   /**
@@ -251,6 +292,7 @@ public:
    * @param[out] out_descTypes output vector of describerType
    * @param[out] out_matchedImages image matches output
    * @param[in] imagePath
+   * @param[in] retrievedImages Optional similar images already retrieved from the database
    */
   void getAllAssociations(const feature::MapRegionsPerDesc & queryRegions,
                           const std::pair<std::size_t, std::size_t> &imageSize,
@@ -262,9 +304,23 @@ public:
                           Mat &out_pt3D,
                           std::vector<feature::EImageDescriberType>& out_descTypes,
                           std::vector<voctree::DocMatch>& out_matchedImages,
-                          const std::string& imagePath = std::string()) const;
+                          const std::string& imagePath = std::string(),
+                          const std::vector<voctree::DocMatch>* retrievedImages = nullptr) const;
 
 private:
+  /**
+   * @brief Query the vocabulary tree database to retrieve the images the most
+   * similar to the query image.
+   *
+   * @param[in] queryRegions The input features of the query image
+   * @param[in] numResults The number of retrieved images
+   * @param[out] out_matchedImages The similar images sorted by decreasing score
+   * @return false if the query image has no feature of the vocabulary tree describer type
+   */
+  bool retrieveSimilarImages(const feature::MapRegionsPerDesc & queryRegions,
+                             std::size_t numResults,
+                             std::vector<voctree::DocMatch>& out_matchedImages) const;
+
   /**
    * @brief Load the vocabulary tree.
 
@@ -310,6 +366,40 @@ private:
                       const std::pair<size_t,size_t> & imageSizeJ,     // size of the query image
                       matching::MatchesPerDescType & out_featureMatches,
                       robustEstimation::ERobustEstimator estimator = robustEstimation::ERobustEstimator::ACRANSAC) const;
+
+  /**
+   * @brief Geometric validation of the putative matches, second step of robustMatching().
+   * It allows to compute the putative matches of several images at once
+   * (see matching::RegionsDatabaseMatcherPerDesc::MatchBatch).
+   *
+   * @param[in] matchers
+   * @param[in] queryIntrinsics
+   * @param[in] regionsToMatch
+   * @param[in] matchedIntrinsics
+   * @param[in] fDistRatio
+   * @param[in] matchingError
+   * @param[in] useGeometricFiltering
+   * @param[in] useGuidedMatching
+   * @param[in] imageSizeI
+   * @param[in] imageSizeJ
+   * @param[in,out] putativeFeatureMatches The putative matches (not empty), they may be swapped with the output
+   * @param[out] out_featureMatches
+   * @param[in] estimator
+   * @return
+   */
+  bool robustMatching(const matching::RegionsDatabaseMatcherPerDesc & matchers,
+                      const camera::IntrinsicBase * queryIntrinsics,
+                      const feature::MapRegionsPerDesc & regionsToMatch,
+                      const camera::IntrinsicBase * matchedIntrinsics,
+                      float fDistRatio,
+                      double matchingError,
+                      bool useGeometricFiltering,
+                      bool useGuidedMatching,
+                      const std::pair<size_t,size_t> & imageSizeI,
+                      const std::pair<size_t,size_t> & imageSizeJ,
+                      matching::MatchesPerDescType & putativeFeatureMatches,
+                      matching::MatchesPerDescType & out_featureMatches,
+                      robustEstimation::ERobustEstimator estimator) const;
   
   void getAssociationsFromBuffer(matching::RegionsDatabaseMatcherPerDesc& matchers,
                                  const std::pair<std::size_t, std::size_t> & imageSize,
@@ -337,6 +427,10 @@ public:
   
   /// the feature extractor
   std::vector<std::unique_ptr<feature::ImageDescriber>> _imageDescribers;
+
+  /// the feature extractors of the other cameras of a rig (the first camera uses
+  /// _imageDescribers), to describe the images of the rig in parallel
+  std::vector<std::vector<std::unique_ptr<feature::ImageDescriber>>> _rigImageDescribers;
   
   // CUDA CCTag supports several parallel pipelines, where each one can
   // processing different image dimensions.
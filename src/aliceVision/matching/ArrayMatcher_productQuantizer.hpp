@@ -0,0 +1,221 @@
+// This file is part of the AliceVision project.
+// Copyright (c) 2016 AliceVision contributors.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include "aliceVision/matching/ArrayMatcher.hpp"
+#include "aliceVision/matching/metric.hpp"
+#include "aliceVision/feature/ProductQuantizer.hpp"
+#include "aliceVision/feature/CompressedRegions.hpp"
+#include "aliceVision/stl/indexedSort.hpp"
+#include <aliceVision/config.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace aliceVision {
+namespace matching {
+
+/**
+ * @brief Brute force matcher on a database of compressed descriptors (product quantization).
+ *
+ * The database only stores the codes of the descriptors (getCodeSize() bytes per descriptor),
+ * the queries are not compressed and are matched with the asymmetric distance of the quantizer.
+ * The distances are squared L2 distances.
+ */
+template < typename Scalar = float >
+class ArrayMatcher_productQuantizer : public ArrayMatcher<Scalar, L2_Simple<float> >
+{
+  public:
+  typedef float DistanceType;
+
+  /**
+   * \param[in] quantizer The trained product quantizer (shared with the other databases)
+   */
+  explicit ArrayMatcher_productQuantizer(const std::shared_ptr<const feature::ProductQuantizer>& quantizer)
+    : _quantizer(quantizer)
+  {}
+
+  virtual ~ArrayMatcher_productQuantizer() {}
+
+  /**
+   * Build the matching structure: compress the dataset.
+   *
+   * \param[in] dataset   Input data.
+   * \param[in] nbRows    The number of component.
+   * \param[in] dimension Length of the data contained in the dataset.
+   *
+   * \return True if success.
+   */
+  bool Build(const Scalar * dataset, int nbRows, int dimension)
+  {
+    _nbRows = 0;
+    _codes.clear();
+    if (nbRows < 1 || dimension != _quantizer->getDimension())
+      return false;
+
+    const int codeSize = _quantizer->getCodeSize();
+    _codes.resize(static_cast<std::size_t>(nbRows) * codeSize);
+
+    #pragma omp parallel for
+    for (int i = 0; i < nbRows; ++i)
+      _quantizer->encode(dataset + static_cast<std::size_t>(i) * dimension, &_codes[static_cast<std::size_t>(i) * codeSize]);
+
+    _nbRows = nbRows;
+    return true;
+  }
+
+  /**
+   * Build the matching structure from already compressed descriptors.
+   *
+   * \param[in] codes     The compressed descriptors (nbRows x getCodeSize()).
+   * \param[in] nbRows    The number of compressed descriptors.
+   *
+   * \return True if success.
+   */
+  bool BuildFromCodes(const unsigned char * codes, int nbRows)
+  {
+    _nbRows = 0;
+    _codes.clear();
+    if (nbRows < 1)
+      return false;
+
+    _codes.assign(codes, codes + static_cast<std::size_t>(nbRows) * _quantizer->getCodeSize());
+    _nbRows = nbRows;
+    return true;
+  }
+
+  /**
+   * Search the nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[out]  indice    The indice of array in the dataset that
+   *  have been computed as the nearest array.
+   * \param[out]  distance  The distance between the two arrays.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbour( const Scalar * query,
+                        int * indice, DistanceType * distance)
+  {
+    IndMatches vec_indices;
+    std::vector<DistanceType> vec_distances;
+    if (!SearchNeighbours(query, 1, &vec_indices, &vec_distances, 1))
+      return false;
+
+    *indice = vec_indices.front()._j;
+    *distance = vec_distances.front();
+    return true;
+  }
+
+  /**
+   * Search the N nearest Neighbor of the scalar array query.
+   *
+   * \param[in]   query     The query array
+   * \param[in]   nbQuery   The number of query rows
+   * \param[out]  indices   The corresponding (query, neighbor) indices
+   * \param[out]  distances The distances between the matched arrays.
+   * \param[out]  NN        The number of maximal neighbor that will be searched.
+   *
+   * \return True if success.
+   */
+  bool SearchNeighbours
+  (
+    const Scalar * query, int nbQuery,
+    IndMatches * pvec_indices,
+    std::vector<DistanceType> * pvec_distances,
+    size_t NN
+  )
+  {
+    if (_nbRows == 0 || NN > _nbRows || nbQuery < 1)
+      return false;
+
+    const int dimension = _quantizer->getDimension();
+    const int codeSize = _quantizer->getCodeSize();
+
+    pvec_distances->resize(nbQuery * NN);
+    pvec_indices->resize(nbQuery * NN);
+
+    #pragma omp parallel
+    {
+      std::vector<float> distanceTable(_quantizer->getDistanceTableSize());
+      std::vector<DistanceType> vec_distance(_nbRows);
+
+      #pragma omp for schedule(dynamic)
+      for (int queryIndex = 0; queryIndex < nbQuery; ++queryIndex)
+      {
+        // the query is not compressed: distances to all the centroids
+        _quantizer->computeDistanceTable(query + static_cast<std::size_t>(queryIndex) * dimension, distanceTable.data());
+
+        const unsigned char * codePtr = _codes.data();
+        for (std::size_t i = 0; i < _nbRows; ++i)
+        {
+          vec_distance[i] = _quantizer->asymmetricDistance(distanceTable.data(), codePtr);
+          codePtr += codeSize;
+        }
+
+        // Find the N minimum distances:
+        const int maxMinFound = (int) std::min( size_t(NN), vec_distance.size());
+        using namespace stl::indexed_sort;
+        std::vector< sort_index_packet_ascend< DistanceType, int> > packet_vec(vec_distance.size());
+        sort_index_helper(packet_vec, &vec_distance[0], maxMinFound);
+
+        for (int i = 0; i < maxMinFound; ++i)
+        {
+          (*pvec_distances)[queryIndex*NN+i] = packet_vec[i].val;
+          (*pvec_indices)[queryIndex*NN+i] = IndMatch(queryIndex, packet_vec[i].index);
+        }
+      }
+    }
+    return true;
+  }
+
+  /// The compressed database (nbRows x getCodeSize())
+  const std::vector<unsigned char>& getCodes() const { return _codes; }
+
+  const std::shared_ptr<const feature::ProductQuantizer>& getQuantizer() const { return _quantizer; }
+
+private:
+  std::shared_ptr<const feature::ProductQuantizer> _quantizer;
+  std::vector<unsigned char> _codes;
+  std::size_t _nbRows = 0;
+};
+
+/**
+ * @brief Build the matcher from the codes of compressed Regions, see RegionsMatcher.
+ * @return False if the Regions are not compressed with the codebooks of the matcher.
+ */
+template < typename Scalar >
+bool buildArrayMatcher(ArrayMatcher_productQuantizer<Scalar> & matcher, const feature::Regions& regions)
+{
+  const feature::CompressedRegions * compressedRegions = dynamic_cast<const feature::CompressedRegions *>(&regions);
+  if (compressedRegions == nullptr || !(*compressedRegions->getQuantizer() == *matcher.getQuantizer()))
+    return false;
+  return matcher.BuildFromCodes(compressedRegions->Codes().data(), compressedRegions->RegionCount());
+}
+
+/**
+ * @brief Get the query descriptors of compressed Regions: the decompressed descriptors, see RegionsMatcher.
+ * The uncompressed descriptors of scalar Regions are not handled, the pipeline only stores the codes.
+ * @return nullptr if the Regions are not compressed with the codebooks of the matcher.
+ */
+template < typename Scalar >
+const Scalar * getQueryDescriptors(const ArrayMatcher_productQuantizer<Scalar> & matcher,
+                                   const feature::Regions& regions,
+                                   std::vector<Scalar>& buffer)
+{
+  const feature::CompressedRegions * compressedRegions = dynamic_cast<const feature::CompressedRegions *>(&regions);
+  if (compressedRegions == nullptr || !(*compressedRegions->getQuantizer() == *matcher.getQuantizer()))
+    return nullptr;
+
+  std::vector<float> descriptors;
+  compressedRegions->decodeDescriptors(descriptors);
+  buffer.assign(descriptors.begin(), descriptors.end());
+  return buffer.data();
+}
+
+}  // namespace matching
+}  // namespace aliceVision
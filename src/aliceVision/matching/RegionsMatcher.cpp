@@ -10,6 +10,8 @@
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/ArrayMatcher_productQuantizer.hpp"
+#include "aliceVision/feature/CompressedRegions.hpp"
 
 namespace aliceVision {
 namespace matching {
@@ -39,6 +41,20 @@ bool RegionsDatabaseMatcher::Match(
   return _regionsMatcher->Match(distRatio, queryRegions, matches);
 }
 
+bool RegionsDatabaseMatcher::MatchBatch(
+  float distRatio,
+  const std::vector<const feature::Regions*> & queryRegions,
+  std::vector<matching::IndMatches> & matches) const
+{
+  matches.clear();
+  matches.resize(queryRegions.size());
+
+  if (!_regionsMatcher)
+    return false;
+
+  return _regionsMatcher->MatchBatch(distRatio, queryRegions, matches);
+}
+
 RegionsDatabaseMatcher::RegionsDatabaseMatcher():
   _matcherType(BRUTE_FORCE_L2),
   _regionsMatcher(nullptr)
@@ -58,6 +74,25 @@ std::unique_ptr<IRegionsMatcher> createRegionsMatcher(const feature::Regions & r
 {
   std::unique_ptr<IRegionsMatcher> out;
 
+  // Compressed regions: asymmetric distance on the codes
+  const feature::CompressedRegions* compressedRegions = dynamic_cast<const feature::CompressedRegions*>(&regions);
+  if (compressedRegions != nullptr || matcherType == BRUTE_FORCE_PQ_L2)
+  {
+    if (compressedRegions == nullptr)
+    {
+      ALICEVISION_LOG_WARNING("BRUTE_FORCE_PQ_L2 matcher needs compressed descriptors (.pqdesc).");
+      return out;
+    }
+    if (matcherType != BRUTE_FORCE_PQ_L2)
+    {
+      ALICEVISION_LOG_WARNING("Compressed descriptors (.pqdesc) can only be matched with the BRUTE_FORCE_PQ_L2 matcher.");
+      return out;
+    }
+    typedef ArrayMatcher_productQuantizer<float> MatcherT;
+    out.reset(new matching::RegionsMatcher<MatcherT>(regions, MatcherT(compressedRegions->getQuantizer()), true));
+    return out;
+  }
+
   // Handle invalid request
   if (regions.IsScalar() && matcherType == BRUTE_FORCE_HAMMING)
     return out;
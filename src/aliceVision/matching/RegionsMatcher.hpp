@@ -79,12 +79,61 @@ public:
     matching::IndMatches & vec_putative_matches
   ) = 0;
 
+  /**
+   * @brief Match several Regions to the internal database in a single search.
+   * The descriptors of all the query Regions are concatenated in one contiguous
+   * array, the result is the same as calling Match() for each of them.
+   *
+   * @param[in] f_dist_ratio The threshold for the ratio test.
+   * @param[in] query_regions The Regions to match.
+   * @param[out] vec_putative_matches For each query Regions, the indices of the matching
+   * features of the database and the query Regions.
+   * @return True if at least one of the query Regions has matches.
+   */
+  virtual bool MatchBatch(
+    const float f_dist_ratio,
+    const std::vector<const feature::Regions*>& query_regions,
+    std::vector<matching::IndMatches> & vec_putative_matches
+  ) = 0;
+
   const feature::Regions& getDatabaseRegions() const { return regions_; }
 };
 
 inline IRegionsMatcher::~IRegionsMatcher()
 {}
 
+/**
+ * @brief Build an ArrayMatcher on the descriptors of a Regions (database).
+ * Overloaded for the ArrayMatchers that are not built from the raw descriptors.
+ *
+ * @param[in,out] matcher The ArrayMatcher to build.
+ * @param[in] regions The database Regions.
+ * @return True if success.
+ */
+template < class ArrayMatcherT >
+bool buildArrayMatcher(ArrayMatcherT & matcher, const feature::Regions& regions)
+{
+  const typename ArrayMatcherT::ScalarT * tab = reinterpret_cast<const typename ArrayMatcherT::ScalarT *>(regions.DescriptorRawData());
+  return matcher.Build(tab, regions.RegionCount(), regions.DescriptorLength());
+}
+
+/**
+ * @brief Get the query descriptors of a Regions for an ArrayMatcher.
+ * Overloaded for the ArrayMatchers that do not match the raw descriptors.
+ *
+ * @param[in] matcher The ArrayMatcher.
+ * @param[in] regions The query Regions.
+ * @param[out] buffer Storage of the converted descriptors, if any.
+ * @return The query descriptors (RegionCount() x DescriptorLength()), nullptr if the Regions can't be matched.
+ */
+template < class ArrayMatcherT >
+const typename ArrayMatcherT::ScalarT * getQueryDescriptors(const ArrayMatcherT & matcher,
+                                                            const feature::Regions& regions,
+                                                            std::vector<typename ArrayMatcherT::ScalarT>& buffer)
+{
+  return reinterpret_cast<const typename ArrayMatcherT::ScalarT *>(regions.DescriptorRawData());
+}
+
 /**
  * Match two Regions with one stored as a "database" according a Template ArrayMatcher.
  */
@@ -116,8 +165,25 @@ public:
     if (regions_.RegionCount() == 0)
       return;
 
-    const Scalar * tab = reinterpret_cast<const Scalar *>(regions_.DescriptorRawData());
-    matcher_.Build(tab, regions_.RegionCount(), regions_.DescriptorLength());
+    buildArrayMatcher(matcher_, regions_);
+  }
+
+  /**
+   * @brief Initialize the matcher with a Regions that will be used as database
+   * and a configured ArrayMatcher (for the ArrayMatchers without default constructor).
+   *
+   * @param regions The Regions to be used as database.
+   * @param matcher The ArrayMatcher, not built yet.
+   * @param b_squared_metric Whether to use a squared metric for the ratio test
+   * when matching two Regions.
+   */
+  RegionsMatcher(const feature::Regions& regions, const ArrayMatcherT& matcher, bool b_squared_metric = false)
+    : IRegionsMatcher(regions), matcher_(matcher), b_squared_metric_(b_squared_metric)
+  {
+    if (regions_.RegionCount() == 0)
+      return;
+
+    buildArrayMatcher(matcher_, regions_);
   }
 
   /**
@@ -135,7 +201,10 @@ public:
              matching::IndMatches & vec_putative_matches)
   {
 
-    const Scalar * queries = reinterpret_cast<const Scalar *>(queryregions_.DescriptorRawData());
+    std::vector<Scalar> queriesBuffer;
+    const Scalar * queries = getQueryDescriptors(matcher_, queryregions_, queriesBuffer);
+    if (queries == nullptr)
+      return false;
 
     const size_t NNN__ = 2;
     matching::IndMatches vec_nIndice;
@@ -179,6 +248,100 @@ public:
     return (!vec_putative_matches.empty());
   }
 
+  /**
+   * @brief Match several Regions to the internal database in a single search.
+   * The descriptors of all the query Regions are concatenated in one contiguous
+   * array, the result is the same as calling Match() for each of them.
+   *
+   * @param[in] f_dist_ratio The threshold for the ratio test.
+   * @param[in] query_regions The Regions to match.
+   * @param[out] vec_putative_matches For each query Regions, the indices of the matching
+   * features of the database and the query Regions.
+   * @return True if at least one of the query Regions has matches.
+   */
+  bool MatchBatch(const float f_dist_ratio,
+                  const std::vector<const feature::Regions*>& query_regions,
+                  std::vector<matching::IndMatches> & vec_putative_matches)
+  {
+    vec_putative_matches.clear();
+    vec_putative_matches.resize(query_regions.size());
+
+    // offset of each query Regions in the concatenated array
+    std::vector<std::size_t> vec_offsets(query_regions.size() + 1, 0);
+    for(std::size_t b = 0; b < query_regions.size(); ++b)
+      vec_offsets[b + 1] = vec_offsets[b] + query_regions[b]->RegionCount();
+
+    const std::size_t nbQueries = vec_offsets.back();
+    if(nbQueries == 0)
+      return false;
+
+    const std::size_t descLength = regions_.DescriptorLength();
+    std::vector<Scalar> queries(nbQueries * descLength);
+    std::vector<Scalar> queriesBuffer;
+    for(std::size_t b = 0; b < query_regions.size(); ++b)
+    {
+      assert(query_regions[b]->DescriptorLength() == descLength);
+      const std::size_t count = query_regions[b]->RegionCount();
+      if(count == 0)
+        continue;
+      const Scalar * tab = getQueryDescriptors(matcher_, *query_regions[b], queriesBuffer);
+      if(tab == nullptr)
+        return false;
+      std::copy(tab, tab + count * descLength, queries.begin() + vec_offsets[b] * descLength);
+    }
+
+    const size_t NNN__ = 2;
+    matching::IndMatches vec_nIndice;
+    std::vector<DistanceType> vec_fDistance;
+
+    // Search the 2 closest features neighbours for all the query descriptors at once
+    if (!matcher_.SearchNeighbours(queries.data(), nbQueries, &vec_nIndice, &vec_fDistance, NNN__))
+      return false;
+
+    std::vector<int> vec_nn_ratio_idx;
+    matching::NNdistanceRatio(
+      vec_fDistance.begin(), // distance start
+      vec_fDistance.end(),   // distance end
+      NNN__, // Number of neighbor in iterator sequence (minimum required 2)
+      vec_nn_ratio_idx, // output (indices that respect the distance Ratio)
+      b_squared_metric_ ? Square(f_dist_ratio) : f_dist_ratio);
+
+    // dispatch the matches to their query Regions
+    // (the results are ordered by query descriptor)
+    std::size_t batchIndex = 0;
+    for (size_t k=0; k < vec_nn_ratio_idx.size(); ++k)
+    {
+      const size_t index = vec_nn_ratio_idx[k];
+      const IndexT queryIndex = vec_nIndice[index*NNN__]._i;
+      while(queryIndex >= vec_offsets[batchIndex + 1])
+        ++batchIndex;
+      vec_putative_matches[batchIndex].emplace_back(vec_nIndice[index*NNN__]._j, queryIndex - vec_offsets[batchIndex]
+  #ifdef ALICEVISION_DEBUG_MATCHING
+          , (float) vec_fDistance[vec_nn_ratio_idx[0]]
+  #endif
+      );
+    }
+
+    bool hasMatches = false;
+    for(std::size_t b = 0; b < query_regions.size(); ++b)
+    {
+      matching::IndMatches& putativeMatches = vec_putative_matches[b];
+      if(putativeMatches.empty())
+        continue;
+
+      // Remove duplicates
+      matching::IndMatch::getDeduplicated(putativeMatches);
+
+      // Remove matches that have the same (X,Y) coordinates
+      matching::IndMatchDecorator<float> matchDeduplicator(putativeMatches,
+        regions_.GetRegionsPositions(), query_regions[b]->GetRegionsPositions());
+      matchDeduplicator.getDeduplicated(putativeMatches);
+
+      hasMatches |= !putativeMatches.empty();
+    }
+    return hasMatches;
+  }
+
 };
 
 
@@ -220,6 +383,21 @@ class RegionsDatabaseMatcher
       const feature::Regions & queryRegions,
       matching::IndMatches & matches) const;
 
+    /**
+     * @brief Find corresponding points between several query Regions and the database one
+     * in a single search.
+     *
+     * @param[in] distRatio The threshold for the ratio test used to discard spurious correspondence.
+     * @param[in] queryRegions The Regions to match.
+     * @param[out] matches For each query Regions, the indices of the matching features
+     *                     of the database and the query Regions.
+     * @return True if at least one of the query Regions has matches.
+     */
+    bool MatchBatch(
+      float distRatio,
+      const std::vector<const feature::Regions*> & queryRegions,
+      std::vector<matching::IndMatches> & matches) const;
+
     const feature::Regions& getDatabaseRegions() const { return _regionsMatcher->getDatabaseRegions(); }
 
   private:
@@ -260,6 +438,46 @@ public:
     return res;
   }
 
+  /**
+   * @brief Match several images to the database in a single search per describer type.
+   *
+   * @param[in] distRatio The threshold for the ratio test.
+   * @param[in] matchedRegions The regions of each image to match.
+   * @param[out] out_putativeFeatureMatches For each image, the putative matches per describer type
+   * (same as calling Match() for each image).
+   * @return For each image, true if putative matches have been found.
+   */
+  std::vector<bool> MatchBatch(
+    float distRatio,
+    const std::vector<const feature::MapRegionsPerDesc*> & matchedRegions,
+    std::vector<matching::MatchesPerDescType> & out_putativeFeatureMatches)
+  {
+    std::vector<bool> res(matchedRegions.size(), false);
+    out_putativeFeatureMatches.clear();
+    out_putativeFeatureMatches.resize(matchedRegions.size());
+
+    for(auto& matcherIt: _mapMatchers)
+    {
+      const feature::EImageDescriberType descType = matcherIt.first;
+
+      std::vector<const feature::Regions*> regionsPerImage;
+      regionsPerImage.reserve(matchedRegions.size());
+      for(const feature::MapRegionsPerDesc* regions : matchedRegions)
+        regionsPerImage.push_back(regions->at(descType).get());
+
+      std::vector<matching::IndMatches> matchesPerImage;
+      matcherIt.second.MatchBatch(distRatio, regionsPerImage, matchesPerImage);
+      matchesPerImage.resize(matchedRegions.size());
+
+      for(std::size_t i = 0; i < matchedRegions.size(); ++i)
+      {
+        res[i] = res[i] || !matchesPerImage[i].empty();
+        out_putativeFeatureMatches[i][descType].swap(matchesPerImage[i]);
+      }
+    }
+    return res;
+  }
+
   const feature::MapRegionsPerDesc & getDatabaseRegionsPerDesc() const { return _databaseRegions; }
 
   const feature::Regions & getDatabaseRegions(feature::EImageDescriberType descType) const { return _mapMatchers.at(descType).getDatabaseRegions(); }
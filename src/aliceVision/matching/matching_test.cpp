@@ -9,7 +9,13 @@
 #include "aliceVision/matching/ArrayMatcher_bruteForce.hpp"
 #include "aliceVision/matching/ArrayMatcher_kdtreeFlann.hpp"
 #include "aliceVision/matching/ArrayMatcher_cascadeHashing.hpp"
+#include "aliceVision/matching/ArrayMatcher_productQuantizer.hpp"
+#include "aliceVision/matching/RegionsMatcher.hpp"
+#include "aliceVision/feature/regionsFactory.hpp"
+#include "aliceVision/feature/CompressedRegions.hpp"
+#include <cstdio>
 #include <iostream>
+#include <random>
 
 #define BOOST_TEST_MODULE matching
 #include <boost/test/included/unit_test.hpp>
@@ -148,3 +154,193 @@ BOOST_AUTO_TEST_CASE(Matching_Cascade_Hashing_Simple_EmptyArrays)
   float fDistance = -1.0f;
   BOOST_CHECK(! matcher.SearchNeighbour( &array[0], &nIndice, &fDistance) );
 }
+
+namespace {
+
+void fillRandomRegions(std::size_t nbRegions, std::mt19937& generator, feature::SIFT_Regions& regions)
+{
+  std::uniform_real_distribution<float> positionDistribution(0.f, 1000.f);
+  std::uniform_int_distribution<int> binDistribution(0, 255);
+  for(std::size_t i = 0; i < nbRegions; ++i)
+  {
+    regions.Features().emplace_back(positionDistribution(generator), positionDistribution(generator));
+    feature::SIFT_Regions::DescriptorT desc;
+    for(std::size_t j = 0; j < desc.size(); ++j)
+      desc[j] = static_cast<unsigned char>(binDistribution(generator));
+    regions.Descriptors().push_back(desc);
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(Matching_RegionsDatabaseMatcher_MatchBatch)
+{
+  std::mt19937 generator(42);
+
+  feature::SIFT_Regions databaseRegions;
+  fillRandomRegions(300, generator, databaseRegions);
+
+  // the query regions are noisy copies of subsets of the database (one of them is empty)
+  std::vector<feature::SIFT_Regions> queryRegions(4);
+  const std::vector<std::size_t> nbQueryRegions = {120, 0, 80, 200};
+  std::uniform_int_distribution<int> noiseDistribution(-4, 4);
+  std::uniform_int_distribution<std::size_t> indexDistribution(0, 299);
+  for(std::size_t b = 0; b < queryRegions.size(); ++b)
+  {
+    fillRandomRegions(nbQueryRegions[b], generator, queryRegions[b]);
+    for(std::size_t i = 0; i < nbQueryRegions[b]; i += 2)
+    {
+      const std::size_t dbIndex = indexDistribution(generator);
+      queryRegions[b].Features()[i] = databaseRegions.Features()[dbIndex];
+      for(std::size_t j = 0; j < 128; ++j)
+        queryRegions[b].Descriptors()[i][j] = static_cast<unsigned char>(
+          std::max(0, std::min(255, databaseRegions.Descriptors()[dbIndex][j] + noiseDistribution(generator))));
+    }
+  }
+
+  std::vector<const feature::Regions*> queryRegionsPtr;
+  for(const feature::SIFT_Regions& regions : queryRegions)
+    queryRegionsPtr.push_back(&regions);
+
+  for(EMatcherType matcherType : {BRUTE_FORCE_L2, ANN_L2, CASCADE_HASHING_L2})
+  {
+    RegionsDatabaseMatcher matcher(matcherType, databaseRegions);
+
+    std::vector<IndMatches> batchMatches;
+    BOOST_CHECK(matcher.MatchBatch(0.8f, queryRegionsPtr, batchMatches));
+    BOOST_CHECK_EQUAL(batchMatches.size(), queryRegions.size());
+
+    for(std::size_t b = 0; b < queryRegions.size(); ++b)
+    {
+      IndMatches matches;
+      matcher.Match(0.8f, queryRegions[b], matches);
+      BOOST_CHECK(matches == batchMatches[b]);
+      if(nbQueryRegions[b] > 0)
+        BOOST_CHECK(!matches.empty());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Matching_ArrayMatcher_productQuantizer_NN)
+{
+  std::mt19937 generator(42);
+
+  feature::SIFT_Regions databaseRegions;
+  fillRandomRegions(300, generator, databaseRegions);
+  const unsigned char * database = reinterpret_cast<const unsigned char *>(databaseRegions.DescriptorRawData());
+
+  // the queries are noisy copies of the database
+  std::vector<unsigned char> queries(300 * 128);
+  std::uniform_int_distribution<int> noiseDistribution(-4, 4);
+  for(std::size_t i = 0; i < queries.size(); ++i)
+    queries[i] = static_cast<unsigned char>(std::max(0, std::min(255, database[i] + noiseDistribution(generator))));
+
+  std::vector<float> trainingDescriptors(database, database + 300 * 128);
+  std::shared_ptr<feature::ProductQuantizer> quantizer = std::make_shared<feature::ProductQuantizer>(128, 16);
+  quantizer->train(trainingDescriptors.data(), 300);
+
+  ArrayMatcher_productQuantizer<unsigned char> matcher(quantizer);
+  BOOST_CHECK( !matcher.Build(database, 300, 64) );
+  BOOST_CHECK( matcher.Build(database, 300, 128) );
+  BOOST_CHECK_EQUAL( matcher.getCodes().size(), 300 * 16 );
+
+  IndMatches vec_nIndice;
+  vector<float> vec_fDistance;
+  BOOST_CHECK( matcher.SearchNeighbours(queries.data(), 300, &vec_nIndice, &vec_fDistance, 2) );
+  BOOST_CHECK_EQUAL( 600, vec_nIndice.size());
+
+  std::size_t nbFound = 0;
+  for(std::size_t i = 0; i < 300; ++i)
+  {
+    BOOST_CHECK_EQUAL( vec_nIndice[2 * i]._i, i );
+    BOOST_CHECK_LE( vec_fDistance[2 * i], vec_fDistance[2 * i + 1] );
+    if(vec_nIndice[2 * i]._j == i)
+      ++nbFound;
+  }
+  // the asymmetric distance finds the original descriptors
+  BOOST_CHECK_GE( nbFound, 285 );
+
+  // same result with a database built from the compressed descriptors
+  ArrayMatcher_productQuantizer<unsigned char> codesMatcher(quantizer);
+  BOOST_CHECK( codesMatcher.BuildFromCodes(matcher.getCodes().data(), 300) );
+  IndMatches vec_nIndiceCodes;
+  vector<float> vec_fDistanceCodes;
+  BOOST_CHECK( codesMatcher.SearchNeighbours(queries.data(), 300, &vec_nIndiceCodes, &vec_fDistanceCodes, 2) );
+  BOOST_CHECK( vec_nIndice == vec_nIndiceCodes );
+  BOOST_CHECK( vec_fDistance == vec_fDistanceCodes );
+
+  int nIndice = -1;
+  float fDistance = -1.0f;
+  BOOST_CHECK( codesMatcher.SearchNeighbour(queries.data(), &nIndice, &fDistance) );
+  BOOST_CHECK_EQUAL( vec_nIndice[0]._j, nIndice );
+  BOOST_CHECK_EQUAL( vec_fDistance[0], fDistance );
+}
+
+BOOST_AUTO_TEST_CASE(Matching_RegionsDatabaseMatcher_productQuantizer)
+{
+  std::mt19937 generator(42);
+
+  feature::SIFT_Regions databaseRegions;
+  fillRandomRegions(300, generator, databaseRegions);
+
+  // the query regions are noisy copies of the database
+  feature::SIFT_Regions queryRegions;
+  fillRandomRegions(300, generator, queryRegions);
+  std::uniform_int_distribution<int> noiseDistribution(-4, 4);
+  for(std::size_t i = 0; i < 300; ++i)
+    for(std::size_t j = 0; j < 128; ++j)
+      queryRegions.Descriptors()[i][j] = static_cast<unsigned char>(
+        std::max(0, std::min(255, databaseRegions.Descriptors()[i][j] + noiseDistribution(generator))));
+
+  const unsigned char * database = reinterpret_cast<const unsigned char *>(databaseRegions.DescriptorRawData());
+  std::vector<float> trainingDescriptors(database, database + 300 * 128);
+  std::shared_ptr<feature::ProductQuantizer> quantizer = std::make_shared<feature::ProductQuantizer>(128, 16);
+  quantizer->train(trainingDescriptors.data(), 300);
+
+  // compressed regions, as loaded from the .pqdesc files
+  const auto compressRegions = [&](const feature::SIFT_Regions& regions, feature::CompressedRegions& compressedRegions)
+  {
+    compressedRegions.Features() = regions.Features();
+    compressedRegions.Codes().resize(regions.RegionCount() * compressedRegions.getCodeSize());
+    for(std::size_t i = 0; i < regions.RegionCount(); ++i)
+      quantizer->encode(regions.Descriptors()[i].getData(), &compressedRegions.Codes()[i * compressedRegions.getCodeSize()]);
+  };
+  feature::CompressedRegions compressedDatabaseRegions(quantizer);
+  feature::CompressedRegions compressedQueryRegions(quantizer);
+  compressRegions(databaseRegions, compressedDatabaseRegions);
+  compressRegions(queryRegions, compressedQueryRegions);
+
+  // save and reload the compressed query regions
+  {
+    const std::string featsPath = "Matching_RegionsDatabaseMatcher_productQuantizer.feat";
+    const std::string descsPath = "Matching_RegionsDatabaseMatcher_productQuantizer.pqdesc";
+    compressedQueryRegions.Save(featsPath, descsPath);
+    feature::CompressedRegions loadedRegions(quantizer);
+    loadedRegions.Load(featsPath, descsPath);
+    std::remove(featsPath.c_str());
+    std::remove(descsPath.c_str());
+    BOOST_CHECK_EQUAL(loadedRegions.RegionCount(), 300);
+    BOOST_CHECK(loadedRegions.Codes() == compressedQueryRegions.Codes());
+  }
+
+  RegionsDatabaseMatcher matcher(BRUTE_FORCE_PQ_L2, compressedDatabaseRegions);
+
+  IndMatches matches;
+  BOOST_CHECK(matcher.Match(0.8f, compressedQueryRegions, matches));
+  std::size_t nbCorrectMatches = 0;
+  for(const IndMatch& match : matches)
+    if(match._i == match._j)
+      ++nbCorrectMatches;
+  BOOST_CHECK_GE(nbCorrectMatches, 270);
+  BOOST_CHECK_GE(nbCorrectMatches, matches.size() * 95 / 100);
+
+  std::vector<IndMatches> batchMatches;
+  BOOST_CHECK(matcher.MatchBatch(0.8f, {&compressedQueryRegions}, batchMatches));
+  BOOST_CHECK(matches == batchMatches.front());
+
+  // the compressed and uncompressed regions are not matched together
+  IndMatches invalidMatches;
+  BOOST_CHECK(!matcher.Match(0.8f, queryRegions, invalidMatches));
+  BOOST_CHECK(!RegionsDatabaseMatcher(BRUTE_FORCE_PQ_L2, databaseRegions).Match(0.8f, queryRegions, invalidMatches));
+  BOOST_CHECK(!RegionsDatabaseMatcher(ANN_L2, compressedDatabaseRegions).Match(0.8f, compressedQueryRegions, invalidMatches));
+}
@@ -4,6 +4,8 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "Mesh.hpp"
+#include "MeshTopology.hpp"
+#include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
 #include <aliceVision/mvsData/OrientedPoint.hpp>
@@ -11,6 +13,10 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <map>
 
@@ -29,6 +35,327 @@ Mesh::~Mesh()
     delete tris;
 }
 
+/// a line of an OBJ file is a blank separated list of tokens
+inline bool isObjBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline void skipObjBlanks(const char*& s, const char* end)
+{
+    while(s < end && isObjBlank(*s))
+        ++s;
+}
+
+/**
+ * @brief Parse an integer at \p s and move \p s after it.
+ * @return false if there is no integer at \p s
+ */
+inline bool parseObjInt(const char*& s, const char* end, int& value)
+{
+    skipObjBlanks(s, end);
+    bool negative = false;
+    if(s < end && (*s == '-' || *s == '+'))
+        negative = (*s++ == '-');
+    if(s == end || *s < '0' || *s > '9')
+        return false;
+    int n = 0;
+    while(s < end && *s >= '0' && *s <= '9')
+        n = n * 10 + (*s++ - '0');
+    value = negative ? -n : n;
+    return true;
+}
+
+/**
+ * @brief Parse a floating point number at \p s and move \p s after it.
+ *
+ * The usual decimal notations with up to 19 significant digits are converted
+ * exactly (fast path of Clinger's algorithm), the other ones with strtod.
+ * @return false if there is no number at \p s
+ */
+inline bool parseObjDouble(const char*& s, const char* end, double& value)
+{
+    static const double pow10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+    skipObjBlanks(s, end);
+    const char* begin = s;
+    bool negative = false;
+    if(s < end && (*s == '-' || *s == '+'))
+        negative = (*s++ == '-');
+
+    std::uint64_t mantissa = 0;
+    int nbDigits = 0;
+    int exponent = 0;
+    while(s < end && *s >= '0' && *s <= '9')
+    {
+        mantissa = mantissa * 10 + (*s++ - '0');
+        ++nbDigits;
+    }
+    if(s < end && *s == '.')
+    {
+        ++s;
+        while(s < end && *s >= '0' && *s <= '9')
+        {
+            mantissa = mantissa * 10 + (*s++ - '0');
+            ++nbDigits;
+            --exponent;
+        }
+    }
+    if(s < end && (*s == 'e' || *s == 'E'))
+    {
+        int e = 0;
+        if(!parseObjInt(++s, end, e))
+            nbDigits = 0;
+        exponent += e;
+    }
+
+    if(nbDigits > 0 && nbDigits <= 19 && mantissa < (std::uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        value = static_cast<double>(mantissa);
+        value = exponent < 0 ? value / pow10[-exponent] : value * pow10[exponent];
+        if(negative)
+            value = -value;
+        return true;
+    }
+
+    // slow path: the buffer is null terminated
+    char* numberEnd = nullptr;
+    value = std::strtod(begin, &numberEnd);
+    if(numberEnd == begin)
+        return false;
+    s = numberEnd;
+    return true;
+}
+
+/// data parsed from a part of an OBJ file
+struct ObjChunk
+{
+    std::vector<Point3d> pts;
+    std::vector<Point3d> normals;
+    std::vector<Point2d> uvCoords;
+    std::vector<Mesh::triangle> tris;
+    std::vector<Voxel> trisUvIds;
+    std::vector<Voxel> trisNormalsIds;
+    /// index in materials, -1 for the material active at the beginning of the chunk
+    std::vector<int> trisMtlIds;
+    /// material names in order of usemtl statements
+    std::vector<std::string> materials;
+    /// first invalid line (empty if none)
+    std::string invalidLine;
+
+    void clear()
+    {
+        *this = ObjChunk();
+    }
+};
+
+/// parse a facet: 3 or 4 corners with the same syntax (v, v/vt, v/vt/vn or v//vn)
+bool parseObjFacet(const char* s, const char* end, ObjChunk& chunk)
+{
+    int corners[4][3];
+    int nbCorners = 0;
+    int nbUVs = 0;
+    int nbNormals = 0;
+
+    while(true)
+    {
+        skipObjBlanks(s, end);
+        if(s == end)
+            break;
+        if(nbCorners == 4)
+            return false;
+
+        int* corner = corners[nbCorners++];
+        corner[1] = corner[2] = 0;
+        if(!parseObjInt(s, end, corner[0]))
+            return false;
+        if(s < end && *s == '/')
+        {
+            ++s;
+            if(s < end && *s != '/')
+            {
+                if(!parseObjInt(s, end, corner[1]))
+                    return false;
+                ++nbUVs;
+            }
+            if(s < end && *s == '/')
+            {
+                ++s;
+                if(!parseObjInt(s, end, corner[2]))
+                    return false;
+                ++nbNormals;
+            }
+        }
+        if(s < end && !isObjBlank(*s))
+            return false;
+    }
+
+    if(nbCorners < 3 || (nbUVs != 0 && nbUVs != nbCorners) || (nbNormals != 0 && nbNormals != nbCorners))
+        return false;
+
+    // 1st triangle: corners 0 1 2, potential 2nd triangle: corners 0 2 3
+    const int trisCorners[2][3] = {{0, 1, 2}, {0, 2, 3}};
+    const int mtlId = chunk.materials.empty() ? -1 : static_cast<int>(chunk.materials.size()) - 1;
+
+    for(int t = 0; t < nbCorners - 2; ++t)
+    {
+        const int* c = trisCorners[t];
+        chunk.tris.emplace_back(corners[c[0]][0] - 1, corners[c[1]][0] - 1, corners[c[2]][0] - 1);
+        chunk.trisMtlIds.push_back(mtlId);
+        if(nbUVs != 0)
+            chunk.trisUvIds.push_back(Voxel(corners[c[0]][1], corners[c[1]][1], corners[c[2]][1]) - Voxel(1, 1, 1));
+        if(nbNormals != 0)
+            chunk.trisNormalsIds.push_back(Voxel(corners[c[0]][2], corners[c[1]][2], corners[c[2]][2]) - Voxel(1, 1, 1));
+    }
+    return true;
+}
+
+/// parse the lines of an OBJ file in [s; end[
+void parseObjChunk(const char* s, const char* end, ObjChunk& chunk)
+{
+    while(s < end)
+    {
+        const char* lineEnd = static_cast<const char*>(std::memchr(s, '\n', end - s));
+        if(lineEnd == nullptr)
+            lineEnd = end;
+
+        const char* lineBegin = s;
+        skipObjBlanks(s, lineEnd);
+
+        bool ok = true;
+        if(lineEnd - s < 2 || *s == '#')
+        {
+            // nothing to do
+        }
+        else if(s[0] == 'v' && isObjBlank(s[1]))
+        {
+            Point3d pt;
+            s += 1;
+            ok = parseObjDouble(s, lineEnd, pt.x) && parseObjDouble(s, lineEnd, pt.y) && parseObjDouble(s, lineEnd, pt.z);
+            chunk.pts.push_back(pt);
+        }
+        else if(s[0] == 'v' && s[1] == 'n' && lineEnd - s > 2 && isObjBlank(s[2]))
+        {
+            Point3d pt;
+            s += 2;
+            ok = parseObjDouble(s, lineEnd, pt.x) && parseObjDouble(s, lineEnd, pt.y) && parseObjDouble(s, lineEnd, pt.z);
+            chunk.normals.push_back(pt);
+        }
+        else if(s[0] == 'v' && s[1] == 't' && lineEnd - s > 2 && isObjBlank(s[2]))
+        {
+            Point2d pt;
+            s += 2;
+            ok = parseObjDouble(s, lineEnd, pt.x) && parseObjDouble(s, lineEnd, pt.y);
+            chunk.uvCoords.push_back(pt);
+        }
+        else if(s[0] == 'f' && isObjBlank(s[1]))
+        {
+            ok = parseObjFacet(s + 1, lineEnd, chunk);
+        }
+        else if(lineEnd - s > 6 && std::strncmp(s, "usemtl", 6) == 0 && isObjBlank(s[6]))
+        {
+            s += 6;
+            skipObjBlanks(s, lineEnd);
+            const char* nameEnd = s;
+            while(nameEnd < lineEnd && !isObjBlank(*nameEnd))
+                ++nameEnd;
+            chunk.materials.emplace_back(s, nameEnd);
+        }
+
+        if(!ok && chunk.invalidLine.empty())
+            chunk.invalidLine.assign(lineBegin, lineEnd);
+
+        s = lineEnd + 1;
+    }
+}
+
+/// append the elements parsed from a chunk to the mesh data
+template <class T>
+void appendObjChunkData(StaticVector<T>& dst, const std::vector<T>& src)
+{
+    dst.getDataWritable().insert(dst.end(), src.begin(), src.end());
+}
+
+/// append an integer to \p out
+inline void appendObjInt(std::string& out, int value)
+{
+    char buffer[16];
+    char* end = buffer + sizeof(buffer);
+    char* s = end;
+    unsigned int n = value < 0 ? -static_cast<unsigned int>(value) : value;
+    do
+    {
+        *--s = '0' + n % 10;
+        n /= 10;
+    } while(n != 0);
+    if(value < 0)
+        *--s = '-';
+    out.append(s, end);
+}
+
+/// append a floating point number with 6 decimals to \p out, as printf("%f")
+inline void appendObjDouble(std::string& out, double value)
+{
+    const double absValue = std::abs(value);
+    if(!(absValue < 1e9))
+    {
+        // large values, inf and nan
+        char buffer[512];
+        const int size = std::snprintf(buffer, sizeof(buffer), "%f", value);
+        out.append(buffer, size);
+        return;
+    }
+
+    // round the exact value of absValue * 1e6 to the nearest integer, ties to even
+    const double product = absValue * 1e6;
+    const double productError = std::fma(absValue, 1e6, -product);
+    double integral = std::floor(product);
+    const double remainder = product - integral;
+    if(remainder > 0.5 || (remainder == 0.5 && (productError > 0.0 || (productError == 0.0 && std::fmod(integral, 2.0) != 0.0))))
+        integral += 1.0;
+    const std::uint64_t scaled = static_cast<std::uint64_t>(integral);
+    if(std::signbit(value))
+        out += '-';
+    appendObjInt(out, static_cast<int>(scaled / 1000000));
+
+    char decimals[7] = {'.', '0', '0', '0', '0', '0', '0'};
+    std::uint64_t fraction = scaled % 1000000;
+    for(int i = 6; i > 0; --i, fraction /= 10)
+        decimals[i] = '0' + fraction % 10;
+    out.append(decimals, 7);
+}
+
+/**
+ * @brief Write \p nbLines lines in \p f, formatted in parallel by blocks
+ *        with formatLine(lineIndex, buffer) and written in order.
+ */
+template <typename FormatLine>
+void writeObjLines(FILE* f, int nbLines, FormatLine&& formatLine)
+{
+    const int blockSize = 65536;
+    const int nbBlocks = (nbLines + blockSize - 1) / blockSize;
+
+    #pragma omp parallel for ordered schedule(static, 1)
+    for(int b = 0; b < nbBlocks; ++b)
+    {
+        std::string buffer;
+        buffer.reserve(blockSize * 40);
+        const int lastLine = std::min(nbLines, (b + 1) * blockSize);
+        for(int i = b * blockSize; i < lastLine; ++i)
+            formatLine(i, buffer);
+
+        #pragma omp ordered
+        {
+            fwrite(buffer.data(), 1, buffer.size(), f);
+        }
+    }
+}
+
+/// magic number of the binary mesh files ("AVMB"), the legacy files start with the number of points
+const char binMeshMagic[4] = {'A', 'V', 'M', 'B'};
+const int binMeshVersion = 1;
+
 void Mesh::saveToObj(const std::string& filename)
 {
   ALICEVISION_LOG_INFO("Save mesh to obj: " << filename);
@@ -36,26 +363,48 @@ void Mesh::saveToObj(const std::string& filename)
   ALICEVISION_LOG_INFO("Nb triangles: " << tris->size());
 
   FILE* f = fopen(filename.c_str(), "w");
+  if(f == nullptr)
+      throw std::runtime_error("Unable to create the obj file: " + filename);
 
   fprintf(f, "# \n");
   fprintf(f, "# Wavefront OBJ file\n");
   fprintf(f, "# Created with AliceVision\n");
   fprintf(f, "# \n");
   fprintf(f, "g Mesh\n");
-  for(int i = 0; i < pts->size(); i++)
-      fprintf(f, "v %f %f %f\n", (*pts)[i].x, (*pts)[i].y, (*pts)[i].z);
 
-  for(int i = 0; i < tris->size(); i++)
+  writeObjLines(f, pts->size(), [this](int i, std::string& out)
   {
-      Mesh::triangle& t = (*tris)[i];
-      fprintf(f, "f %i %i %i\n", t.v[0] + 1, t.v[1] + 1, t.v[2] + 1);
-  }
+      const Point3d& p = (*pts)[i];
+      out += "v ";
+      appendObjDouble(out, p.x);
+      out += ' ';
+      appendObjDouble(out, p.y);
+      out += ' ';
+      appendObjDouble(out, p.z);
+      out += '\n';
+  });
+
+  writeObjLines(f, tris->size(), [this](int i, std::string& out)
+  {
+      const Mesh::triangle& t = (*tris)[i];
+      out += "f ";
+      appendObjInt(out, t.v[0] + 1);
+      out += ' ';
+      appendObjInt(out, t.v[1] + 1);
+      out += ' ';
+      appendObjInt(out, t.v[2] + 1);
+      out += '\n';
+  });
+
   fclose(f);
   ALICEVISION_LOG_INFO("Save mesh to obj done.");
 }
 
-bool Mesh::loadFromBin(std::string binFileName)
+bool Mesh::loadFromBin(const std::string& binFileName, StaticVector<StaticVector<int>*>** ptsVisibilities)
 {
+    if(ptsVisibilities != nullptr)
+        *ptsVisibilities = nullptr;
+
     FILE* f = fopen(binFileName.c_str(), "rb");
 
     if(f == nullptr)
@@ -63,40 +412,114 @@ bool Mesh::loadFromBin(std::string binFileName)
         return false;
     }
 
-    int npts;
-    fread(&npts, sizeof(int), 1, f);
+    char magic[4];
+    int version = 0;
+    int npts = 0;
+    int ntris = 0;
+    int hasVisibilities = 0;
+
+    bool ok = (fread(magic, sizeof(magic), 1, f) == 1);
+    if(ok && std::equal(magic, magic + 4, binMeshMagic))
+    {
+        ok = fread(&version, sizeof(int), 1, f) == 1 &&
+             fread(&npts, sizeof(int), 1, f) == 1 &&
+             fread(&ntris, sizeof(int), 1, f) == 1 &&
+             fread(&hasVisibilities, sizeof(int), 1, f) == 1;
+        if(ok && version != binMeshVersion)
+        {
+            fclose(f);
+            throw std::runtime_error("Unsupported binary mesh version " + std::to_string(version) + ": " + binFileName);
+        }
+    }
+    else if(ok)
+    {
+        // legacy format: npts, pts, ntris, tris
+        std::memcpy(&npts, magic, sizeof(int));
+    }
+
     pts = new StaticVector<Point3d>();
     pts->resize(npts);
-    fread(&(*pts)[0], sizeof(Point3d), npts, f);
-    int ntris;
-    fread(&ntris, sizeof(int), 1, f);
+    ok = ok && (npts == 0 || fread(&(*pts)[0], sizeof(Point3d), npts, f) == static_cast<std::size_t>(npts));
+
+    if(version == 0)
+        ok = ok && fread(&ntris, sizeof(int), 1, f) == 1;
     tris = new StaticVector<Mesh::triangle>();
     tris->resize(ntris);
-    fread(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
+    ok = ok && (ntris == 0 || fread(&(*tris)[0], sizeof(Mesh::triangle), ntris, f) == static_cast<std::size_t>(ntris));
+
+    if(ok && hasVisibilities && ptsVisibilities != nullptr)
+    {
+        // visibilities stored as offsets (npts + 1) and concatenated camera ids
+        std::vector<int> offsets(npts + 1);
+        ok = fread(offsets.data(), sizeof(int), offsets.size(), f) == offsets.size();
+        std::vector<int> camIds(ok ? offsets.back() : 0);
+        ok = ok && (camIds.empty() || fread(camIds.data(), sizeof(int), camIds.size(), f) == camIds.size());
+
+        if(ok)
+        {
+            StaticVector<StaticVector<int>*>* visibilities = new StaticVector<StaticVector<int>*>();
+            visibilities->resize_with(npts, nullptr);
+            for(int i = 0; i < npts; ++i)
+            {
+                const int nbCams = offsets[i + 1] - offsets[i];
+                if(nbCams == 0)
+                    continue;
+                StaticVector<int>* cams = new StaticVector<int>();
+                cams->getDataWritable().assign(camIds.begin() + offsets[i], camIds.begin() + offsets[i + 1]);
+                (*visibilities)[i] = cams;
+            }
+            *ptsVisibilities = visibilities;
+        }
+    }
     fclose(f);
 
-    return true;
+    if(!ok)
+        ALICEVISION_LOG_ERROR("Unable to read the binary mesh file: " << binFileName);
+
+    return ok;
 }
 
-void Mesh::saveToBin(std::string binFileName)
+void Mesh::saveToBin(const std::string& binFileName, const StaticVector<StaticVector<int>*>* ptsVisibilities)
 {
     long t = std::clock();
     ALICEVISION_LOG_DEBUG("Save mesh to bin.");
-    // printf("open\n");
+
+    if(ptsVisibilities != nullptr && ptsVisibilities->size() != pts->size())
+        throw std::runtime_error("Mesh and associated visibilities don't have the same size.");
+
     FILE* f = fopen(binFileName.c_str(), "wb");
-    int npts = pts->size();
-    // printf("write npts %i\n",npts);
+    if(f == nullptr)
+        throw std::runtime_error("Unable to create the binary mesh file: " + binFileName);
+
+    const int npts = pts->size();
+    const int ntris = tris->size();
+    const int hasVisibilities = (ptsVisibilities != nullptr);
+
+    fwrite(binMeshMagic, sizeof(binMeshMagic), 1, f);
+    fwrite(&binMeshVersion, sizeof(int), 1, f);
     fwrite(&npts, sizeof(int), 1, f);
-    // printf("write pts\n");
-    fwrite(&(*pts)[0], sizeof(Point3d), npts, f);
-    int ntris = tris->size();
-    // printf("write ntris %i\n",ntris);
     fwrite(&ntris, sizeof(int), 1, f);
-    // printf("write tris\n");
-    fwrite(&(*tris)[0], sizeof(Mesh::triangle), ntris, f);
-    // printf("close\n");
+    fwrite(&hasVisibilities, sizeof(int), 1, f);
+    fwrite(pts->getData().data(), sizeof(Point3d), npts, f);
+    fwrite(tris->getData().data(), sizeof(Mesh::triangle), ntris, f);
+
+    if(hasVisibilities)
+    {
+        std::vector<int> offsets(npts + 1, 0);
+        for(int i = 0; i < npts; ++i)
+        {
+            const StaticVector<int>* cams = (*ptsVisibilities)[i];
+            offsets[i + 1] = offsets[i] + (cams != nullptr ? cams->size() : 0);
+        }
+        fwrite(offsets.data(), sizeof(int), offsets.size(), f);
+        for(int i = 0; i < npts; ++i)
+        {
+            const StaticVector<int>* cams = (*ptsVisibilities)[i];
+            if(cams != nullptr && !cams->empty())
+                fwrite(cams->getData().data(), sizeof(int), cams->size(), f);
+        }
+    }
     fclose(f);
-    // printf("done\n");
     mvsUtils::printfElapsedTime(t, "Save mesh to bin ");
 }
 
@@ -492,57 +915,20 @@ bool Mesh::doesTriangleIntersectsRectangle(Mesh::triangle_proj* tp, Mesh::rectan
 
 StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles()
 {
-    // array of tuples <x: vertexIndex, y: triangleIndex, z: numberOfNeighbors>
-    StaticVector<Voxel> vertexNeighborhoodPairs;
-    vertexNeighborhoodPairs.reserve(tris->size() * 3);
-    for(int i = 0; i < tris->size(); ++i)
-    {
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[0], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[1], i, 0));
-        vertexNeighborhoodPairs.push_back(Voxel((*tris)[i].v[2], i, 0));
-    }
-    qsort(&vertexNeighborhoodPairs[0], vertexNeighborhoodPairs.size(), sizeof(Voxel), qSortCompareVoxelByXAsc);
-
-    int i = 0; // index of the unique pair of <vertex, neighborhood>
-    int j = 0; // index of the vertex
-    int k = 0; // number of neighbors
-    int firstid = 0;
-    while(i < vertexNeighborhoodPairs.size())
-    {
-        k++;
-        // (*vertexNeighborhoodPairs)[i].z = j;
-        if((i == vertexNeighborhoodPairs.size() - 1) || (vertexNeighborhoodPairs[i].x != vertexNeighborhoodPairs[i + 1].x))
-        {
-            vertexNeighborhoodPairs[firstid].z = k; // store the number of neighbors
-            ++j;
-            firstid = i + 1;
-            k = 0;
-        }
-        ++i;
-    }
-    int npts = j;
+    const MeshTopology topology(*this, false);
 
     StaticVector<StaticVector<int>*>* out_ptsNeighTris = new StaticVector<StaticVector<int>*>();
-    out_ptsNeighTris->reserve(pts->size());
     out_ptsNeighTris->resize_with(pts->size(), nullptr);
 
-    i = 0;
-    for(j = 0; j < npts; ++j)
+    #pragma omp parallel for
+    for(int i = 0; i < pts->size(); ++i)
     {
-        int middlePtId = vertexNeighborhoodPairs[i].x;
-        int nbNeighbors = vertexNeighborhoodPairs[i].z;
-        int i0 = i;
-        int i1 = i + nbNeighbors;
-        i = i1;
-
+        const MeshTopology::IndexRange ptNeighTris = topology.getPtNeighTris(i);
+        if(ptNeighTris.empty())
+            continue;
         StaticVector<int>* triTmp = new StaticVector<int>();
-        triTmp->reserve(nbNeighbors);
-        for(int l = i0; l < i1; ++l)
-        {
-            triTmp->push_back(vertexNeighborhoodPairs[l].y); // index of triangle
-        }
-
-        (*out_ptsNeighTris)[middlePtId] = triTmp;
+        triTmp->getDataWritable().assign(ptNeighTris.begin(), ptNeighTris.end());
+        (*out_ptsNeighTris)[i] = triTmp;
     }
 
     return out_ptsNeighTris;
@@ -550,87 +936,22 @@ StaticVector<StaticVector<int>*>* Mesh::getPtsNeighborTriangles()
 
 StaticVector<StaticVector<int>*>* Mesh::getPtsNeighPtsOrdered()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighborTriangles = getPtsNeighborTriangles();
+    const MeshTopology topology(*this);
 
     StaticVector<StaticVector<int>*>* out_ptsNeighPts = new StaticVector<StaticVector<int>*>();
     out_ptsNeighPts->resize_with(pts->size(), nullptr);
 
-    for(int middlePtId = 0; middlePtId < pts->size(); ++middlePtId)
+    #pragma omp parallel for
+    for(int i = 0; i < pts->size(); ++i)
     {
-        StaticVector<int>* neighborTriangles = (*ptsNeighborTriangles)[middlePtId];
-        if((neighborTriangles == nullptr) || neighborTriangles->empty())
+        if(topology.getPtNeighTris(i).empty())
             continue;
-
-        StaticVector<int> vhid;
-        vhid.reserve(neighborTriangles->size() * 2);
-        int currentTriPtId = (*tris)[(*neighborTriangles)[0]].v[0];
-        int firstTriPtId = currentTriPtId;
-        vhid.push_back(currentTriPtId);
-
-        bool isThereTWithCurrentTriPtId = true;
-        while(!neighborTriangles->empty() && isThereTWithCurrentTriPtId)
-        {
-            isThereTWithCurrentTriPtId = false;
-
-            // find triangle with middlePtId and currentTriPtId and get remaining point id
-            for(int n = 0; n < neighborTriangles->size(); ++n)
-            {
-                bool ok_middlePtId = false;
-                bool ok_actTriPtId = false;
-                int remainingPtId = -1; // remaining pt id
-                for(int k = 0; k < 3; ++k)
-                {
-                    int triPtId = (*tris)[(*neighborTriangles)[n]].v[k];
-                    double length = ((*pts)[middlePtId] - (*pts)[triPtId]).size();
-                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
-                    {
-                        remainingPtId = triPtId;
-                    }
-                    if(triPtId == middlePtId)
-                    {
-                        ok_middlePtId = true;
-                    }
-                    if(triPtId == currentTriPtId)
-                    {
-                        ok_actTriPtId = true;
-                    }
-                }
-
-                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
-                {
-                    currentTriPtId = remainingPtId;
-                    neighborTriangles->remove(n);
-                    vhid.push_back(currentTriPtId);
-                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
-                    break;
-                }
-            }
-        }
-
-        if(!vhid.empty())
-        {
-            if(currentTriPtId == firstTriPtId)
-            {
-                vhid.pop(); // remove last ... which is first
-            }
-
-            // remove duplicates
-            StaticVector<int>* vhid1 = new StaticVector<int>();
-            vhid1->reserve(vhid.size());
-            for(int k1 = 0; k1 < vhid.size(); k1++)
-            {
-                if(vhid1->indexOf(vhid[k1]) == -1)
-                {
-                    vhid1->push_back(vhid[k1]);
-                }
-            }
-
-            (*out_ptsNeighPts)[middlePtId] = vhid1;
-        }
+        const MeshTopology::IndexRange ptNeighPts = topology.getPtNeighPts(i);
+        StaticVector<int>* vhid = new StaticVector<int>();
+        vhid->getDataWritable().assign(ptNeighPts.begin(), ptNeighPts.end());
+        (*out_ptsNeighPts)[i] = vhid;
     }
 
-    deleteArrayOfArrays<int>(&ptsNeighborTriangles);
-
     return out_ptsNeighPts;
 }
 
@@ -1211,35 +1532,27 @@ void Mesh::getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris
     delete edges;
 }
 
-StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
-                                                             double maximalNeighDist)
+StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(const MeshTopology& topology, double maximalNeighDist)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
-    nms->reserve(pts->size());
+    nms->resize_with(pts->size(), Point3d(0.0, 0.0, 0.0));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         Point3d p = (*pts)[i];
-        StaticVector<int>* nei = (*ptsNeighPts)[i];
-        int nneighs = 0;
-        if(nei != nullptr)
-        {
-            nneighs = nei->size();
-        }
+        const MeshTopology::IndexRange nei = topology.getPtNeighPts(i);
+        const int nneighs = nei.size();
 
-        if(nneighs == 0)
-        {
-            nms->push_back(Point3d(0.0, 0.0, 0.0));
-        }
-        else
+        if(nneighs > 0)
         {
             double maxNeighDist = 0.0f;
             // laplacian smoothing vector
             Point3d n = Point3d(0.0, 0.0, 0.0);
             for(int j = 0; j < nneighs; j++)
             {
-                n = n + (*pts)[(*nei)[j]];
-                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[(*nei)[j]]).size());
+                n = n + (*pts)[nei[j]];
+                maxNeighDist = std::max(maxNeighDist, (p - (*pts)[nei[j]]).size());
             }
             n = ((n / (float)nneighs) - p);
 
@@ -1267,7 +1580,7 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
                 n = Point3d(0.0, 0.0, 0.0);
             }
 
-            nms->push_back(n);
+            (*nms)[i] = n;
         }
     }
 
@@ -1276,16 +1589,16 @@ StaticVector<Point3d>* Mesh::getLaplacianSmoothingVectors(StaticVector<StaticVec
 
 void Mesh::laplacianSmoothPts(float maximalNeighDist)
 {
-    StaticVector<StaticVector<int>*>* ptsNei = getPtsNeighPtsOrdered();
-    laplacianSmoothPts(ptsNei, maximalNeighDist);
-    deleteArrayOfArrays<int>(&ptsNei);
+    const MeshTopology topology(*this);
+    laplacianSmoothPts(topology, maximalNeighDist);
 }
 
-void Mesh::laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist)
+void Mesh::laplacianSmoothPts(const MeshTopology& topology, double maximalNeighDist)
 {
-    StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(ptsNeighPts, maximalNeighDist);
+    StaticVector<Point3d>* nms = getLaplacianSmoothingVectors(topology, maximalNeighDist);
 
     // smooth
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
         (*pts)[i] = (*pts)[i] + (*nms)[i];
@@ -1315,28 +1628,27 @@ double Mesh::computeTriangleMaxEdgeLength(int idTri) const
 
 StaticVector<Point3d>* Mesh::computeNormalsForPts()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighTris = getPtsNeighborTriangles();
-    StaticVector<Point3d>* nms = computeNormalsForPts(ptsNeighTris);
-    deleteArrayOfArrays<int>(&ptsNeighTris);
-    return nms;
+    const MeshTopology topology(*this, false);
+    return computeNormalsForPts(topology);
 }
 
-StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris)
+StaticVector<Point3d>* Mesh::computeNormalsForPts(const MeshTopology& topology)
 {
     StaticVector<Point3d>* nms = new StaticVector<Point3d>();
     nms->reserve(pts->size());
     nms->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
-        StaticVector<int>* triTmp = (*ptsNeighTris)[i];
-        if((triTmp != nullptr) && (triTmp->size() > 0))
+        const MeshTopology::IndexRange triTmp = topology.getPtNeighTris(i);
+        if(!triTmp.empty())
         {
             Point3d n = Point3d(0.0f, 0.0f, 0.0f);
             float nn = 0.0f;
-            for(int j = 0; j < triTmp->size(); j++)
+            for(int j = 0; j < triTmp.size(); j++)
             {
-                Point3d n1 = computeTriangleNormal((*triTmp)[j]);
+                Point3d n1 = computeTriangleNormal(triTmp[j]);
                 n1 = n1.normalize();
                 if(std::isnan(n1.x) || std::isnan(n1.y) || std::isnan(n1.z) || (n1.x != n1.x) || (n1.y != n1.y) ||
                    (n1.z != n1.z)) // check if is not NaN
@@ -1345,7 +1657,7 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
                 }
                 else
                 {
-                    n = n + computeTriangleNormal((*triTmp)[j]);
+                    n = n + computeTriangleNormal(triTmp[j]);
                     nn += 1.0f;
                 }
             }
@@ -1365,22 +1677,24 @@ StaticVector<Point3d>* Mesh::computeNormalsForPts(StaticVector<StaticVector<int>
     return nms;
 }
 
-void Mesh::smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts)
+void Mesh::smoothNormals(StaticVector<Point3d>* nms, const MeshTopology& topology)
 {
     StaticVector<Point3d>* nmss = new StaticVector<Point3d>();
     nmss->reserve(pts->size());
     nmss->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.0f));
 
+    #pragma omp parallel for
     for(int i = 0; i < pts->size(); i++)
     {
+        const MeshTopology::IndexRange ptNeighPts = topology.getPtNeighPts(i);
         Point3d n = (*nms)[i];
-        for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPts)[i]); j++)
+        for(int j = 0; j < ptNeighPts.size(); j++)
         {
-            n = n + (*nms)[(*(*ptsNeighPts)[i])[j]];
+            n = n + (*nms)[ptNeighPts[j]];
         }
-        if(sizeOfStaticVector<int>((*ptsNeighPts)[i]) > 0)
+        if(ptNeighPts.size() > 0)
         {
-            n = n / (float)sizeOfStaticVector<int>((*ptsNeighPts)[i]);
+            n = n / (float)ptNeighPts.size();
         }
         n = n.normalize();
         if(std::isnan(n.x) || std::isnan(n.y) || std::isnan(n.z) || (n.x != n.x) || (n.y != n.y) || (n.z != n.z))
@@ -2337,7 +2651,7 @@ bool Mesh::isTriangleObtuse(int triId)
 
 StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 {
-    StaticVector<StaticVector<int>*>* ptsNeighPtsOrdered = getPtsNeighPtsOrdered();
+    const MeshTopology topology(*this);
 
     StaticVector<int>* colors = new StaticVector<int>();
     colors->reserve(pts->size());
@@ -2369,13 +2683,11 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
                 {
                     delete colors;
                     delete buff;
-                    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
                     throw std::runtime_error("getLargestConnectedComponentTrisIds: bad condition.");
                 }
             }
-            for(int j = 0; j < sizeOfStaticVector<int>((*ptsNeighPtsOrdered)[ptid]); ++j)
+            for(int nptid : topology.getPtNeighPts(ptid))
             {
-                int nptid = (*(*ptsNeighPtsOrdered)[ptid])[j];
                 if((nptid > -1) && ((*colors)[nptid] == -1))
                 {
                     if(buff->size() >= buff->capacity()) // should not happen but no problem
@@ -2411,7 +2723,6 @@ StaticVector<int>* Mesh::getLargestConnectedComponentTrisIds()
 
     delete colors;
     delete buff;
-    deleteArrayOfArrays<int>(&ptsNeighPtsOrdered);
 
     return out;
 }
@@ -2421,247 +2732,106 @@ bool Mesh::loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVec
                                StaticVector<Voxel>& trisUvIds, std::string objAsciiFileName)
 {
     ALICEVISION_LOG_INFO("Loading mesh from obj file: " << objAsciiFileName);
-    // read number of points, triangles, uvcoords
-    int npts = 0;
-    int ntris = 0;
-    int nuvs = 0;
-    int nnorms = 0;
-    int nlines = 0;
-
-    {
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
-        while(getline(in, line))
-        {
-            if((line[0] == 'v') && (line[1] == ' '))
-            {
-                npts += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                nnorms += 1;
-            }
-            if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                nuvs += 1;
-            }
-            if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                if((n1 == 3 && n2 == 0) ||
-                   (n1 == 0 && n2 == 3) ||
-                   (n1 == 0 && n2 == 0))
-                    ntris += 1;
-                else if((n1 == 4 && n2 == 0) ||
-                        (n1 == 8 && n2 == 0) ||
-                        (n1 == 0 && n2 == 4))
-                    ntris += 2;
-            }
-            nlines++;
-        }
-        in.close();
-    }
-
-    ALICEVISION_LOG_INFO("\t- # vertices: " << npts << std::endl
-      << "\t- # normals: " << nnorms << std::endl
-      << "\t- # uv coordinates: " << nuvs << std::endl
-      << "\t- # triangles: " << ntris);
 
     pts = new StaticVector<Point3d>();
-    pts->reserve(npts);
     tris = new StaticVector<Mesh::triangle>();
-    tris->reserve(ntris);
-    uvCoords.reserve(nuvs);
-    trisUvIds.reserve(ntris);
-    normals.reserve(nnorms);
-    trisNormalsIds.reserve(ntris);
-    trisMtlIds.reserve(ntris);
+
+    FILE* f = fopen(objAsciiFileName.c_str(), "rb");
+    if(f == nullptr)
+        return false;
 
     std::map<std::string, int> materialCache;
+    int mtlId = -1;
 
+    // the file is read by blocks, each block is split in chunks of lines parsed in parallel
+    const std::size_t blockSize = 64 * 1024 * 1024;
+    const int nbChunks = omp_get_max_threads();
+    std::vector<ObjChunk> chunks(nbChunks);
+    std::vector<char> buffer;
+    std::size_t carrySize = 0;
+    bool endOfFile = false;
+
+    while(!endOfFile)
     {
-        int mtlId = -1;
-        std::ifstream in(objAsciiFileName.c_str());
-        std::string line;
+        // +1: null terminated buffer
+        buffer.resize(carrySize + blockSize + 1);
+        const std::size_t readSize = fread(buffer.data() + carrySize, 1, blockSize, f);
+        endOfFile = (readSize < blockSize);
 
-        long t1 = mvsUtils::initEstimate();
-        int idline = 0;
-        while(getline(in, line))
+        const std::size_t dataSize = carrySize + readSize;
+        buffer[dataSize] = '\0';
+
+        // parse up to the last complete line, the rest is carried to the next block
+        std::size_t parseSize = dataSize;
+        if(!endOfFile)
+        {
+            while(parseSize > 0 && buffer[parseSize - 1] != '\n')
+                --parseSize;
+        }
+
+        // split the block in chunks of lines
+        std::vector<std::size_t> chunkBegins(nbChunks + 1, parseSize);
+        chunkBegins[0] = 0;
+        for(int c = 1; c < nbChunks; ++c)
         {
-            if(line.size() < 3 || line[0] == '#')
+            std::size_t pos = std::max(chunkBegins[c - 1], parseSize * c / nbChunks);
+            while(pos < parseSize && pos > 0 && buffer[pos - 1] != '\n')
+                ++pos;
+            chunkBegins[c] = pos;
+        }
+
+        #pragma omp parallel for
+        for(int c = 0; c < nbChunks; ++c)
+        {
+            chunks[c].clear();
+            parseObjChunk(buffer.data() + chunkBegins[c], buffer.data() + chunkBegins[c + 1], chunks[c]);
+        }
+
+        // append the chunks in the file order
+        for(ObjChunk& chunk : chunks)
+        {
+            if(!chunk.invalidLine.empty())
             {
-                // nothing to do
+                fclose(f);
+                throw std::runtime_error("Mesh: Unrecognized syntax while reading obj file: " + objAsciiFileName + "\n" + chunk.invalidLine);
             }
-            else if(mvsUtils::findNSubstrsInString(line, "usemtl") == 1)
+
+            // materials: ids in order of first appearance in the file
+            std::vector<int> chunkMtlIds(chunk.materials.size());
+            for(std::size_t i = 0; i < chunk.materials.size(); ++i)
             {
-                char buff[5000];
-                sscanf(line.c_str(), "usemtl %s", buff);
-                auto it = materialCache.find(buff);
+                auto it = materialCache.find(chunk.materials[i]);
                 if(it == materialCache.end())
-                    materialCache.emplace(buff, ++mtlId); // new material
-                else
-                    mtlId = it->second;                   // already known material
-            }
-            else if((line[0] == 'v') && (line[1] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "v %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                pts->push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 'n') && (line[2] == ' '))
-            {
-                Point3d pt;
-                sscanf(line.c_str(), "vn %lf %lf %lf", &pt.x, &pt.y, &pt.z);
-                // printf("%f %f %f\n", pt.x, pt.y, pt.z);
-                normals.push_back(pt);
-            }
-            else if((line[0] == 'v') && (line[1] == 't') && (line[2] == ' '))
-            {
-                Point2d pt;
-                sscanf(line.c_str(), "vt %lf %lf", &pt.x, &pt.y);
-                uvCoords.push_back(pt);
-            }
-            else if((line[0] == 'f') && (line[1] == ' '))
-            {
-                int n1 = mvsUtils::findNSubstrsInString(line, "/");
-                int n2 = mvsUtils::findNSubstrsInString(line, "//");
-                Voxel vertex, uvCoord, vertexNormal;
-                Voxel vertex2, uvCoord2, vertexNormal2;
-                bool ok = false;
-                bool withNormal = false;
-                bool withUV = false;
-                bool withQuad = false;
-                if(n2 == 0)
-                {
-                    if(n1 == 0)
-                    {
-                        sscanf(line.c_str(), "f %i %i %i", &vertex.x, &vertex.y, &vertex.z);
-                        ok = true;
-                    }
-                    else if(n1 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z);
-                        ok = true;
-                        withUV = true;
-                    }
-                    else if(n1 == 6)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i", &vertex.x, &uvCoord.x, &vertexNormal.x, &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z);
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                    }
-                    else if(n1 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i/%i %i/%i %i/%i %i/%i", &vertex.x, &uvCoord.x, &vertex.y, &uvCoord.y, &vertex.z, &uvCoord.z, &vertex2.z, &uvCoord2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        ok = true;
-                        withUV = true;
-                        withQuad = true;
-                    }
-                    else if(n1 == 8)
-                    {
-                        sscanf(line.c_str(), "f %i/%i/%i %i/%i/%i %i/%i/%i %i/%i/%i",
-                               &vertex.x, &uvCoord.x, &vertexNormal.x,
-                               &vertex.y, &uvCoord.y, &vertexNormal.y,
-                               &vertex.z, &uvCoord.z, &vertexNormal.z,
-                               &vertex2.z, &uvCoord2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        uvCoord2.x = uvCoord.x;
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        uvCoord2.y = uvCoord.z;
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withUV = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                else
-                {
-                    if(n2 == 3)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i", &vertex.x, &vertexNormal.x, &vertex.y, &vertexNormal.y, &vertex.z, &vertexNormal.z);
-                        ok = true;
-                        withNormal = true;
-                    }
-                    else if(n2 == 4)
-                    {
-                        sscanf(line.c_str(), "f %i//%i %i//%i %i//%i %i//%i",
-                               &vertex.x, &vertexNormal.x,
-                               &vertex.y, &vertexNormal.y,
-                               &vertex.z, &vertexNormal.z,
-                               &vertex2.z, &vertexNormal2.z);
-                        vertex2.x = vertex.x; // same first point
-                        vertexNormal2.x = vertexNormal.x;
-                        vertex2.y = vertex.z; // 3rd point of the 1st triangle is the 2nd of the 2nd triangle.
-                        vertexNormal2.y = vertexNormal.z;
-                        ok = true;
-                        withNormal = true;
-                        withQuad = true;
-                    }
-                }
-                if(!ok)
-                {
-                    throw std::runtime_error("Mesh: Unrecognized facet syntax while reading obj file: " + objAsciiFileName);
-                }
-
-                // 1st triangle
-                {
-                    triangle t;
-                    t.v[0] = vertex.x - 1;
-                    t.v[1] = vertex.y - 1;
-                    t.v[2] = vertex.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal - Voxel(1, 1, 1));
-                    }
-                }
-
-                // potential 2nd triangle
-                if(withQuad)
-                {
-                    triangle t;
-                    t.v[0] = vertex2.x - 1;
-                    t.v[1] = vertex2.y - 1;
-                    t.v[2] = vertex2.z - 1;
-                    t.alive = true;
-                    tris->push_back(t);
-                    trisMtlIds.push_back(mtlId);
-                    if(withUV)
-                    {
-                        trisUvIds.push_back(uvCoord2 - Voxel(1, 1, 1));
-                    }
-                    if(withNormal)
-                    {
-                        trisNormalsIds.push_back(vertexNormal2 - Voxel(1, 1, 1));
-                    }
-                }
+                    it = materialCache.emplace(chunk.materials[i], materialCache.size()).first; // new material
+                chunkMtlIds[i] = it->second;
             }
+            for(int& triMtlId : chunk.trisMtlIds)
+                triMtlId = (triMtlId < 0) ? mtlId : chunkMtlIds[triMtlId];
+            if(!chunkMtlIds.empty())
+                mtlId = chunkMtlIds.back();
+
+            appendObjChunkData(*pts, chunk.pts);
+            appendObjChunkData(normals, chunk.normals);
+            appendObjChunkData(uvCoords, chunk.uvCoords);
+            appendObjChunkData(*tris, chunk.tris);
+            appendObjChunkData(trisUvIds, chunk.trisUvIds);
+            appendObjChunkData(trisNormalsIds, chunk.trisNormalsIds);
+            appendObjChunkData(trisMtlIds, chunk.trisMtlIds);
+        }
+
+        // carry the incomplete last line
+        carrySize = dataSize - parseSize;
+        if(parseSize == 0 && !endOfFile)
+            continue; // line longer than the block: read more
+        std::memmove(buffer.data(), buffer.data() + parseSize, carrySize);
+    }
+    fclose(f);
 
-            mvsUtils::printfEstimate(idline, nlines, t1);
-            idline++;
-        }
-        mvsUtils::finishEstimate();
+    nmtls = materialCache.size();
 
-        in.close();
-        nmtls = materialCache.size();
-    }
-    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << npts << "\n\t- # triangles: " << ntris);
-    return npts != 0 && ntris != 0;
+    ALICEVISION_LOG_INFO("Mesh loaded: \n\t- #points: " << pts->size() << "\n\t- # normals: " << normals.size()
+      << "\n\t- # uv coordinates: " << uvCoords.size() << "\n\t- # triangles: " << tris->size());
+    return !pts->empty() && !tris->empty();
 }
 
 bool Mesh::getEdgeNeighTrisInterval(Pixel& itr, Pixel edge, StaticVector<Voxel>* edgesXStat,
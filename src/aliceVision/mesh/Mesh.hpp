@@ -16,6 +16,8 @@
 namespace aliceVision {
 namespace mesh {
 
+class MeshTopology;
+
 class Mesh
 {
 public:
@@ -109,10 +111,28 @@ public:
     Mesh();
     ~Mesh();
 
+    /// Save the mesh as an OBJ file (lines formatted in parallel)
     void saveToObj(const std::string& filename);
 
-    bool loadFromBin(std::string binFileName);
-    void saveToBin(std::string binFileName);
+    /**
+     * @brief Load a mesh from a binary file written by saveToBin (or with the legacy layout).
+     *
+     * @param[in] binFileName the binary mesh file
+     * @param[out] ptsVisibilities if not null, the points visibilities stored in the file
+     *             (set to nullptr if the file does not contain visibilities)
+     * @return false if the file cannot be read
+     */
+    bool loadFromBin(const std::string& binFileName, StaticVector<StaticVector<int>*>** ptsVisibilities = nullptr);
+
+    /**
+     * @brief Save the mesh and optionally its points visibilities in a single binary file.
+     *
+     * Layout: "AVMB", version, #points, #triangles, has visibilities, points, triangles
+     * and visibilities as per point offsets (#points + 1) followed by the camera ids.
+     */
+    void saveToBin(const std::string& binFileName, const StaticVector<StaticVector<int>*>* ptsVisibilities = nullptr);
+
+    /// Load a mesh from an OBJ file, the file is parsed by chunks of lines in parallel
     bool loadFromObjAscii(int& nmtls, StaticVector<int>& trisMtlIds, StaticVector<Point3d>& normals,
                           StaticVector<Voxel>& trisNormalsIds, StaticVector<Point2d>& uvCoords,
                           StaticVector<Voxel>& trisUvIds, std::string objAsciiFileName);
@@ -126,7 +146,9 @@ public:
     void getDepthMap(StaticVector<float>* depthMap, StaticVector<StaticVector<int>*>* tmp, const mvsUtils::MultiViewParams* mp, int rc,
                      int scale, int w, int h);
 
+    /// triangles around each vertex (by ascending index), see MeshTopology for a compact version
     StaticVector<StaticVector<int>*>* getPtsNeighborTriangles();
+    /// ordered one-ring of each vertex, see MeshTopology for a compact version
     StaticVector<StaticVector<int>*>* getPtsNeighPtsOrdered();
 
     StaticVector<int>* getVisibleTrianglesIndexes(std::string tmpDir, const mvsUtils::MultiViewParams* mp, int rc, int w, int h);
@@ -143,13 +165,12 @@ public:
     void getNotOrientedEdges(StaticVector<StaticVector<int>*>** edgesNeighTris, StaticVector<Pixel>** edgesPointsPairs);
     StaticVector<Voxel>* getTrianglesEdgesIds(StaticVector<StaticVector<int>*>* edgesNeighTris);
 
-    StaticVector<Point3d>* getLaplacianSmoothingVectors(StaticVector<StaticVector<int>*>* ptsNeighPts,
-                                                        double maximalNeighDist = -1.0f);
+    StaticVector<Point3d>* getLaplacianSmoothingVectors(const MeshTopology& topology, double maximalNeighDist = -1.0f);
     void laplacianSmoothPts(float maximalNeighDist = -1.0f);
-    void laplacianSmoothPts(StaticVector<StaticVector<int>*>* ptsNeighPts, double maximalNeighDist = -1.0f);
+    void laplacianSmoothPts(const MeshTopology& topology, double maximalNeighDist = -1.0f);
     StaticVector<Point3d>* computeNormalsForPts();
-    StaticVector<Point3d>* computeNormalsForPts(StaticVector<StaticVector<int>*>* ptsNeighTris);
-    void smoothNormals(StaticVector<Point3d>* nms, StaticVector<StaticVector<int>*>* ptsNeighPts);
+    StaticVector<Point3d>* computeNormalsForPts(const MeshTopology& topology);
+    void smoothNormals(StaticVector<Point3d>* nms, const MeshTopology& topology);
     Point3d computeTriangleNormal(int idTri);
     Point3d computeTriangleCenterOfGravity(int idTri) const;
     double computeTriangleMaxEdgeLength(int idTri) const;
@@ -0,0 +1,261 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshBVH.hpp"
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace aliceVision {
+namespace mesh {
+
+/// subtrees with more triangles are built in separate tasks
+static const int minNbTrisPerBuildTask = 100000;
+
+MeshBVH::MeshBVH(const Mesh& mesh)
+    : _mesh(mesh)
+{
+    const int nbTris = mesh.tris->size();
+    _trisIds.resize(nbTris);
+    std::iota(_trisIds.begin(), _trisIds.end(), 0);
+
+    if(nbTris == 0)
+        return;
+
+    std::vector<Point3d> centroids(nbTris);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbTris; ++i)
+    {
+        const Mesh::triangle& t = (*mesh.tris)[i];
+        centroids[i] = ((*mesh.pts)[t.v[0]] + (*mesh.pts)[t.v[1]] + (*mesh.pts)[t.v[2]]) / 3.0;
+    }
+
+    // the layout of the nodes only depends on the number of triangles:
+    // the subtrees are built in parallel in their preallocated ranges of nodes
+    _nodes.resize(getNbNodes(nbTris));
+
+    #pragma omp parallel
+    #pragma omp single nowait
+    build(0, 0, nbTris, centroids);
+}
+
+int MeshBVH::getNbNodes(int nbTris)
+{
+    if(nbTris <= maxLeafSize)
+        return 1;
+    return 1 + getNbNodes(nbTris / 2) + getNbNodes(nbTris - nbTris / 2);
+}
+
+void MeshBVH::build(int nodeId, int first, int count, const std::vector<Point3d>& centroids)
+{
+    Node& node = _nodes[nodeId];
+
+    // bounding box of the triangles, rounded outward to stay conservative in float
+    Point3d bboxMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bboxMax = -bboxMin;
+    Point3d centroidsMin = bboxMin;
+    Point3d centroidsMax = bboxMax;
+    for(int i = first; i < first + count; ++i)
+    {
+        const Mesh::triangle& t = (*_mesh.tris)[_trisIds[i]];
+        for(int k = 0; k < 3; ++k)
+        {
+            const Point3d& p = (*_mesh.pts)[t.v[k]];
+            for(int d = 0; d < 3; ++d)
+            {
+                bboxMin.m[d] = std::min(bboxMin.m[d], p.m[d]);
+                bboxMax.m[d] = std::max(bboxMax.m[d], p.m[d]);
+            }
+        }
+        const Point3d& c = centroids[_trisIds[i]];
+        for(int d = 0; d < 3; ++d)
+        {
+            centroidsMin.m[d] = std::min(centroidsMin.m[d], c.m[d]);
+            centroidsMax.m[d] = std::max(centroidsMax.m[d], c.m[d]);
+        }
+    }
+    for(int d = 0; d < 3; ++d)
+    {
+        node.bboxMin[d] = std::nextafter(static_cast<float>(bboxMin.m[d]), -std::numeric_limits<float>::max());
+        node.bboxMax[d] = std::nextafter(static_cast<float>(bboxMax.m[d]), std::numeric_limits<float>::max());
+    }
+
+    if(count <= maxLeafSize)
+    {
+        node.first = first;
+        node.count = count;
+        return;
+    }
+
+    // median split on the largest axis of the centroids
+    const Point3d extent = centroidsMax - centroidsMin;
+    int axis = 0;
+    if(extent.y > extent.m[axis])
+        axis = 1;
+    if(extent.z > extent.m[axis])
+        axis = 2;
+
+    const int leftCount = count / 2;
+    std::nth_element(_trisIds.begin() + first, _trisIds.begin() + first + leftCount, _trisIds.begin() + first + count,
+                     [&](int a, int b) { return centroids[a].m[axis] < centroids[b].m[axis]; });
+
+    const int leftId = nodeId + 1;
+    const int rightId = nodeId + 1 + getNbNodes(leftCount);
+    node.first = rightId;
+    node.count = 0;
+
+    if(count > minNbTrisPerBuildTask)
+    {
+        // shared: a reference is firstprivate by default, the centroids would be copied for each task
+        #pragma omp task shared(centroids)
+        build(leftId, first, leftCount, centroids);
+        build(rightId, first + leftCount, count - leftCount, centroids);
+        #pragma omp taskwait
+    }
+    else
+    {
+        build(leftId, first, leftCount, centroids);
+        build(rightId, first + leftCount, count - leftCount, centroids);
+    }
+}
+
+double MeshBVH::getSqDistToBBox(const Point3d& p, const Node& node) const
+{
+    double sqDist = 0.0;
+    for(int d = 0; d < 3; ++d)
+    {
+        if(p.m[d] < node.bboxMin[d])
+            sqDist += (node.bboxMin[d] - p.m[d]) * (node.bboxMin[d] - p.m[d]);
+        else if(p.m[d] > node.bboxMax[d])
+            sqDist += (p.m[d] - node.bboxMax[d]) * (p.m[d] - node.bboxMax[d]);
+    }
+    return sqDist;
+}
+
+double MeshBVH::getClosestPointOnTriangle(const Point3d& p, int triangleId, std::array<double, 3>& out_barycentricCoords) const
+{
+    // Real-Time Collision Detection (Ericson), ClosestPtPointTriangle
+    const Mesh::triangle& t = (*_mesh.tris)[triangleId];
+    const Point3d& a = (*_mesh.pts)[t.v[0]];
+    const Point3d& b = (*_mesh.pts)[t.v[1]];
+    const Point3d& c = (*_mesh.pts)[t.v[2]];
+
+    const auto sqDistTo = [&](double u, double v, double w) {
+        out_barycentricCoords = {{u, v, w}};
+        return (p - (a * u + b * v + c * w)).size2();
+    };
+
+    const Point3d ab = b - a;
+    const Point3d ac = c - a;
+    const Point3d ap = p - a;
+    const double d1 = dot(ab, ap);
+    const double d2 = dot(ac, ap);
+    if(d1 <= 0.0 && d2 <= 0.0)
+        return sqDistTo(1.0, 0.0, 0.0);
+
+    const Point3d bp = p - b;
+    const double d3 = dot(ab, bp);
+    const double d4 = dot(ac, bp);
+    if(d3 >= 0.0 && d4 <= d3)
+        return sqDistTo(0.0, 1.0, 0.0);
+
+    const double vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+        const double v = d1 / (d1 - d3);
+        return sqDistTo(1.0 - v, v, 0.0);
+    }
+
+    const Point3d cp = p - c;
+    const double d5 = dot(ab, cp);
+    const double d6 = dot(ac, cp);
+    if(d6 >= 0.0 && d5 <= d6)
+        return sqDistTo(0.0, 0.0, 1.0);
+
+    const double vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+        const double w = d2 / (d2 - d6);
+        return sqDistTo(1.0 - w, 0.0, w);
+    }
+
+    const double va = d3 * d6 - d5 * d4;
+    if(va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+        const double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        return sqDistTo(0.0, 1.0 - w, w);
+    }
+
+    const double sum = va + vb + vc;
+    if(sum <= 0.0)
+    {
+        // degenerated triangle: nearest vertex
+        const double da = ap.size2();
+        const double db = bp.size2();
+        const double dc = cp.size2();
+        if(da <= db && da <= dc)
+            return sqDistTo(1.0, 0.0, 0.0);
+        return (db <= dc) ? sqDistTo(0.0, 1.0, 0.0) : sqDistTo(0.0, 0.0, 1.0);
+    }
+    const double v = vb / sum;
+    const double w = vc / sum;
+    return sqDistTo(1.0 - v - w, v, w);
+}
+
+int MeshBVH::getNearestTriangle(const Point3d& p, double& inout_sqDist) const
+{
+    if(_nodes.empty())
+        return -1;
+
+    int nearestTriangle = -1;
+    std::array<double, 3> barycentricCoords;
+
+    // depth first traversal, the nearest child first
+    std::array<int, 64> stack;
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while(stackSize > 0)
+    {
+        const int nodeId = stack[--stackSize];
+        const Node& node = _nodes[nodeId];
+        if(getSqDistToBBox(p, node) >= inout_sqDist)
+            continue;
+
+        if(node.count > 0)
+        {
+            for(int i = node.first; i < node.first + node.count; ++i)
+            {
+                const double sqDist = getClosestPointOnTriangle(p, _trisIds[i], barycentricCoords);
+                if(sqDist < inout_sqDist)
+                {
+                    inout_sqDist = sqDist;
+                    nearestTriangle = _trisIds[i];
+                }
+            }
+            continue;
+        }
+
+        const int leftId = nodeId + 1;
+        const int rightId = node.first;
+        const double leftSqDist = getSqDistToBBox(p, _nodes[leftId]);
+        const double rightSqDist = getSqDistToBBox(p, _nodes[rightId]);
+        const bool leftFirst = leftSqDist <= rightSqDist;
+        const int nearId = leftFirst ? leftId : rightId;
+        const int farId = leftFirst ? rightId : leftId;
+        if(std::max(leftSqDist, rightSqDist) < inout_sqDist)
+            stack[stackSize++] = farId;
+        if(std::min(leftSqDist, rightSqDist) < inout_sqDist)
+            stack[stackSize++] = nearId;
+    }
+
+    return nearestTriangle;
+}
+
+} // namespace mesh
+} // namespace aliceVision
@@ -0,0 +1,83 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <aliceVision/mvsData/Point3d.hpp>
+
+#include <array>
+#include <limits>
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+/**
+ * @brief Bounding volume hierarchy (AABB tree) over the triangles of a mesh, for nearest triangle queries.
+ *
+ * The tree is built once, in parallel, by median splits of the triangles centroids on the largest axis.
+ * The queries are const and can be done in parallel.
+ * @note The mesh is referenced and has to outlive the BVH.
+ */
+class MeshBVH
+{
+public:
+    explicit MeshBVH(const Mesh& mesh);
+
+    /**
+     * @brief Find the nearest triangle of a point.
+     * @param[in] p the point
+     * @param[in,out] inout_sqDist the squared search radius, updated with the squared distance to the nearest triangle
+     * @return the nearest triangle, -1 if there is no triangle in the search radius
+     *         (or if the distances can't be computed: non finite point or triangles)
+     */
+    int getNearestTriangle(const Point3d& p, double& inout_sqDist) const;
+
+    /// @see getNearestTriangle(const Point3d&, double&)
+    int getNearestTriangle(const Point3d& p) const
+    {
+        double sqDist = std::numeric_limits<double>::max();
+        return getNearestTriangle(p, sqDist);
+    }
+
+    /**
+     * @brief Closest point of a triangle.
+     * @param[in] p the point
+     * @param[in] triangleId the triangle
+     * @param[out] out_barycentricCoords barycentric coordinates of the closest point
+     * @return the squared distance between the point and the triangle
+     */
+    double getClosestPointOnTriangle(const Point3d& p, int triangleId, std::array<double, 3>& out_barycentricCoords) const;
+
+private:
+    struct Node
+    {
+        /// conservative bounding box (rounded outward)
+        std::array<float, 3> bboxMin;
+        std::array<float, 3> bboxMax;
+        /// first triangle in _trisIds for a leaf, index of the right child otherwise (the left child is the next node)
+        int first;
+        /// number of triangles of a leaf, 0 otherwise
+        int count;
+    };
+
+    static const int maxLeafSize = 8;
+
+    /// number of nodes of a subtree of nbTris triangles
+    static int getNbNodes(int nbTris);
+
+    void build(int nodeId, int first, int count, const std::vector<Point3d>& centroids);
+
+    double getSqDistToBBox(const Point3d& p, const Node& node) const;
+
+    const Mesh& _mesh;
+    std::vector<Node> _nodes;
+    std::vector<int> _trisIds;
+};
+
+} // namespace mesh
+} // namespace aliceVision
@@ -663,15 +663,8 @@ void MeshClean::init()
 {
     deallocateCleaningAttributes();
 
+    // already sorted by ascending triangle index
     ptsNeighTrisSortedAsc = getPtsNeighborTriangles();
-    for(int i = 0; i < pts->size(); i++)
-    {
-        StaticVector<int>* ptNeigTris = (*ptsNeighTrisSortedAsc)[i];
-        if(sizeOfStaticVector<int>(ptNeigTris) > 1)
-        {
-            qsort(&(*ptNeigTris)[0], ptNeigTris->size(), sizeof(int), qSortCompareIntAsc);
-        }
-    }
 
     ptsNeighPtsOrdered = new StaticVector<StaticVector<int>*>();
     ptsNeighPtsOrdered->reserve(pts->size());
@@ -4,10 +4,15 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "MeshEnergyOpt.hpp"
+#include "MeshTopology.hpp"
 #include <aliceVision/system/Logger.hpp>
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -22,60 +27,31 @@ MeshEnergyOpt::MeshEnergyOpt(mvsUtils::MultiViewParams* _mp)
 
 MeshEnergyOpt::~MeshEnergyOpt() = default;
 
-StaticVector<Point3d>* MeshEnergyOpt::computeLaplacianPtsParallel()
-{
-    StaticVector<Point3d>* lapPts = new StaticVector<Point3d>();
-    lapPts->reserve(pts->size());
-    lapPts->resize_with(pts->size(), Point3d(0.0f, 0.0f, 0.f));
-    int nlabpts = 0;
-
-#pragma omp parallel for
-    for(int i = 0; i < pts->size(); i++)
-    {
-        Point3d lapPt;
-        if(getLaplacianSmoothingVector(i, lapPt))
-        {
-            (*lapPts)[i] = lapPt;
-            nlabpts++;
-        }
-    }
-
-    return lapPts;
-}
+namespace {
 
-void MeshEnergyOpt::updateGradientParallel(float lambda, const Point3d& LU,
-                                                const Point3d& RD, StaticVectorBool* ptsCanMove)
+/// coordinates of the vertices in separate arrays
+struct PointsSoA
 {
-    // printf("nlabpts %i of %i\n",nlabpts,pts->size());
-    StaticVector<Point3d>* lapPts = computeLaplacianPtsParallel();
-
-    StaticVector<Point3d>* newPts = new StaticVector<Point3d>();
-    newPts->reserve(pts->size());
-    newPts->push_back_arr(pts);
-
-#pragma omp parallel for
-    for(int i = 0; i < pts->size(); ++i)
-    {
-        if((ptsCanMove == nullptr) || ((*ptsCanMove)[i]))
-        {
-            Point3d n;
-
-            if(getBiLaplacianSmoothingVector(i, lapPts, n))
-            {
-                Point3d p = (*newPts)[i] + n * lambda;
-                if((p.x > LU.x) && (p.y > LU.y) && (p.z > LU.z) && (p.x < RD.x) && (p.y < RD.y) && (p.z < RD.z))
-                {
-                    (*newPts)[i] = p;
-                }
-            }
-        }
-    }
-
-    delete pts;
-    pts = newPts;
-    delete lapPts;
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> z;
+
+    explicit PointsSoA(int size)
+        : x(size, 0.0)
+        , y(size, 0.0)
+        , z(size, 0.0)
+    {}
+};
+
+inline bool isValidSmoothingVector(double x, double y, double z)
+{
+    // zero (or undefined) vectors are the invalid ones, as they cannot be normalized
+    const double d2 = x * x + y * y + z * z;
+    return d2 > 0.0 && std::isfinite(d2);
 }
 
+} // namespace
+
 bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove)
 {
     if(pts->size() <= 4)
@@ -102,14 +78,124 @@ bool MeshEnergyOpt::optimizeSmooth(float lambda, int niter, StaticVectorBool* pt
                          << "\t- lamda: " << lambda << std::endl
                          << "\t- niters: " << niter << std::endl);
 
-    for(int i = 0; i < niter; i++)
+    const int nbPts = pts->size();
+
+    // ordered one-ring of each vertex
+    const MeshTopology topology(*this);
+
+    // weights of the Laplacian (mean of the one-ring) and of the bi-Laplacian step [Kobbelt et al 98, eq (8)]
+    // a null bi-Laplacian weight means the vertex does not move
+    std::vector<double> lapWeights(nbPts, 0.0);
+    std::vector<double> biLapWeights(nbPts, 0.0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const MeshTopology::IndexRange ptNeighPts = topology.getPtNeighPts(i);
+        if(ptNeighPts.empty())
+            continue;
+        lapWeights[i] = 1.0 / static_cast<double>(ptNeighPts.size());
+
+        if((ptsCanMove != nullptr && !(*ptsCanMove)[i]) || topology.getPtNeighTris(i).empty())
+            continue;
+
+        float sum = 0.0f;
+        for(int neighPtId : ptNeighPts)
+        {
+            const int neighValence = topology.getPtNeighPts(neighPtId).size();
+            if(neighValence > 0)
+                sum += 1.0f / (float)neighValence;
+        }
+        const float v = 1.0f + (1.0f / (float)ptNeighPts.size()) * sum;
+        biLapWeights[i] = -static_cast<double>(lambda) / v;
+    }
+
+    PointsSoA points(nbPts);
+    PointsSoA laplacians(nbPts);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        points.x[i] = (*pts)[i].x;
+        points.y[i] = (*pts)[i].y;
+        points.z[i] = (*pts)[i].z;
+    }
+
+    const auto copyPointsToMesh = [&]() {
+        #pragma omp parallel for
+        for(int i = 0; i < nbPts; ++i)
+            (*pts)[i] = Point3d(points.x[i], points.y[i], points.z[i]);
+    };
+
+    for(int iter = 0; iter < niter; ++iter)
     {
-        ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << i);
-        updateGradientParallel(lambda, LU, RD, ptsCanMove);
+        ALICEVISION_LOG_INFO("Optimizing mesh smooth: iteration " << iter);
+
+        // Laplacian of the vertices [Ohtake et al 00, eq (3)], zero if undefined
+        #pragma omp parallel for
+        for(int i = 0; i < nbPts; ++i)
+        {
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+            bool hasNullNeighPt = false;
+            for(int j : topology.getPtNeighPts(i))
+            {
+                sx += points.x[j];
+                sy += points.y[j];
+                sz += points.z[j];
+                hasNullNeighPt |= (points.x[j] == 0.0) & (points.y[j] == 0.0) & (points.z[j] == 0.0);
+            }
+            double lx = sx * lapWeights[i] - points.x[i];
+            double ly = sy * lapWeights[i] - points.y[i];
+            double lz = sz * lapWeights[i] - points.z[i];
+            if(lapWeights[i] == 0.0 || hasNullNeighPt || !isValidSmoothingVector(lx, ly, lz))
+                lx = ly = lz = 0.0;
+            laplacians.x[i] = lx;
+            laplacians.y[i] = ly;
+            laplacians.z[i] = lz;
+        }
+
+        // bi-Laplacian step, the Laplacians are only read so the points are updated in place
+        #pragma omp parallel for
+        for(int i = 0; i < nbPts; ++i)
+        {
+            if(biLapWeights[i] == 0.0)
+                continue;
+
+            double sx = 0.0, sy = 0.0, sz = 0.0;
+            bool hasNullNeighLap = false;
+            for(int j : topology.getPtNeighPts(i))
+            {
+                sx += laplacians.x[j];
+                sy += laplacians.y[j];
+                sz += laplacians.z[j];
+                hasNullNeighLap |= (laplacians.x[j] == 0.0) & (laplacians.y[j] == 0.0) & (laplacians.z[j] == 0.0);
+            }
+            const double tx = sx * lapWeights[i] - laplacians.x[i];
+            const double ty = sy * lapWeights[i] - laplacians.y[i];
+            const double tz = sz * lapWeights[i] - laplacians.z[i];
+            if(hasNullNeighLap || !isValidSmoothingVector(tx, ty, tz))
+                continue;
+
+            const double px = points.x[i] + tx * biLapWeights[i];
+            const double py = points.y[i] + ty * biLapWeights[i];
+            const double pz = points.z[i] + tz * biLapWeights[i];
+            if((px > LU.x) && (py > LU.y) && (pz > LU.z) && (px < RD.x) && (py < RD.y) && (pz < RD.z))
+            {
+                points.x[i] = px;
+                points.y[i] = py;
+                points.z[i] = pz;
+            }
+        }
+
         if(saveDebug)
-            saveToObj(mp->mvDir + "mesh_smoothed_" + std::to_string(i) + ".obj");
+        {
+            copyPointsToMesh();
+            saveToObj(mp->mvDir + "mesh_smoothed_" + std::to_string(iter) + ".obj");
+        }
     }
 
+    copyPointsToMesh();
+
     return true;
 }
 
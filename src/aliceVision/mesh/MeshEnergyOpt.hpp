@@ -18,11 +18,16 @@ public:
     explicit MeshEnergyOpt(mvsUtils::MultiViewParams* _mp);
     ~MeshEnergyOpt();
 
+    /**
+     * @brief Bi-Laplacian smoothing of the vertices [Kobbelt et al 98].
+     * The one-ring of each vertex comes from a MeshTopology, the smoothing weights are computed once
+     * and the coordinates are stored in separate arrays (SoA), so the iterations run without allocation.
+     * @param[in] lambda the smoothing step
+     * @param[in] niter the number of iterations
+     * @param[in] ptsCanMove the vertices allowed to move (all if nullptr)
+     * @return false if the mesh is too small to be smoothed
+     */
     bool optimizeSmooth(float lambda, int niter, StaticVectorBool* ptsCanMove);
-
-private:
-    StaticVector<Point3d>* computeLaplacianPtsParallel();
-    void updateGradientParallel(float lambda, const Point3d& LU, const Point3d& RD, StaticVectorBool* ptsCanMove);
 };
 
 } // namespace mesh
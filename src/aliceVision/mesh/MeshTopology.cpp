@@ -0,0 +1,190 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include "MeshTopology.hpp"
+#include <aliceVision/mesh/Mesh.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace aliceVision {
+namespace mesh {
+
+/**
+ * @brief Compute the one-ring of a vertex, ordered by walking through its neighbor triangles.
+ *
+ * @param[in] mesh the mesh
+ * @param[in] middlePtId the vertex
+ * @param[in,out] neighborTriangles the triangles around the vertex (consumed)
+ * @param[out] path temporary buffer
+ * @param[out] ring the ordered one-ring, without duplicates
+ */
+static void computePtNeighPtsOrdered(const Mesh& mesh, int middlePtId, std::vector<int>& neighborTriangles,
+                                     std::vector<int>& path, std::vector<int>& ring)
+{
+    const StaticVector<Point3d>& pts = *mesh.pts;
+    const StaticVector<Mesh::triangle>& tris = *mesh.tris;
+
+    ring.clear();
+    path.clear();
+
+    if(neighborTriangles.empty())
+        return;
+
+    // start the walk from a vertex of the first triangle other than the middle one
+    const Mesh::triangle& firstTri = tris[neighborTriangles[0]];
+    int currentTriPtId = (firstTri.v[0] != middlePtId) ? firstTri.v[0] : firstTri.v[1];
+    const int firstTriPtId = currentTriPtId;
+    path.push_back(currentTriPtId);
+
+    // walk around the vertex from the first triangle, then from the other side of its first vertex
+    // if the walk stopped on a border before using all the triangles
+    for(int side = 0; side < 2 && !neighborTriangles.empty(); ++side)
+    {
+        if(side == 1)
+        {
+            std::reverse(path.begin(), path.end());
+            currentTriPtId = firstTriPtId;
+        }
+
+        bool isThereTWithCurrentTriPtId = true;
+        while(!neighborTriangles.empty() && isThereTWithCurrentTriPtId)
+        {
+            isThereTWithCurrentTriPtId = false;
+
+            // find triangle with middlePtId and currentTriPtId and get remaining point id
+            for(std::size_t n = 0; n < neighborTriangles.size(); ++n)
+            {
+                bool ok_middlePtId = false;
+                bool ok_actTriPtId = false;
+                int remainingPtId = -1; // remaining pt id
+                for(int k = 0; k < 3; ++k)
+                {
+                    const int triPtId = tris[neighborTriangles[n]].v[k];
+                    const double length = (pts[middlePtId] - pts[triPtId]).size();
+                    if((triPtId != middlePtId) && (triPtId != currentTriPtId) && (length > 0.0) && (!std::isnan(length)))
+                        remainingPtId = triPtId;
+                    if(triPtId == middlePtId)
+                        ok_middlePtId = true;
+                    if(triPtId == currentTriPtId)
+                        ok_actTriPtId = true;
+                }
+
+                if(ok_middlePtId && ok_actTriPtId && (remainingPtId > -1))
+                {
+                    currentTriPtId = remainingPtId;
+                    neighborTriangles.erase(neighborTriangles.begin() + n);
+                    path.push_back(currentTriPtId);
+                    isThereTWithCurrentTriPtId = true; // we removed one, so we try again
+                    break;
+                }
+            }
+        }
+
+        if(side == 0 && currentTriPtId == firstTriPtId)
+            path.pop_back(); // remove last ... which is first
+    }
+
+    // remove duplicates
+    for(int ptId : path)
+    {
+        if(std::find(ring.begin(), ring.end(), ptId) == ring.end())
+            ring.push_back(ptId);
+    }
+}
+
+MeshTopology::MeshTopology(const Mesh& mesh, bool withPtsNeighPts)
+{
+    build(mesh, withPtsNeighPts);
+}
+
+void MeshTopology::build(const Mesh& mesh, bool withPtsNeighPts)
+{
+    const StaticVector<Mesh::triangle>& tris = *mesh.tris;
+    const int npts = mesh.pts->size();
+    const int ntris = tris.size();
+
+    // count the triangles around each vertex
+    _ptsNeighTrisOffsets.assign(npts + 1, 0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < ntris; ++i)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            #pragma omp atomic
+            ++_ptsNeighTrisOffsets[tris[i].v[k] + 1];
+        }
+    }
+
+    for(int i = 0; i < npts; ++i)
+        _ptsNeighTrisOffsets[i + 1] += _ptsNeighTrisOffsets[i];
+
+    // fill the triangles around each vertex
+    _ptsNeighTris.resize(_ptsNeighTrisOffsets.back());
+    {
+        std::vector<int> fillPos(_ptsNeighTrisOffsets.begin(), _ptsNeighTrisOffsets.end() - 1);
+
+        #pragma omp parallel for
+        for(int i = 0; i < ntris; ++i)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                int pos;
+                #pragma omp atomic capture
+                pos = fillPos[tris[i].v[k]]++;
+                _ptsNeighTris[pos] = i;
+            }
+        }
+    }
+
+    // the filling order depends on the threads: sort the triangles of each vertex
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(int i = 0; i < npts; ++i)
+        std::sort(_ptsNeighTris.begin() + _ptsNeighTrisOffsets[i], _ptsNeighTris.begin() + _ptsNeighTrisOffsets[i + 1]);
+
+    _ptsNeighPtsOffsets.clear();
+    _ptsNeighPts.clear();
+
+    if(!withPtsNeighPts)
+        return;
+
+    // the one-ring of a vertex has at most 2 vertices per neighbor triangle:
+    // compute each ring in a slot of this size, then compact the rings
+    std::vector<int> rings(2 * _ptsNeighTris.size());
+    _ptsNeighPtsOffsets.assign(npts + 1, 0);
+
+    #pragma omp parallel
+    {
+        std::vector<int> neighborTriangles;
+        std::vector<int> path;
+        std::vector<int> ring;
+
+        #pragma omp for schedule(dynamic, 4096)
+        for(int i = 0; i < npts; ++i)
+        {
+            const IndexRange ptNeighTris = getPtNeighTris(i);
+            neighborTriangles.assign(ptNeighTris.begin(), ptNeighTris.end());
+            computePtNeighPtsOrdered(mesh, i, neighborTriangles, path, ring);
+            std::copy(ring.begin(), ring.end(), rings.begin() + 2 * _ptsNeighTrisOffsets[i]);
+            _ptsNeighPtsOffsets[i + 1] = ring.size();
+        }
+    }
+
+    for(int i = 0; i < npts; ++i)
+        _ptsNeighPtsOffsets[i + 1] += _ptsNeighPtsOffsets[i];
+
+    _ptsNeighPts.resize(_ptsNeighPtsOffsets.back());
+
+    #pragma omp parallel for
+    for(int i = 0; i < npts; ++i)
+    {
+        const auto first = rings.begin() + 2 * _ptsNeighTrisOffsets[i];
+        std::copy(first, first + (_ptsNeighPtsOffsets[i + 1] - _ptsNeighPtsOffsets[i]), _ptsNeighPts.begin() + _ptsNeighPtsOffsets[i]);
+    }
+}
+
+} // namespace mesh
+} // namespace aliceVision
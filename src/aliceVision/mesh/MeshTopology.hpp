@@ -0,0 +1,84 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#pragma once
+
+#include <vector>
+
+namespace aliceVision {
+namespace mesh {
+
+class Mesh;
+
+/**
+ * @brief Compact (CSR) vertex adjacency of a triangle mesh.
+ *
+ * The neighbors of the vertex i are stored in [offsets[i]; offsets[i+1][
+ * of a single array, instead of one heap allocated StaticVector per vertex.
+ * The structure is built once, in parallel, and is read-only: it has to be
+ * rebuilt if the mesh connectivity changes.
+ */
+class MeshTopology
+{
+public:
+    /// contiguous range of indexes
+    class IndexRange
+    {
+    public:
+        IndexRange(const int* first, const int* last)
+            : _first(first)
+            , _last(last)
+        {}
+
+        const int* begin() const { return _first; }
+        const int* end() const { return _last; }
+        int size() const { return static_cast<int>(_last - _first); }
+        bool empty() const { return _first == _last; }
+        int operator[](int i) const { return _first[i]; }
+
+    private:
+        const int* _first;
+        const int* _last;
+    };
+
+    MeshTopology() = default;
+
+    /**
+     * @brief Build the adjacency of the given mesh.
+     * @param[in] mesh the mesh
+     * @param[in] withPtsNeighPts also compute the ordered one-ring of each vertex
+     */
+    explicit MeshTopology(const Mesh& mesh, bool withPtsNeighPts = true);
+
+    /// @see MeshTopology(const Mesh&, bool)
+    void build(const Mesh& mesh, bool withPtsNeighPts = true);
+
+    int getNbPts() const { return _ptsNeighTrisOffsets.empty() ? 0 : static_cast<int>(_ptsNeighTrisOffsets.size()) - 1; }
+
+    bool hasPtsNeighPts() const { return !_ptsNeighPtsOffsets.empty(); }
+
+    /// triangles around the vertex \p ptId, by ascending index
+    IndexRange getPtNeighTris(int ptId) const
+    {
+        return IndexRange(_ptsNeighTris.data() + _ptsNeighTrisOffsets[ptId],
+                          _ptsNeighTris.data() + _ptsNeighTrisOffsets[ptId + 1]);
+    }
+
+    /// vertices of the one-ring of the vertex \p ptId, ordered by path around the vertex
+    IndexRange getPtNeighPts(int ptId) const
+    {
+        return IndexRange(_ptsNeighPts.data() + _ptsNeighPtsOffsets[ptId],
+                          _ptsNeighPts.data() + _ptsNeighPtsOffsets[ptId + 1]);
+    }
+
+private:
+    std::vector<int> _ptsNeighTrisOffsets;
+    std::vector<int> _ptsNeighTris;
+    std::vector<int> _ptsNeighPtsOffsets;
+    std::vector<int> _ptsNeighPts;
+};
+
+} // namespace mesh
+} // namespace aliceVision
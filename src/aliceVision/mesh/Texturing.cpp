@@ -5,6 +5,7 @@
 
 #include "Texturing.hpp"
 #include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/MemoryInfo.hpp>
 #include <aliceVision/numeric/numeric.hpp>
 #include <aliceVision/mvsData/Color.hpp>
 #include <aliceVision/mvsData/geometry.hpp>
@@ -18,6 +19,7 @@
 #include <geogram/parameterization/mesh_atlas_maker.h>
 
 #include <map>
+#include <numeric>
 #include <set>
 
 namespace aliceVision {
@@ -73,6 +75,92 @@ bool isPixelInTriangle(const Point2d* triangle, const Pixel& pixel, Point2d& bar
     return dist < 0.5 + std::numeric_limits<double>::epsilon();
 }
 
+/**
+ * @brief Rasterize a 2D triangle: call \p func(x, y, barycentricCoords) for each pixel
+ *        of the [LU; RD[ box contained in or intersected by the triangle.
+ *
+ * Same result as testing each pixel with isPixelInTriangle, but the pixels are
+ * classified incrementally with the edge functions of the triangle. Only the pixels
+ * outside the triangle and close to one of its edges need an exact distance computation.
+ *
+ * @param[in] triangle the triangle as an array of 3 point2Ds
+ * @param[in] LU the top-left corner of the box to rasterize
+ * @param[in] RD the bottom-right corner (excluded) of the box to rasterize
+ * @param[in] func the function to call for each pixel of the triangle
+ */
+template <typename PixelFunc>
+void rasterizeTriangle(const Point2d* triangle, const Pixel& LU, const Pixel& RD, PixelFunc&& func)
+{
+    const Point2d e1 = triangle[1] - triangle[0];
+    const Point2d e2 = triangle[2] - triangle[0];
+    const double area = e1.x * e2.y - e1.y * e2.x;
+
+    // tolerance threshold of 1/2 pixel for pixels on the edges of the triangle (see isPixelInTriangle)
+    const double maxSqrDist = 0.5 + std::numeric_limits<double>::epsilon();
+
+    if(std::abs(area) < std::numeric_limits<double>::epsilon())
+    {
+        // degenerated triangle: exact test for each pixel
+        for(int y = LU.y; y < RD.y; ++y)
+        {
+            for(int x = LU.x; x < RD.x; ++x)
+            {
+                Point2d barycCoords;
+                if(isPixelInTriangle(triangle, Pixel(x, y), barycCoords))
+                    func(x, y, barycCoords);
+            }
+        }
+        return;
+    }
+
+    // barycentric coordinates l1 (triangle[1]) and l2 (triangle[2]) are linear in the pixel position
+    const double dl1dx = e2.y / area;
+    const double dl1dy = -e2.x / area;
+    const double dl2dx = -e1.y / area;
+    const double dl2dy = e1.x / area;
+
+    // squared heights of the triangle, to get the distance of a pixel to each edge line
+    // from its barycentric coordinates
+    const double sqrArea = area * area;
+    const Point2d e12 = triangle[2] - triangle[1];
+    const double sqrHeight0 = sqrArea / dot(e12, e12);
+    const double sqrHeight1 = sqrArea / dot(e2, e2);
+    const double sqrHeight2 = sqrArea / dot(e1, e1);
+
+    for(int y = LU.y; y < RD.y; ++y)
+    {
+        // barycentric coordinates of the first pixel center of the row
+        const double dx = LU.x + 0.5 - triangle[0].x;
+        const double dy = y + 0.5 - triangle[0].y;
+        double l1 = dl1dx * dx + dl1dy * dy;
+        double l2 = dl2dx * dx + dl2dy * dy;
+
+        for(int x = LU.x; x < RD.x; ++x, l1 += dl1dx, l2 += dl2dx)
+        {
+            const double l0 = 1.0 - l1 - l2;
+
+            if(l0 >= 0.0 && l1 >= 0.0 && l2 >= 0.0)
+            {
+                // pixel center inside the triangle
+                func(x, y, Point2d(l2, l1));
+                continue;
+            }
+
+            // the distance to the triangle is larger than the distance to the line of any
+            // edge the pixel center is outside of
+            if((l0 < 0.0 && l0 * l0 * sqrHeight0 > maxSqrDist) ||
+               (l1 < 0.0 && l1 * l1 * sqrHeight1 > maxSqrDist) ||
+               (l2 < 0.0 && l2 * l2 * sqrHeight2 > maxSqrDist))
+                continue;
+
+            // close to an edge: exact test
+            Point2d barycCoords;
+            if(isPixelInTriangle(triangle, Pixel(x, y), barycCoords))
+                func(x, y, barycCoords);
+        }
+    }
+}
+
 Point2d barycentricToCartesian(const Point2d* triangle, const Point2d& coords)
 {
     return triangle[0] + (triangle[2] - triangle[0]) * coords.x + (triangle[1] - triangle[0]) * coords.y;
@@ -230,15 +318,6 @@ void Texturing::generateUVs(mvsUtils::MultiViewParams& mp)
     deleteArrayOfArrays<int>(&updatedPointsCams);
 }
 
-void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
-                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
-{
-    mvsUtils::ImagesCache imageCache(&mp, 0, false);
-    for(size_t atlasID = 0; atlasID < _atlases.size(); ++atlasID)
-        generateTexture(mp, atlasID, imageCache, outPath, textureFileType);
-}
-
-
 /// accumulates colors and keeps count for providing average
 struct AccuColor {
     Color colorSum;
@@ -267,122 +346,19 @@ struct AccuColor {
 };
 
 
-void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
-                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+/**
+ * @brief Pad the edges of a texture atlas, compute the final (average) color of each pixel,
+ *        fill the holes, downscale and write the texture file.
+ *
+ * The accumulation buffers are released as soon as possible.
+ */
+void writeTexture(const TexturingParams& texParams, std::vector<int>& colorIDs, std::vector<AccuColor>& perPixelColors,
+                  const bfs::path& texturePath)
 {
-    if(atlasID >= _atlases.size())
-        throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
-
-    unsigned int textureSize = texParams.textureSide * texParams.textureSide;
-    std::vector<int> colorIDs(textureSize, -1);
-
-    std::vector<std::vector<unsigned int>> camTriangles(mp.ncams);
-
-    ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
-              << " (" << _atlases[atlasID].size() << " triangles).");
-
-    // iterate over atlas' triangles
-    for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
-    {
-        int triangleId = _atlases[atlasID][i];
-
-        std::set<int> triCams;
-        // retrieve triangle visibilities (set of triangle's points visibilities)
-        for(int k = 0; k < 3; k++)
-        {
-            const int pointIndex = (*me->tris)[triangleId].v[k];
-            const StaticVector<int>* pointVisibilities = (*pointsVisibilities)[pointIndex];
-            if(pointVisibilities != nullptr)
-            {
-                std::copy(pointVisibilities->begin(), pointVisibilities->end(), std::inserter(triCams, triCams.end()));
-            }
-        }
-        // register this triangle in cameras seeing it
-        for(int camId : triCams)
-            camTriangles[camId].push_back(triangleId);
-    }
-
-    ALICEVISION_LOG_INFO("Reading pixel color.");
-
-    std::vector<AccuColor> perPixelColors(textureSize);
-
-    // iterate over triangles for each camera
-    int camId = 0;
-    for(const std::vector<unsigned int>& triangles : camTriangles)
-    {
-        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
-
-        for(const auto& triangleId : triangles)
-        {
-            // retrieve triangle 3D and UV coordinates
-            Point2d triPixs[3];
-            Point3d triPts[3];
-
-            for(int k = 0; k < 3; k++)
-            {
-                const int pointIndex = (*me->tris)[triangleId].v[k];
-                triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
-                const int uvPointIndex = trisUvIds[triangleId].m[k];
-                triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
-            }
-
-            // compute triangle bounding box in pixel indexes
-            // min values: floor(value)
-            // max values: ceil(value)
-            Pixel LU, RD;
-            LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-            RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
-            RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
-
-            // sanity check: clamp values to [0; textureSide]
-            int texSide = static_cast<int>(texParams.textureSide);
-            LU.x = clamp(LU.x, 0, texSide);
-            LU.y = clamp(LU.y, 0, texSide);
-            RD.x = clamp(RD.x, 0, texSide);
-            RD.y = clamp(RD.y, 0, texSide);
-
-            // iterate over bounding box's pixels
-            for(int y = LU.y; y < RD.y; y++)
-            {
-                for(int x = LU.x; x < RD.x; x++)
-                {
-                    Pixel pix(x, y); // top-left corner of the pixel
-                    Point2d barycCoords;
-
-                    // test if the pixel is inside triangle
-                    // and retrieve its barycentric coordinates
-                    if(!isPixelInTriangle(triPixs, pix, barycCoords))
-                    {
-                        continue;
-                    }
-
-                    // remap 'y' to image coordinates system (inverted Y axis)
-                    const unsigned int y_ = (texParams.textureSide - 1) - y;
-                    // 1D pixel index
-                    unsigned int xyoffset = y_ * texParams.textureSide + x;
-                    // get 3D coordinates
-                    Point3d pt3d = barycentricToCartesian(triPts, barycCoords);
-                    // get 2D coordinates in source image
-                    Point2d pixRC;
-                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
-                    // exclude out of bounds pixels
-                    if(!mp.isPixelInImage(pixRC, camId))
-                        continue;
-                    // fill the colorID map
-                    colorIDs[xyoffset] = xyoffset;
-                    // fill the accumulated color map for this pixel
-                    perPixelColors[xyoffset] += imageCache.getPixelValueInterpolated(&pixRC, camId);
-                }
-            }
-        }
-        // increment current cam index
-        camId++;
-    }
-    camTriangles.clear();
-
     if(!texParams.fillHoles && texParams.padding > 0)
     {
+        const unsigned int textureSize = texParams.textureSide * texParams.textureSide;
+
         ALICEVISION_LOG_INFO("Edge padding (" << texParams.padding << " pixels).");
         // edge padding (dilate gutter)
         for(unsigned int g = 0; g < texParams.padding; ++g)
@@ -429,7 +405,8 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
     if(texParams.fillHoles)
         alphaBuffer.resize(colorBuffer.size(), 0.0f);
 
-    for(unsigned int yp = 0; yp < texParams.textureSide; ++yp)
+    #pragma omp parallel for
+    for(int yp = 0; yp < static_cast<int>(texParams.textureSide); ++yp)
     {
         unsigned int yoffset = yp * texParams.textureSide;
         for(unsigned int xp = 0; xp < texParams.textureSide; ++xp)
@@ -447,11 +424,9 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
         }
     }
 
-    perPixelColors.clear();
-    colorIDs.clear();
+    perPixelColors = std::vector<AccuColor>();
+    colorIDs = std::vector<int>();
 
-    std::string textureName = "texture_" + std::to_string(atlasID) + "." + EImageFileType_enumToString(textureFileType);
-    bfs::path texturePath = outPath / textureName;
     ALICEVISION_LOG_INFO("Writing texture file: " << texturePath.string());
 
     unsigned int outTextureSide = texParams.textureSide;
@@ -477,6 +452,250 @@ void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
 }
 
 
+void Texturing::generateTextures(const mvsUtils::MultiViewParams &mp,
+                                 const boost::filesystem::path &outPath, EImageFileType textureFileType)
+{
+    mvsUtils::ImagesCache imageCache(&mp, 0, false);
+
+    const std::size_t textureSize = static_cast<std::size_t>(texParams.textureSide) * texParams.textureSide;
+    // accumulation buffers of one atlas
+    const std::size_t atlasMemory = textureSize * (sizeof(int) + sizeof(AccuColor));
+    // output buffers of the atlas being written
+    const std::size_t outputMemory = textureSize * (sizeof(Color) + (texParams.fillHoles ? sizeof(float) : 0));
+
+    std::size_t memoryBudget = static_cast<std::size_t>(texParams.maxMemory) * 1024 * 1024;
+    if(memoryBudget == 0)
+    {
+        const system::MemoryInfo memoryInformation = system::getMemoryInfo();
+        ALICEVISION_LOG_DEBUG("Memory information: " << std::endl << memoryInformation);
+
+        if(memoryInformation.freeRam == 0)
+            ALICEVISION_LOG_WARNING("Can't find available system memory, this can be due to OS limitations.\n"
+                                    "Texture one atlas at a time.");
+        memoryBudget = 0.9 * memoryInformation.freeRam;
+    }
+
+    // the atlases are textured by batches fitting in the memory budget:
+    // each source image is loaded once per batch
+    std::size_t nbAtlasesPerBatch = memoryBudget > outputMemory ? (memoryBudget - outputMemory) / atlasMemory : 0;
+    nbAtlasesPerBatch = std::max(std::size_t(1), std::min(nbAtlasesPerBatch, _atlases.size()));
+
+    ALICEVISION_LOG_INFO("Texturing " << _atlases.size() << " atlas(es) by batches of " << nbAtlasesPerBatch
+                         << " (" << atlasMemory / (1024 * 1024) << " MB per atlas).");
+
+    for(size_t firstAtlasID = 0; firstAtlasID < _atlases.size(); firstAtlasID += nbAtlasesPerBatch)
+    {
+        std::vector<size_t> atlasIDs;
+        for(size_t atlasID = firstAtlasID; atlasID < std::min(firstAtlasID + nbAtlasesPerBatch, _atlases.size()); ++atlasID)
+            atlasIDs.push_back(atlasID);
+        generateTextures(mp, atlasIDs, imageCache, outPath, textureFileType);
+    }
+}
+
+void Texturing::generateTexture(const mvsUtils::MultiViewParams& mp,
+                                size_t atlasID, mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    generateTextures(mp, std::vector<size_t>(1, atlasID), imageCache, outPath, textureFileType);
+}
+
+void Texturing::generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                                 mvsUtils::ImagesCache& imageCache, const bfs::path& outPath, EImageFileType textureFileType)
+{
+    for(size_t atlasID : atlasIDs)
+    {
+        if(atlasID >= _atlases.size())
+            throw std::runtime_error("Invalid atlas ID " + std::to_string(atlasID));
+    }
+
+    const int nbAtlases = static_cast<int>(atlasIDs.size());
+    const std::size_t textureSize = static_cast<std::size_t>(texParams.textureSide) * texParams.textureSide;
+
+    /// accumulation buffers of an atlas
+    struct AtlasTexture
+    {
+        std::vector<int> colorIDs;
+        std::vector<AccuColor> perPixelColors;
+    };
+    std::vector<AtlasTexture> atlasTextures(nbAtlases);
+
+    // (atlas index in the batch, triangle id) seen by each camera
+    std::vector<std::vector<std::pair<int, unsigned int>>> camTriangles(mp.ncams);
+
+    for(int atlas = 0; atlas < nbAtlases; ++atlas)
+    {
+        const size_t atlasID = atlasIDs[atlas];
+
+        ALICEVISION_LOG_INFO("Generating texture for atlas " << atlasID + 1 << "/" << _atlases.size()
+                  << " (" << _atlases[atlasID].size() << " triangles).");
+
+        // iterate over atlas' triangles
+        for(size_t i = 0; i < _atlases[atlasID].size(); ++i)
+        {
+            int triangleId = _atlases[atlasID][i];
+
+            std::set<int> triCams;
+            // retrieve triangle visibilities (set of triangle's points visibilities)
+            for(int k = 0; k < 3; k++)
+            {
+                const int pointIndex = (*me->tris)[triangleId].v[k];
+                const StaticVector<int>* pointVisibilities = (*pointsVisibilities)[pointIndex];
+                if(pointVisibilities != nullptr)
+                {
+                    std::copy(pointVisibilities->begin(), pointVisibilities->end(), std::inserter(triCams, triCams.end()));
+                }
+            }
+            // register this triangle in cameras seeing it
+            for(int camId : triCams)
+                camTriangles[camId].emplace_back(atlas, triangleId);
+        }
+
+        atlasTextures[atlas].colorIDs.resize(textureSize, -1);
+        atlasTextures[atlas].perPixelColors.resize(textureSize);
+    }
+
+    ALICEVISION_LOG_INFO("Reading pixel color.");
+
+    // the textures are split in horizontal bands of pixels rasterized in parallel:
+    // each band accumulates the colors of its triangles in the same order
+    // as a sequential processing, without concurrent writes
+    const int texSide = static_cast<int>(texParams.textureSide);
+    const int bandHeight = 64;
+    const int nbBands = (texSide + bandHeight - 1) / bandHeight;
+    const int nbBins = nbAtlases * nbBands;
+
+    /// a triangle to rasterize
+    struct RasterTriangle
+    {
+        int atlas;
+        Point2d triPixs[3];
+        Point3d triPts[3];
+        Pixel LU, RD;
+    };
+    std::vector<RasterTriangle> rasterTriangles;
+    // triangles per (atlas, band) bin (CSR)
+    std::vector<int> binTrianglesOffsets(nbBins + 1);
+    std::vector<int> binTriangles;
+
+    // iterate over cameras: each source image is loaded once
+    // and splatted in the textures of all the atlases
+    for(int camId = 0; camId < static_cast<int>(camTriangles.size()); ++camId)
+    {
+        const std::vector<std::pair<int, unsigned int>>& triangles = camTriangles[camId];
+
+        ALICEVISION_LOG_INFO(" - camera " << camId + 1 << "/" << mp.ncams << " (" << triangles.size() << " triangles)");
+
+        if(triangles.empty())
+            continue;
+
+        rasterTriangles.resize(triangles.size());
+
+        #pragma omp parallel for
+        for(int i = 0; i < static_cast<int>(triangles.size()); ++i)
+        {
+            const unsigned int triangleId = triangles[i].second;
+            RasterTriangle& tri = rasterTriangles[i];
+            tri.atlas = triangles[i].first;
+
+            // retrieve triangle 3D and UV coordinates
+            for(int k = 0; k < 3; k++)
+            {
+                const int pointIndex = (*me->tris)[triangleId].v[k];
+                tri.triPts[k] = (*me->pts)[pointIndex];                               // 3D coordinates
+                const int uvPointIndex = trisUvIds[triangleId].m[k];
+                tri.triPixs[k] = uvCoords[uvPointIndex] * texParams.textureSide;   // UV coordinates
+            }
+
+            // compute triangle bounding box in pixel indexes
+            // min values: floor(value)
+            // max values: ceil(value)
+            const Point2d* triPixs = tri.triPixs;
+            tri.LU.x = static_cast<int>(std::floor(std::min(std::min(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+            tri.LU.y = static_cast<int>(std::floor(std::min(std::min(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+            tri.RD.x = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].x, triPixs[1].x), triPixs[2].x)));
+            tri.RD.y = static_cast<int>(std::ceil(std::max(std::max(triPixs[0].y, triPixs[1].y), triPixs[2].y)));
+
+            // sanity check: clamp values to [0; textureSide]
+            tri.LU.x = clamp(tri.LU.x, 0, texSide);
+            tri.LU.y = clamp(tri.LU.y, 0, texSide);
+            tri.RD.x = clamp(tri.RD.x, 0, texSide);
+            tri.RD.y = clamp(tri.RD.y, 0, texSide);
+        }
+
+        // register the triangles in the bands they overlap, in the camera order
+        std::fill(binTrianglesOffsets.begin(), binTrianglesOffsets.end(), 0);
+        for(const RasterTriangle& tri : rasterTriangles)
+        {
+            if(tri.LU.y >= tri.RD.y || tri.LU.x >= tri.RD.x)
+                continue;
+            for(int band = tri.LU.y / bandHeight; band <= (tri.RD.y - 1) / bandHeight; ++band)
+                ++binTrianglesOffsets[tri.atlas * nbBands + band + 1];
+        }
+        for(int bin = 0; bin < nbBins; ++bin)
+            binTrianglesOffsets[bin + 1] += binTrianglesOffsets[bin];
+
+        binTriangles.resize(binTrianglesOffsets.back());
+        {
+            std::vector<int> binFill(binTrianglesOffsets.begin(), binTrianglesOffsets.end() - 1);
+            for(int i = 0; i < static_cast<int>(rasterTriangles.size()); ++i)
+            {
+                const RasterTriangle& tri = rasterTriangles[i];
+                if(tri.LU.y >= tri.RD.y || tri.LU.x >= tri.RD.x)
+                    continue;
+                for(int band = tri.LU.y / bandHeight; band <= (tri.RD.y - 1) / bandHeight; ++band)
+                    binTriangles[binFill[tri.atlas * nbBands + band]++] = i;
+            }
+        }
+
+        // load the source image once, then read it concurrently
+        const Color* img = imageCache.getImg(camId);
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int bin = 0; bin < nbBins; ++bin)
+        {
+            AtlasTexture& atlasTexture = atlasTextures[bin / nbBands];
+            const int bandYMin = (bin % nbBands) * bandHeight;
+            const int bandYMax = std::min(bandYMin + bandHeight, texSide);
+
+            for(int t = binTrianglesOffsets[bin]; t < binTrianglesOffsets[bin + 1]; ++t)
+            {
+                const RasterTriangle& tri = rasterTriangles[binTriangles[t]];
+
+                // iterate over the bounding box's pixels of this band
+                const Pixel LU(tri.LU.x, std::max(tri.LU.y, bandYMin));
+                const Pixel RD(tri.RD.x, std::min(tri.RD.y, bandYMax));
+
+                rasterizeTriangle(tri.triPixs, LU, RD, [&](int x, int y, const Point2d& barycCoords)
+                {
+                    // remap 'y' to image coordinates system (inverted Y axis)
+                    const unsigned int y_ = (texParams.textureSide - 1) - y;
+                    // 1D pixel index
+                    unsigned int xyoffset = y_ * texParams.textureSide + x;
+                    // get 3D coordinates
+                    Point3d pt3d = barycentricToCartesian(tri.triPts, barycCoords);
+                    // get 2D coordinates in source image
+                    Point2d pixRC;
+                    mp.getPixelFor3DPoint(&pixRC, pt3d, camId);
+                    // exclude out of bounds pixels
+                    if(!mp.isPixelInImage(pixRC, camId))
+                        return;
+                    // fill the colorID map
+                    atlasTexture.colorIDs[xyoffset] = xyoffset;
+                    // fill the accumulated color map for this pixel
+                    atlasTexture.perPixelColors[xyoffset] += imageCache.getPixelValueInterpolated(img, &pixRC, camId);
+                });
+            }
+        }
+    }
+    camTriangles.clear();
+
+    for(int atlas = 0; atlas < nbAtlases; ++atlas)
+    {
+        const std::string textureName = "texture_" + std::to_string(atlasIDs[atlas]) + "." + EImageFileType_enumToString(textureFileType);
+        writeTexture(texParams, atlasTextures[atlas].colorIDs, atlasTextures[atlas].perPixelColors, outPath / textureName);
+    }
+}
+
+
 void Texturing::clear()
 {
     trisMtlIds.clear();
@@ -522,15 +741,44 @@ void Texturing::loadFromOBJ(const std::string& filename, bool flipNormals)
     }
 }
 
+void Texturing::loadMesh(const std::string& filename, bool flipNormals)
+{
+    if(bfs::path(filename).extension() != ".bin")
+    {
+        loadFromOBJ(filename, flipNormals);
+        return;
+    }
+
+    // Clear internal data
+    clear();
+    me = new Mesh();
+    // Load .bin
+    if(!me->loadFromBin(filename))
+    {
+        throw std::runtime_error("Unable to load: " + filename);
+    }
+
+    // Handle normals flipping
+    if(flipNormals)
+        me->invertTriangleOrientations();
+
+    // no material: only one atlas with all triangles
+    _atlases.resize(1);
+    _atlases[0].resize(me->tris->size());
+    std::iota(_atlases[0].begin(), _atlases[0].end(), 0);
+}
+
 void Texturing::loadFromMeshing(const std::string& meshFilepath, const std::string& visibilitiesFilepath)
 {
     clear();
     me = new Mesh();
-    if(!me->loadFromBin(meshFilepath))
+    if(!me->loadFromBin(meshFilepath, &pointsVisibilities))
     {
         throw std::runtime_error("Unable to load: " + meshFilepath);
     }
-    pointsVisibilities = loadArrayOfArraysFromFile<int>(visibilitiesFilepath);
+    // legacy dense reconstruction: visibilities in a separate file
+    if(pointsVisibilities == nullptr)
+        pointsVisibilities = loadArrayOfArraysFromFile<int>(visibilitiesFilepath);
     if(pointsVisibilities->size() != me->pts->size())
         throw std::runtime_error("Error: Reference mesh and associated visibilities don't have the same size.");
 }
@@ -543,8 +791,8 @@ void Texturing::replaceMesh(const std::string& otherMeshPath, bool flipNormals)
     // set pointers to null to avoid deallocation by 'loadFromObj'
     me = nullptr;
     pointsVisibilities = nullptr;
-    // load input obj file
-    loadFromOBJ(otherMeshPath, flipNormals);
+    // load input mesh file
+    loadMesh(otherMeshPath, flipNormals);
     // allocate pointsVisibilities for new internal mesh
     pointsVisibilities = new PointsVisibility();
     // remap visibilities from reconstruction onto input mesh
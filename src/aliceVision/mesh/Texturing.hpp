@@ -51,6 +51,8 @@ struct TexturingParams
     unsigned int padding = 15;
     unsigned int downscale = 2;
     bool fillHoles = false;
+    /// maximum memory (in MB) for the texture accumulation buffers (0: use the available memory)
+    unsigned int maxMemory = 0;
 };
 
 struct Texturing
@@ -84,11 +86,15 @@ public:
     /// Load a mesh from a .obj file and initialize internal structures
     void loadFromOBJ(const std::string& filename, bool flipNormals=false);
 
+    /// Load a mesh from a .obj or a .bin file (see Mesh::saveToBin) and initialize internal structures
+    void loadMesh(const std::string& filename, bool flipNormals=false);
+
     /**
      * @brief Load a mesh from a dense reconstruction.
      *
      * @param meshFilepath the path to the .bin mesh file
-     * @param visibilitiesFilepath the path to the .bin points visibilities file
+     * @param visibilitiesFilepath the path to the .bin points visibilities file,
+     *        only used if the mesh file does not contain the visibilities
      */
     void loadFromMeshing(const std::string& meshFilepath, const std::string& visibilitiesFilepath);
 
@@ -120,10 +126,24 @@ public:
      */
     void generateUVs(mvsUtils::MultiViewParams &mp);
 
-    /// Generate texture files for all texture atlases
+    /**
+     * @brief Generate texture files for all texture atlases
+     *
+     * The atlases are processed by batches fitting in texParams.maxMemory.
+     */
     void generateTextures(const mvsUtils::MultiViewParams& mp,
                           const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
 
+    /**
+     * @brief Generate texture files for the given texture atlas indexes
+     *
+     * Iterates over the cameras and splats each source image in the textures
+     * of all the given atlases, so that each image is loaded only once.
+     */
+    void generateTextures(const mvsUtils::MultiViewParams& mp, const std::vector<size_t>& atlasIDs,
+                          mvsUtils::ImagesCache& imageCache,
+                          const bfs::path &outPath, EImageFileType textureFileType = EImageFileType::PNG);
+
     /// Generate texture files for the given texture atlas index
     void generateTexture(const mvsUtils::MultiViewParams& mp,
                          size_t atlasID, mvsUtils::ImagesCache& imageCache,
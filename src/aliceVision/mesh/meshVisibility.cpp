@@ -4,10 +4,16 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "meshVisibility.hpp"
+#include <aliceVision/mesh/MeshBVH.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <geogram/points/kd_tree.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
 namespace aliceVision {
 namespace mesh {
 
@@ -29,35 +35,211 @@ int getNearestVertices(const Mesh& refMesh, const Mesh& mesh, StaticVector<int>&
 }
 
 
-void remapMeshVisibilities(
-    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
-    const Mesh& mesh, PointsVisibility& out_ptsVisibilities)
+void PointsVisibilityCSR::fromPointsVisibility(const PointsVisibility& ptsVisibilities)
 {
-    ALICEVISION_LOG_DEBUG("remapMeshVisibility start.");
+    const int nbPts = ptsVisibilities.size();
+    offsets.assign(nbPts + 1, 0);
+    for(int i = 0; i < nbPts; ++i)
+        offsets[i + 1] = offsets[i] + (ptsVisibilities[i] == nullptr ? 0 : ptsVisibilities[i]->size());
 
-    GEO::AdaptiveKdTree refMesh_kdTree(3);
-    refMesh_kdTree.set_points(refMesh.pts->size(), refMesh.pts->front().m);
+    cams.resize(offsets.back());
 
-    out_ptsVisibilities.resize(mesh.pts->size());
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        if(ptsVisibilities[i] != nullptr)
+            std::copy(ptsVisibilities[i]->begin(), ptsVisibilities[i]->end(), cams.begin() + offsets[i]);
+    }
+}
+
+void PointsVisibilityCSR::toPointsVisibility(PointsVisibility& out_ptsVisibilities) const
+{
+    out_ptsVisibilities.resize(size());
 
     #pragma omp parallel for
-    for(int i = 0; i < mesh.pts->size(); ++i)
+    for(int i = 0; i < size(); ++i)
     {
+        const MeshTopology::IndexRange ptCams = getCams(i);
         PointVisibility* pOut = new StaticVector<int>();
+        pOut->getDataWritable().assign(ptCams.begin(), ptCams.end());
         out_ptsVisibilities[i] = pOut; // give ownership
+    }
+}
+
+/// interleave the bits of a 10 bits value with 2 zeros
+static inline unsigned int spreadBits3D(unsigned int v)
+{
+    v = (v | (v << 16)) & 0x030000FF;
+    v = (v | (v << 8)) & 0x0300F00F;
+    v = (v | (v << 4)) & 0x030C30C3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+
+/**
+ * @brief Sort the vertices of a mesh along a Morton curve, so consecutive queries are spatially close.
+ */
+static void getMortonOrder(const Mesh& mesh, std::vector<int>& out_order)
+{
+    const int nbPts = mesh.pts->size();
+    Point3d bboxMin(std::numeric_limits<double>::max(), std::numeric_limits<double>::max(), std::numeric_limits<double>::max());
+    Point3d bboxMax = -bboxMin;
+    for(const Point3d& p : mesh.pts->getData())
+    {
+        for(int d = 0; d < 3; ++d)
+        {
+            bboxMin.m[d] = std::min(bboxMin.m[d], p.m[d]);
+            bboxMax.m[d] = std::max(bboxMax.m[d], p.m[d]);
+        }
+    }
+    const Point3d extent = bboxMax - bboxMin;
+    const double scale = 1023.0 / std::max(std::max(extent.x, extent.y), std::max(extent.z, std::numeric_limits<double>::min()));
+
+    std::vector<std::pair<unsigned int, int>> codes(nbPts);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const Point3d q = ((*mesh.pts)[i] - bboxMin) * scale;
+        codes[i] = std::make_pair(spreadBits3D(static_cast<unsigned int>(q.x)) |
+                                  (spreadBits3D(static_cast<unsigned int>(q.y)) << 1) |
+                                  (spreadBits3D(static_cast<unsigned int>(q.z)) << 2), i);
+    }
+    std::sort(codes.begin(), codes.end());
+
+    out_order.resize(nbPts);
+    for(int i = 0; i < nbPts; ++i)
+        out_order[i] = codes[i].second;
+}
+
+void remapMeshVisibilities(
+    const Mesh& refMesh, const PointsVisibilityCSR& refPtsVisibilities,
+    const Mesh& mesh, PointsVisibilityCSR& out_ptsVisibilities)
+{
+    ALICEVISION_LOG_DEBUG("remapMeshVisibility start.");
 
-        int iRef = refMesh_kdTree.get_nearest_neighbor((*mesh.pts)[i].m);
-        if(iRef == -1)
-            continue;
-        PointVisibility* pRef = refPtsVisibilities[iRef];
-        if(pRef == nullptr)
-            continue;
+    const int nbPts = mesh.pts->size();
+    out_ptsVisibilities.offsets.assign(nbPts + 1, 0);
+    out_ptsVisibilities.cams.clear();
 
-        *pOut = *pRef;
+    if(nbPts == 0 || refMesh.pts->empty())
+        return;
+
+    // reference vertices whose visibility is transferred to each vertex
+    // (the 3 vertices of the nearest triangle, or the nearest vertex without triangles)
+    std::vector<std::array<int, 3>> refPtsIds(nbPts, {{-1, -1, -1}});
+
+    if(refMesh.tris->empty())
+    {
+        StaticVector<int> nearestVertex;
+        getNearestVertices(refMesh, mesh, nearestVertex);
+        for(int i = 0; i < nbPts; ++i)
+            refPtsIds[i][0] = nearestVertex[i];
+    }
+    else
+    {
+        const MeshBVH refMeshBVH(refMesh);
+
+        std::vector<int> order;
+        getMortonOrder(mesh, order);
+
+        // batches of spatially close queries: the nearest triangle of the previous query bounds the search
+        const int batchSize = 1024;
+        const int nbBatches = (nbPts + batchSize - 1) / batchSize;
+
+        #pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < nbBatches; ++b)
+        {
+            std::array<double, 3> barycentricCoords;
+            int previousTriangle = -1;
+            for(int o = b * batchSize; o < std::min(nbPts, (b + 1) * batchSize); ++o)
+            {
+                const int i = order[o];
+                const Point3d& p = (*mesh.pts)[i];
+                if(!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+                    continue; // invalid vertex: no reference vertices
+
+                double sqDist = std::numeric_limits<double>::max();
+                if(previousTriangle != -1)
+                    sqDist = refMeshBVH.getClosestPointOnTriangle(p, previousTriangle, barycentricCoords);
+
+                int nearestTriangle = refMeshBVH.getNearestTriangle(p, sqDist);
+                if(nearestTriangle == -1)
+                    nearestTriangle = previousTriangle; // nothing closer than the previous triangle
+                if(nearestTriangle == -1)
+                    continue; // no triangle found (degenerated reference triangles): no reference vertices
+                previousTriangle = nearestTriangle;
+
+                for(int k = 0; k < 3; ++k)
+                    refPtsIds[i][k] = (*refMesh.tris)[nearestTriangle].v[k];
+            }
+        }
+    }
+
+    // union of the reference visibilities per vertex
+    std::vector<int> nbCams(nbPts, 0);
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        int n = 0;
+        for(int iRef : refPtsIds[i])
+        {
+            if(iRef != -1)
+                n += refPtsVisibilities.getCams(iRef).size();
+        }
+        nbCams[i] = n;
+    }
+
+    for(int i = 0; i < nbPts; ++i)
+        out_ptsVisibilities.offsets[i + 1] = out_ptsVisibilities.offsets[i] + nbCams[i];
+    std::vector<int> cams(out_ptsVisibilities.offsets.back());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        auto it = cams.begin() + out_ptsVisibilities.offsets[i];
+        const auto first = it;
+        for(int iRef : refPtsIds[i])
+        {
+            if(iRef == -1)
+                continue;
+            const MeshTopology::IndexRange refCams = refPtsVisibilities.getCams(iRef);
+            it = std::copy(refCams.begin(), refCams.end(), it);
+        }
+        std::sort(first, it);
+        nbCams[i] = std::unique(first, it) - first;
+    }
+
+    // compact the lists without the duplicated cameras
+    std::vector<int> offsets(nbPts + 1, 0);
+    for(int i = 0; i < nbPts; ++i)
+        offsets[i + 1] = offsets[i] + nbCams[i];
+    out_ptsVisibilities.cams.resize(offsets.back());
+
+    #pragma omp parallel for
+    for(int i = 0; i < nbPts; ++i)
+    {
+        const auto first = cams.begin() + out_ptsVisibilities.offsets[i];
+        std::copy(first, first + nbCams[i], out_ptsVisibilities.cams.begin() + offsets[i]);
     }
+    out_ptsVisibilities.offsets.swap(offsets);
 
     ALICEVISION_LOG_DEBUG("remapMeshVisibility done.");
 }
 
+void remapMeshVisibilities(
+    const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
+    const Mesh& mesh, PointsVisibility& out_ptsVisibilities)
+{
+    PointsVisibilityCSR refPtsVisibilitiesCSR;
+    refPtsVisibilitiesCSR.fromPointsVisibility(refPtsVisibilities);
+
+    PointsVisibilityCSR ptsVisibilitiesCSR;
+    remapMeshVisibilities(refMesh, refPtsVisibilitiesCSR, mesh, ptsVisibilitiesCSR);
+
+    ptsVisibilitiesCSR.toPointsVisibility(out_ptsVisibilities);
+}
+
 } // namespace mesh
 } // namespace aliceVision
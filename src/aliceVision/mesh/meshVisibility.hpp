@@ -6,14 +6,39 @@
 #pragma once
 
 #include <aliceVision/mesh/Mesh.hpp>
+#include <aliceVision/mesh/MeshTopology.hpp>
 #include <aliceVision/mvsData/StaticVector.hpp>
 
+#include <vector>
+
 namespace aliceVision {
 namespace mesh {
 
 using PointVisibility = StaticVector<int>;
 using PointsVisibility = StaticVector<PointVisibility*>;
 
+/**
+ * @brief Compact visibility per vertex: the camera IDs of all the vertices in a single array (CSR layout).
+ */
+struct PointsVisibilityCSR
+{
+    /// cameras of the vertex i are in [offsets[i], offsets[i+1])
+    std::vector<int> offsets{0};
+    std::vector<int> cams;
+
+    int size() const { return static_cast<int>(offsets.size()) - 1; }
+
+    MeshTopology::IndexRange getCams(int ptId) const
+    {
+        return MeshTopology::IndexRange(cams.data() + offsets[ptId], cams.data() + offsets[ptId + 1]);
+    }
+
+    void fromPointsVisibility(const PointsVisibility& ptsVisibilities);
+
+    /// @note allocates a new visibility array per vertex, owned by the caller
+    void toPointsVisibility(PointsVisibility& out_ptsVisibilities) const;
+};
+
 /**
  * @brief Retrieve the nearest neighbor vertex in @p refMesh for each vertex in @p mesh.
  * @param[in] refMesh input reference mesh
@@ -25,14 +50,21 @@ int getNearestVertices(const Mesh& refMesh, const Mesh& mesh, StaticVector<int>&
 
 /**
  * @brief Transfer the visibility per vertex from one mesh to another.
- * For each vertex of the @p mesh, we search the nearest neighbor vertex in the @p refMesh and copy its visibility information.
+ * For each vertex of the @p mesh, we search the nearest triangle in the @p refMesh (with a BVH built once)
+ * and merge the visibility information of its vertices.
+ * If @p refMesh has no triangle, the visibility of the nearest neighbor vertex is copied.
  * @note The visibility information is a list of camera IDs which are seeing the vertex.
  *
  * @param[in] refMesh input reference mesh
- * @param[in] refPtsVisibilities visibility array per vertex of @p refMesh
+ * @param[in] refPtsVisibilities visibility per vertex of @p refMesh
  * @param[in] mesh input target mesh
- * @param[out] out_ptsVisibilities visibility array per vertex of @p mesh
+ * @param[out] out_ptsVisibilities visibility per vertex of @p mesh
  */
+void remapMeshVisibilities(
+    const Mesh& refMesh, const PointsVisibilityCSR& refPtsVisibilities,
+    const Mesh& mesh, PointsVisibilityCSR& out_ptsVisibilities);
+
+/// @see remapMeshVisibilities(const Mesh&, const PointsVisibilityCSR&, const Mesh&, PointsVisibilityCSR&)
 void remapMeshVisibilities(
     const Mesh& refMesh, const PointsVisibility& refPtsVisibilities,
     const Mesh& mesh, PointsVisibility& out_ptsVisibilities);
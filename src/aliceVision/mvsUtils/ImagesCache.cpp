@@ -10,7 +10,7 @@
 namespace aliceVision {
 namespace mvsUtils {
 
-int ImagesCache::getPixelId(int x, int y, int imgid)
+int ImagesCache::getPixelId(int x, int y, int imgid) const
 {
     if(!transposed)
         return x * mp->getHeight(imgid) + y;
@@ -124,14 +124,22 @@ void ImagesCache::refreshData(int camId)
     }
 }
 
-Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+const Color* ImagesCache::getImg(int camId)
 {
     refreshData(camId);
 
     // get the image index in the memory
     const int i = (*camIdMapId)[camId];
-    const Color* img = imgs[i];
-    
+    return imgs[i];
+}
+
+Color ImagesCache::getPixelValueInterpolated(const Point2d* pix, int camId)
+{
+    return getPixelValueInterpolated(getImg(camId), pix, camId);
+}
+
+Color ImagesCache::getPixelValueInterpolated(const Color* img, const Point2d* pix, int camId) const
+{
     const int xp = static_cast<int>(pix->x);
     const int yp = static_cast<int>(pix->y);
 
@@ -36,10 +36,23 @@ public:
     void initIC(int _bandType, std::vector<std::string>& _imagesNames, bool _transposed);
     ~ImagesCache();
 
-    int getPixelId(int x, int y, int imgid);
+    int getPixelId(int x, int y, int imgid) const;
     void refreshData(int camId);
     Color getPixelValueInterpolated(const Point2d* pix, int camId);
     rgb getPixelValue(const Pixel& pix, int camId);
+
+    /**
+     * @brief Load the image in the cache if needed and return its data.
+     * @note The returned buffer is valid until the image is removed from the cache
+     *       by another call to refreshData().
+     */
+    const Color* getImg(int camId);
+
+    /**
+     * @brief Bilinear interpolation of the color of a pixel in an image returned by getImg().
+     * @note Thread-safe, the cache is not modified.
+     */
+    Color getPixelValueInterpolated(const Color* img, const Point2d* pix, int camId) const;
 };
 
 } // namespace mvsUtils
@@ -8,6 +8,7 @@
 #include "aliceVision/sfm/SfMData.hpp"
 #include "aliceVision/sfm/sfmDataIO.hpp"
 #include "aliceVision/image/io.hpp"
+#include "aliceVision/image/DecodedImageCache.hpp"
 #include "aliceVision/stl/stl.hpp"
 
 #include <boost/filesystem.hpp>
@@ -229,7 +230,7 @@ void SfMData::combine(const SfMData& sfmData)
 }
 
 /// Find the color of the SfMData Landmarks/structure
-bool ColorizeTracks( SfMData & sfm_data )
+bool ColorizeTracks( SfMData & sfm_data, const image::DecodedImageCache* imageCache )
 {
   // Colorize each track
   //  Start with the most representative image
@@ -303,7 +304,10 @@ bool ColorizeTracks( SfMData & sfm_data )
     const std::string sView_filename = view->getImagePath();
     Image<RGBColor> image;
 
-    readImage(sView_filename, image);
+    if(imageCache)
+      imageCache->readImage(sView_filename, image, view->getViewId());
+    else
+      readImage(sView_filename, image);
 
     // Iterate through the remaining track to color
     // - look if the current view is present to color the track
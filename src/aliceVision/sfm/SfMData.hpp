@@ -18,6 +18,11 @@
 #include <cassert>
 
 namespace aliceVision {
+
+namespace image {
+class DecodedImageCache;
+} // namespace image
+
 namespace sfm {
 
 /// Define a collection of View
@@ -362,9 +367,10 @@ private:
  * the sfm_data, using the track to determine the best view from which
  * to get the color.
  * @param sfm_data The container of the data
+ * @param imageCache The decoded image cache used to read the images (optional)
  * @return true if everything went well
  */
-bool ColorizeTracks( SfMData & sfm_data );
+bool ColorizeTracks( SfMData & sfm_data, const image::DecodedImageCache* imageCache = nullptr );
 
 } // namespace sfm
 } // namespace aliceVision
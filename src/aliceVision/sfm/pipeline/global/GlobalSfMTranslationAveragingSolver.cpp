@@ -11,7 +11,6 @@
 #include <aliceVision/sfm/sfmDataIO.hpp>
 #include <aliceVision/sfm/BundleAdjustmentCeres.hpp>
 #include <aliceVision/sfm/pipeline/global/reindexGlobalSfM.hpp>
-#include <aliceVision/sfm/pipeline/global/MutexSet.hpp>
 #include <aliceVision/matching/IndMatch.hpp>
 #include <aliceVision/multiview/translationAveraging/common.hpp>
 #include <aliceVision/multiview/translationAveraging/solver.hpp>
@@ -32,6 +31,9 @@
 
 #include <boost/progress.hpp>
 
+#include <array>
+#include <atomic>
+
 namespace aliceVision{
 namespace sfm{
 
@@ -304,8 +306,37 @@ void GlobalSfMTranslationAveragingSolver::Compute_translations(
     tripletWise_matches);
 }
 
+/// List the pairwise matches shared by the three poses of a triplet
+/// from the matches indexed per (sorted) pair of pose ids.
+static void getTripletMatches(
+  const std::map<Pair, std::vector<const matching::PairwiseMatches::value_type*>> & matchesPerPosePair,
+  const graph::Triplet & triplet,
+  matching::PairwiseMatches & tripletMatches)
+{
+  const Pair posePairs[3] = {
+    Pair(triplet.i, triplet.j),
+    Pair(triplet.i, triplet.k),
+    Pair(triplet.j, triplet.k)};
+
+  for (const Pair & posePair : posePairs)
+  {
+    const auto it = matchesPerPosePair.find(posePair);
+    if (it == matchesPerPosePair.end())
+      continue;
+    for (const matching::PairwiseMatches::value_type * match : it->second)
+      tripletMatches.insert(*match);
+  }
+}
+
 //-- Perform a trifocal estimation of the graph contained in vec_triplets with an
 // edge coverage algorithm. Its complexity is sub-linear in term of edges count.
+//
+// The work is organized as a lock-free pipeline:
+//  - triplets are listed in parallel on a CSR adjacency of the pose graph,
+//  - pairwise matches are indexed once per pair of poses,
+//  - edges and their supporting triplets are stored in sorted arrays,
+//  - each thread accumulates its estimates and inlier matches in its own buffers,
+//    merged once all the edges are processed.
 void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCoverage(
   const SfMData & sfm_data,
   const HashMap<IndexT, Mat3> & map_globalR,
@@ -315,6 +346,7 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   matching::PairwiseMatches & newpairMatches)
 {
   aliceVision::system::Timer timerLP_triplet;
+  aliceVision::system::Timer timerStep;
 
   //--
   // Compute the relative translations using triplets of rotations over the rotation graph.
@@ -322,8 +354,10 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
   //
   // 1. List plausible triplets over the global rotation pose graph Ids.
   //   - list all edges that have support in the rotation pose graph
+  //   - index the pairwise matches per pair of poses
   //
   PairSet rotation_pose_id_graph;
+  std::map<Pair, std::vector<const matching::PairwiseMatches::value_type*>> matchesPerPosePair;
   std::set<IndexT> set_pose_ids;
   std::transform(map_globalR.begin(), map_globalR.end(),
     std::inserter(set_pose_ids, set_pose_ids.begin()), stl::RetrieveKey());
@@ -339,14 +373,17 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
         && set_pose_ids.count(v1->getPoseId())
         && set_pose_ids.count(v2->getPoseId()))
     {
-      rotation_pose_id_graph.insert(
-        std::make_pair(v1->getPoseId(), v2->getPoseId()));
+      const Pair posePair(
+        std::min(v1->getPoseId(), v2->getPoseId()),
+        std::max(v1->getPoseId(), v2->getPoseId()));
+      rotation_pose_id_graph.insert(posePair);
+      matchesPerPosePair[posePair].push_back(&match_iterator);
     }
   }
   // List putative triplets (from global rotations Ids)
   const std::vector< graph::Triplet > vec_triplets =
-    graph::tripletListing(rotation_pose_id_graph);
-  ALICEVISION_LOG_DEBUG("#Triplets: " << vec_triplets.size());
+    graph::tripletListingCSR(rotation_pose_id_graph);
+  ALICEVISION_LOG_DEBUG("#Triplets: " << vec_triplets.size() << " (listed in " << timerStep.elapsedMs() << " ms)");
 
   {
     // Compute triplets of translations
@@ -354,222 +391,240 @@ void GlobalSfMTranslationAveragingSolver::ComputePutativeTranslation_EdgesCovera
     // An estimated triplets of translation mark three edges as estimated.
 
     //-- precompute the number of track per triplet:
-    HashMap<IndexT, IndexT> map_tracksPerTriplets;
+    timerStep.reset();
+    std::vector<std::size_t> vec_tracksPerTriplets(vec_triplets.size(), 0);
 
     #pragma omp parallel for schedule(dynamic)
     for (int i = 0; i < (int)vec_triplets.size(); ++i)
     {
       // List matches that belong to the triplet of poses
-      const graph::Triplet & triplet = vec_triplets[i];
       matching::PairwiseMatches map_triplet_matches;
-      const std::set<IndexT> set_triplet_pose_ids = {triplet.i, triplet.j, triplet.k};
-      // List shared correspondences (pairs) between the triplet poses
-      for (const auto & match_iterator : pairwiseMatches)
-      {
-        const Pair pair = match_iterator.first;
-        const View * v1 = sfm_data.GetViews().at(pair.first).get();
-        const View * v2 = sfm_data.GetViews().at(pair.second).get();
-        if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-            (v1->getPoseId() != v2->getPoseId())
-            && set_triplet_pose_ids.count(v1->getPoseId())
-            && set_triplet_pose_ids.count(v2->getPoseId()))
-        {
-          map_triplet_matches.insert( match_iterator );
-        }
-      }
-      // Compute tracks:
-      {
-        aliceVision::track::TracksBuilder tracksBuilder;
-        tracksBuilder.Build(map_triplet_matches);
-        tracksBuilder.Filter(3);
+      getTripletMatches(matchesPerPosePair, vec_triplets[i], map_triplet_matches);
 
-        #pragma omp critical
-        map_tracksPerTriplets[i] = tracksBuilder.NbTracks(); //count the # of matches in the UF tree
-      }
+      // Compute tracks:
+      aliceVision::track::TracksBuilder tracksBuilder;
+      tracksBuilder.Build(map_triplet_matches);
+      tracksBuilder.Filter(3);
+      vec_tracksPerTriplets[i] = tracksBuilder.NbTracks(); //count the # of matches in the UF tree
     }
+    ALICEVISION_LOG_DEBUG("Tracks per triplet computed in " << timerStep.elapsedMs() << " ms");
 
     typedef Pair myEdge;
 
-    //-- Alias (list triplet ids used per pose id edges)
-    std::map<myEdge, std::vector<size_t> > map_tripletIds_perEdge;
-    for (size_t i = 0; i < vec_triplets.size(); ++i)
+    //-- List the edges covered by the triplets (sorted, unique)
+    std::vector<myEdge> vec_edges;
+    vec_edges.reserve(3 * vec_triplets.size());
+    for (const graph::Triplet & triplet : vec_triplets)
+    {
+      vec_edges.emplace_back(triplet.i, triplet.j);
+      vec_edges.emplace_back(triplet.i, triplet.k);
+      vec_edges.emplace_back(triplet.j, triplet.k);
+    }
+    std::sort(vec_edges.begin(), vec_edges.end());
+    vec_edges.erase(std::unique(vec_edges.begin(), vec_edges.end()), vec_edges.end());
+
+    const auto edgeIndex = [&vec_edges](IndexT a, IndexT b) -> std::size_t
+    {
+      return std::lower_bound(vec_edges.begin(), vec_edges.end(), myEdge(a, b)) - vec_edges.begin();
+    };
+
+    //-- Alias (list triplet ids used per pose id edges) in a CSR layout
+    std::vector<std::array<std::size_t, 3>> vec_edgesPerTriplet(vec_triplets.size());
+    std::vector<std::size_t> tripletOffsetsPerEdge(vec_edges.size() + 1, 0);
+    for (std::size_t i = 0; i < vec_triplets.size(); ++i)
     {
       const graph::Triplet & triplet = vec_triplets[i];
-      map_tripletIds_perEdge[std::make_pair(triplet.i, triplet.j)].push_back(i);
-      map_tripletIds_perEdge[std::make_pair(triplet.i, triplet.k)].push_back(i);
-      map_tripletIds_perEdge[std::make_pair(triplet.j, triplet.k)].push_back(i);
+      vec_edgesPerTriplet[i] = {
+        edgeIndex(triplet.i, triplet.j),
+        edgeIndex(triplet.i, triplet.k),
+        edgeIndex(triplet.j, triplet.k)};
+      for (const std::size_t e : vec_edgesPerTriplet[i])
+        ++tripletOffsetsPerEdge[e + 1];
     }
+    for (std::size_t e = 0; e < vec_edges.size(); ++e)
+      tripletOffsetsPerEdge[e + 1] += tripletOffsetsPerEdge[e];
 
-    // Collect edges that are covered by the triplets
-    std::vector<myEdge > vec_edges;
-    std::transform(map_tripletIds_perEdge.begin(), map_tripletIds_perEdge.end(), std::back_inserter(vec_edges), stl::RetrieveKey());
+    std::vector<std::size_t> tripletIdsPerEdge(tripletOffsetsPerEdge.back());
+    {
+      std::vector<std::size_t> fill(tripletOffsetsPerEdge.begin(), tripletOffsetsPerEdge.end() - 1);
+      for (std::size_t i = 0; i < vec_triplets.size(); ++i)
+        for (const std::size_t e : vec_edgesPerTriplet[i])
+          tripletIdsPerEdge[fill[e]++] = i;
+    }
 
-    aliceVision::sfm::MutexSet<myEdge> m_mutexSet;
+    //-- Sort the triplets of each edge according the number of track they are supporting
+    #pragma omp parallel for schedule(dynamic)
+    for (int e = 0; e < (int)vec_edges.size(); ++e)
+    {
+      std::stable_sort(
+        tripletIdsPerEdge.begin() + tripletOffsetsPerEdge[e],
+        tripletIdsPerEdge.begin() + tripletOffsetsPerEdge[e + 1],
+        [&vec_tracksPerTriplets](std::size_t a, std::size_t b)
+        {
+          return vec_tracksPerTriplets[a] > vec_tracksPerTriplets[b];
+        });
+    }
+
+    // Estimated edges flags (value-initialized to false)
+    std::vector<std::atomic<bool>> vec_edgeEstimated(vec_edges.size());
+    std::atomic<std::size_t> nbEstimatedEdges(0);
+    std::atomic<std::size_t> nbProcessedEdges(0);
+    std::atomic<std::size_t> nbTestedTriplets(0);
+    std::atomic<std::size_t> nbEstimatedTriplets(0);
 
     boost::progress_display my_progress_bar(
       vec_edges.size(),
       std::cout,
       "\nRelative translations computation (edge coverage algorithm)\n");
 
-    // set number of threads, 1 if openMP is not enabled  
+    // set number of threads, 1 if openMP is not enabled
     std::vector<translationAveraging::RelativeInfoVec> initial_estimates(omp_get_max_threads());
-    const bool bVerbose = false;
+    std::vector<matching::PairwiseMatches> newpairMatchesPerThread(omp_get_max_threads());
+
+    timerStep.reset();
 
     #pragma omp parallel for schedule(dynamic)
     for (int k = 0; k < vec_edges.size(); ++k)
     {
-      const myEdge & edge = vec_edges[k];
-      #pragma omp critical
-      {
-        ++my_progress_bar;
-      }
-      if (m_mutexSet.count(edge) == 0 && m_mutexSet.size() != vec_edges.size())
-      {
-        // Find the triplets that support the given edge
-        const auto & vec_possibleTripletIndexes = map_tripletIds_perEdge.at(edge);
+      const int thread_id = omp_get_thread_num();
 
-        //-- Sort the triplets according the number of track they are supporting
-        std::vector<size_t> vec_commonTracksPerTriplets;
-        for (const size_t triplet_index : vec_possibleTripletIndexes)
-        {
-          vec_commonTracksPerTriplets.push_back(map_tracksPerTriplets[triplet_index]);
-        }
+      // Only the master thread refreshes the progress display
+      const std::size_t nbProcessed = ++nbProcessedEdges;
+      if (thread_id == 0 && nbProcessed > my_progress_bar.count())
+        my_progress_bar += nbProcessed - my_progress_bar.count();
 
-        using namespace stl::indexed_sort;
-        std::vector< sort_index_packet_descend < size_t, size_t> > packet_vec(vec_commonTracksPerTriplets.size());
-        sort_index_helper(packet_vec, &vec_commonTracksPerTriplets[0]);
+      if (vec_edgeEstimated[k] || nbEstimatedEdges == vec_edges.size())
+        continue;
 
-        std::vector<size_t> vec_triplet_ordered(vec_commonTracksPerTriplets.size(), 0);
-        for (size_t i = 0; i < vec_commonTracksPerTriplets.size(); ++i) {
-          vec_triplet_ordered[i] = vec_possibleTripletIndexes[packet_vec[i].index];
+      // Try to solve a triplet of translations for the given edge
+      // (triplets are sorted by decreasing number of supported tracks)
+      for (std::size_t t = tripletOffsetsPerEdge[k]; t < tripletOffsetsPerEdge[k + 1]; ++t)
+      {
+        const std::size_t triplet_index = tripletIdsPerEdge[t];
+        const graph::Triplet & triplet = vec_triplets[triplet_index];
+        const std::array<std::size_t, 3> & tripletEdges = vec_edgesPerTriplet[triplet_index];
+
+        // If the triplet is already estimated by another thread; try the next one
+        if (vec_edgeEstimated[tripletEdges[0]] &&
+            vec_edgeEstimated[tripletEdges[1]] &&
+            vec_edgeEstimated[tripletEdges[2]])
+        {
+          break;
         }
 
-        // Try to solve a triplet of translations for the given edge
-        for (const size_t triplet_index : vec_triplet_ordered)
+        //--
+        // Try to estimate this triplet of translations
+        //--
+        double dPrecision = 4.0; // upper bound of the residual pixel reprojection error
+
+        std::vector<Vec3> vec_tis(3);
+        std::vector<size_t> vec_inliers;
+        aliceVision::track::TracksMap pose_triplet_tracks;
+
+        matching::PairwiseMatches map_triplet_matches;
+        getTripletMatches(matchesPerPosePair, triplet, map_triplet_matches);
+
+        ++nbTestedTriplets;
+
+        const std::string sOutDirectory = "./";
+        const bool bTriplet_estimation = Estimate_T_triplet(
+            sfm_data,
+            map_globalR,
+            normalizedFeaturesPerView,
+            map_triplet_matches,
+            triplet,
+            vec_tis,
+            dPrecision,
+            vec_inliers,
+            pose_triplet_tracks,
+            sOutDirectory);
+
+        if (bTriplet_estimation)
         {
-          const graph::Triplet & triplet = vec_triplets[triplet_index];
+          ++nbEstimatedTriplets;
 
-          // If the triplet is already estimated by another thread; try the next one
-          if (m_mutexSet.count(Pair(triplet.i, triplet.j)) &&
-              m_mutexSet.count(Pair(triplet.i, triplet.k)) &&
-              m_mutexSet.count(Pair(triplet.j, triplet.k)))
+          // Since new translation edges have been computed, mark their corresponding edges as estimated
+          for (const std::size_t e : tripletEdges)
           {
-            break;
+            if (!vec_edgeEstimated[e].exchange(true))
+              ++nbEstimatedEdges;
           }
 
-          //--
-          // Try to estimate this triplet of translations
-          //--
-          double dPrecision = 4.0; // upper bound of the residual pixel reprojection error
-
-          std::vector<Vec3> vec_tis(3);
-          std::vector<size_t> vec_inliers;
-          aliceVision::track::TracksMap pose_triplet_tracks;
-
-          const std::string sOutDirectory = "./";
-          const bool bTriplet_estimation = Estimate_T_triplet(
-              sfm_data,
-              map_globalR,
-              normalizedFeaturesPerView,
-              pairwiseMatches,
-              triplet,
-              vec_tis,
-              dPrecision,
-              vec_inliers,
-              pose_triplet_tracks,
-              sOutDirectory);
-
-          if (bTriplet_estimation)
+          // Compute the triplet relative motions (IJ, JK, IK)
           {
-            // Since new translation edges have been computed, mark their corresponding edges as estimated
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.j));
-            m_mutexSet.insert(std::make_pair(triplet.j, triplet.k));
-            m_mutexSet.insert(std::make_pair(triplet.i, triplet.k));
-
-            // Compute the triplet relative motions (IJ, JK, IK)
+            const Mat3
+              RI = map_globalR.at(triplet.i),
+              RJ = map_globalR.at(triplet.j),
+              RK = map_globalR.at(triplet.k);
+            const Vec3
+              ti = vec_tis[0],
+              tj = vec_tis[1],
+              tk = vec_tis[2];
+
+            Mat3 Rij;
+            Vec3 tij;
+            RelativeCameraMotion(RI, ti, RJ, tj, &Rij, &tij);
+
+            Mat3 Rjk;
+            Vec3 tjk;
+            RelativeCameraMotion(RJ, tj, RK, tk, &Rjk, &tjk);
+
+            Mat3 Rik;
+            Vec3 tik;
+            RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
+
+            initial_estimates[thread_id].emplace_back(
+              std::make_pair(triplet.i, triplet.j), std::make_pair(Rij, tij));
+            initial_estimates[thread_id].emplace_back(
+              std::make_pair(triplet.j, triplet.k), std::make_pair(Rjk, tjk));
+            initial_estimates[thread_id].emplace_back(
+              std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
+
+            // Add inliers as valid pairwise matches (in the thread buffer)
+            matching::PairwiseMatches & threadPairMatches = newpairMatchesPerThread[thread_id];
+            for (const std::size_t inlier : vec_inliers)
             {
-              const Mat3
-                RI = map_globalR.at(triplet.i),
-                RJ = map_globalR.at(triplet.j),
-                RK = map_globalR.at(triplet.k);
-              const Vec3
-                ti = vec_tis[0],
-                tj = vec_tis[1],
-                tk = vec_tis[2];
-
-              Mat3 Rij;
-              Vec3 tij;
-              RelativeCameraMotion(RI, ti, RJ, tj, &Rij, &tij);
-
-              Mat3 Rjk;
-              Vec3 tjk;
-              RelativeCameraMotion(RJ, tj, RK, tk, &Rjk, &tjk);
-
-              Mat3 Rik;
-              Vec3 tik;
-              RelativeCameraMotion(RI, ti, RK, tk, &Rik, &tik);
-
-              // set number of threads, 1 if openMP is not enabled
-              const int thread_id = omp_get_thread_num();
-
-              initial_estimates[thread_id].emplace_back(
-                std::make_pair(triplet.i, triplet.j), std::make_pair(Rij, tij));
-              initial_estimates[thread_id].emplace_back(
-                std::make_pair(triplet.j, triplet.k), std::make_pair(Rjk, tjk));
-              initial_estimates[thread_id].emplace_back(
-                std::make_pair(triplet.i, triplet.k), std::make_pair(Rik, tik));
-
-              //--- ATOMIC
-              #pragma omp critical
+              using namespace aliceVision::track;
+              const Track & track = (pose_triplet_tracks.begin() + inlier)->second;
+
+              // create pairwise matches from inlier track
+              for (auto iter_I = track.featPerView.begin(); iter_I != track.featPerView.end(); ++iter_I)
               {
-                // Add inliers as valid pairwise matches
-                for (std::vector<size_t>::const_iterator iterInliers = vec_inliers.begin();
-                  iterInliers != vec_inliers.end(); ++iterInliers)
+                // loop on subtracks
+                for (auto iter_J = std::next(iter_I); iter_J != track.featPerView.end(); ++iter_J)
                 {
-                  using namespace aliceVision::track;
-                  TracksMap::iterator it_tracks = pose_triplet_tracks.begin();
-                  std::advance(it_tracks, *iterInliers);
-                  const Track & track = it_tracks->second;
-
-                  // create pairwise matches from inlier track
-                  for (size_t index_I = 0; index_I < track.featPerView.size() ; ++index_I)
-                  {
-                    Track::FeatureIdPerView::const_iterator iter_I = track.featPerView.begin();
-                    std::advance(iter_I, index_I);
-
-                    // extract camera indexes
-                    const size_t id_view_I = iter_I->first;
-                    const size_t id_feat_I = iter_I->second;
-
-                    // loop on subtracks
-                    for (size_t index_J = index_I+1; index_J < track.featPerView.size() ; ++index_J)
-                    {
-                      Track::FeatureIdPerView::const_iterator iter_J = track.featPerView.begin();
-                      std::advance(iter_J, index_J);
-
-                      // extract camera indexes
-                      const size_t id_view_J = iter_J->first;
-                      const size_t id_feat_J = iter_J->second;
-
-                      newpairMatches[std::make_pair(id_view_I, id_view_J)][track.descType].emplace_back(id_feat_I, id_feat_J);
-                    }
-                  }
+                  threadPairMatches[std::make_pair(iter_I->first, iter_J->first)][track.descType].emplace_back(iter_I->second, iter_J->second);
                 }
               }
             }
-            // Since a relative translation have been found for the edge: vec_edges[k],
-            //  we break and start to estimate the translations for some other edges.
-            break;
           }
+          // Since a relative translation have been found for the edge: vec_edges[k],
+          //  we break and start to estimate the translations for some other edges.
+          break;
         }
       }
     }
+    my_progress_bar += vec_edges.size() - my_progress_bar.count();
+
+    ALICEVISION_LOG_DEBUG(
+      "Edge coverage: " << nbEstimatedEdges << "/" << vec_edges.size() << " edges estimated from "
+      << nbEstimatedTriplets << "/" << nbTestedTriplets << " tested triplets in " << timerStep.elapsedMs() << " ms");
+
     // Merge thread estimates
-    for (const auto vec : initial_estimates)
+    for (const auto & vec : initial_estimates)
+    {
+      vec_initialEstimates.insert(vec_initialEstimates.end(), vec.begin(), vec.end());
+    }
+    // Merge thread pairwise matches
+    for (const matching::PairwiseMatches & threadPairMatches : newpairMatchesPerThread)
     {
-      for (const auto val : vec)
+      for (const auto & pairMatches : threadPairMatches)
       {
-        vec_initialEstimates.emplace_back(val);
+        for (const auto & descMatches : pairMatches.second)
+        {
+          matching::IndMatches & matches = newpairMatches[pairMatches.first][descMatches.first];
+          matches.insert(matches.end(), descMatches.second.begin(), descMatches.second.end());
+        }
       }
     }
   }
@@ -592,7 +647,7 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   const SfMData & sfm_data,
   const HashMap<IndexT, Mat3> & map_globalR,
   const feature::FeaturesPerView & normalizedFeaturesPerView,
-  const matching::PairwiseMatches & pairwiseMatches,
+  const matching::PairwiseMatches & map_triplet_matches,
   const graph::Triplet & poses_id,
   std::vector<Vec3> & vec_tis,
   double & dPrecision, // UpperBound of the precision found by the AContrario estimator
@@ -600,24 +655,6 @@ bool GlobalSfMTranslationAveragingSolver::Estimate_T_triplet(
   aliceVision::track::TracksMap & tracks,
   const std::string & sOutDirectory) const
 {
-  // List matches that belong to the triplet of poses
-  matching::PairwiseMatches map_triplet_matches;
-  const std::set<IndexT> set_pose_ids = {poses_id.i, poses_id.j, poses_id.k};
-  // List shared correspondences (pairs) between poses
-  for (const auto & match_iterator : pairwiseMatches)
-  {
-    const Pair & pair = match_iterator.first;
-    const View * v1 = sfm_data.GetViews().at(pair.first).get();
-    const View * v2 = sfm_data.GetViews().at(pair.second).get();
-    if (// Consider the pair iff it is supported by the triplet graph & 2 different pose id
-        (v1->getPoseId() != v2->getPoseId())
-        && set_pose_ids.count(v1->getPoseId())
-        && set_pose_ids.count(v2->getPoseId()))
-    {
-      map_triplet_matches.insert( match_iterator );
-    }
-  }
-
   aliceVision::track::TracksBuilder tracksBuilder;
   tracksBuilder.Build(map_triplet_matches);
   tracksBuilder.Filter(3);
@@ -66,11 +66,12 @@ private:
     matching::PairwiseMatches & newpairMatches);
 
   // Robust estimation and refinement of a translation and 3D points of an image triplets.
+  // triplet_matches must only contain the matches shared by the poses of the triplet.
   bool Estimate_T_triplet(
     const SfMData & sfm_data,
     const HashMap<IndexT, Mat3> & map_globalR,
     const feature::FeaturesPerView & normalizedFeaturesPerView,
-    const matching::PairwiseMatches & matches_provider,
+    const matching::PairwiseMatches & triplet_matches,
     const graph::Triplet & poses_id,
     std::vector<Vec3> & vec_tis,
     double & dPrecision, // UpperBound of the precision found by the AContrario estimator
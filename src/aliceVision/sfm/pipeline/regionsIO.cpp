@@ -6,18 +6,47 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include "regionsIO.hpp"
+#include <aliceVision/feature/CompressedRegions.hpp>
 
 #include <boost/progress.hpp>
 #include <boost/filesystem.hpp>
 
 #include <atomic>
 #include <cassert>
+#include <map>
+#include <mutex>
 
 namespace fs = boost::filesystem;
 
 namespace aliceVision {
 namespace sfm {
 
+namespace {
+
+/**
+ * @brief Load product quantizer codebooks, shared by all the compressed regions of the same codebooks file
+ * @param[in] path The codebooks file path
+ * @return the product quantizer
+ */
+std::shared_ptr<const feature::ProductQuantizer> loadProductQuantizer(const std::string& path)
+{
+  static std::mutex mutex;
+  static std::map<std::string, std::weak_ptr<const feature::ProductQuantizer>> quantizers;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<const feature::ProductQuantizer> quantizer = quantizers[path].lock();
+  if(!quantizer)
+  {
+    std::shared_ptr<feature::ProductQuantizer> loadedQuantizer = std::make_shared<feature::ProductQuantizer>();
+    loadedQuantizer->load(path);
+    quantizer = loadedQuantizer;
+    quantizers[path] = quantizer;
+  }
+  return quantizer;
+}
+
+} // namespace
+
 std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& folders,
                                               IndexT viewId,
                                               const feature::ImageDescriber& imageDescriber)
@@ -29,16 +58,27 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
 
   std::string featFilename;
   std::string descFilename;
+  std::string codebooksFilename;
 
   for(const std::string& folder : folders)
   {
     const fs::path featPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".feat");
     const fs::path descPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".desc");
+    // compressed descriptors and their codebooks (see aliceVision_compressDescriptors)
+    const fs::path pqDescPath = fs::path(folder) / std::string(basename + "." + imageDescriberTypeName + ".pqdesc");
+    const fs::path codebooksPath = fs::path(folder) / std::string(imageDescriberTypeName + ".pq");
 
     if(fs::exists(featPath) && fs::exists(descPath))
     {
       featFilename = featPath.string();
       descFilename = descPath.string();
+      codebooksFilename.clear();
+    }
+    else if(fs::exists(featPath) && fs::exists(pqDescPath) && fs::exists(codebooksPath))
+    {
+      featFilename = featPath.string();
+      descFilename = pqDescPath.string();
+      codebooksFilename = codebooksPath.string();
     }
   }
 
@@ -49,10 +89,14 @@ std::unique_ptr<feature::Regions> loadRegions(const std::vector<std::string>& fo
   ALICEVISION_LOG_TRACE("Descriptors filename: " << descFilename);
 
   std::unique_ptr<feature::Regions> regionsPtr;
-  imageDescriber.allocate(regionsPtr);
 
   try
   {
+    if(codebooksFilename.empty())
+      imageDescriber.allocate(regionsPtr);
+    else
+      regionsPtr.reset(new feature::CompressedRegions(loadProductQuantizer(codebooksFilename)));
+
     regionsPtr->Load(featFilename, descFilename);
   }
   catch(const std::exception& e)
@@ -21,6 +21,8 @@ namespace sfm {
 
 /**
  * @brief Load Regions (Features & Descriptors) for one view.
+ *        If a folder has no descriptors file (.desc) but compressed descriptors (.pqdesc)
+ *        and the codebooks of the describer type (<describerType>.pq), CompressedRegions are loaded.
  * @param[in] folders The list of featureFolders
  * @param[in] viewId The view id
  * @param[in] imageDescriber The imageDescriber type
@@ -0,0 +1,309 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/feature/ProductQuantizer.hpp>
+#include <aliceVision/feature/Regions.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/algorithm/string/predicate.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+using namespace aliceVision;
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+/**
+ * @brief Get the descriptors of scalar regions in float
+ * @return false if the descriptor type is not supported
+ */
+bool getFloatDescriptors(const feature::Regions& regions, std::vector<float>& descriptors)
+{
+  const std::size_t size = regions.RegionCount() * regions.DescriptorLength();
+
+  if(!regions.IsScalar())
+    return false;
+
+  if(regions.Type_id() == typeid(unsigned char).name())
+  {
+    const unsigned char* data = static_cast<const unsigned char*>(regions.DescriptorRawData());
+    descriptors.assign(data, data + size);
+    return true;
+  }
+  if(regions.Type_id() == typeid(float).name())
+  {
+    const float* data = static_cast<const float*>(regions.DescriptorRawData());
+    descriptors.assign(data, data + size);
+    return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Read the number of descriptors of a descriptors file (header only)
+ */
+std::size_t getNbDescriptors(const std::string& descPath)
+{
+  std::ifstream file(descPath, std::ios::binary);
+  std::size_t nbDescriptors = 0;
+  file.read(reinterpret_cast<char*>(&nbDescriptors), sizeof(std::size_t));
+  return file ? nbDescriptors : 0;
+}
+
+int main( int argc, char** argv )
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::string inputFolder;
+  std::string outputFolder;
+  std::string describerTypesName = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  std::string codebooksFilepath;
+  int nbSubspaces = 16;
+  std::size_t maxTrainingDescriptors = 100000;
+  int nbIterations = 20;
+
+  po::options_description allParams("This program compresses the descriptors of a features folder with a product quantizer.\n"
+                                    "The output folder stores the features, the compressed descriptors (.pqdesc) and the codebooks (<describerType>.pq),\n"
+                                    "it can be used as features folder of featureMatching with the BRUTE_FORCE_PQ_L2 matcher.\n"
+                                    "AliceVision compressDescriptors");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::string>(&inputFolder)->required(),
+      "Input folder containing the features and descriptors files.")
+    ("output,o", po::value<std::string>(&outputFolder)->required(),
+      "Output folder that stores the features, the compressed descriptors and the codebooks (different from the input folder).");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("describerTypes,d", po::value<std::string>(&describerTypesName)->default_value(describerTypesName),
+      feature::EImageDescriberType_informations().c_str())
+    ("codebooks", po::value<std::string>(&codebooksFilepath)->default_value(codebooksFilepath),
+      "Existing product quantizer codebooks file (only for one describer type). "
+      "If empty, the codebooks are trained on the input descriptors and saved in the output folder.")
+    ("nbSubspaces", po::value<int>(&nbSubspaces)->default_value(nbSubspaces),
+      "Number of subspaces of the product quantizer: size in bytes of a compressed descriptor.")
+    ("maxTrainingDescriptors", po::value<std::size_t>(&maxTrainingDescriptors)->default_value(maxTrainingDescriptors),
+      "Maximum number of descriptors (randomly sampled) used to train the codebooks.")
+    ("nbIterations", po::value<int>(&nbIterations)->default_value(nbIterations),
+      "Number of k-means iterations to train the codebooks.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal,  error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  if(!(fs::exists(inputFolder) && fs::is_directory(inputFolder)))
+  {
+    ALICEVISION_LOG_ERROR(inputFolder << " does not exists or it is not a folder");
+    return EXIT_FAILURE;
+  }
+
+  const std::vector<feature::EImageDescriberType> describerTypes = feature::EImageDescriberType_stringToEnums(describerTypesName);
+
+  if(!codebooksFilepath.empty() && describerTypes.size() != 1)
+  {
+    ALICEVISION_LOG_ERROR("An existing codebooks file can only be used with one describer type.");
+    return EXIT_FAILURE;
+  }
+
+  // if the folder does not exist create it (recursively)
+  if(!fs::exists(outputFolder))
+  {
+    fs::create_directories(outputFolder);
+  }
+
+  // the regions loading prefers the uncompressed descriptors of a folder
+  if(fs::equivalent(inputFolder, outputFolder))
+  {
+    ALICEVISION_LOG_ERROR("The output folder should be different from the input folder.");
+    return EXIT_FAILURE;
+  }
+
+  for(feature::EImageDescriberType describerType : describerTypes)
+  {
+    const std::string describerTypeName = feature::EImageDescriberType_enumToString(describerType);
+    std::unique_ptr<feature::ImageDescriber> imageDescriber = feature::createImageDescriber(describerType);
+
+    // list the regions files of this describer type
+    std::vector<fs::path> descPaths;
+    std::size_t nbDescriptors = 0;
+    for(fs::directory_iterator it(inputFolder); it != fs::directory_iterator(); ++it)
+    {
+      const fs::path& path = it->path();
+      if(boost::algorithm::ends_with(path.filename().string(), "." + describerTypeName + ".desc") &&
+         fs::exists(fs::path(path).replace_extension(".feat")))
+      {
+        descPaths.push_back(path);
+        nbDescriptors += getNbDescriptors(path.string());
+      }
+    }
+
+    if(descPaths.empty())
+    {
+      ALICEVISION_LOG_WARNING("No " << describerTypeName << " regions files in " << inputFolder);
+      continue;
+    }
+
+    const auto loadRegions = [&](const fs::path& descPath) {
+      std::unique_ptr<feature::Regions> regions;
+      imageDescriber->allocate(regions);
+      regions->Load(fs::path(descPath).replace_extension(".feat").string(), descPath.string());
+      return regions;
+    };
+
+    feature::ProductQuantizer quantizer;
+
+    if(!codebooksFilepath.empty())
+    {
+      quantizer.load(codebooksFilepath);
+    }
+    else
+    {
+      // random subset of the descriptors
+      const double samplingRate = std::min(1.0, double(maxTrainingDescriptors) / nbDescriptors);
+      std::mt19937 generator(0);
+      std::bernoulli_distribution samplingDistribution(samplingRate);
+
+      std::vector<float> trainingDescriptors;
+      std::vector<float> descriptors;
+      int dimension = 0;
+
+      for(const fs::path& descPath : descPaths)
+      {
+        std::unique_ptr<feature::Regions> regions = loadRegions(descPath);
+        if(!getFloatDescriptors(*regions, descriptors))
+        {
+          ALICEVISION_LOG_ERROR("The " << describerTypeName << " descriptors can't be compressed (binary descriptors).");
+          return EXIT_FAILURE;
+        }
+        dimension = regions->DescriptorLength();
+        for(std::size_t i = 0; i < regions->RegionCount(); ++i)
+        {
+          if(samplingDistribution(generator))
+            trainingDescriptors.insert(trainingDescriptors.end(), descriptors.begin() + i * dimension, descriptors.begin() + (i + 1) * dimension);
+        }
+      }
+
+      const std::size_t nbTrainingDescriptors = trainingDescriptors.size() / std::max(1, dimension);
+      ALICEVISION_LOG_INFO("Train the " << describerTypeName << " codebooks with " << nbTrainingDescriptors << " descriptors.");
+
+      try
+      {
+        quantizer = feature::ProductQuantizer(dimension, nbSubspaces);
+        quantizer.train(trainingDescriptors.data(), nbTrainingDescriptors, nbIterations);
+      }
+      catch(const std::exception& e)
+      {
+        ALICEVISION_LOG_ERROR(e.what());
+        return EXIT_FAILURE;
+      }
+    }
+
+    // the codebooks are loaded with the compressed descriptors of the output folder
+    quantizer.save((fs::path(outputFolder) / (describerTypeName + ".pq")).string());
+
+    // compress the descriptors of each view
+    std::size_t inputSize = 0;
+    std::size_t outputSize = 0;
+    double quantizationError = 0.0;
+    double descriptorsNorm = 0.0;
+
+    for(const fs::path& descPath : descPaths)
+    {
+      std::unique_ptr<feature::Regions> regions = loadRegions(descPath);
+      std::vector<float> descriptors;
+      getFloatDescriptors(*regions, descriptors);
+
+      if(regions->DescriptorLength() != static_cast<std::size_t>(quantizer.getDimension()))
+      {
+        ALICEVISION_LOG_ERROR("The codebooks dimension (" << quantizer.getDimension() << ") does not match the "
+                              << describerTypeName << " descriptors dimension (" << regions->DescriptorLength() << ").");
+        return EXIT_FAILURE;
+      }
+
+      const int dimension = quantizer.getDimension();
+      const int codeSize = quantizer.getCodeSize();
+      std::vector<unsigned char> codes(regions->RegionCount() * codeSize);
+      std::vector<float> decoded(dimension);
+
+      for(std::size_t i = 0; i < regions->RegionCount(); ++i)
+      {
+        const float* descriptor = descriptors.data() + i * dimension;
+        quantizer.encode(descriptor, &codes[i * codeSize]);
+        quantizer.decode(&codes[i * codeSize], decoded.data());
+        for(int d = 0; d < dimension; ++d)
+        {
+          quantizationError += (descriptor[d] - decoded[d]) * (descriptor[d] - decoded[d]);
+          descriptorsNorm += descriptor[d] * descriptor[d];
+        }
+      }
+
+      const fs::path featPath = fs::path(descPath).replace_extension(".feat");
+      const fs::path outputDescPath = fs::path(outputFolder) / fs::path(descPath.filename()).replace_extension(".pqdesc");
+
+      // just copy the features file into the output folder
+      fs::copy_file(featPath, fs::path(outputFolder) / featPath.filename(), fs::copy_option::overwrite_if_exists);
+      feature::saveCompressedDescsToBinFile(outputDescPath.string(), codes, codeSize);
+
+      inputSize += fs::file_size(descPath);
+      outputSize += fs::file_size(outputDescPath);
+    }
+
+    ALICEVISION_LOG_INFO("Compressed " << descPaths.size() << " " << describerTypeName << " descriptors files:" << std::endl
+                         << "\t- size: " << inputSize << " bytes -> " << outputSize << " bytes"
+                         << " (ratio: " << double(inputSize) / std::max<std::size_t>(1, outputSize) << ")" << std::endl
+                         << "\t- relative quantization error: " << std::sqrt(quantizationError / std::max(1e-12, descriptorsNorm)));
+  }
+
+  return EXIT_SUCCESS;
+}
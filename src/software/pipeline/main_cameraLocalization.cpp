@@ -10,6 +10,7 @@
 #include <aliceVision/localization/CCTagLocalizer.hpp>
 #endif
 #include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/localization/LocalizationPipeline.hpp>
 #include <aliceVision/localization/optimization.hpp>
 #include <aliceVision/image/io.hpp>
 #include <aliceVision/dataio/FeedProvider.hpp>
@@ -101,6 +102,8 @@ int main(int argc, char** argv)
   std::string weightsFilepath;
   /// Number of previous frame of the sequence to use for matching
   std::size_t nbFrameBufferMatching = 10;
+  /// Number of frames decoded and described ahead of the frame being localized
+  std::size_t nbInFlightFrames = 1;
   /// enable/disable the robust matching (geometric validation) when matching query image
   /// and databases images
   bool robustMatching = true;
@@ -188,6 +191,10 @@ int main(int argc, char** argv)
       ("nbFrameBufferMatching", po::value<std::size_t>(&nbFrameBufferMatching)->default_value(nbFrameBufferMatching),
           "[voctree] Number of previous frame of the sequence to use for matching "
           "(0 = Disable)")
+      ("nbInFlightFrames", po::value<std::size_t>(&nbInFlightFrames)->default_value(nbInFlightFrames),
+          "[voctree] Number of frames in flight in the localization pipeline: the next frames "
+          "are decoded, described and queried in the database while the current one is localized "
+          "(1 = sequential processing)")
       ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching), 
           "[voctree] Enable/Disable the robust matching between query and database images, "
           "all putative matches will be considered.")
@@ -401,24 +408,14 @@ int main(int argc, char** argv)
   bacc::accumulator_set<double, bacc::stats<bacc::tag::mean, bacc::tag::min, bacc::tag::max, bacc::tag::sum > > stats;
   
   std::vector<localization::LocalizationResult> vec_localizationResults;
-  
-  while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+
+  const auto processResult = [&](const localization::LocalizationResult& localizationResult,
+                                 const camera::PinholeRadialK3& queryIntrinsics,
+                                 const std::string& currentImgName,
+                                 double elapsedMs)
   {
-    ALICEVISION_COUT("******************************");
-    ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
-    ALICEVISION_COUT("******************************");
-    localization::LocalizationResult localizationResult;
-    auto detect_start = std::chrono::steady_clock::now();
-    localizer->localize(imageGrey, 
-                       param.get(),
-                       hasIntrinsics /*useInputIntrinsics*/,
-                       queryIntrinsics,
-                       localizationResult,
-                       currentImgName);
-    auto detect_end = std::chrono::steady_clock::now();
-    auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
-    ALICEVISION_COUT("\nLocalization took  " << detect_elapsed.count() << " [ms]");
-    stats(detect_elapsed.count());
+    ALICEVISION_COUT("\nLocalization took  " << elapsedMs << " [ms]");
+    stats(elapsedMs);
     
     vec_localizationResults.emplace_back(localizationResult);
 
@@ -440,7 +437,44 @@ int main(int argc, char** argv)
 #endif
     }
     ++frameCounter;
-    feed.goToNextFrame();
+  };
+
+  if(useVoctreeLocalizer && nbInFlightFrames > 1)
+  {
+    // decode, describe and query the next frames while the current one is localized
+    localization::LocalizationPipeline pipeline(*static_cast<localization::VoctreeLocalizer*>(localizer.get()),
+                                                *static_cast<localization::VoctreeLocalizer::Parameters*>(param.get()),
+                                                nbInFlightFrames);
+
+    pipeline.run(feed, [&](localization::PipelineFrame& frame)
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("Description and database query took  " << frame.describeTimeMs << " [ms]");
+      processResult(frame.localizationResult, frame.queryIntrinsics, frame.imagePath, frame.localizeTimeMs);
+    });
+  }
+  else
+  {
+    while(feed.readImage(imageGrey, queryIntrinsics, currentImgName, hasIntrinsics))
+    {
+      ALICEVISION_COUT("******************************");
+      ALICEVISION_COUT("FRAME " << myToString(frameCounter,4));
+      ALICEVISION_COUT("******************************");
+      localization::LocalizationResult localizationResult;
+      auto detect_start = std::chrono::steady_clock::now();
+      localizer->localize(imageGrey, 
+                         param.get(),
+                         hasIntrinsics /*useInputIntrinsics*/,
+                         queryIntrinsics,
+                         localizationResult,
+                         currentImgName);
+      auto detect_end = std::chrono::steady_clock::now();
+      auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
+      processResult(localizationResult, queryIntrinsics, currentImgName, detect_elapsed.count());
+      feed.goToNextFrame();
+    }
   }
 
   if(wantsJsonOutput)
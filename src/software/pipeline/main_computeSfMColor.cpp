@@ -4,12 +4,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/sfm/sfm.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
 #include <aliceVision/config.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
 #include <boost/program_options.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -26,6 +28,8 @@ int main(int argc, char **argv)
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outputSfMDataFilename;
+  std::string decodedImageCacheFolder;
+  std::size_t decodedImageCacheMaxSize = image::DecodedImageCache::defaultMaxSize;
 
   po::options_description allParams("AliceVision computeSfMColor");
 
@@ -40,12 +44,19 @@ int main(int argc, char **argv)
 #endif
       ").");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("decodedImageCache", po::value<std::string>(&decodedImageCacheFolder)->default_value(decodedImageCacheFolder),
+      "Folder of the decoded images cache shared by the pipeline stages (empty to disable).")
+    ("decodedImageCacheMaxSize", po::value<std::size_t>(&decodedImageCacheMaxSize)->default_value(decodedImageCacheMaxSize),
+      "Maximum size of the decoded images cache folder in MB, the least recently used images are removed (0 for no limit).");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal, error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -92,8 +103,12 @@ int main(int argc, char **argv)
     return EXIT_FAILURE;
   }
 
+  std::unique_ptr<image::DecodedImageCache> imageCache;
+  if(!decodedImageCacheFolder.empty())
+    imageCache.reset(new image::DecodedImageCache(decodedImageCacheFolder, decodedImageCacheMaxSize));
+
   // Compute the scene structure color
-  if (!ColorizeTracks(sfm_data))
+  if (!ColorizeTracks(sfm_data, imageCache.get()))
   {
     ALICEVISION_LOG_ERROR("Error while trying to colorize the tracks! Aborting...");
   }
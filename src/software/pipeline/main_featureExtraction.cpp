@@ -6,6 +6,7 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/alicevision_omp.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/feature/imageDescriberCommon.hpp>
 #include <aliceVision/feature/feature.hpp>
@@ -27,9 +28,14 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iomanip>
 #include <functional>
 #include <memory>
 #include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <numeric>
+#include <algorithm>
 
 using namespace aliceVision;
 
@@ -42,6 +48,7 @@ class FeatureExtractor
   {
     const sfm::View& view;
     std::size_t memoryConsuption = 0;
+    int maxNbThreads = 1;
     std::string outputBasename;
     std::vector<std::size_t> cpuImageDescriberIndexes;
     std::vector<std::size_t> gpuImageDescriberIndexes;
@@ -86,9 +93,14 @@ class FeatureExtractor
         memoryConsuption += imageDescriber->getMemoryConsumption(view.getWidth(), view.getHeight());
 
         if(imageDescriber->useCuda())
+        {
           gpuImageDescriberIndexes.push_back(i);
+        }
         else
+        {
           cpuImageDescriberIndexes.push_back(i);
+          maxNbThreads = std::max(maxNbThreads, imageDescriber->getMaxNbThreads(view.getWidth(), view.getHeight()));
+        }
       }
     }
   };
@@ -115,6 +127,11 @@ public:
     _outputFolder = folder;
   }
 
+  void setDecodedImageCache(const std::shared_ptr<image::DecodedImageCache>& imageCache)
+  {
+    _imageCache = imageCache;
+  }
+
   void addImageDescriber(std::shared_ptr<feature::ImageDescriber>& imageDescriber)
   {
     _imageDescribers.push_back(imageDescriber);
@@ -152,57 +169,175 @@ public:
     }
 
     if(!_cpuJobs.empty())
+      processCpuJobs(jobMaxMemoryConsuption);
+
+    if(!_gpuJobs.empty())
     {
-      system::MemoryInfo memoryInformation = system::getMemoryInfo();
+      for(const auto& job : _gpuJobs)
+        computeViewJob(job, true);
+    }
+  }
 
-      ALICEVISION_LOG_DEBUG("Job max memory consumption: " << jobMaxMemoryConsuption << " B");
-      ALICEVISION_LOG_DEBUG("Memory information: " << std::endl <<memoryInformation);
+private:
 
-      if(jobMaxMemoryConsuption == 0)
-        throw std::runtime_error("Can't compute feature extraction job max memory consuption.");
+  /**
+   * @brief Statistics of a processed view job
+   */
+  struct ViewJobReport
+  {
+    double timeMs = 0.0;
+    int nbThreads = 0;
+    std::size_t nbRegions = 0;
+  };
 
-      std::size_t nbThreads =  (0.9 * memoryInformation.freeRam) / jobMaxMemoryConsuption;
+  /**
+   * @brief Process the CPU jobs, several images at a time.
+   *
+   * The jobs are started from the most memory consuming to the least one.
+   * A job starts only if its memory consumption fits in the free memory not reserved by the running jobs
+   * (the first job always starts). The cores left by the running jobs are shared between the remaining jobs:
+   * with more jobs than cores, each image is processed by one thread; at the end of the queue,
+   * the multithreaded image describers get several threads per image.
+   *
+   * @param[in] jobMaxMemoryConsuption the memory consumption of the most consuming job
+   */
+  void processCpuJobs(std::size_t jobMaxMemoryConsuption)
+  {
+    const system::MemoryInfo memoryInformation = system::getMemoryInfo();
 
-      if(memoryInformation.freeRam == 0)
-      {
-        ALICEVISION_LOG_WARNING("Can't find available system memory, this can be due to OS limitations.\n"
-                                "Use only one thread for CPU feature extraction.");
-        nbThreads = 1;
-      }
+    ALICEVISION_LOG_DEBUG("Job max memory consumption: " << jobMaxMemoryConsuption << " B");
+    ALICEVISION_LOG_DEBUG("Memory information: " << std::endl <<memoryInformation);
 
-      // nbThreads should not be higher than user maxThreads param
-      if(_maxThreads > 0)
-        nbThreads = std::min(static_cast<std::size_t>(_maxThreads), nbThreads);
+    if(jobMaxMemoryConsuption == 0)
+      throw std::runtime_error("Can't compute feature extraction job max memory consuption.");
 
-      // nbThreads should not be higher than the core number
-      nbThreads = std::min(static_cast<std::size_t>(omp_get_num_procs()), nbThreads);
+    int nbCores = omp_get_num_procs();
 
-      // nbThreads should not be higher than the job number
-      nbThreads = std::min(_cpuJobs.size(), nbThreads);
+    // nbCores should not be higher than user maxThreads param
+    if(_maxThreads > 0)
+      nbCores = std::min(_maxThreads, nbCores);
 
-      ALICEVISION_LOG_DEBUG("# threads for extraction: " << nbThreads);
-      omp_set_nested(1);
+    std::size_t memoryBudget = 0.9 * memoryInformation.freeRam;
 
-#pragma omp parallel for num_threads(nbThreads)
-      for(int i = 0; i < _cpuJobs.size(); ++i)
-        computeViewJob(_cpuJobs.at(i));
+    if(memoryInformation.freeRam == 0)
+    {
+      ALICEVISION_LOG_WARNING("Can't find available system memory, this can be due to OS limitations.\n"
+                              "Use only one image at a time for CPU feature extraction.");
+      memoryBudget = 0;
     }
 
-    if(!_gpuJobs.empty())
+    // most memory consuming jobs first, the small ones fill the gaps at the end
+    std::vector<std::size_t> jobOrder(_cpuJobs.size());
+    std::iota(jobOrder.begin(), jobOrder.end(), 0);
+    std::stable_sort(jobOrder.begin(), jobOrder.end(), [&](std::size_t a, std::size_t b) {
+      return _cpuJobs.at(a).memoryConsuption > _cpuJobs.at(b).memoryConsuption;
+    });
+
+    // nbWorkers should not be higher than the number of the smallest jobs fitting in memory
+    std::size_t nbWorkers = std::max(std::size_t(1), memoryBudget / std::max(std::size_t(1), _cpuJobs.at(jobOrder.back()).memoryConsuption));
+    nbWorkers = std::min(static_cast<std::size_t>(nbCores), nbWorkers);
+    nbWorkers = std::min(_cpuJobs.size(), nbWorkers);
+
+    ALICEVISION_LOG_DEBUG("# cores for extraction: " << nbCores << ", max # images in parallel: " << nbWorkers);
+
+    std::vector<ViewJobReport> reports(_cpuJobs.size());
+    std::mutex mutex;
+    std::condition_variable jobFinished;
+    std::size_t nextJob = 0;
+    std::size_t nbRunningJobs = 0;
+    std::size_t reservedMemory = 0;
+    int nbUsedCores = 0;
+
+    omp_set_nested(1);
+
+#pragma omp parallel num_threads(nbWorkers)
     {
-      for(const auto& job : _gpuJobs)
-        computeViewJob(job, true);
+      while(true)
+      {
+        std::size_t jobIndex;
+        int nbThreads;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          if(nextJob == _cpuJobs.size())
+            break;
+          jobIndex = jobOrder.at(nextJob++);
+          const ViewJob& job = _cpuJobs.at(jobIndex);
+
+          // wait for enough memory and a free core
+          jobFinished.wait(lock, [&] {
+            if(nbRunningJobs == 0)
+              return true;
+            if(nbUsedCores >= nbCores)
+              return false;
+            // live check, the running jobs may not have allocated their memory yet
+            const std::size_t liveBudget = reservedMemory + 0.9 * system::getMemoryInfo().freeRam;
+            return reservedMemory + job.memoryConsuption <= std::min(memoryBudget, liveBudget);
+          });
+
+          const int nbFreeCores = std::max(1, nbCores - nbUsedCores);
+          const int nbWaitingJobs = static_cast<int>(_cpuJobs.size() - nextJob) + 1;
+          nbThreads = std::min(job.maxNbThreads, std::max(1, nbFreeCores / nbWaitingJobs));
+
+          ++nbRunningJobs;
+          reservedMemory += job.memoryConsuption;
+          nbUsedCores += nbThreads;
+        }
+
+        const ViewJob& job = _cpuJobs.at(jobIndex);
+        ViewJobReport& report = reports.at(jobIndex);
+        report.nbThreads = nbThreads;
+
+        // number of threads of the image describers parallel regions
+        omp_set_num_threads(nbThreads);
+
+        system::Timer timer;
+        report.nbRegions = computeViewJob(job);
+        report.timeMs = timer.elapsedMs();
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          --nbRunningJobs;
+          reservedMemory -= job.memoryConsuption;
+          nbUsedCores -= nbThreads;
+        }
+        jobFinished.notify_all();
+      }
     }
-  }
 
-private:
+    // per image report
+    std::stringstream ss;
+    ss << "CPU feature extraction report:" << std::endl
+       << "\t" << std::left << std::setw(12) << "view id" << std::setw(12) << "size (MP)" << std::setw(12) << "memory (MB)"
+       << std::setw(10) << "threads" << std::setw(12) << "time (s)" << "regions" << std::endl;
+    for(std::size_t i = 0; i < _cpuJobs.size(); ++i)
+    {
+      const ViewJob& job = _cpuJobs.at(i);
+      const ViewJobReport& report = reports.at(i);
+      ss << "\t" << std::setw(12) << job.view.getViewId()
+         << std::setw(12) << std::setprecision(3) << (job.view.getWidth() * job.view.getHeight() / 1000000.0)
+         << std::setw(12) << (job.memoryConsuption / (1024 * 1024))
+         << std::setw(10) << report.nbThreads
+         << std::setw(12) << std::setprecision(3) << (report.timeMs / 1000.0)
+         << report.nbRegions << std::endl;
+    }
+    ALICEVISION_LOG_INFO(ss.str());
+  }
 
-  void computeViewJob(const ViewJob& job, bool useGPU = false)
+  /**
+   * @brief Compute and save the features of a view job
+   * @return the number of extracted regions
+   */
+  std::size_t computeViewJob(const ViewJob& job, bool useGPU = false)
   {
+    std::size_t nbRegions = 0;
+
     image::Image<float> imageGrayFloat;
     image::Image<unsigned char> imageGrayUChar;
 
-    image::readImage(job.view.getImagePath(), imageGrayFloat);
+    if(_imageCache)
+      _imageCache->readImage(job.view.getImagePath(), imageGrayFloat, job.view.getViewId());
+    else
+      image::readImage(job.view.getImagePath(), imageGrayFloat);
 
     const auto imageDescriberIndexes = useGPU ? job.gpuImageDescriberIndexes : job.cpuImageDescriberIndexes;
 
@@ -230,12 +365,15 @@ private:
       }
       imageDescriber->Save(regions.get(), job.getFeaturesPath(imageDescriberType), job.getDescriptorPath(imageDescriberType));
       ALICEVISION_LOG_INFO(std::left << std::setw(6) << " " << regions->RegionCount() << " " << imageDescriberTypeName  << " features extracted from view '" << job.view.getImagePath() << "'");
+      nbRegions += regions->RegionCount();
     }
+    return nbRegions;
   }
 
   const sfm::SfMData& _sfmData;
   std::vector<std::shared_ptr<feature::ImageDescriber>> _imageDescribers;
   std::string _outputFolder;
+  std::shared_ptr<image::DecodedImageCache> _imageCache;
   int _rangeStart = -1;
   int _rangeSize = -1;
   int _maxThreads = -1;
@@ -263,6 +401,8 @@ int main(int argc, char **argv)
   int rangeSize = 1;
   int maxThreads = 0;
   bool forceCpuExtraction = false;
+  std::string decodedImageCacheFolder;
+  std::size_t decodedImageCacheMaxSize = image::DecodedImageCache::defaultMaxSize;
 
   po::options_description allParams("AliceVision featureExtraction");
 
@@ -289,7 +429,11 @@ int main(int argc, char **argv)
     ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
       "Range size.")
     ("maxThreads", po::value<int>(&maxThreads)->default_value(maxThreads),
-      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).");
+      "Specifies the maximum number of threads to run simultaneously (0 for automatic mode).")
+    ("decodedImageCache", po::value<std::string>(&decodedImageCacheFolder)->default_value(decodedImageCacheFolder),
+      "Folder of the decoded images cache shared by the pipeline stages (empty to disable).")
+    ("decodedImageCacheMaxSize", po::value<std::size_t>(&decodedImageCacheMaxSize)->default_value(decodedImageCacheMaxSize),
+      "Maximum size of the decoded images cache folder in MB, the least recently used images are removed (0 for no limit).");
 
   po::options_description logParams("Log parameters");
   logParams.add_options()
@@ -362,6 +506,10 @@ int main(int argc, char **argv)
   FeatureExtractor extractor(sfmData);
   extractor.setOutputFolder(outputFolder);
 
+  // set decoded image cache
+  if(!decodedImageCacheFolder.empty())
+    extractor.setDecodedImageCache(std::make_shared<image::DecodedImageCache>(decodedImageCacheFolder, decodedImageCacheMaxSize));
+
   // set maxThreads
   extractor.setMaxThreads(maxThreads);
 
@@ -146,6 +146,8 @@ int main(int argc, char **argv)
       "* CASCADE_HASHING_L2: L2 Cascade Hashing matching\n"
       "* FAST_CASCADE_HASHING_L2: L2 Cascade Hashing with precomputed hashed regions\n"
       "(faster than CASCADE_HASHING_L2 but use more memory)\n"
+      "* BRUTE_FORCE_PQ_L2: L2 BruteForce matching on the compressed descriptors (.pqdesc)\n"
+      "(see aliceVision_compressDescriptors)\n"
       "For Binary based descriptor:\n"
       "* BRUTE_FORCE_HAMMING: BruteForce Hamming matching")
     ("geometricEstimator", po::value<std::string>(&geometricEstimatorName)->default_value(geometricEstimatorName),
@@ -0,0 +1,392 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/config.hpp>
+#include <aliceVision/localization/VoctreeLocalizer.hpp>
+#include <aliceVision/localization/LocalizationServer.hpp>
+#include <aliceVision/localization/LocalizationResult.hpp>
+#include <aliceVision/dataio/IFeed.hpp>
+#include <aliceVision/feature/ImageDescriber.hpp>
+#include <aliceVision/feature/imageDescriberCommon.hpp>
+#include <aliceVision/sfm/SfMData.hpp>
+#include <aliceVision/sfm/sfmDataIO.hpp>
+#include <aliceVision/robustEstimation/estimators.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/Timer.hpp>
+#include <aliceVision/system/cmdline.hpp>
+
+#include <boost/algorithm/string/trim.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace bfs = boost::filesystem;
+namespace po = boost::program_options;
+
+using namespace aliceVision;
+
+/**
+ * @brief Escape a string for a JSON string value.
+ */
+std::string jsonEscape(const std::string& str)
+{
+  std::ostringstream os;
+  for(const char c : str)
+  {
+    switch(c)
+    {
+      case '"':  os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\b': os << "\\b"; break;
+      case '\f': os << "\\f"; break;
+      case '\n': os << "\\n"; break;
+      case '\r': os << "\\r"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if(static_cast<unsigned char>(c) < 0x20)
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        else
+          os << c;
+    }
+  }
+  return os.str();
+}
+
+/**
+ * @brief Write a response as a single line of JSON.
+ */
+void writeResponse(std::ostream& os, const localization::LocalizationResponse& response)
+{
+  const localization::LocalizationResult& result = response.result;
+
+  os << "{\"frameId\": " << response.frameId
+     << ", \"image\": \"" << jsonEscape(response.imagePath) << "\""
+     << ", \"localized\": " << (result.isValid() ? "true" : "false")
+     << ", \"nbInliers\": " << (result.isValid() ? result.getInliers().size() : 0)
+     << ", \"queueTimeMs\": " << response.queueTimeMs
+     << ", \"processingTimeMs\": " << response.processingTimeMs
+     << ", \"latencyMs\": " << response.latencyMs;
+
+  if(result.isValid())
+  {
+    const Mat3& R = result.getPose().rotation();
+    const Vec3& C = result.getPose().center();
+    os << ", \"rotation\": [";
+    for(int i = 0; i < 9; ++i)
+      os << (i ? ", " : "") << R(i / 3, i % 3);
+    os << "], \"center\": [" << C(0) << ", " << C(1) << ", " << C(2) << "]";
+  }
+  os << "}" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  /// the calibration file
+  std::string calibFile;
+  /// the AliceVision .json data file
+  std::string sfmFilePath;
+  /// the folder containing the descriptors
+  std::string descriptorsFolder;
+  /// the file or named pipe from which the requests are read
+  std::string requestsPath = "-";
+  /// the file or named pipe to which the responses are written
+  std::string responsesPath = "-";
+  /// number of frames processed concurrently
+  std::size_t nbWorkers = 0;
+  /// the number of processed frames between two latency reports
+  std::size_t reportInterval = 100;
+
+  /// the describer types name to use for the matching
+  std::string matchDescTypeNames = feature::EImageDescriberType_enumToString(feature::EImageDescriberType::SIFT);
+  /// the preset for the feature extractor
+  feature::EImageDescriberPreset featurePreset = feature::EImageDescriberPreset::NORMAL;
+  /// the estimator to use for resection
+  robustEstimation::ERobustEstimator resectionEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  /// the estimator to use for matching
+  robustEstimation::ERobustEstimator matchingEstimator = robustEstimation::ERobustEstimator::ACRANSAC;
+  /// the possible choices for the estimators as strings
+  const std::string str_estimatorChoices = robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::ACRANSAC)
+                                          +", "+robustEstimation::ERobustEstimator_enumToString(robustEstimation::ERobustEstimator::LORANSAC);
+  bool refineIntrinsics = false;
+  /// the maximum reprojection error allowed for resection
+  double resectionErrorMax = 4.0;
+  /// the maximum reprojection error allowed for image matching with geometric validation
+  double matchingErrorMax = 4.0;
+
+  // voctree parameters
+  std::string algostring = "AllResults";
+  /// number of similar images to search when querying the voctree
+  std::size_t numResults = 4;
+  /// maximum number of successfully matched similar images
+  std::size_t maxResults = 10;
+  /// the vocabulary tree file
+  std::string vocTreeFilepath;
+  /// the vocabulary tree weights file
+  std::string weightsFilepath;
+  /// enable/disable the robust matching (geometric validation) when matching query image
+  /// and databases images
+  bool robustMatching = true;
+
+  /// the JSON export file
+  std::string exportJsonFile = "";
+
+  po::options_description allParams(
+      "This program keeps a localization database (vocabulary tree, 3D scene data) in memory "
+      "and localizes the images whose paths are received, one per line, on a file or a named pipe.\n"
+      "The line \"quit\" stops the server. For each frame, a line of JSON is written with the pose "
+      "and the latency of the localization.\n"
+      "Example with a named pipe:\n"
+      "  mkfifo requests && aliceVision_localizationServer --requests requests ...\n"
+      "  ls images/*.jpg > requests");
+
+  po::options_description inputParams("Required input parameters");
+  inputParams.add_options()
+      ("sfmdata", po::value<std::string>(&sfmFilePath)->required(),
+          "The sfm_data.json kind of file generated by AliceVision.")
+      ("voctree", po::value<std::string>(&vocTreeFilepath)->required(),
+          "Filename for the vocabulary tree");
+
+  po::options_description serverParams("Server parameters");
+  serverParams.add_options()
+      ("requests", po::value<std::string>(&requestsPath)->default_value(requestsPath),
+          "File or named pipe providing the image paths to localize (- for the standard input). "
+          "A named pipe is reopened each time a client closes it.")
+      ("responses", po::value<std::string>(&responsesPath)->default_value(responsesPath),
+          "File or named pipe receiving the localization results (- for the standard output).")
+      ("nbWorkers", po::value<std::size_t>(&nbWorkers)->default_value(nbWorkers),
+          "Number of frames processed concurrently (0 = number of cores).")
+      ("reportInterval", po::value<std::size_t>(&reportInterval)->default_value(reportInterval),
+          "Log the latency statistics every given number of frames (0 = only at exit).");
+
+  po::options_description commonParams(
+      "Common optional parameters for the localizer");
+  commonParams.add_options()
+      ("descriptorPath", po::value<std::string>(&descriptorsFolder),
+          "Folder containing the descriptors for all the images (ie the *.desc.)")
+      ("matchDescTypes", po::value<std::string>(&matchDescTypeNames)->default_value(matchDescTypeNames),
+          "The describer types to use for the matching")
+      ("preset", po::value<feature::EImageDescriberPreset>(&featurePreset)->default_value(featurePreset),
+          "Preset for the feature extractor when localizing a new image "
+          "{LOW,MEDIUM,NORMAL,HIGH,ULTRA}")
+      ("resectionEstimator", po::value<robustEstimation::ERobustEstimator>(&resectionEstimator)->default_value(resectionEstimator),
+          std::string("The type of *sac framework to use for resection "
+          "("+str_estimatorChoices+")").c_str())
+      ("matchingEstimator", po::value<robustEstimation::ERobustEstimator>(&matchingEstimator)->default_value(matchingEstimator),
+          std::string("The type of *sac framework to use for matching "
+          "("+str_estimatorChoices+")").c_str())
+      ("calibration", po::value<std::string>(&calibFile),
+          "Calibration file of the query camera")
+      ("refineIntrinsics", po::value<bool>(&refineIntrinsics),
+          "Enable/Disable camera intrinsics refinement for each localized image")
+      ("reprojectionError", po::value<double>(&resectionErrorMax)->default_value(resectionErrorMax),
+          "Maximum reprojection error (in pixels) allowed for resectioning. If set "
+          "to 0 it lets the ACRansac select an optimal value.")
+      ("voctreeWeights", po::value<std::string>(&weightsFilepath),
+          "Filename for the vocabulary tree weights")
+      ("nbImageMatch", po::value<std::size_t>(&numResults)->default_value(numResults),
+          "Number of images to retrieve in database")
+      ("maxResults", po::value<std::size_t>(&maxResults)->default_value(maxResults),
+          "For algorithm AllResults, it stops the image matching when "
+          "this number of matched images is reached. If 0 it is ignored.")
+      ("algorithm", po::value<std::string>(&algostring)->default_value(algostring),
+          "Algorithm type: FirstBest, AllResults")
+      ("matchingError", po::value<double>(&matchingErrorMax)->default_value(matchingErrorMax),
+          "Maximum matching error (in pixels) allowed for image matching with "
+          "geometric verification. If set to 0 it lets the ACRansac select "
+          "an optimal value.")
+      ("robustMatching", po::value<bool>(&robustMatching)->default_value(robustMatching),
+          "Enable/Disable the robust matching between query and database images, "
+          "all putative matches will be considered.");
+
+  po::options_description outputParams("Options for the output of the localizer");
+  outputParams.add_options()
+      ("help,h", "Print this message")
+      ("outputJSON", po::value<std::string>(&exportJsonFile)->default_value(exportJsonFile),
+          "Filename for the localization results (raw data) of all the frames as .json, saved at exit");
+
+  allParams.add(inputParams).add(serverParams).add(outputParams).add(commonParams);
+
+  po::variables_map vm;
+
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what() << std::endl);
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  if(!checkRobustEstimator(matchingEstimator, matchingErrorMax) ||
+     !checkRobustEstimator(resectionEstimator, resectionErrorMax))
+  {
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  const std::vector<feature::EImageDescriberType> matchDescTypes = feature::EImageDescriberType_stringToEnums(matchDescTypeNames);
+
+  //***********************************************************************
+  // Database initialization (done once)
+  //***********************************************************************
+
+  system::Timer initTimer;
+
+  sfm::SfMData sfmData;
+  if(!sfm::Load(sfmData, sfmFilePath, sfm::ESfMData::ALL))
+  {
+    ALICEVISION_LOG_ERROR("The input SfMData file '" + sfmFilePath + "' cannot be read.");
+    return EXIT_FAILURE;
+  }
+
+  localization::VoctreeLocalizer localizer(sfmData,
+                                           descriptorsFolder,
+                                           vocTreeFilepath,
+                                           weightsFilepath,
+                                           matchDescTypes);
+  if(!localizer.isInit())
+  {
+    ALICEVISION_CERR("ERROR while initializing the localizer!");
+    return EXIT_FAILURE;
+  }
+
+  localization::VoctreeLocalizer::Parameters param;
+  param._algorithm = localization::VoctreeLocalizer::initFromString(algostring);
+  param._numResults = numResults;
+  param._maxResults = maxResults;
+  param._ccTagUseCuda = false;
+  param._matchingError = matchingErrorMax;
+  param._useRobustMatching = robustMatching;
+  param._featurePreset = featurePreset;
+  param._refineIntrinsics = refineIntrinsics;
+  param._errorMax = resectionErrorMax;
+  param._resectionEstimator = resectionEstimator;
+  param._matchingEstimator = matchingEstimator;
+
+  std::unique_ptr<camera::PinholeRadialK3> queryIntrinsics;
+  if(!calibFile.empty())
+  {
+    queryIntrinsics.reset(new camera::PinholeRadialK3());
+    dataio::readCalibrationFromFile(calibFile, *queryIntrinsics);
+  }
+
+  ALICEVISION_LOG_INFO("Database loaded in " << initTimer.elapsed() << " [s]");
+
+  //***********************************************************************
+  // Serve the requests
+  //***********************************************************************
+
+  std::ofstream responsesFile;
+  if(responsesPath != "-")
+  {
+    responsesFile.open(responsesPath);
+    if(!responsesFile.is_open())
+    {
+      ALICEVISION_LOG_ERROR("Unable to open the responses file: " << responsesPath);
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostream& responsesStream = responsesFile.is_open() ? responsesFile : std::cout;
+
+  std::map<std::size_t, localization::LocalizationResult> resultsPerFrame;
+  std::size_t nbResponses = 0;
+
+  localization::LocalizationServer server(localizer, param, matchDescTypes, nbWorkers,
+    [&](const localization::LocalizationResponse& response)
+    {
+      // called by the server under its own lock
+      writeResponse(responsesStream, response);
+      if(!exportJsonFile.empty())
+        resultsPerFrame[response.frameId] = response.result;
+      ++nbResponses;
+      if(reportInterval > 0 && nbResponses % reportInterval == 0)
+        ALICEVISION_LOG_INFO("[server] " << nbResponses << " frames processed");
+    },
+    queryIntrinsics.get());
+
+  const bool readFromStdin = (requestsPath == "-");
+  bool quit = false;
+
+  while(!quit)
+  {
+    std::ifstream requestsFile;
+    if(!readFromStdin)
+    {
+      // opening a named pipe blocks until a client opens it for writing
+      requestsFile.open(requestsPath);
+      if(!requestsFile.is_open())
+      {
+        ALICEVISION_LOG_ERROR("Unable to open the requests file: " << requestsPath);
+        break;
+      }
+    }
+    std::istream& requestsStream = readFromStdin ? std::cin : requestsFile;
+
+    std::string line;
+    while(std::getline(requestsStream, line))
+    {
+      boost::algorithm::trim(line);
+      if(line.empty())
+        continue;
+      if(line == "quit")
+      {
+        quit = true;
+        break;
+      }
+      server.push(line);
+    }
+
+    // a regular file or the standard input is read only once,
+    // a named pipe is reopened to wait for the next client
+    if(readFromStdin || bfs::is_regular_file(requestsPath))
+      quit = true;
+
+    if(reportInterval > 0)
+      ALICEVISION_LOG_INFO("[server] " << server.getLatencyStats());
+  }
+
+  server.stop();
+
+  if(!exportJsonFile.empty())
+  {
+    std::vector<localization::LocalizationResult> vec_localizationResults;
+    vec_localizationResults.reserve(resultsPerFrame.size());
+    for(const auto& result : resultsPerFrame)
+      vec_localizationResults.push_back(result.second);
+    localization::LocalizationResult::save(vec_localizationResults, exportJsonFile);
+  }
+
+  ALICEVISION_COUT("\n\n******************************");
+  ALICEVISION_COUT(server.getLatencyStats());
+
+  return EXIT_SUCCESS;
+}
@@ -36,9 +36,9 @@ int main(int argc, char* argv[])
     po::options_description requiredParams("Required parameters");
     requiredParams.add_options()
         ("input,i", po::value<std::string>(&inputMeshPath)->required(),
-            "Input Mesh (OBJ file format).")
+            "Input Mesh (OBJ or binary .bin file format).")
         ("output,o", po::value<std::string>(&outputMeshPath)->required(),
-            "Output mesh (OBJ file format).");
+            "Output mesh (OBJ or binary .bin file format).");
 
     po::options_description optionalParams("Optional parameters");
     optionalParams.add_options()
@@ -96,7 +96,7 @@ int main(int argc, char* argv[])
         bfs::create_directory(outDirectory);
 
     mesh::Texturing texturing;
-    texturing.loadFromOBJ(inputMeshPath);
+    texturing.loadMesh(inputMeshPath);
     mesh::Mesh* mesh = texturing.me;
 
     if(!mesh)
@@ -157,7 +157,10 @@ int main(int argc, char* argv[])
     ALICEVISION_LOG_INFO("Save mesh.");
 
     // Save output mesh
-    outMesh.saveToObj(outputMeshPath);
+    if(bfs::path(outputMeshPath).extension() == ".bin")
+        outMesh.saveToBin(outputMeshPath);
+    else
+        outMesh.saveToObj(outputMeshPath);
 
     ALICEVISION_LOG_INFO("Mesh file: \"" << outputMeshPath << "\" saved.");
 
@@ -20,6 +20,8 @@
 #include <boost/program_options.hpp>
 #include <boost/filesystem.hpp>
 
+#include <cmath>
+
 using namespace aliceVision;
 namespace bfs = boost::filesystem;
 namespace po = boost::program_options;
@@ -87,6 +89,10 @@ int main(int argc, char* argv[])
     ERepartitionMode repartitionMode = eRepartitionMultiResolution;
     po::options_description inputParams;
     int maxPtsPerVoxel = 6000000;
+    float voxelsOverlap = 0.05f;
+    float stitchingWeldDistance = 0.5f;
+    int rangeStart = -1;
+    int rangeSize = -1;
 
     fuseCut::FuseParams fuseParams;
 
@@ -121,7 +127,20 @@ int main(int argc, char* argv[])
         ("partitioning", po::value<EPartitioningMode>(&partitioningMode)->default_value(partitioningMode),
             "Partitioning: 'singleBlock' or 'auto'.")
         ("repartition", po::value<ERepartitionMode>(&repartitionMode)->default_value(repartitionMode),
-            "Repartition: 'multiResolution' or 'regularGrid'.");
+            "Repartition: 'multiResolution' or 'regularGrid'.")
+        ("voxelsOverlap", po::value<float>(&voxelsOverlap)->default_value(voxelsOverlap),
+            "Overlap between the voxels reconstructed independently (relative to the voxel size), "
+            "for partitioning 'auto' with repartition 'regularGrid'.")
+        ("stitchingWeldDistance", po::value<float>(&stitchingWeldDistance)->default_value(stitchingWeldDistance),
+            "Max distance between the vertices welded when stitching the meshes of the voxels (relative to the average edge length).")
+        ("rangeStart", po::value<int>(&rangeStart)->default_value(rangeStart),
+            "Index of the first voxel of the sub-range to reconstruct (required with rangeSize > 0), "
+            "for partitioning 'auto' with repartition 'regularGrid'.")
+        ("rangeSize", po::value<int>(&rangeSize)->default_value(rangeSize),
+            "Number of voxels of the sub-range to reconstruct: the voxels of index rangeStart to rangeStart+rangeSize-1 "
+            "(within the number of voxels) are reconstructed, each in a bounded amount of memory, and the meshes are not stitched. "
+            "With rangeSize=0, only compute the voxels. The sub-ranges can be computed by separate processes "
+            "once the voxels are computed. With rangeSize=-1, the missing voxels are reconstructed and the meshes are stitched.");
 
     po::options_description advancedParams("Advanced parameters");
     advancedParams.add_options()
@@ -210,41 +229,79 @@ int main(int argc, char* argv[])
                     fuseCut::LargeScale lsbase(&mp, &pc, tmpDirectory.string() + "/");
                     lsbase.generateSpace(maxPtsPerVoxel, ocTreeDim, true);
                     std::string voxelsArrayFileName = lsbase.spaceFolderName + "hexahsToReconstruct.bin";
+                    const float inflateFactor = 1.0f + voxelsOverlap;
                     StaticVector<Point3d>* voxelsArray = nullptr;
                     if(bfs::exists(voxelsArrayFileName))
                     {
-                        // If already computed reload it.
-                        ALICEVISION_LOG_INFO("Voxels array already computed, reload from file: " << voxelsArrayFileName);
-                        voxelsArray = loadArrayFromFile<Point3d>(voxelsArrayFileName);
+                        // If already computed with the same overlap reload it.
+                        float fileInflateFactor;
+                        voxelsArray = fuseCut::loadVoxelsArrayFromFile(voxelsArrayFileName, fileInflateFactor);
+                        if(std::abs(fileInflateFactor - inflateFactor) < 1e-6f)
+                        {
+                            ALICEVISION_LOG_INFO("Voxels array already computed, reload from file: " << voxelsArrayFileName);
+                        }
+                        else
+                        {
+                            ALICEVISION_LOG_WARNING("Voxels array computed with another voxels overlap (inflate factor: " << fileInflateFactor
+                                                    << " instead of " << inflateFactor << "), the voxels are computed and reconstructed again.");
+                            // the voxels reconstructed with the previous bounds are outdated
+                            for(int i = 0; i < voxelsArray->size() / 8; ++i)
+                                bfs::remove_all(lsbase.getReconstructionVoxelFolder(i));
+                            delete voxelsArray;
+                            voxelsArray = nullptr;
+                        }
                     }
-                    else
+                    if(voxelsArray == nullptr)
                     {
                         ALICEVISION_LOG_INFO("Compute voxels array.");
                         fuseCut::ReconstructionPlan rp(lsbase.dimensions, &lsbase.space[0], lsbase.mp, lsbase.pc, lsbase.spaceVoxelsFolderName);
-                        voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints);
-                        saveArrayToFile<Point3d>(voxelsArrayFileName, voxelsArray);
+                        voxelsArray = rp.computeReconstructionPlanBinSearch(fuseParams.maxPoints, inflateFactor);
+                        fuseCut::saveVoxelsArrayToFile(voxelsArrayFileName, *voxelsArray, inflateFactor);
                     }
-                    fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase);
-                    // Join meshes
-                    mesh::Mesh* mesh = fuseCut::joinMeshes(voxelsArrayFileName, &lsbase);
+                    ALICEVISION_LOG_INFO("Number of voxels: " << voxelsArray->size() / 8);
+
+                    if(rangeSize == 0)
+                    {
+                        // only compute the voxels
+                        delete voxelsArray;
+                        break;
+                    }
+                    if(rangeSize != -1)
+                    {
+                        if(rangeStart < 0 || rangeSize < 0)
+                        {
+                            ALICEVISION_LOG_ERROR("invalid subrange of voxels to reconstruct.");
+                            delete voxelsArray;
+                            return EXIT_FAILURE;
+                        }
+                        // reconstruct the sub-range, the meshes are stitched by a last call without range
+                        fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase, fuseParams, rangeStart, rangeSize);
+                        delete voxelsArray;
+                        break;
+                    }
+
+                    fuseCut::reconstructSpaceAccordingToVoxelsArray(voxelsArrayFileName, &lsbase, fuseParams);
+
+                    // Stitch meshes
+                    StaticVector<StaticVector<int>*>* ptsCams = nullptr;
+                    mesh::Mesh* mesh = fuseCut::stitchMeshes(lsbase.getRecsDirs(voxelsArray), *voxelsArray, inflateFactor,
+                                                             stitchingWeldDistance, &ptsCams);
+                    delete voxelsArray;
 
                     if(mesh->pts->empty() || mesh->tris->empty())
                       throw std::runtime_error("Empty mesh");
 
                     ALICEVISION_LOG_INFO("Saving joined meshes...");
 
+                    // Save mesh and visibilities as .bin
                     bfs::path spaceBinFileName = outDirectory/"denseReconstruction.bin";
-                    mesh->saveToBin(spaceBinFileName.string());
+                    mesh->saveToBin(spaceBinFileName.string(), ptsCams);
+                    deleteArrayOfArrays<int>(&ptsCams);
 
                     // Export joined mesh to obj
                     mesh->saveToObj(outputMesh);
 
                     delete mesh;
-
-                    // Join ptsCams
-                    StaticVector<StaticVector<int>*>* ptsCams = fuseCut::loadLargeScalePtsCams(lsbase.getRecsDirs(voxelsArray));
-                    saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
-                    deleteArrayOfArrays<int>(&ptsCams);
                     break;
                 }
                 case ePartitioningSingleBlock:
@@ -289,7 +346,7 @@ int main(int argc, char* argv[])
 
                     delaunayGC.graphCutPostProcessing();
 
-                    // Save mesh as .bin and .obj
+                    // Save mesh and visibilities as .bin and mesh as .obj
                     mesh::Mesh* mesh = delaunayGC.createMesh();
                     if(mesh->pts->empty() || mesh->tris->empty())
                       throw std::runtime_error("Empty mesh");
@@ -299,9 +356,7 @@ int main(int argc, char* argv[])
 
                     StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = nullptr;
                     mesh::meshPostProcessing(mesh, ptsCams, usedCams, mp, pc, outDirectory.string()+"/", hexahsToExcludeFromResultingMesh, hexah);
-                    mesh->saveToBin((outDirectory/"denseReconstruction.bin").string());
-
-                    saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
+                    mesh->saveToBin((outDirectory/"denseReconstruction.bin").string(), ptsCams);
                     deleteArrayOfArrays<int>(&ptsCams);
 
                     mesh->saveToObj(outputMesh);
@@ -355,7 +410,7 @@ int main(int argc, char* argv[])
 
                     delaunayGC.graphCutPostProcessing();
 
-                    // Save mesh as .bin and .obj
+                    // Save mesh and visibilities as .bin and mesh as .obj
                     mesh::Mesh* mesh = delaunayGC.createMesh();
                     if(mesh->pts->empty() || mesh->tris->empty())
                         throw std::runtime_error("Empty mesh");
@@ -365,9 +420,7 @@ int main(int argc, char* argv[])
 
                     StaticVector<Point3d>* hexahsToExcludeFromResultingMesh = nullptr;
                     mesh::meshPostProcessing(mesh, ptsCams, usedCams, mp, pc, outDirectory.string()+"/", hexahsToExcludeFromResultingMesh, &hexah[0]);
-                    mesh->saveToBin((outDirectory/"denseReconstruction.bin").string());
-
-                    saveArrayOfArraysToFile<int>((outDirectory/"meshPtsCamsFromDGC.bin").string(), ptsCams);
+                    mesh->saveToBin((outDirectory/"denseReconstruction.bin").string(), ptsCams);
                     deleteArrayOfArrays<int>(&ptsCams);
                     delete voxels;
 
@@ -6,6 +6,7 @@
 #include <aliceVision/config.hpp>
 #include <aliceVision/sfm/sfm.hpp>
 #include <aliceVision/image/all.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
 #include <aliceVision/system/Logger.hpp>
 #include <aliceVision/system/cmdline.hpp>
 
@@ -16,6 +17,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <cmath>
+#include <memory>
 #include <vector>
 #include <set>
 #include <iterator>
@@ -147,7 +149,7 @@ void retrieveSeedsPerView(
   }
 }
 
-bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
+bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder, const DecodedImageCache* imageCache)
 {
   // defined view Ids
   std::set<IndexT> viewIds;
@@ -251,7 +253,10 @@ bool prepareDenseScene(const SfMData& sfmData, const std::string& outFolder)
       const IntrinsicBase* cam = iterIntrinsic->second.get();
       Image<RGBfColor> image, image_ud;
 
-      readImage(srcImage, image);
+      if(imageCache)
+        imageCache->readImage(srcImage, image, viewId);
+      else
+        readImage(srcImage, image);
       
       // Undistort
       if(cam->isValid() && cam->have_disto())
@@ -313,6 +318,8 @@ int main(int argc, char *argv[])
   std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
   std::string sfmDataFilename;
   std::string outFolder;
+  std::string decodedImageCacheFolder;
+  std::size_t decodedImageCacheMaxSize = DecodedImageCache::defaultMaxSize;
 
   po::options_description allParams("AliceVision prepareDenseScene");
 
@@ -323,12 +330,19 @@ int main(int argc, char *argv[])
     ("output,o", po::value<std::string>(&outFolder)->required(),
       "Output folder.");
 
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("decodedImageCache", po::value<std::string>(&decodedImageCacheFolder)->default_value(decodedImageCacheFolder),
+      "Folder of the decoded images cache shared by the pipeline stages (empty to disable).")
+    ("decodedImageCacheMaxSize", po::value<std::size_t>(&decodedImageCacheMaxSize)->default_value(decodedImageCacheMaxSize),
+      "Maximum size of the decoded images cache folder in MB, the least recently used images are removed (0 for no limit).");
+
   po::options_description logParams("Log parameters");
   logParams.add_options()
     ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
       "verbosity level (fatal, error, warning, info, debug, trace).");
 
-  allParams.add(requiredParams).add(logParams);
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
 
   po::variables_map vm;
   try
@@ -375,7 +389,11 @@ int main(int argc, char *argv[])
       return EXIT_FAILURE;
     }
 
-    if(!prepareDenseScene(sfmData, outFolder))
+    std::unique_ptr<DecodedImageCache> imageCache;
+    if(!decodedImageCacheFolder.empty())
+      imageCache.reset(new DecodedImageCache(decodedImageCacheFolder, decodedImageCacheMaxSize));
+
+    if(!prepareDenseScene(sfmData, outFolder, imageCache.get()))
       return EXIT_FAILURE;
   }
 
@@ -434,6 +434,11 @@ int main(int argc, char** argv)
     auto detect_elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(detect_end - detect_start);
     ALICEVISION_COUT("Localization took  " << detect_elapsed.count() << " [ms]");
     stats(detect_elapsed.count());
+    for(std::size_t camIDX = 0; camIDX < localizationResults.size(); ++camIDX)
+    {
+      ALICEVISION_COUT("\tcamera " << camIDX << ": description took " << localizationResults[camIDX].getDescribeTimeMs() << " [ms]"
+                       << ", matching took " << localizationResults[camIDX].getMatchingTimeMs() << " [ms]");
+    }
     
     rigResultPerFrame.push_back(localizationResults);
     
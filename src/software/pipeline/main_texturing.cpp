@@ -67,6 +67,9 @@ int main(int argc, char* argv[])
             "Fill texture holes with plausible values.")
         ("padding", po::value<unsigned int>(&texParams.padding)->default_value(texParams.padding),
             "Texture edge padding size in pixel")
+        ("maxMemory", po::value<unsigned int>(&texParams.maxMemory)->default_value(texParams.maxMemory),
+            "Maximum memory (in MB) for the texture accumulation buffers (0: use the available memory). "
+            "The atlases fitting in memory are textured together, loading each source image once.")
         ("inputMesh", po::value<std::string>(&inputMeshFilepath),
             "Optional input mesh to texture. By default, it will texture the inputReconstructionMesh.")
         ("flipNormals", po::value<bool>(&flipNormals)->default_value(flipNormals),
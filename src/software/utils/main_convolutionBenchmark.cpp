@@ -0,0 +1,214 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/image/Image.hpp>
+#include <aliceVision/image/convolution.hpp>
+#include <aliceVision/image/filtering.hpp>
+#include <aliceVision/alicevision_omp.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::image;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Reference (scalar, sequential) 1d convolution of the rows or of the columns.
+ * @param[in] mirror mirror the borders without repeating the border pixel, repeat the border pixel otherwise
+ */
+void referenceConvolution(const Image<float>& img, const Vec& kernel, bool vertical, bool mirror, Image<float>& out)
+{
+  const int rows = img.Height();
+  const int cols = img.Width();
+  const int half = static_cast<int>(kernel.size()) / 2;
+
+  const auto border = [&](int i, int size) {
+    if(!mirror)
+      return std::min(std::max(i, 0), size - 1);
+    if(i < 0)
+      return -i;
+    if(i >= size)
+      // the right border of the separable convolutions is mirrored one pixel further
+      return vertical ? 2 * size - 2 - i : 2 * size - 3 - i;
+    return i;
+  };
+
+  out.resize(cols, rows);
+  for(int row = 0; row < rows; ++row)
+  {
+    for(int col = 0; col < cols; ++col)
+    {
+      double sum = 0.0;
+      for(int k = 0; k < kernel.size(); ++k)
+      {
+        if(vertical)
+          sum += img(border(row + k - half, rows), col) * kernel(k);
+        else
+          sum += img(row, border(col + k - half, cols)) * kernel(k);
+      }
+      out(row, col) = static_cast<float>(sum);
+    }
+  }
+}
+
+/**
+ * @brief Run a filter several times and return the best time.
+ */
+double benchmark(const std::function<void()>& filter, int nbRuns)
+{
+  double bestTimeMs = std::numeric_limits<double>::max();
+  for(int i = 0; i < nbRuns; ++i)
+  {
+    system::Timer timer;
+    filter();
+    bestTimeMs = std::min(bestTimeMs, timer.elapsedMs());
+  }
+  return bestTimeMs;
+}
+
+/**
+ * @brief Compare a filter with its reference implementation.
+ */
+void compare(const std::string& name,
+             const std::function<void(Image<float>&)>& filter,
+             const std::function<void(Image<float>&)>& reference,
+             int nbRuns)
+{
+  Image<float> out;
+  Image<float> referenceOut;
+
+  const double timeMs = benchmark([&] { filter(out); }, nbRuns);
+  const double referenceTimeMs = benchmark([&] { reference(referenceOut); }, 1);
+  const float maxDiff = (out.array() - referenceOut.array()).abs().maxCoeff();
+
+  ALICEVISION_LOG_INFO("[" << name << "]" << std::endl
+                       << "\t- time: " << timeMs << " ms" << std::endl
+                       << "\t- reference time: " << referenceTimeMs << " ms" << std::endl
+                       << "\t- speedup: " << referenceTimeMs / timeMs << std::endl
+                       << "\t- max difference with the reference: " << maxDiff);
+}
+
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  int width = 4000;
+  int height = 3000;
+  int nbRuns = 5;
+  std::vector<double> sigmas = {1.0, 1.6, 3.0};
+
+  po::options_description allParams("Benchmark the image convolutions (Gaussian filters and derivatives)\n"
+                                    "against a scalar sequential reference on a random image.\n"
+                                    "AliceVision convolutionBenchmark");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("width", po::value<int>(&width)->default_value(width),
+      "Image width.")
+    ("height", po::value<int>(&height)->default_value(height),
+      "Image height.")
+    ("nbRuns", po::value<int>(&nbRuns)->default_value(nbRuns),
+      "Number of runs of each filter (the best time is kept).")
+    ("sigmas", po::value<std::vector<double>>(&sigmas)->multitoken()->default_value(sigmas, "1.0 1.6 3.0"),
+      "Sigmas of the Gaussian filters.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help"))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  ALICEVISION_LOG_INFO("Image: " << width << "x" << height << ", # threads: " << omp_get_max_threads());
+
+  // random image
+  Image<float> image(width, height);
+  {
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> distribution(0.f, 1.f);
+    for(int row = 0; row < height; ++row)
+      for(int col = 0; col < width; ++col)
+        image(row, col) = distribution(generator);
+  }
+
+  // Gaussian filters (mirrored borders)
+  for(double sigma : sigmas)
+  {
+    const Vec kernel = ComputeGaussianKernel(0, sigma);
+    compare("gaussian, sigma: " + std::to_string(sigma) + ", kernel size: " + std::to_string(kernel.size()),
+            [&](Image<float>& out) { ImageGaussianFilter(image, sigma, out, 0, 0); },
+            [&](Image<float>& out) {
+              Image<float> tmp;
+              referenceConvolution(image, kernel, true, true, tmp);
+              referenceConvolution(tmp, kernel, false, true, out);
+            },
+            nbRuns);
+  }
+
+  // Scharr derivatives (mirrored borders)
+  {
+    const Vec derivativeKernel = Vec3(-1.0, 0.0, 1.0);
+    const Vec smoothKernel = Vec3(3.0, 10.0, 3.0);
+    compare("scharr x derivative",
+            [&](Image<float>& out) { ImageScharrXDerivative(image, out, false); },
+            [&](Image<float>& out) {
+              Image<float> tmp;
+              referenceConvolution(image, smoothKernel, true, true, tmp);
+              referenceConvolution(tmp, derivativeKernel, false, true, out);
+            },
+            nbRuns);
+  }
+
+  // 1d convolutions (repeated borders)
+  {
+    const Vec kernel = ComputeGaussianKernel(7, 1.6);
+    compare("horizontal convolution, kernel size: 7",
+            [&](Image<float>& out) { ImageHorizontalConvolution(image, kernel, out); },
+            [&](Image<float>& out) { referenceConvolution(image, kernel, false, false, out); },
+            nbRuns);
+    compare("vertical convolution, kernel size: 7",
+            [&](Image<float>& out) { ImageVerticalConvolution(image, kernel, out); },
+            [&](Image<float>& out) { referenceConvolution(image, kernel, true, false, out); },
+            nbRuns);
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -4,12 +4,14 @@
 // You can obtain one at https://mozilla.org/MPL/2.0/.
 
 #include <aliceVision/keyframe/KeyframeSelector.hpp>
+#include <aliceVision/image/DecodedImageCache.hpp>
 #include <aliceVision/system/Logger.hpp>
 
 #include <boost/program_options.hpp> 
 #include <boost/filesystem.hpp>
 
 #include <string>
+#include <memory>
 #include <vector>
 
 using namespace aliceVision::keyframe;
@@ -28,6 +30,8 @@ int main(int argc, char** argv)
   std::string sensorDbPath;              // camera sensor width database
   std::string voctreeFilePath;           // SIFT voctree file path
   std::string outputFolder;              // output folder for keyframes
+  std::string decodedImageCacheFolder;   // decoded images cache folder
+  std::size_t decodedImageCacheMaxSize = aliceVision::image::DecodedImageCache::defaultMaxSize;   // decoded images cache maximum size (MB)
 
   // algorithm variables
 
@@ -69,11 +73,15 @@ int main(int argc, char** argv)
       ("sharpSubset", po::value<unsigned int>(&sharpSubset)->default_value(sharpSubset), 
         "sharp part of the image (1 = all, 2 = size/2, ...) ")
       ("minFrameStep", po::value<unsigned int>(&minFrameStep)->default_value(minFrameStep), 
-        "minimum number of frames between two keyframes")
+        "minimum number of frames between two keyframes (> 0)")
       ("maxFrameStep", po::value<unsigned int>(&maxFrameStep)->default_value(maxFrameStep), 
         "maximum number of frames after which a keyframe can be taken")
       ("maxNbOutFrame", po::value<unsigned int>(&maxNbOutFrame)->default_value(maxNbOutFrame), 
-        "maximum number of output frames (0 = no limit)");
+        "maximum number of output frames (0 = no limit)")
+      ("decodedImageCache", po::value<std::string>(&decodedImageCacheFolder)->default_value(decodedImageCacheFolder),
+        "Folder of the decoded images cache shared by the pipeline stages, used for the image sequences (empty to disable).")
+      ("decodedImageCacheMaxSize", po::value<std::size_t>(&decodedImageCacheMaxSize)->default_value(decodedImageCacheMaxSize),
+        "Maximum size of the decoded images cache folder in MB, the least recently used images are removed (0 for no limit).");
 
   allParams.add(inputParams).add(metadataParams).add(algorithmParams);
 
@@ -188,6 +196,10 @@ int main(int argc, char** argv)
   selector.setMinFrameStep(minFrameStep);
   selector.setMaxFrameStep(maxFrameStep);
   selector.setMaxOutFrame(maxNbOutFrame);
+
+  // set decoded image cache
+  if(!decodedImageCacheFolder.empty())
+    selector.setDecodedImageCache(std::make_shared<aliceVision::image::DecodedImageCache>(decodedImageCacheFolder, decodedImageCacheMaxSize));
   
   // process
   selector.process();        
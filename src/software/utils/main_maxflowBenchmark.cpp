@@ -0,0 +1,211 @@
+// This file is part of the AliceVision project.
+// This Source Code Form is subject to the terms of the Mozilla Public License,
+// v. 2.0. If a copy of the MPL was not distributed with this file,
+// You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#include <aliceVision/fuseCut/MaxFlow_AdjList.hpp>
+#include <aliceVision/fuseCut/MaxFlow_CSR.hpp>
+#include <aliceVision/fuseCut/MaxFlow_Tetra.hpp>
+#include <aliceVision/system/Logger.hpp>
+#include <aliceVision/system/cmdline.hpp>
+#include <aliceVision/system/Timer.hpp>
+
+#include <boost/program_options.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace aliceVision;
+using namespace aliceVision::fuseCut;
+
+namespace po = boost::program_options;
+
+/**
+ * @brief Fill a generic maxflow graph from a tetrahedral graph.
+ */
+template <typename MaxFlow>
+void fillGraph(const MaxFlow_Tetra& tetraGraph, MaxFlow& graph)
+{
+  const int nbNodes = static_cast<int>(tetraGraph.getNbNodes());
+
+  for(int n = 0; n < nbNodes; ++n)
+  {
+    const float terminal = tetraGraph.getTerminalCapacity(n);
+    graph.addNode(n, std::max(terminal, 0.0f), std::max(-terminal, 0.0f));
+  }
+
+  for(int n = 0; n < nbNodes; ++n)
+  {
+    for(int k = 0; k < MaxFlow_Tetra::nbNeighbors; ++k)
+    {
+      const int neighbor = tetraGraph.getNeighbor(n, k);
+      if(neighbor <= n)
+        continue; // no neighbor or edge already added
+
+      // find the reverse edge
+      for(int rk = 0; rk < MaxFlow_Tetra::nbNeighbors; ++rk)
+      {
+        if(tetraGraph.getNeighbor(neighbor, rk) == n)
+        {
+          graph.addEdge(n, neighbor, tetraGraph.getCapacity(n, k), tetraGraph.getCapacity(neighbor, rk));
+          break;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Compute the maxflow and compare the cut with the reference one.
+ */
+template <typename MaxFlow>
+void benchmark(const std::string& name, MaxFlow& graph, std::size_t nbNodes, double buildTimeMs,
+               std::vector<bool>& referenceIsTarget)
+{
+  system::Timer timer;
+  const float flow = graph.compute();
+  const double computeTimeMs = timer.elapsedMs();
+
+  std::size_t nbDifferentNodes = 0;
+
+  if(referenceIsTarget.empty())
+  {
+    referenceIsTarget.resize(nbNodes);
+    for(std::size_t n = 0; n < nbNodes; ++n)
+      referenceIsTarget[n] = graph.isTarget(n);
+  }
+  else
+  {
+    for(std::size_t n = 0; n < nbNodes; ++n)
+    {
+      if(graph.isTarget(n) != referenceIsTarget[n])
+        ++nbDifferentNodes;
+    }
+  }
+
+  ALICEVISION_LOG_INFO("[" << name << "]" << std::endl
+                       << "\t- build: " << buildTimeMs << " ms" << std::endl
+                       << "\t- compute: " << computeTimeMs << " ms" << std::endl
+                       << "\t- flow: " << flow << std::endl
+                       << "\t- full nodes different from the first method: " << nbDifferentNodes
+                       << " (several minimum cuts may exist)");
+}
+
+int main(int argc, char** argv)
+{
+  std::string verboseLevel = system::EVerboseLevel_enumToString(system::Logger::getDefaultVerboseLevel());
+  std::vector<std::string> graphFilepaths;
+  std::vector<std::string> methods = {"tetra", "adjList", "csr"};
+  std::vector<int> nbBlocksList = {0};
+
+  po::options_description allParams("Compare the maxflow implementations on graphs saved by the meshing\n"
+                                    "(see the 'delaunaycut.saveMaxflowGraph' option).\n"
+                                    "AliceVision maxflowBenchmark");
+
+  po::options_description requiredParams("Required parameters");
+  requiredParams.add_options()
+    ("input,i", po::value<std::vector<std::string>>(&graphFilepaths)->multitoken()->required(),
+      "Maxflow graph files.");
+
+  po::options_description optionalParams("Optional parameters");
+  optionalParams.add_options()
+    ("methods,m", po::value<std::vector<std::string>>(&methods)->multitoken()->default_value(methods, "tetra adjList csr"),
+      "Maxflow implementations to compare: tetra, adjList, csr. The cuts are compared with the first one.")
+    ("nbBlocks", po::value<std::vector<int>>(&nbBlocksList)->multitoken()->default_value(nbBlocksList, "0"),
+      "Number of blocks solved in parallel by the tetra implementation (0 for automatic, 1 for sequential). "
+      "Multiple values can be given.");
+
+  po::options_description logParams("Log parameters");
+  logParams.add_options()
+    ("verboseLevel,v", po::value<std::string>(&verboseLevel)->default_value(verboseLevel),
+      "verbosity level (fatal, error, warning, info, debug, trace).");
+
+  allParams.add(requiredParams).add(optionalParams).add(logParams);
+
+  po::variables_map vm;
+  try
+  {
+    po::store(po::parse_command_line(argc, argv, allParams), vm);
+
+    if(vm.count("help") || (argc == 1))
+    {
+      ALICEVISION_COUT(allParams);
+      return EXIT_SUCCESS;
+    }
+    po::notify(vm);
+  }
+  catch(boost::program_options::required_option& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+  catch(boost::program_options::error& e)
+  {
+    ALICEVISION_CERR("ERROR: " << e.what());
+    ALICEVISION_COUT("Usage:\n\n" << allParams);
+    return EXIT_FAILURE;
+  }
+
+  ALICEVISION_COUT("Program called with the following parameters:");
+  ALICEVISION_COUT(vm);
+
+  // set verbose level
+  system::Logger::get()->setLogLevel(verboseLevel);
+
+  for(const std::string& graphFilepath : graphFilepaths)
+  {
+    ALICEVISION_LOG_INFO("Graph: " << graphFilepath);
+
+    MaxFlow_Tetra tetraGraph;
+    try
+    {
+      tetraGraph.loadGraph(graphFilepath);
+    }
+    catch(std::exception& e)
+    {
+      ALICEVISION_LOG_ERROR(e.what());
+      return EXIT_FAILURE;
+    }
+    ALICEVISION_LOG_INFO("# nodes: " << tetraGraph.getNbNodes());
+
+    std::vector<bool> referenceIsTarget;
+
+    for(const std::string& method : methods)
+    {
+      if(method == "tetra")
+      {
+        for(int nbBlocks : nbBlocksList)
+        {
+          system::Timer timer;
+          MaxFlow_Tetra graph(tetraGraph); // copy the loaded graph, compute modifies the capacities
+          graph.setNbBlocks(nbBlocks);
+          benchmark(method + " (nbBlocks: " + std::to_string(nbBlocks) + ")", graph, tetraGraph.getNbNodes(), timer.elapsedMs(), referenceIsTarget);
+        }
+      }
+      else if(method == "adjList")
+      {
+        system::Timer timer;
+        std::unique_ptr<MaxFlow_AdjList> graph(new MaxFlow_AdjList(tetraGraph.getNbNodes()));
+        fillGraph(tetraGraph, *graph);
+        benchmark(method, *graph, tetraGraph.getNbNodes(), timer.elapsedMs(), referenceIsTarget);
+      }
+      else if(method == "csr")
+      {
+        system::Timer timer;
+        std::unique_ptr<MaxFlow_CSR> graph(new MaxFlow_CSR(tetraGraph.getNbNodes()));
+        fillGraph(tetraGraph, *graph);
+        benchmark(method, *graph, tetraGraph.getNbNodes(), timer.elapsedMs(), referenceIsTarget);
+      }
+      else
+      {
+        ALICEVISION_LOG_ERROR("Unknown maxflow method: " << method);
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  return EXIT_SUCCESS;
+}